@@ -906,7 +906,8 @@ class JniScanningCallbacks : ScanningCallbacks {
   void OnScanResult(uint16_t event_type, uint8_t addr_type, RawAddress bda,
                     uint8_t primary_phy, uint8_t secondary_phy,
                     uint8_t advertising_sid, int8_t tx_power, int8_t rssi,
-                    uint16_t periodic_adv_int, std::vector<uint8_t> adv_data) {
+                    uint16_t periodic_adv_int,
+                    const std::vector<uint8_t>& adv_data) {
     CallbackEnv sCallbackEnv(__func__);
     if (!sCallbackEnv.valid()) return;
 
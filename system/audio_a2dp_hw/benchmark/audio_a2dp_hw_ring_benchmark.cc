@@ -0,0 +1,244 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Loopback of the A2DP audio data channel: a producer thread writes PCM the
+// way the Audio HAL does, and the benchmark thread reads it the way the A2DP
+// source does on each media tick, through either the audio socket or the
+// shared memory ring.
+//
+// Reported per run:
+//   cpu_us_per_audio_s: process CPU time spent per second of audio moved
+//   wakeups_per_tick:   voluntary context switches of both threads per tick,
+//                       the tick timer itself accounts for one
+//   reader_syscalls_per_tick: system calls made by the reading side per tick
+
+#include <benchmark/benchmark.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "audio_a2dp_hw/include/audio_a2dp_hw.h"
+#include "audio_a2dp_hw/include/audio_a2dp_hw_ring.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// 44.1 kHz, 16 bits stereo
+constexpr size_t kBytesPerSecond = 44100 * 4;
+constexpr auto kTick = std::chrono::milliseconds(20);
+constexpr size_t kTickBytes = kBytesPerSecond * 20 / 1000;
+// One SBC frame of 128 PCM frames, what the encoder reads at a time
+constexpr size_t kReadBytes = 512;
+// What the AudioFlinger mixer delivers per write
+constexpr size_t kWriteBytes =
+    AUDIO_STREAM_OUTPUT_BUFFER_SZ / AUDIO_STREAM_OUTPUT_BUFFER_PERIODS;
+constexpr int kReadPollMs = 10;
+constexpr int kWritePollMs = 20;
+constexpr size_t kNumTicks = 100;
+
+struct Usage {
+  int64_t cpu_us;
+  int64_t context_switches;
+};
+
+Usage get_usage() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return {usage.ru_utime.tv_sec * 1000000LL + usage.ru_utime.tv_usec +
+              usage.ru_stime.tv_sec * 1000000LL + usage.ru_stime.tv_usec,
+          usage.ru_nvcsw};
+}
+
+// The audio socket, written like skt_write() and read like UIPC_Read()
+class SocketTransport {
+ public:
+  SocketTransport() {
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds_);
+    int size = AUDIO_STREAM_OUTPUT_BUFFER_SZ;
+    setsockopt(fds_[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds_[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+
+  ~SocketTransport() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  bool Write(const uint8_t* p_buf, size_t len) {
+    size_t count = 0;
+    while (count < len) {
+      ssize_t sent = send(fds_[0], p_buf + count, len - count,
+                          MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        usleep(kWritePollMs * 1000);
+        continue;
+      }
+      count += sent;
+    }
+    return true;
+  }
+
+  size_t Read(uint8_t* p_buf, size_t len) {
+    size_t n_read = 0;
+    while (n_read < len) {
+      struct pollfd pfd = {fds_[1], POLLIN | POLLHUP, 0};
+      reader_syscalls_++;
+      if (poll(&pfd, 1, kReadPollMs) <= 0) break;
+      reader_syscalls_++;
+      ssize_t n = recv(fds_[1], p_buf + n_read, len - n_read, 0);
+      if (n <= 0) break;
+      n_read += n;
+    }
+    return n_read;
+  }
+
+  void Close() { shutdown(fds_[1], SHUT_RDWR); }
+
+  uint64_t reader_syscalls() const { return reader_syscalls_; }
+
+ private:
+  int fds_[2];
+  uint64_t reader_syscalls_ = 0;
+};
+
+// The shared memory ring, handed over the audio socket as the HAL does
+class RingTransport {
+ public:
+  RingTransport() {
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds_);
+    producer_ = A2dpAudioRing::Create(AUDIO_STREAM_OUTPUT_RING_SZ);
+    std::thread sender([this] {
+      producer_->SendTo(fds_[0], A2DP_AUDIO_RING_HANDSHAKE_TMO_MS);
+    });
+    consumer_ =
+        A2dpAudioRing::ReceiveFrom(fds_[1], A2DP_AUDIO_RING_HANDSHAKE_TMO_MS);
+    sender.join();
+  }
+
+  ~RingTransport() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  bool Write(const uint8_t* p_buf, size_t len) {
+    size_t count = 0;
+    while (count < len) {
+      uint32_t written = producer_->Write(p_buf + count, len - count);
+      count += written;
+      if (written == 0) {
+        struct pollfd pfd = {fds_[0], POLLRDHUP, 0};
+        if (poll(&pfd, 1, kWritePollMs) != 0) return false;
+      }
+    }
+    return true;
+  }
+
+  size_t Read(uint8_t* p_buf, size_t len) {
+    size_t n_read = consumer_->Read(p_buf, len);
+    while (n_read < len) {
+      if (consumer_->Wait(len - n_read, fds_[1], kReadPollMs) <= 0) break;
+      n_read += consumer_->Read(p_buf + n_read, len - n_read);
+    }
+    return n_read;
+  }
+
+  void Close() { shutdown(fds_[1], SHUT_RDWR); }
+
+  uint64_t reader_syscalls() const { return consumer_->wait_count(); }
+
+ private:
+  int fds_[2];
+  std::unique_ptr<A2dpAudioRing> producer_;
+  std::unique_ptr<A2dpAudioRing> consumer_;
+};
+
+template <class Transport>
+static void BM_AudioLoopback(State& state) {
+  int64_t cpu_us = 0;
+  int64_t context_switches = 0;
+  uint64_t reader_syscalls = 0;
+  size_t bytes_read = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Transport transport;
+    std::atomic<bool> running = true;
+    std::thread producer([&transport, &running] {
+      std::vector<uint8_t> period(kWriteBytes, 0x55);
+      while (running && transport.Write(period.data(), period.size())) {
+      }
+    });
+    // Let the producer fill the buffers, as AudioFlinger does before the
+    // media task starts reading
+    std::this_thread::sleep_for(kTick);
+
+    std::vector<uint8_t> buffer(kReadBytes);
+    Usage start = get_usage();
+    uint64_t syscalls_start = transport.reader_syscalls();
+    state.ResumeTiming();
+
+    auto next_tick = std::chrono::steady_clock::now();
+    for (size_t tick = 0; tick < kNumTicks; tick++) {
+      next_tick += kTick;
+      std::this_thread::sleep_until(next_tick);
+      for (size_t len = 0; len < kTickBytes; len += kReadBytes) {
+        bytes_read += transport.Read(buffer.data(), kReadBytes);
+      }
+    }
+
+    state.PauseTiming();
+    Usage end = get_usage();
+    cpu_us += end.cpu_us - start.cpu_us;
+    context_switches += end.context_switches - start.context_switches;
+    reader_syscalls += transport.reader_syscalls() - syscalls_start;
+    running = false;
+    transport.Close();
+    producer.join();
+    state.ResumeTiming();
+  }
+
+  double audio_seconds = (double)bytes_read / kBytesPerSecond;
+  double ticks = (double)state.iterations() * kNumTicks;
+  state.counters["cpu_us_per_audio_s"] = cpu_us / audio_seconds;
+  state.counters["wakeups_per_tick"] = context_switches / ticks;
+  state.counters["reader_syscalls_per_tick"] = reader_syscalls / ticks;
+}
+BENCHMARK_TEMPLATE(BM_AudioLoopback, SocketTransport)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_AudioLoopback, RingTransport)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -85,6 +85,7 @@ typedef enum {
   A2DP_CTRL_GET_OUTPUT_AUDIO_CONFIG,
   A2DP_CTRL_SET_OUTPUT_AUDIO_CONFIG,
   A2DP_CTRL_GET_PRESENTATION_POSITION,
+  A2DP_CTRL_CMD_OFFER_AUDIO_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
@@ -150,6 +151,12 @@ size_t audio_a2dp_hw_stream_compute_buffer_size(
 // Returns whether the delay reporting property is set.
 bool delay_reporting_enabled();
 
+// Returns whether the audio data should go through a shared memory ring
+// rather than the audio socket. Each side reads it on its own, the ring is
+// only used once the Audio HAL offered it with A2DP_CTRL_CMD_OFFER_AUDIO_RING
+// and the stack accepted it.
+bool audio_ring_enabled();
+
 // Returns a string representation of |event|.
 const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event);
 
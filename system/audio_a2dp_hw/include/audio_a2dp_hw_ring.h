@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      audio_a2dp_hw_ring.h
+ *
+ *  Description:   Shared memory transport for the A2DP audio data channel
+ *
+ *****************************************************************************/
+
+#ifndef AUDIO_A2DP_HW_RING_H
+#define AUDIO_A2DP_HW_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+// Size of the audio ring created by the Audio HAL. It must be a power of two,
+// and is chosen to hold about as much as the audio socket buffers did.
+#define AUDIO_STREAM_OUTPUT_RING_SZ (32 * 1024)
+
+// How long each side of the audio channel waits for the other side's part of
+// the ring handshake.
+#define A2DP_AUDIO_RING_HANDSHAKE_TMO_MS 500
+
+// Single producer, single consumer byte ring shared between the Audio HAL
+// (producer) and the stack (consumer) through a memfd, with an eventfd used
+// by the producer to wake up the consumer.
+//
+// Positions are only ever advanced by their owner, so neither side takes a
+// lock or makes a system call while data flows; the consumer publishes how
+// many bytes it is waiting for and the producer signals the eventfd once, when
+// that many bytes are available.
+//
+// The handshake happens on the audio socket, which stays connected for the
+// lifetime of the ring: the Audio HAL sends the ring file descriptors, and the
+// stack answers with a single tA2DP_CTRL_ACK byte. Closing the socket tears
+// the ring down.
+class A2dpAudioRing {
+ public:
+  ~A2dpAudioRing();
+
+  // Creates a ring of |size| bytes, which must be a power of two.
+  // Returns nullptr on failure, with errno set.
+  static std::unique_ptr<A2dpAudioRing> Create(uint32_t size);
+
+  // Sends the ring file descriptors over the connected |socket_fd|, then waits
+  // at most |timeout_ms| for the peer to answer.
+  // Returns 1 if the peer uses the ring from now on, 0 if it refused it and
+  // keeps reading the socket, or -1 if it did not answer.
+  int SendTo(int socket_fd, int timeout_ms) const;
+
+  // Waits for ring file descriptors on the connected |socket_fd|, maps the
+  // ring and answers the peer.
+  // Returns nullptr if no valid ring was received, in which case the socket
+  // should keep being used for the audio data.
+  static std::unique_ptr<A2dpAudioRing> ReceiveFrom(int socket_fd,
+                                                    int timeout_ms);
+
+  // Producer: copies at most |len| bytes from |p_buf| into the ring.
+  // Returns the number of bytes copied, 0 if the ring is full.
+  uint32_t Write(const uint8_t* p_buf, uint32_t len);
+
+  // Consumer: copies at most |len| bytes from the ring into |p_buf|.
+  // Returns the number of bytes copied, 0 if the ring is empty.
+  uint32_t Read(uint8_t* p_buf, uint32_t len);
+
+  // Consumer: waits for |len| bytes to be readable, for at most |timeout_ms|.
+  // |hangup_fd| is polled as well so that the wait ends if the producer
+  // disconnects.
+  // Returns 1 if the bytes are readable, 0 on timeout and -1 if the producer
+  // disconnected or the ring is corrupted.
+  int Wait(uint32_t len, int hangup_fd, int timeout_ms);
+
+  // Consumer: drops everything written so far.
+  void Flush();
+
+  // Returns the number of bytes which can be read.
+  uint32_t Readable() const;
+
+  uint32_t size() const { return size_; }
+
+  // Number of times the producer signaled the eventfd.
+  uint64_t signal_count() const { return signal_count_; }
+  // Number of times the consumer had to block on the eventfd.
+  uint64_t wait_count() const { return wait_count_; }
+
+ private:
+  struct Shared;
+
+  A2dpAudioRing(int mem_fd, int event_fd, Shared* shared, uint32_t size);
+  static std::unique_ptr<A2dpAudioRing> Map(int mem_fd, int event_fd,
+                                            bool create, uint32_t size);
+
+  // Bytes written and not read yet, more than |size_| if the ring is corrupted
+  uint32_t Used() const;
+
+  int mem_fd_;
+  int event_fd_;
+  Shared* shared_;
+  uint8_t* data_;
+  uint32_t size_;
+  uint64_t signal_count_ = 0;
+  uint64_t wait_count_ = 0;
+};
+
+#endif  // AUDIO_A2DP_HW_RING_H
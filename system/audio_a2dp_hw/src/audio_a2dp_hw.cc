@@ -30,6 +30,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <log/log.h>
+#include <poll.h>
 #include <stdint.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
@@ -38,6 +39,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <memory>
 #include <mutex>
 
 #include <hardware/audio.h>
@@ -49,6 +51,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
+#include "audio_a2dp_hw_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -125,6 +128,10 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  // Shared memory ring the audio data is written to instead of audio_fd, when
+  // the stack accepted it. Writers hold a reference while writing unlocked.
+  std::shared_ptr<A2dpAudioRing>* ring;
+  bool use_ring;  // True if a ring should be offered on the next connection
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -341,6 +348,36 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+/* Writes to the audio ring, waiting for room like skt_write() does. The audio
+ * socket |fd| is only polled to notice the stack going away. */
+static int ring_write(A2dpAudioRing* ring, int fd, const void* p, size_t len) {
+  FNLOG();
+
+  ts_log("ring_write", len, NULL);
+
+  int ms_timeout = SOCK_SEND_TIMEOUT_MS;
+  size_t count = 0;
+  while (count < len) {
+    uint32_t written = ring->Write((const uint8_t*)p + count, len - count);
+    count += written;
+    if (written != 0) continue;
+
+    if (ms_timeout < WRITE_POLL_MS) {
+      WARN("write timeout exceeded, sent %zu bytes", count);
+      return -1;
+    }
+    struct pollfd pfd = {fd, POLLRDHUP, 0};
+    int ret;
+    OSI_NO_INTR(ret = poll(&pfd, 1, WRITE_POLL_MS));
+    if (ret != 0) {
+      ERROR("audio ring detached (ret %d revents 0x%x)", ret, pfd.revents);
+      return -1;
+    }
+    ms_timeout -= WRITE_POLL_MS;
+  }
+  return (int)count;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -826,6 +863,8 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->ring = new std::shared_ptr<A2dpAudioRing>;
+  common->use_ring = false;
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -837,6 +876,42 @@ static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
 
   delete common->mutex;
   common->mutex = NULL;
+  delete common->ring;
+  common->ring = NULL;
+}
+
+/* Offers a shared memory ring to the stack on the freshly connected audio
+ * socket. The socket keeps carrying the data if the stack refuses it. */
+static int a2dp_open_audio_ring(struct a2dp_stream_common* common) {
+  std::unique_ptr<A2dpAudioRing> ring =
+      A2dpAudioRing::Create(AUDIO_STREAM_OUTPUT_RING_SZ);
+  if (ring == nullptr) {
+    ERROR("failed to create the audio ring (%s)", strerror(errno));
+    common->use_ring = false;
+    return 0;
+  }
+
+  switch (ring->SendTo(common->audio_fd, A2DP_AUDIO_RING_HANDSHAKE_TMO_MS)) {
+    case 1:
+      INFO("writing audio to a %u bytes ring", ring->size());
+      *common->ring = std::move(ring);
+      return 0;
+    case 0:
+      WARN("audio ring refused, writing audio to the socket");
+      common->use_ring = false;
+      return 0;
+    default:
+      // The stack may or may not read the ring: start over without it
+      ERROR("audio ring handshake failed");
+      common->use_ring = false;
+      return -1;
+  }
+}
+
+static void a2dp_disconnect_audio_path(struct a2dp_stream_common* common) {
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->ring->reset();
 }
 
 static int start_audio_datapath(struct a2dp_stream_common* common) {
@@ -856,11 +931,29 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
 
   /* connect socket if not yet connected */
   if (common->audio_fd == AUDIO_SKT_DISCONNECTED) {
+    /* the stack only expects the ring handshake once it accepted the offer */
+    bool ring_accepted = false;
+    if (common->use_ring) {
+      if (a2dp_command(common, A2DP_CTRL_CMD_OFFER_AUDIO_RING) == 0) {
+        ring_accepted = true;
+      } else if (common->ctrl_fd == AUDIO_SKT_DISCONNECTED) {
+        /* the stack may have accepted the offer without us knowing */
+        ERROR("Audiopath start failed - no answer to the audio ring offer");
+        goto error;
+      } else {
+        WARN("audio ring not accepted, writing audio to the socket");
+        common->use_ring = false;
+      }
+    }
     common->audio_fd = skt_connect(A2DP_DATA_PATH, common->buffer_sz);
     if (common->audio_fd < 0) {
       ERROR("Audiopath start failed - error opening data socket");
       goto error;
     }
+    if (ring_accepted && a2dp_open_audio_ring(common) < 0) {
+      a2dp_disconnect_audio_path(common);
+      goto error;
+    }
   }
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STARTED;
 
@@ -892,8 +985,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_disconnect_audio_path(common);
 
   return 0;
 }
@@ -912,9 +1004,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  a2dp_disconnect_audio_path(common);
 
   return 0;
 }
@@ -964,13 +1054,19 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
-  lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
-  lock.lock();
+  {
+    std::shared_ptr<A2dpAudioRing> ring = *out->common.ring;
+    lock.unlock();
+    if (ring != nullptr) {
+      sent = ring_write(ring.get(), out->common.audio_fd, buffer, write_bytes);
+    } else {
+      sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+    }
+    lock.lock();
+  }
 
   if (sent == -1) {
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    a2dp_disconnect_audio_path(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
         (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -1618,6 +1714,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize a2dp specifics */
   a2dp_stream_common_init(&out->common);
+  out->common.use_ring = audio_ring_enabled();
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
@@ -0,0 +1,361 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "audio_a2dp_hw_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "audio_a2dp_hw.h"
+#include "osi/include/osi.h"
+
+namespace {
+
+constexpr uint32_t kRingMagic = 0x41324452;  // "A2DR"
+constexpr uint32_t kMinRingSize = 1024;
+constexpr uint32_t kMaxRingSize = 1024 * 1024;
+constexpr size_t kCacheLineSize = 64;
+
+// Sent by the Audio HAL on the audio socket along with the ring descriptors
+struct RingHello {
+  uint32_t magic;
+  uint32_t size;
+};
+
+bool is_valid_size(uint64_t size) {
+  return size >= kMinRingSize && size <= kMaxRingSize &&
+         (size & (size - 1)) == 0;
+}
+
+uint64_t time_now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+bool poll_readable(int fd, int timeout_ms) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  int ret;
+  OSI_NO_INTR(ret = poll(&pfd, 1, timeout_ms));
+  return ret > 0 && (pfd.revents & POLLIN);
+}
+
+void send_ack(int socket_fd, tA2DP_CTRL_ACK status) {
+  uint8_t ack = status;
+  OSI_NO_INTR(send(socket_fd, &ack, sizeof(ack), MSG_NOSIGNAL));
+}
+
+}  // namespace
+
+// Header of the shared memory, followed by the ring data. The positions are
+// free running byte counts, the data offset is the position modulo the size.
+struct A2dpAudioRing::Shared {
+  uint32_t magic;
+  uint32_t size;
+  // Written by the producer only
+  alignas(kCacheLineSize) std::atomic<uint32_t> write_pos;
+  // Written by the consumer only
+  alignas(kCacheLineSize) std::atomic<uint32_t> read_pos;
+  // Bytes the consumer waits for, 0 when it is not waiting. Cleared by the
+  // producer when it signals the eventfd.
+  std::atomic<uint32_t> wanted;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "the ring positions are shared between processes");
+
+A2dpAudioRing::A2dpAudioRing(int mem_fd, int event_fd, Shared* shared,
+                             uint32_t size)
+    : mem_fd_(mem_fd),
+      event_fd_(event_fd),
+      shared_(shared),
+      data_(reinterpret_cast<uint8_t*>(shared) + sizeof(Shared)),
+      size_(size) {
+  static_assert(sizeof(Shared) % kCacheLineSize == 0,
+                "the ring data should start on a cache line");
+}
+
+A2dpAudioRing::~A2dpAudioRing() {
+  munmap(shared_, sizeof(Shared) + size_);
+  close(event_fd_);
+  close(mem_fd_);
+}
+
+std::unique_ptr<A2dpAudioRing> A2dpAudioRing::Create(uint32_t size) {
+  if (!is_valid_size(size)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  // memfd_create() is not exposed by all the libc versions this builds with
+  int mem_fd = syscall(__NR_memfd_create, "a2dp_audio_ring",
+                       MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (mem_fd < 0) return nullptr;
+
+  // The stack maps the same memory: it must not be shrunk under its feet
+  if (ftruncate(mem_fd, sizeof(Shared) + size) < 0 ||
+      fcntl(mem_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) <
+          0) {
+    int saved_errno = errno;
+    close(mem_fd);
+    errno = saved_errno;
+    return nullptr;
+  }
+
+  int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd < 0) {
+    int saved_errno = errno;
+    close(mem_fd);
+    errno = saved_errno;
+    return nullptr;
+  }
+
+  return Map(mem_fd, event_fd, true, size);
+}
+
+std::unique_ptr<A2dpAudioRing> A2dpAudioRing::Map(int mem_fd, int event_fd,
+                                                  bool create, uint32_t size) {
+  struct stat st;
+  void* mapping = MAP_FAILED;
+  if (fstat(mem_fd, &st) == 0 && S_ISREG(st.st_mode) &&
+      (uint64_t)st.st_size == sizeof(Shared) + size &&
+      (create ||
+       (fcntl(mem_fd, F_GET_SEALS) & (F_SEAL_SHRINK | F_SEAL_GROW)) ==
+           (F_SEAL_SHRINK | F_SEAL_GROW))) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   mem_fd, 0);
+  }
+  if (mapping == MAP_FAILED) {
+    int saved_errno = errno;
+    close(event_fd);
+    close(mem_fd);
+    errno = saved_errno;
+    return nullptr;
+  }
+
+  Shared* shared;
+  if (create) {
+    shared = new (mapping) Shared();
+    shared->magic = kRingMagic;
+    shared->size = size;
+  } else {
+    shared = static_cast<Shared*>(mapping);
+  }
+  std::unique_ptr<A2dpAudioRing> ring(
+      new A2dpAudioRing(mem_fd, event_fd, shared, size));
+  if (shared->magic != kRingMagic || shared->size != size) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return ring;
+}
+
+int A2dpAudioRing::SendTo(int socket_fd, int timeout_ms) const {
+  RingHello hello = {kRingMagic, size_};
+  struct iovec iov = {&hello, sizeof(hello)};
+  int fds[2] = {mem_fd_, event_fd_};
+  char control[CMSG_SPACE(sizeof(fds))] = {};
+
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(socket_fd, &msg, MSG_NOSIGNAL));
+  if (ret != sizeof(hello)) return -1;
+
+  uint8_t ack;
+  if (!poll_readable(socket_fd, timeout_ms)) return -1;
+  OSI_NO_INTR(ret = recv(socket_fd, &ack, sizeof(ack), MSG_DONTWAIT));
+  if (ret != sizeof(ack)) return -1;
+  return ack == A2DP_CTRL_ACK_SUCCESS ? 1 : 0;
+}
+
+std::unique_ptr<A2dpAudioRing> A2dpAudioRing::ReceiveFrom(int socket_fd,
+                                                          int timeout_ms) {
+  if (!poll_readable(socket_fd, timeout_ms)) return nullptr;
+
+  RingHello hello = {};
+  struct iovec iov = {&hello, sizeof(hello)};
+  char control[CMSG_SPACE(sizeof(int) * 2)] = {};
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t ret;
+  OSI_NO_INTR(
+      ret = recvmsg(socket_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC));
+  if (ret < 0) return nullptr;
+
+  int fds[2] = {-1, -1};
+  size_t num_fds = 0;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t i = 0; i < count; i++) {
+      int fd;
+      memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+      if (num_fds < 2) {
+        fds[num_fds] = fd;
+      } else {
+        close(fd);
+      }
+      num_fds++;
+    }
+  }
+
+  if (ret != sizeof(hello) || hello.magic != kRingMagic || num_fds != 2 ||
+      (msg.msg_flags & MSG_CTRUNC) || !is_valid_size(hello.size)) {
+    if (fds[0] >= 0) close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+    send_ack(socket_fd, A2DP_CTRL_ACK_FAILURE);
+    errno = EPROTO;
+    return nullptr;
+  }
+
+  std::unique_ptr<A2dpAudioRing> ring = Map(fds[0], fds[1], false, hello.size);
+  send_ack(socket_fd,
+           ring != nullptr ? A2DP_CTRL_ACK_SUCCESS : A2DP_CTRL_ACK_FAILURE);
+  return ring;
+}
+
+uint32_t A2dpAudioRing::Used() const {
+  // Sequentially consistent, paired with the store of |wanted| in Wait()
+  return shared_->write_pos.load() -
+         shared_->read_pos.load(std::memory_order_relaxed);
+}
+
+uint32_t A2dpAudioRing::Readable() const {
+  uint32_t used = Used();
+  return used > size_ ? 0 : used;
+}
+
+uint32_t A2dpAudioRing::Write(const uint8_t* p_buf, uint32_t len) {
+  uint32_t write_pos = shared_->write_pos.load(std::memory_order_relaxed);
+  uint32_t used =
+      write_pos - shared_->read_pos.load(std::memory_order_acquire);
+  if (used > size_) return 0;
+  len = std::min(len, size_ - used);
+  if (len == 0) return 0;
+
+  uint32_t offset = write_pos & (size_ - 1);
+  uint32_t first = std::min(len, size_ - offset);
+  memcpy(data_ + offset, p_buf, first);
+  memcpy(data_, p_buf + first, len - first);
+  write_pos += len;
+  // Sequentially consistent, so that either the consumer sees the new data or
+  // this sees that the consumer is waiting
+  shared_->write_pos.store(write_pos);
+
+  uint32_t wanted = shared_->wanted.load();
+  if (wanted != 0 &&
+      write_pos - shared_->read_pos.load(std::memory_order_acquire) >=
+          wanted &&
+      shared_->wanted.exchange(0) != 0) {
+    uint64_t count = 1;
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(event_fd_, &count, sizeof(count)));
+    signal_count_++;
+  }
+  return len;
+}
+
+uint32_t A2dpAudioRing::Read(uint8_t* p_buf, uint32_t len) {
+  uint32_t read_pos = shared_->read_pos.load(std::memory_order_relaxed);
+  uint32_t used =
+      shared_->write_pos.load(std::memory_order_acquire) - read_pos;
+  if (used > size_) return 0;
+  len = std::min(len, used);
+  if (len == 0) return 0;
+
+  uint32_t offset = read_pos & (size_ - 1);
+  uint32_t first = std::min(len, size_ - offset);
+  memcpy(p_buf, data_ + offset, first);
+  memcpy(p_buf + first, data_, len - first);
+  shared_->read_pos.store(read_pos + len, std::memory_order_release);
+  return len;
+}
+
+int A2dpAudioRing::Wait(uint32_t len, int hangup_fd, int timeout_ms) {
+  len = std::min(std::max(len, 1u), size_);
+  uint64_t deadline_ms = time_now_ms() + std::max(timeout_ms, 0);
+
+  while (true) {
+    uint32_t used = Used();
+    if (used > size_) return -1;
+    if (used >= len) return 1;
+
+    uint64_t now_ms = time_now_ms();
+    if (now_ms >= deadline_ms) return 0;
+
+    // Publish what is needed, then check again in case the producer wrote
+    // before it could see it
+    shared_->wanted.store(len);
+    used = Used();
+    if (used < len) {
+      struct pollfd pfds[2] = {{event_fd_, POLLIN, 0},
+                               {hangup_fd, POLLRDHUP, 0}};
+      int ret;
+      wait_count_++;
+      OSI_NO_INTR(ret = poll(pfds, hangup_fd >= 0 ? 2 : 1,
+                             (int)(deadline_ms - now_ms)));
+      if (ret < 0 ||
+          (pfds[1].revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL))) {
+        shared_->wanted.store(0, std::memory_order_relaxed);
+        return -1;
+      }
+      if (pfds[0].revents & POLLIN) {
+        uint64_t count;
+        OSI_NO_INTR(ret = read(event_fd_, &count, sizeof(count)));
+      }
+    }
+    // A signal raced with this may be left in the eventfd: it only causes
+    // one extra loop on the next wait.
+    shared_->wanted.store(0, std::memory_order_relaxed);
+  }
+}
+
+void A2dpAudioRing::Flush() {
+  shared_->read_pos.store(shared_->write_pos.load(std::memory_order_acquire),
+                          std::memory_order_release);
+}
@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <future>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "audio_a2dp_hw/include/audio_a2dp_hw.h"
+#include "audio_a2dp_hw/include/audio_a2dp_hw_ring.h"
+
+namespace {
+
+constexpr uint32_t kRingSize = 4096;
+
+class AudioA2dpHwRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds_), 0);
+  }
+
+  void TearDown() override {
+    if (fds_[0] >= 0) close(fds_[0]);
+    if (fds_[1] >= 0) close(fds_[1]);
+  }
+
+  // Hands a new ring from |producer_| to |consumer_| over the socket pair
+  void Connect() {
+    producer_ = A2dpAudioRing::Create(kRingSize);
+    ASSERT_NE(producer_, nullptr);
+    auto sent = std::async(std::launch::async, [this] {
+      return producer_->SendTo(fds_[0], A2DP_AUDIO_RING_HANDSHAKE_TMO_MS);
+    });
+    consumer_ =
+        A2dpAudioRing::ReceiveFrom(fds_[1], A2DP_AUDIO_RING_HANDSHAKE_TMO_MS);
+    ASSERT_NE(consumer_, nullptr);
+    ASSERT_EQ(sent.get(), 1);
+  }
+
+  int fds_[2] = {-1, -1};
+  std::unique_ptr<A2dpAudioRing> producer_;
+  std::unique_ptr<A2dpAudioRing> consumer_;
+};
+
+}  // namespace
+
+TEST_F(AudioA2dpHwRingTest, create_rejects_invalid_sizes) {
+  EXPECT_EQ(A2dpAudioRing::Create(0), nullptr);
+  EXPECT_EQ(A2dpAudioRing::Create(3000), nullptr);
+  EXPECT_EQ(A2dpAudioRing::Create(64 * 1024 * 1024), nullptr);
+  EXPECT_NE(A2dpAudioRing::Create(AUDIO_STREAM_OUTPUT_RING_SZ), nullptr);
+}
+
+TEST_F(AudioA2dpHwRingTest, data_crosses_the_ring) {
+  Connect();
+  EXPECT_EQ(consumer_->size(), kRingSize);
+
+  std::vector<uint8_t> data(kRingSize * 3);
+  std::iota(data.begin(), data.end(), 0);
+  std::vector<uint8_t> received(data.size());
+
+  // Odd chunk sizes so that the positions wrap in the middle of copies
+  size_t written = 0;
+  size_t read = 0;
+  while (read < data.size()) {
+    written += producer_->Write(&data[written],
+                                std::min<size_t>(1000, data.size() - written));
+    EXPECT_EQ(consumer_->Readable(), written - read);
+    read += consumer_->Read(&received[read], 700);
+  }
+  EXPECT_EQ(received, data);
+  EXPECT_EQ(consumer_->Read(received.data(), 1), 0u);
+}
+
+TEST_F(AudioA2dpHwRingTest, write_stops_when_full) {
+  Connect();
+  std::vector<uint8_t> data(kRingSize + 100, 0x5a);
+  EXPECT_EQ(producer_->Write(data.data(), data.size()), kRingSize);
+  EXPECT_EQ(producer_->Write(data.data(), 1), 0u);
+
+  consumer_->Flush();
+  EXPECT_EQ(consumer_->Readable(), 0u);
+  EXPECT_EQ(producer_->Write(data.data(), 100), 100u);
+}
+
+TEST_F(AudioA2dpHwRingTest, receive_rejects_data_without_ring) {
+  const uint8_t pcm[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  ASSERT_EQ(write(fds_[0], pcm, sizeof(pcm)), (ssize_t)sizeof(pcm));
+  EXPECT_EQ(A2dpAudioRing::ReceiveFrom(fds_[1], 0), nullptr);
+
+  uint8_t ack = A2DP_CTRL_ACK_SUCCESS;
+  ASSERT_EQ(read(fds_[0], &ack, sizeof(ack)), 1);
+  EXPECT_EQ(ack, A2DP_CTRL_ACK_FAILURE);
+}
+
+TEST_F(AudioA2dpHwRingTest, send_reports_refusal_and_no_answer) {
+  std::unique_ptr<A2dpAudioRing> ring = A2dpAudioRing::Create(kRingSize);
+  ASSERT_NE(ring, nullptr);
+  EXPECT_EQ(ring->SendTo(fds_[0], 0), -1);
+
+  uint8_t ack = A2DP_CTRL_ACK_FAILURE;
+  ASSERT_EQ(write(fds_[1], &ack, sizeof(ack)), 1);
+  EXPECT_EQ(ring->SendTo(fds_[0], 0), 0);
+}
+
+TEST_F(AudioA2dpHwRingTest, wait_is_signaled_once) {
+  Connect();
+  auto waited = std::async(std::launch::async,
+                           [this] { return consumer_->Wait(1024, -1, 5000); });
+
+  // Feed the bytes in small pieces: only the one completing the wait signals
+  uint8_t chunk[128] = {};
+  while (waited.wait_for(std::chrono::milliseconds(1)) !=
+         std::future_status::ready) {
+    producer_->Write(chunk, sizeof(chunk));
+  }
+  EXPECT_EQ(waited.get(), 1);
+  EXPECT_GE(consumer_->Readable(), 1024u);
+  EXPECT_LE(producer_->signal_count(), 1u);
+  EXPECT_LE(consumer_->wait_count(), 2u);
+
+  // Nothing to wait for when the data is already there
+  EXPECT_EQ(consumer_->Wait(1024, -1, 0), 1);
+}
+
+TEST_F(AudioA2dpHwRingTest, wait_times_out) {
+  Connect();
+  EXPECT_EQ(consumer_->Wait(1, fds_[1], 10), 0);
+  EXPECT_EQ(consumer_->wait_count(), 1u);
+}
+
+TEST_F(AudioA2dpHwRingTest, wait_ends_when_producer_disconnects) {
+  Connect();
+  producer_.reset();
+  shutdown(fds_[0], SHUT_RDWR);
+  EXPECT_EQ(consumer_->Wait(1, fds_[1], 5000), -1);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <vector>
+
+#include "bta/gatt/database.h"
+#include "bta/gatt/database_builder.h"
+#include "types/bluetooth/uuid.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+// Bytes allocated by the process, to measure what the connections hold. The
+// size of each allocation is kept in front of it.
+static std::atomic<size_t> allocated_bytes{0};
+static constexpr size_t kSizeHeader = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+  char* p = static_cast<char*>(malloc(kSizeHeader + size));
+  if (p == nullptr) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(p) = size;
+  allocated_bytes += size;
+  return p + kSizeHeader;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr == nullptr) return;
+  char* p = static_cast<char*>(ptr) - kSizeHeader;
+  allocated_bytes -= *reinterpret_cast<size_t*>(p);
+  free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace {
+
+// Same version as the cache files written by bta_gattc_db_storage.cc
+constexpr uint16_t kCacheVersion = 6;
+
+// The GATT client keeps at most this many hash files and cached databases
+constexpr size_t kNumConnections = 30;
+
+// Database of a sensor: GAP, GATT, battery, device information and a vendor
+// service with a few notifying characteristics
+gatt::Database build_sensor_database() {
+  gatt::DatabaseBuilder builder;
+  uint16_t handle = 0x0001;
+  auto add_service = [&](uint16_t uuid16, size_t num_characteristics) {
+    uint16_t start = handle;
+    uint16_t end = start + 3 * num_characteristics;
+    builder.AddService(start, end, Uuid::From16Bit(uuid16), true);
+    handle++;
+    for (size_t i = 0; i < num_characteristics; i++) {
+      builder.AddCharacteristic(handle, handle + 1,
+                                Uuid::From16Bit(0x2a00 + handle), 0x12);
+      builder.AddDescriptor(handle + 2, Uuid::From16Bit(0x2902));
+      handle += 3;
+    }
+  };
+  add_service(0x1800, 3);
+  add_service(0x1801, 1);
+  add_service(0x180f, 1);
+  add_service(0x180a, 6);
+  add_service(0xfe55, 8);
+  return builder.Build();
+}
+
+FILE* write_cache_file(const gatt::Database& database) {
+  std::vector<gatt::StoredAttribute> attributes = database.Serialize();
+  uint16_t num_attributes = attributes.size();
+  FILE* fd = tmpfile();
+  fwrite(&kCacheVersion, sizeof(uint16_t), 1, fd);
+  fwrite(&num_attributes, sizeof(uint16_t), 1, fd);
+  fwrite(attributes.data(), sizeof(gatt::StoredAttribute), num_attributes, fd);
+  fflush(fd);
+  return fd;
+}
+
+// Reads and deserializes the database as bta_gattc_load_db() does, which each
+// connection did before the databases were shared
+gatt::Database load_from_storage(FILE* fd) {
+  uint16_t cache_version = 0;
+  uint16_t num_attributes = 0;
+  rewind(fd);
+  if (fread(&cache_version, sizeof(uint16_t), 1, fd) != 1 ||
+      cache_version != kCacheVersion ||
+      fread(&num_attributes, sizeof(uint16_t), 1, fd) != 1) {
+    abort();
+  }
+  std::vector<gatt::StoredAttribute> attributes(num_attributes);
+  if (fread(attributes.data(), sizeof(gatt::StoredAttribute), num_attributes,
+            fd) != num_attributes) {
+    abort();
+  }
+  bool success = false;
+  gatt::Database database = gatt::Database::Deserialize(attributes, &success);
+  if (!success) abort();
+  return database;
+}
+
+// Reconnection to a known server before the databases were shared
+void BM_ReconnectLoadFromStorage(State& state) {
+  FILE* fd = write_cache_file(build_sensor_database());
+  for (auto _ : state) {
+    gatt::Database database = load_from_storage(fd);
+    benchmark::DoNotOptimize(database);
+  }
+  fclose(fd);
+}
+BENCHMARK(BM_ReconnectLoadFromStorage);
+
+// Reconnection to a known server with the in-memory cache: address to hash,
+// then hash to the shared database, as bta_gattc_cache_load() does
+void BM_ReconnectSharedDatabase(State& state) {
+  gatt::Database sensor_database = build_sensor_database();
+  RawAddress address({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+  std::map<RawAddress, Octet16> address_hashes = {
+      {address, sensor_database.Hash()}};
+  std::map<Octet16, gatt::Database> databases = {
+      {sensor_database.Hash(), sensor_database}};
+  for (auto _ : state) {
+    gatt::Database database = databases.at(address_hashes.at(address));
+    benchmark::DoNotOptimize(database);
+  }
+}
+BENCHMARK(BM_ReconnectSharedDatabase);
+
+// Memory held by connections to identical servers, each with its own copy of
+// the database (state.range(0) == 0) or sharing a single one
+void BM_ConnectionsMemory(State& state) {
+  bool shared = state.range(0);
+  FILE* fd = write_cache_file(build_sensor_database());
+  gatt::Database cached = load_from_storage(fd);
+  size_t bytes = 0;
+  for (auto _ : state) {
+    size_t before = allocated_bytes;
+    std::vector<gatt::Database> connections;
+    connections.reserve(kNumConnections);
+    for (size_t i = 0; i < kNumConnections; i++) {
+      connections.push_back(shared ? cached : load_from_storage(fd));
+    }
+    bytes = allocated_bytes - before;
+    benchmark::DoNotOptimize(connections);
+  }
+  state.counters["bytes_per_connection"] = bytes / kNumConnections;
+  fclose(fd);
+}
+BENCHMARK(BM_ConnectionsMemory)->Arg(0)->Arg(1);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -889,6 +889,7 @@ void bta_gattc_read_multi(tBTA_GATTC_CLCB* p_clcb,
 
   read_param.read_multiple.num_handles = p_data->api_read_multi.num_attr;
   read_param.read_multiple.auth_req = p_data->api_read_multi.auth_req;
+  read_param.read_multiple.variable_len = p_data->api_read_multi.variable_len;
   memcpy(&read_param.read_multiple.handles, p_data->api_read_multi.handles,
          sizeof(uint16_t) * p_data->api_read_multi.num_attr);
 
@@ -985,6 +986,26 @@ static void bta_gattc_read_cmpl(tBTA_GATTC_CLCB* p_clcb,
   }
 }
 
+/** read multiple complete */
+static void bta_gattc_read_multi_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                      const tBTA_GATTC_OP_CMPL* p_data) {
+  GATT_READ_MULTI_OP_CB cb = p_clcb->p_q_cmd->api_read_multi.read_cb;
+  void* my_cb_data = p_clcb->p_q_cmd->api_read_multi.read_cb_data;
+
+  tBTA_GATTC_MULTI handles;
+  handles.num_attr = p_clcb->p_q_cmd->api_read_multi.num_attr;
+  memcpy(handles.handles, p_clcb->p_q_cmd->api_read_multi.handles,
+         sizeof(uint16_t) * handles.num_attr);
+
+  osi_free_and_reset((void**)&p_clcb->p_q_cmd);
+
+  if (cb) {
+    uint16_t len = p_data->p_cmpl ? p_data->p_cmpl->att_value.len : 0;
+    uint8_t* value = p_data->p_cmpl ? p_data->p_cmpl->att_value.value : NULL;
+    cb(p_clcb->bta_conn_id, p_data->status, handles, len, value, my_cb_data);
+  }
+}
+
 /** write complete */
 static void bta_gattc_write_cmpl(tBTA_GATTC_CLCB* p_clcb,
                                  const tBTA_GATTC_OP_CMPL* p_data) {
@@ -1079,8 +1100,12 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
       return;
   }
 
-  if (p_clcb->p_q_cmd->hdr.event !=
-      bta_gattc_opcode_to_int_evt[op - GATTC_OPTYPE_READ]) {
+  const bool is_read_multi =
+      op == GATTC_OPTYPE_READ &&
+      p_clcb->p_q_cmd->hdr.event == BTA_GATTC_API_READ_MULTI_EVT;
+  if (!is_read_multi &&
+      p_clcb->p_q_cmd->hdr.event !=
+          bta_gattc_opcode_to_int_evt[op - GATTC_OPTYPE_READ]) {
     uint8_t mapped_op =
         p_clcb->p_q_cmd->hdr.event - BTA_GATTC_API_READ_EVT + GATTC_OPTYPE_READ;
     if (mapped_op > GATTC_OPTYPE_INDICATION) mapped_op = 0;
@@ -1104,7 +1129,10 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
   }
 
   /* service handle change void the response, discard it */
-  if (op == GATTC_OPTYPE_READ)
+  if (is_read_multi)
+    bta_gattc_read_multi_cmpl(p_clcb, &p_data->op_cmpl);
+
+  else if (op == GATTC_OPTYPE_READ)
     bta_gattc_read_cmpl(p_clcb, &p_data->op_cmpl);
 
   else if (op == GATTC_OPTYPE_WRITE)
@@ -452,19 +452,25 @@ void BTA_GATTC_ReadCharDescr(uint16_t conn_id, uint16_t handle,
  *
  * Parameters       conn_id - connectino ID.
  *                    p_read_multi - pointer to the read multiple parameter.
+ *                    variable_len - use Read Multiple Variable Length.
+ *                    callback - called with the raw response.
  *
  * Returns          None
  *
  ******************************************************************************/
 void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
-                            tGATT_AUTH_REQ auth_req) {
+                            bool variable_len, tGATT_AUTH_REQ auth_req,
+                            GATT_READ_MULTI_OP_CB callback, void* cb_data) {
   tBTA_GATTC_API_READ_MULTI* p_buf =
       (tBTA_GATTC_API_READ_MULTI*)osi_calloc(sizeof(tBTA_GATTC_API_READ_MULTI));
 
   p_buf->hdr.event = BTA_GATTC_API_READ_MULTI_EVT;
   p_buf->hdr.layer_specific = conn_id;
   p_buf->auth_req = auth_req;
+  p_buf->variable_len = variable_len;
   p_buf->num_attr = p_read_multi->num_attr;
+  p_buf->read_cb = callback;
+  p_buf->read_cb_data = cb_data;
 
   if (p_buf->num_attr > 0)
     memcpy(p_buf->handles, p_read_multi->handles,
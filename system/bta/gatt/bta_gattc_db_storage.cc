@@ -23,6 +23,7 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -44,6 +45,9 @@ using std::vector;
 // Default expired time is 7 days
 #define GATT_HASH_EXPIRED_TIME 604800
 
+// Number of databases kept in memory, matches the number of hash files
+#define GATT_DB_CACHE_MAX_SIZE GATT_HASH_MAX_SIZE
+
 static void bta_gattc_hash_remove_least_recently_used_if_possible();
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
@@ -61,6 +65,46 @@ static void bta_gattc_generate_hash_file_name(char* buffer, size_t buffer_len,
 
 static gatt::Database EMPTY_DB;
 
+/* Databases already in memory, by hash. Servers with the same database share
+ * one copy of it, and reconnecting to a known server does not touch storage.
+ * Content is immutable for a given hash, so entries never go stale. */
+namespace {
+struct CachedDatabase {
+  gatt::Database database;
+  uint64_t last_used;
+};
+
+std::map<Octet16, CachedDatabase> db_cache;
+std::map<RawAddress, Octet16> db_cache_addr_hash;
+uint64_t db_cache_clock = 0;
+}  // namespace
+
+static gatt::Database bta_gattc_db_cache_get(const Octet16& hash) {
+  auto it = db_cache.find(hash);
+  if (it == db_cache.end()) return EMPTY_DB;
+
+  it->second.last_used = ++db_cache_clock;
+  return it->second.database;
+}
+
+/* Returns the cached database with |hash| if there is one, so that the caller
+ * shares it, or caches |database| otherwise. */
+static gatt::Database bta_gattc_db_cache_put(const Octet16& hash,
+                                             const gatt::Database& database) {
+  gatt::Database cached = bta_gattc_db_cache_get(hash);
+  if (!cached.IsEmpty()) return cached;
+
+  if (db_cache.size() >= GATT_DB_CACHE_MAX_SIZE) {
+    auto lru = db_cache.begin();
+    for (auto it = db_cache.begin(); it != db_cache.end(); ++it) {
+      if (it->second.last_used < lru->second.last_used) lru = it;
+    }
+    db_cache.erase(lru);
+  }
+  db_cache[hash] = {database, ++db_cache_clock};
+  return database;
+}
+
 /*******************************************************************************
  *
  * Function         bta_gattc_load_db
@@ -132,9 +176,20 @@ done:
  *
  ******************************************************************************/
 gatt::Database bta_gattc_cache_load(const RawAddress& server_bda) {
+  auto addr_hash = db_cache_addr_hash.find(server_bda);
+  if (addr_hash != db_cache_addr_hash.end()) {
+    gatt::Database db = bta_gattc_db_cache_get(addr_hash->second);
+    if (!db.IsEmpty()) return db;
+  }
+
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
-  return bta_gattc_load_db(fname);
+  gatt::Database db = bta_gattc_load_db(fname);
+  if (db.IsEmpty()) return db;
+
+  Octet16 hash = db.Hash();
+  db_cache_addr_hash[server_bda] = hash;
+  return bta_gattc_db_cache_put(hash, db);
 }
 
 /*******************************************************************************
@@ -150,9 +205,15 @@ gatt::Database bta_gattc_cache_load(const RawAddress& server_bda) {
  *
  ******************************************************************************/
 gatt::Database bta_gattc_hash_load(const Octet16& hash) {
+  gatt::Database db = bta_gattc_db_cache_get(hash);
+  if (!db.IsEmpty()) return db;
+
   char fname[255] = {0};
   bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
-  return bta_gattc_load_db(fname);
+  db = bta_gattc_load_db(fname);
+  if (db.IsEmpty()) return db;
+
+  return bta_gattc_db_cache_put(hash, db);
 }
 
 /*******************************************************************************
@@ -249,9 +310,12 @@ void bta_gattc_cache_link(const RawAddress& server_bda, const Octet16& hash) {
   bta_gattc_generate_hash_file_name(hash_file, sizeof(hash_file), hash);
 
   unlink(addr_file);  // remove addr file first if the file exists
+  db_cache_addr_hash.erase(server_bda);
   if (link(hash_file, addr_file) == -1) {
     LOG_ERROR("link %s to %s, errno=%d", addr_file, hash_file, errno);
+    return;
   }
+  db_cache_addr_hash[server_bda] = hash;
 }
 
 /*******************************************************************************
@@ -271,7 +335,10 @@ bool bta_gattc_hash_write(const Octet16& hash, const gatt::Database& database) {
   char fname[255] = {0};
   bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
   bta_gattc_hash_remove_least_recently_used_if_possible();
-  return bta_gattc_store_db(fname, database.Serialize());
+  if (!bta_gattc_store_db(fname, database.Serialize())) return false;
+
+  bta_gattc_db_cache_put(hash, database);
+  return true;
 }
 
 /*******************************************************************************
@@ -291,6 +358,7 @@ void bta_gattc_cache_reset(const RawAddress& server_bda) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
   unlink(fname);
+  db_cache_addr_hash.erase(server_bda);
 }
 
 /*******************************************************************************
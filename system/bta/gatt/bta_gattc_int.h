@@ -150,8 +150,11 @@ typedef struct {
 typedef struct {
   BT_HDR_RIGID hdr;
   tGATT_AUTH_REQ auth_req;
+  bool variable_len;
   uint8_t num_attr;
   uint16_t handles[GATT_MAX_READ_MULTI_HANDLES];
+  GATT_READ_MULTI_OP_CB read_cb;
+  void* read_cb_data;
 } tBTA_GATTC_API_READ_MULTI;
 
 typedef struct {
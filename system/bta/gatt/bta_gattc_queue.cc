@@ -16,11 +16,17 @@
 
 #include "bta_gatt_queue.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "stack/include/bt_types.h"
 
 #include <base/logging.h>
 
@@ -40,9 +46,19 @@ struct gatt_read_op_data {
 std::unordered_map<uint16_t, std::list<gatt_operation>>
     BtaGattQueue::gatt_op_queue;
 std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_executing;
+std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_read_coalescing;
+std::unordered_map<uint16_t, BtaGattQueue::gatt_queue_stats>
+    BtaGattQueue::gatt_op_queue_stats;
 
 void BtaGattQueue::mark_as_not_executing(uint16_t conn_id) {
   gatt_op_queue_executing.erase(conn_id);
+
+  auto stats = gatt_op_queue_stats.find(conn_id);
+  if (stats == gatt_op_queue_stats.end()) return;
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - stats->second.request_start);
+  stats->second.total_latency += latency;
+  stats->second.max_latency = std::max(stats->second.max_latency, latency);
 }
 
 void BtaGattQueue::gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
@@ -109,6 +125,116 @@ void BtaGattQueue::gatt_configure_mtu_op_finished(uint16_t conn_id,
   }
 }
 
+struct gatt_read_multi_op_data {
+  uint8_t types[GATT_MAX_READ_MULTI_HANDLES];
+  GATT_READ_OP_CB cbs[GATT_MAX_READ_MULTI_HANDLES];
+  void* cb_data[GATT_MAX_READ_MULTI_HANDLES];
+};
+
+void BtaGattQueue::gatt_read_multi_op_finished(uint16_t conn_id,
+                                               tGATT_STATUS status,
+                                               const tBTA_GATTC_MULTI& handles,
+                                               uint16_t len, uint8_t* value,
+                                               void* data) {
+  gatt_read_multi_op_data* tmp = (gatt_read_multi_op_data*)data;
+
+  /* Split the response into its length and value pairs. The response is cut
+   * at the MTU, so the last value may be incomplete or missing. */
+  uint8_t* values[GATT_MAX_READ_MULTI_HANDLES];
+  uint16_t lens[GATT_MAX_READ_MULTI_HANDLES];
+  uint8_t served = 0;
+  if (status == GATT_SUCCESS) {
+    uint8_t* p = value;
+    uint16_t remaining = len;
+    while (served < handles.num_attr && remaining >= 2) {
+      uint16_t value_len;
+      STREAM_TO_UINT16(value_len, p);
+      remaining -= 2;
+      if (value_len > remaining) break;
+
+      values[served] = p;
+      lens[served] = value_len;
+      p += value_len;
+      remaining -= value_len;
+      served++;
+    }
+  } else {
+    LOG_WARN("conn_id=0x%04x, read multiple of %d handles failed, status=%d",
+             conn_id, handles.num_attr, status);
+    if (status == GATT_REQ_NOT_SUPPORTED) {
+      gatt_op_queue_read_coalescing.erase(conn_id);
+    }
+  }
+
+  /* Reads left without a value go back to the front of the queue. The value
+   * that did not fit is read on its own so it is read in full, and on error
+   * every read is retried on its own so each one gets its own status. */
+  bool requeued = false;
+  auto map_ptr = gatt_op_queue.find(conn_id);
+  if (map_ptr != gatt_op_queue.end()) {
+    for (int i = handles.num_attr - 1; i >= served; i--) {
+      map_ptr->second.push_front(
+          {.type = tmp->types[i],
+           .handle = handles.handles[i],
+           .read_cb = tmp->cbs[i],
+           .read_cb_data = tmp->cb_data[i],
+           .no_coalesce = status != GATT_SUCCESS || i == served});
+    }
+    requeued = true;
+  }
+
+  mark_as_not_executing(conn_id);
+  gatt_execute_next_op(conn_id);
+
+  for (uint8_t i = 0; i < handles.num_attr; i++) {
+    if (!tmp->cbs[i]) continue;
+    if (i < served) {
+      tmp->cbs[i](conn_id, GATT_SUCCESS, handles.handles[i], lens[i],
+                  values[i], tmp->cb_data[i]);
+    } else if (!requeued) {
+      tmp->cbs[i](conn_id, status == GATT_SUCCESS ? GATT_ERROR : status,
+                  handles.handles[i], 0, NULL, tmp->cb_data[i]);
+    }
+  }
+
+  osi_free(data);
+}
+
+static bool is_coalescable_read(const gatt_operation& op) {
+  return (op.type == GATT_READ_CHAR || op.type == GATT_READ_DESC) &&
+         !op.no_coalesce;
+}
+
+bool BtaGattQueue::gatt_execute_read_multi(
+    uint16_t conn_id, std::list<gatt_operation>& gatt_ops) {
+  auto last = gatt_ops.begin();
+  uint8_t count = 0;
+  while (last != gatt_ops.end() && count < GATT_MAX_READ_MULTI_HANDLES &&
+         is_coalescable_read(*last)) {
+    ++last;
+    ++count;
+  }
+  // Read Multiple needs at least two handles
+  if (count < 2) return false;
+
+  tBTA_GATTC_MULTI multi = {.num_attr = count};
+  gatt_read_multi_op_data* data =
+      (gatt_read_multi_op_data*)osi_malloc(sizeof(gatt_read_multi_op_data));
+  uint8_t i = 0;
+  for (auto it = gatt_ops.begin(); it != last; ++it, ++i) {
+    multi.handles[i] = it->handle;
+    data->types[i] = it->type;
+    data->cbs[i] = it->read_cb;
+    data->cb_data[i] = it->read_cb_data;
+  }
+  gatt_ops.erase(gatt_ops.begin(), last);
+  gatt_op_queue_stats[conn_id].coalesced_reads += count;
+
+  BTA_GATTC_ReadMultiple(conn_id, &multi, true, GATT_AUTH_REQ_NONE,
+                         gatt_read_multi_op_finished, data);
+  return true;
+}
+
 void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
   APPL_TRACE_DEBUG("%s: conn_id=0x%x", __func__, conn_id);
   if (gatt_op_queue.empty()) {
@@ -123,14 +249,23 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
     return;
   }
 
+  std::list<gatt_operation>& gatt_ops = map_ptr->second;
+  gatt_queue_stats& stats = gatt_op_queue_stats[conn_id];
+  stats.max_depth = std::max(stats.max_depth, gatt_ops.size());
+
   if (gatt_op_queue_executing.count(conn_id)) {
     APPL_TRACE_DEBUG("%s: can't enqueue next op, already executing", __func__);
     return;
   }
 
   gatt_op_queue_executing.insert(conn_id);
+  stats.requests++;
+  stats.request_start = std::chrono::steady_clock::now();
 
-  std::list<gatt_operation>& gatt_ops = map_ptr->second;
+  if (gatt_op_queue_read_coalescing.count(conn_id) &&
+      gatt_execute_read_multi(conn_id, gatt_ops)) {
+    return;
+  }
 
   gatt_operation& op = gatt_ops.front();
 
@@ -182,6 +317,37 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
 void BtaGattQueue::Clean(uint16_t conn_id) {
   gatt_op_queue.erase(conn_id);
   gatt_op_queue_executing.erase(conn_id);
+  gatt_op_queue_read_coalescing.erase(conn_id);
+  gatt_op_queue_stats.erase(conn_id);
+}
+
+void BtaGattQueue::SetReadCoalescing(uint16_t conn_id, bool enable) {
+  if (enable) {
+    gatt_op_queue_read_coalescing.insert(conn_id);
+  } else {
+    gatt_op_queue_read_coalescing.erase(conn_id);
+  }
+}
+
+void BtaGattQueue::DebugDump(int fd) {
+  dprintf(fd, "GATT client operation queue:\n");
+  for (const auto& [conn_id, stats] : gatt_op_queue_stats) {
+    auto map_ptr = gatt_op_queue.find(conn_id);
+    size_t depth = map_ptr == gatt_op_queue.end() ? 0 : map_ptr->second.size();
+    double avg_latency_ms =
+        stats.requests
+            ? stats.total_latency.count() / 1000.0 / stats.requests
+            : 0;
+    dprintf(fd,
+            "  conn_id: 0x%04x, read coalescing: %s, queued: %zu, max queued: "
+            "%zu\n"
+            "    requests: %" PRIu64 ", coalesced reads: %" PRIu64
+            ", latency avg: %.1f ms, max: %.1f ms\n",
+            conn_id,
+            gatt_op_queue_read_coalescing.count(conn_id) ? "on" : "off",
+            depth, stats.max_depth, stats.requests, stats.coalesced_reads,
+            avg_latency_ms, stats.max_latency.count() / 1000.0);
+  }
 }
 
 void BtaGattQueue::ReadCharacteristic(uint16_t conn_id, uint16_t handle,
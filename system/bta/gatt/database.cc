@@ -61,10 +61,17 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+std::list<Service>& Database::MutableServices() {
+  if (services.use_count() > 1) {
+    services = std::make_shared<std::list<Service>>(*services);
+  }
+  return *services;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
-  for (const Service& service : services) {
+  for (const Service& service : *services) {
     tmp << "Service: handle=" << loghex(service.handle)
         << ", end_handle=" << loghex(service.end_handle)
         << ", uuid=" << service.uuid << "\n";
@@ -94,9 +101,9 @@ std::string Database::ToString() const {
 std::vector<StoredAttribute> Database::Serialize() const {
   std::vector<StoredAttribute> nv_attr;
 
-  if (services.empty()) return std::vector<StoredAttribute>();
+  if (services->empty()) return std::vector<StoredAttribute>();
 
-  for (const Service& service : services) {
+  for (const Service& service : *services) {
     // TODO: add constructor to NV_ATTR, use emplace_back
     nv_attr.push_back({service.handle,
                        service.is_primary ? PRIMARY_SERVICE : SECONDARY_SERVICE,
@@ -104,7 +111,7 @@ std::vector<StoredAttribute> Database::Serialize() const {
                                     .end_handle = service.end_handle}}});
   }
 
-  for (const Service& service : services) {
+  for (const Service& service : *services) {
     for (const IncludedService& p_isvc : service.included_services) {
       nv_attr.push_back({p_isvc.handle,
                          INCLUDE,
@@ -146,7 +153,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   for (; it != nv_attr.cend(); ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
-    result.services.emplace_back(Service{
+    result.services->emplace_back(Service{
         .handle = attr.handle,
         .uuid = attr.value.service.uuid,
         .is_primary = (attr.type == PRIMARY_SERVICE),
@@ -154,18 +161,18 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
     });
   }
 
-  auto current_service_it = result.services.begin();
+  auto current_service_it = result.services->begin();
   for (; it != nv_attr.cend(); it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
     // order, so iterating just forward is enough
-    while (current_service_it != result.services.end() &&
+    while (current_service_it != result.services->end() &&
            current_service_it->end_handle < attr.handle) {
       current_service_it++;
     }
 
-    if (current_service_it == result.services.end() ||
+    if (current_service_it == result.services->end() ||
         !HandleInRange(*current_service_it, attr.handle)) {
       LOG(ERROR) << "Can't find service for attribute with handle: "
                  << loghex(attr.handle);
@@ -175,7 +182,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
 
     if (attr.type == INCLUDE) {
       Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+          FindService(*result.services, attr.value.included_service.handle);
       if (!included_service) {
         LOG(ERROR) << __func__ << ": Non-existing included service!";
         *success = false;
@@ -216,7 +223,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
 Octet16 Database::Hash() const {
   int len = 0;
   // Compute how much space we need to actually hold the data.
-  for (const Service& service : services) {
+  for (const Service& service : *services) {
     len += 4 + UuidSize(service.uuid);
 
     for (const auto& is : service.included_services) {
@@ -246,7 +253,7 @@ Octet16 Database::Hash() const {
 
   std::vector<uint8_t> serialized(len);
   uint8_t* p = serialized.data();
-  for (const Service& service : services) {
+  for (const Service& service : *services) {
     UINT16_TO_STREAM(p, service.handle);
     if (service.is_primary) {
       UINT16_TO_STREAM(p, GATT_UUID_PRI_SERVICE);
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -100,17 +101,25 @@ struct Descriptor {
 
 class DatabaseBuilder;
 
+/* Copies of a Database share its services, so the same database held by
+ * many connections is kept in memory once. Services are copied only when a
+ * shared database is modified. */
 class Database {
  public:
   /* Return true if there are no services in this database. */
-  bool IsEmpty() const { return services.empty(); }
+  bool IsEmpty() const { return services->empty(); }
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() { services = std::make_shared<std::list<Service>>(); }
 
   /* Return list of services available in this database */
-  const std::list<Service>& Services() const { return services; }
+  const std::list<Service>& Services() const { return *services; }
+
+  /* Return true if this database shares its services with |other| */
+  bool SharesServicesWith(const Database& other) const {
+    return services == other.services;
+  }
 
   std::string ToString() const;
 
@@ -125,7 +134,11 @@ class Database {
   friend class DatabaseBuilder;
 
  private:
-  std::list<Service> services;
+  /* Return services for modification, copying them first if shared */
+  std::list<Service>& MutableServices();
+
+  std::shared_ptr<std::list<Service>> services =
+      std::make_shared<std::list<Service>>();
 };
 
 /* Find a service that should contain handle. Helper method for internal use
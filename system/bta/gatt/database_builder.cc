@@ -38,18 +38,17 @@ namespace gatt {
 
 void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
                                  const Uuid& uuid, bool is_primary) {
+  auto& vec = database.MutableServices();
+
   // general case optimization - we add services in order
-  if (database.services.empty() ||
-      database.services.back().end_handle < handle) {
-    database.services.emplace_back(Service{
+  if (vec.empty() || vec.back().end_handle < handle) {
+    vec.emplace_back(Service{
         .handle = handle,
         .uuid = uuid,
         .is_primary = is_primary,
         .end_handle = end_handle,
     });
   } else {
-    auto& vec = database.services;
-
     // Find first service whose start handle is bigger than new service handle
     auto it = std::lower_bound(
         vec.begin(), vec.end(), handle,
@@ -70,7 +69,7 @@ void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
 void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
                                          uint16_t start_handle,
                                          uint16_t end_handle) {
-  Service* service = FindService(database.services, handle);
+  Service* service = FindService(database.MutableServices(), handle);
   if (!service) {
     LOG(ERROR) << "Illegal action to add to non-existing service!";
     return;
@@ -78,7 +77,7 @@ void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
 
   /* We discover all Primary Services first. If included service was not seen
    * before, it must be a Secondary Service */
-  if (!FindService(database.services, start_handle)) {
+  if (!FindService(database.MutableServices(), start_handle)) {
     AddService(start_handle, end_handle, uuid, false /* not primary */);
   }
 
@@ -92,7 +91,7 @@ void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
 
 void DatabaseBuilder::AddCharacteristic(uint16_t handle, uint16_t value_handle,
                                         const Uuid& uuid, uint8_t properties) {
-  Service* service = FindService(database.services, handle);
+  Service* service = FindService(database.MutableServices(), handle);
   if (!service) {
     LOG(ERROR) << "Illegal action to add to non-existing service!";
     return;
@@ -113,7 +112,7 @@ void DatabaseBuilder::AddCharacteristic(uint16_t handle, uint16_t value_handle,
 }
 
 void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
-  Service* service = FindService(database.services, handle);
+  Service* service = FindService(database.MutableServices(), handle);
   if (!service) {
     LOG(ERROR) << "Illegal action to add to non-existing service!";
     return;
@@ -162,7 +161,8 @@ DatabaseBuilder::CurrentlyExploredService() {
 }
 
 std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
-  Service* service = FindService(database.services, pending_service.first);
+  Service* service =
+      FindService(database.MutableServices(), pending_service.first);
   if (!service || service->characteristics.empty()) {
     return {HANDLE_MAX, HANDLE_MAX};
   }
@@ -222,7 +222,7 @@ bool DatabaseBuilder::SetValueOfDescriptors(
   }
 
   for (size_t i = 0; i < values.size(); i++) {
-    Descriptor* d = FindDescriptorByHandle(database.services,
+    Descriptor* d = FindDescriptorByHandle(database.MutableServices(),
                                            descriptor_handles_to_read[i]);
     if (!d) {
       LOG(ERROR) << __func__ << "non-existing descriptor!";
@@ -239,7 +239,7 @@ bool DatabaseBuilder::SetValueOfDescriptors(
   return true;
 }
 
-bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
+bool DatabaseBuilder::InProgress() const { return !database.IsEmpty(); }
 
 Database DatabaseBuilder::Build() {
   Database tmp = database;
@@ -160,10 +160,19 @@ typedef struct {
 #define BTA_HH_LE_RPT_MAX 20
 #endif
 
+/* input report looked up by its value handle when notified */
+typedef struct {
+  uint16_t char_inst_id;
+  uint8_t rpt_id;
+} tBTA_HH_LE_INPUT_RPT;
+
 typedef struct {
   bool in_use;
   uint8_t srvc_inst_id;
   tBTA_HH_LE_RPT report[BTA_HH_LE_RPT_MAX];
+  /* input reports sorted by value handle */
+  tBTA_HH_LE_INPUT_RPT input_rpt[BTA_HH_LE_RPT_MAX];
+  uint8_t num_input_rpt;
 
   uint16_t proto_mode_handle;
   uint8_t control_point_handle;
@@ -21,12 +21,14 @@
 #include <base/bind.h>
 #include <base/callback.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
 #include "bta/hh/bta_hh_int.h"
 #include "bta/include/bta_gatt_queue.h"
 #include "bta/include/bta_hh_co.h"
+#include "common/time_util.h"
 #include "device/include/interop.h"
 #include "main/shim/dumpsys.h"
 #include "main/shim/shim.h"
@@ -357,6 +359,55 @@ static tBTA_HH_LE_RPT* bta_hh_le_find_report_entry(
   return NULL;
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_build_input_rpt_table
+ *
+ * Description      build the table of input reports sorted by value handle,
+ *                  so that a notification is routed without looking up the
+ *                  GATT database
+ *
+ ******************************************************************************/
+static void bta_hh_le_build_input_rpt_table(tBTA_HH_DEV_CB* p_cb) {
+  tBTA_HH_LE_HID_SRVC* p_srvc = &p_cb->hid_srvc;
+  tBTA_HH_LE_RPT* p_rpt = &p_srvc->report[0];
+
+  p_srvc->num_input_rpt = 0;
+  for (uint8_t i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
+    if (!p_rpt->in_use || p_rpt->rpt_type != BTA_HH_RPTT_INPUT) continue;
+
+    tBTA_HH_LE_INPUT_RPT* p_input =
+        &p_srvc->input_rpt[p_srvc->num_input_rpt++];
+    p_input->char_inst_id = p_rpt->char_inst_id;
+    p_input->rpt_id = p_rpt->rpt_id;
+  }
+
+  std::sort(p_srvc->input_rpt, p_srvc->input_rpt + p_srvc->num_input_rpt,
+            [](const tBTA_HH_LE_INPUT_RPT& a, const tBTA_HH_LE_INPUT_RPT& b) {
+              return a.char_inst_id < b.char_inst_id;
+            });
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_find_input_rpt
+ *
+ * Description      find the input report notified on a value handle
+ *
+ ******************************************************************************/
+static const tBTA_HH_LE_INPUT_RPT* bta_hh_le_find_input_rpt(
+    const tBTA_HH_DEV_CB* p_cb, uint16_t handle) {
+  const tBTA_HH_LE_INPUT_RPT* p_end =
+      p_cb->hid_srvc.input_rpt + p_cb->hid_srvc.num_input_rpt;
+  const tBTA_HH_LE_INPUT_RPT* p_input = std::lower_bound(
+      p_cb->hid_srvc.input_rpt, p_end, handle,
+      [](const tBTA_HH_LE_INPUT_RPT& rpt, uint16_t handle) {
+        return rpt.char_inst_id < handle;
+      });
+  if (p_input == p_end || p_input->char_inst_id != handle) return NULL;
+  return p_input;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_le_find_rpt_by_idtype
@@ -552,6 +603,8 @@ static void bta_hh_le_register_input_notif(tBTA_HH_DEV_CB* p_dev_cb,
   APPL_TRACE_DEBUG("%s: bta_hh_le_register_input_notif mode: %d", __func__,
                    proto_mode);
 
+  bta_hh_le_build_input_rpt_table(p_dev_cb);
+
   for (int i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
     if (p_rpt->rpt_type == BTA_HH_RPTT_INPUT) {
       if (register_ba && p_rpt->uuid == GATT_UUID_BATTERY_LEVEL) {
@@ -1528,6 +1581,7 @@ static void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
  *
  ******************************************************************************/
 static void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
+  uint64_t rx_time_us = bluetooth::common::time_get_os_boottime_us();
   tBTA_HH_DEV_CB* p_dev_cb = bta_hh_le_find_dev_cb_by_conn_id(p_data->conn_id);
   uint8_t app_id;
   uint8_t* p_buf;
@@ -1540,6 +1594,15 @@ static void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
     return;
   }
 
+  /* fast path for the input reports registered for notification */
+  const tBTA_HH_LE_INPUT_RPT* p_input =
+      bta_hh_le_find_input_rpt(p_dev_cb, p_data->handle);
+  if (p_input != NULL) {
+    bta_hh_co_le_input_data(p_dev_cb->hid_handle, p_input->rpt_id,
+                            p_data->value, p_data->len, rx_time_us);
+    return;
+  }
+
   const gatt::Characteristic* p_char =
       BTA_GATTC_GetCharacteristic(p_dev_cb->conn_id, p_data->handle);
   if (p_char == NULL) {
@@ -591,6 +591,12 @@ typedef void (*GATT_WRITE_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
                                  const uint8_t* value, void* data);
 typedef void (*GATT_CONFIGURE_MTU_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
                                          void* data);
+/* |value| is the raw response, for a variable length read it is a sequence of
+ * 2 octet length and value pairs in the order of |handles| */
+typedef void (*GATT_READ_MULTI_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
+                                      const tBTA_GATTC_MULTI& handles,
+                                      uint16_t len, uint8_t* value,
+                                      void* data);
 
 /*******************************************************************************
  *
@@ -763,13 +769,18 @@ extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
  *
  * Parameters       conn_id - connectino ID.
  *                    p_read_multi - read multiple parameters.
+ *                    variable_len - use Read Multiple Variable Length, the
+ *                                   peer must support it.
+ *                    callback - called with the raw response.
  *
  * Returns          None
  *
  ******************************************************************************/
 extern void BTA_GATTC_ReadMultiple(uint16_t conn_id,
                                    tBTA_GATTC_MULTI* p_read_multi,
-                                   tGATT_AUTH_REQ auth_req);
+                                   bool variable_len, tGATT_AUTH_REQ auth_req,
+                                   GATT_READ_MULTI_OP_CB callback,
+                                   void* cb_data);
 
 /*******************************************************************************
  *
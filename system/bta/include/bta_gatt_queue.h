@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <unordered_map>
@@ -32,6 +33,10 @@
  *
  * If you decide to use those methods in your app, make sure to not mix it with
  * existing BTA_GATTC_* API.
+ *
+ * With read coalescing enabled for a connection, reads queued back to back are
+ * sent as a single ATT Read Multiple Variable Length request. Every read still
+ * gets its own callback, in queue order.
  */
 class BtaGattQueue {
  public:
@@ -50,6 +55,12 @@ class BtaGattQueue {
                               void* cb_data);
   static void ConfigureMtu(uint16_t conn_id, uint16_t mtu);
 
+  /* Opt in to read coalescing. If the peer does not support Read Multiple
+   * Variable Length, coalescing is turned off for the connection after the
+   * first rejected request. */
+  static void SetReadCoalescing(uint16_t conn_id, bool enable);
+  static void DebugDump(int fd);
+
   /* Holds pending GATT operations */
   struct gatt_operation {
     uint8_t type;
@@ -64,11 +75,27 @@ class BtaGattQueue {
     /* write-specific fields */
     tGATT_WRITE_TYPE write_type;
     std::vector<uint8_t> value;
+
+    /* read-specific fields */
+    bool no_coalesce;
+  };
+
+  /* Per connection queue statistics, latency covers the time from sending a
+   * request until its response is handled */
+  struct gatt_queue_stats {
+    size_t max_depth;
+    uint64_t requests;
+    uint64_t coalesced_reads;
+    std::chrono::microseconds total_latency;
+    std::chrono::microseconds max_latency;
+    std::chrono::steady_clock::time_point request_start;
   };
 
  private:
   static void mark_as_not_executing(uint16_t conn_id);
   static void gatt_execute_next_op(uint16_t conn_id);
+  static bool gatt_execute_read_multi(uint16_t conn_id,
+                                      std::list<gatt_operation>& gatt_ops);
   static void gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                     uint16_t handle, uint16_t len,
                                     uint8_t* value, void* data);
@@ -77,9 +104,17 @@ class BtaGattQueue {
                                      const uint8_t* value, void* data);
   static void gatt_configure_mtu_op_finished(uint16_t conn_id,
                                              tGATT_STATUS status, void* data);
+  static void gatt_read_multi_op_finished(uint16_t conn_id,
+                                          tGATT_STATUS status,
+                                          const tBTA_GATTC_MULTI& handles,
+                                          uint16_t len, uint8_t* value,
+                                          void* data);
 
   // maps connection id to operations waiting for execution
   static std::unordered_map<uint16_t, std::list<gatt_operation>> gatt_op_queue;
   // contain connection ids that currently execute operations
   static std::unordered_set<uint16_t> gatt_op_queue_executing;
+  // contain connection ids that opted in to read coalescing
+  static std::unordered_set<uint16_t> gatt_op_queue_read_coalescing;
+  static std::unordered_map<uint16_t, gatt_queue_stats> gatt_op_queue_stats;
 };
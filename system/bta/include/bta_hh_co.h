@@ -54,6 +54,23 @@ extern void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
                            uint8_t ctry_code, const RawAddress& peer_addr,
                            uint8_t app_id);
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_le_input_data
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report is notified by a LE HID device. The report ID is
+ *                  put in front of the data unless it is 0.
+ *
+ *                  rx_time_us is the time the notification was received at.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+extern void bta_hh_co_le_input_data(uint8_t dev_handle, uint8_t rpt_id,
+                                    const uint8_t* p_data, uint16_t len,
+                                    uint64_t rx_time_us);
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_open
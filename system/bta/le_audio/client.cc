@@ -623,9 +623,11 @@ class LeAudioClientImpl : public LeAudioClient {
     bool result = groupStateMachine_->StartStream(
         group, static_cast<LeAudioContextType>(final_context_type),
         GetCcid(static_cast<LeAudioContextType>(final_context_type)));
-    if (result)
+    if (result) {
       stream_setup_start_timestamp_ =
           bluetooth::common::time_get_os_boottime_us();
+      le_audio::MetricsCollector::Get()->OnStreamStartRequested(group_id);
+    }
 
     return result;
   }
@@ -989,6 +991,13 @@ class LeAudioClientImpl : public LeAudioClient {
     BackgroundConnectIfGroupConnected(leAudioDevice);
   }
 
+  /* Drops the configurations found for the group of |leAudioDevice|, as its
+   * capabilities changed */
+  void InvalidateGroupConfigurations(LeAudioDevice* leAudioDevice) {
+    LeAudioDeviceGroup* group = aseGroups_.FindById(leAudioDevice->group_id_);
+    if (group) group->InvalidateCachedConfigurations();
+  }
+
   void DisconnectDevice(LeAudioDevice* leAudioDevice,
                         bool acl_force_disconnect = false) {
     if (leAudioDevice->conn_id_ == GATT_INVALID_CONN_ID) {
@@ -1086,8 +1095,10 @@ class LeAudioClientImpl : public LeAudioClient {
        * Read of available context during initial attribute discovery.
        * Group would be assigned once service search is completed.
        */
-      if (group)
+      if (group) {
+        group->InvalidateCachedConfigurations();
         group->UpdateActiveContextsMap(leAudioDevice->GetAvailableContexts());
+      }
 
       return;
     }
@@ -1113,8 +1124,10 @@ class LeAudioClientImpl : public LeAudioClient {
        * Read of available context during initial attribute discovery.
        * Group would be assigned once service search is completed.
        */
-      if (group)
+      if (group) {
+        group->InvalidateCachedConfigurations();
         group->UpdateActiveContextsMap(leAudioDevice->GetAvailableContexts());
+      }
 
       return;
     }
@@ -1139,6 +1152,7 @@ class LeAudioClientImpl : public LeAudioClient {
       leAudioDevice->snk_audio_locations_ = snk_audio_locations;
 
       LeAudioDeviceGroup* group = aseGroups_.FindById(leAudioDevice->group_id_);
+      if (group) group->InvalidateCachedConfigurations();
       callbacks_->OnSinkAudioLocationAvailable(leAudioDevice->address_,
                                                snk_audio_locations.to_ulong());
       /* Read of source audio locations during initial attribute discovery.
@@ -1170,6 +1184,7 @@ class LeAudioClientImpl : public LeAudioClient {
       leAudioDevice->src_audio_locations_ = src_audio_locations;
 
       LeAudioDeviceGroup* group = aseGroups_.FindById(leAudioDevice->group_id_);
+      if (group) group->InvalidateCachedConfigurations();
       /* Read of source audio locations during initial attribute discovery.
        * Group would be assigned once service search is completed.
        */
@@ -1274,6 +1289,12 @@ class LeAudioClientImpl : public LeAudioClient {
     leAudioDevice->connecting_actively_ = false;
     leAudioDevice->conn_id_ = conn_id;
 
+    /* The PACs, ASEs and audio locations are read back to back on every
+     * connection. The queue falls back to single reads when the peer does not
+     * support Read Multiple Variable Length.
+     */
+    BtaGattQueue::SetReadCoalescing(conn_id, true);
+
     if (mtu == GATT_DEF_BLE_MTU_SIZE) {
       LOG(INFO) << __func__ << ", Configure MTU";
       BtaGattQueue::ConfigureMtu(leAudioDevice->conn_id_, 240);
@@ -1485,6 +1506,9 @@ class LeAudioClientImpl : public LeAudioClient {
     leAudioDevice->known_service_handles_ = false;
     leAudioDevice->csis_member_ = false;
     BtaGattQueue::Clean(leAudioDevice->conn_id_);
+    if (leAudioDevice->conn_id_ != GATT_INVALID_CONN_ID) {
+      BtaGattQueue::SetReadCoalescing(leAudioDevice->conn_id_, true);
+    }
     DeregisterNotifications(leAudioDevice);
   }
 
@@ -1580,6 +1604,7 @@ class LeAudioClientImpl : public LeAudioClient {
 
     /* Refresh PACs handles */
     leAudioDevice->ClearPACs();
+    InvalidateGroupConfigurations(leAudioDevice);
 
     for (const gatt::Characteristic& charac : pac_svc->characteristics) {
       if (charac.uuid ==
@@ -1757,6 +1782,7 @@ class LeAudioClientImpl : public LeAudioClient {
 
     /* Refresh ASE handles */
     leAudioDevice->ases_.clear();
+    InvalidateGroupConfigurations(leAudioDevice);
 
     for (const gatt::Characteristic& charac : ase_svc->characteristics) {
       LOG(INFO) << "Found characteristic, uuid: " << charac.uuid.ToString();
@@ -2678,6 +2704,7 @@ class LeAudioClientImpl : public LeAudioClient {
         (int)((stream_setup_end_timestamp_ - stream_setup_start_timestamp_) /
               1000));
     printCurrentStreamConfiguration(fd);
+    le_audio::MetricsCollector::Get()->Dump(fd);
     dprintf(fd, "  ----------------\n ");
     dprintf(fd, "  LE Audio Groups:\n");
     aseGroups_.Dump(fd);
@@ -58,6 +58,7 @@ void LeAudioDeviceGroup::AddNode(
     const std::shared_ptr<LeAudioDevice>& leAudioDevice) {
   leAudioDevice->group_id_ = group_id_;
   leAudioDevices_.push_back(std::weak_ptr<LeAudioDevice>(leAudioDevice));
+  InvalidateCachedConfigurations();
   MetricsCollector::Get()->OnGroupSizeUpdate(group_id_, leAudioDevices_.size());
 }
 
@@ -75,6 +76,7 @@ void LeAudioDeviceGroup::RemoveNode(
           leAudioDevices_.begin(), leAudioDevices_.end(),
           [&leAudioDevice](auto& d) { return d.lock() == leAudioDevice; }),
       leAudioDevices_.end());
+  InvalidateCachedConfigurations();
   MetricsCollector::Get()->OnGroupSizeUpdate(group_id_, leAudioDevices_.size());
 }
 
@@ -1199,9 +1201,61 @@ void LeAudioDeviceGroup::SetPendingConfiguration(void) {
   stream_conf.pending_configuration = true;
 }
 
+void LeAudioDeviceGroup::InvalidateCachedConfigurations(void) {
+  configuration_cache_.clear();
+}
+
+/* Returns the state of the devices the supported configurations depend on,
+ * besides their capabilities: two bits per device, telling if it is connected
+ * and if |context_type| is available on it. Returns std::nullopt if the group
+ * has too many devices to fit. */
+std::optional<uint64_t> LeAudioDeviceGroup::GetDevicesState(
+    LeAudioContextType context_type) {
+  if (leAudioDevices_.size() > 32) return std::nullopt;
+
+  AudioContexts type_set = static_cast<uint16_t>(context_type);
+  uint64_t state = 0;
+  for (size_t i = 0; i < leAudioDevices_.size(); i++) {
+    auto device = leAudioDevices_[i].lock();
+    if (!device) continue;
+    if (device->conn_id_ != GATT_INVALID_CONN_ID) state |= 1ULL << (2 * i);
+    if ((device->GetAvailableContexts() & type_set).any())
+      state |= 1ULL << (2 * i + 1);
+  }
+  return state;
+}
+
+/* Looks up the configuration found for the same context type and state of the
+ * devices, as checking every configuration against every device, ASE and PAC
+ * is expensive. */
 const set_configurations::AudioSetConfiguration*
 LeAudioDeviceGroup::FindFirstSupportedConfiguration(
     LeAudioContextType context_type) {
+  auto devices_state = GetDevicesState(context_type);
+  if (!devices_state) {
+    return FindFirstSupportedConfigurationUncached(context_type);
+  }
+
+  auto key = std::make_pair(context_type, *devices_state);
+  auto it = configuration_cache_.find(key);
+  if (it != configuration_cache_.end()) {
+    DLOG(INFO) << __func__ << " context type: " << (int)context_type
+               << " cached: "
+               << (it->second != nullptr ? it->second->name : "none");
+    return it->second;
+  }
+
+  /* Only a few states of the devices are expected */
+  if (configuration_cache_.size() >= 64) configuration_cache_.clear();
+
+  auto conf = FindFirstSupportedConfigurationUncached(context_type);
+  configuration_cache_[key] = conf;
+  return conf;
+}
+
+const set_configurations::AudioSetConfiguration*
+LeAudioDeviceGroup::FindFirstSupportedConfigurationUncached(
+    LeAudioContextType context_type) {
   const set_configurations::AudioSetConfigurations* confs =
       AudioSetConfigurationProvider::Get()->GetConfigurations(context_type);
 
@@ -21,6 +21,7 @@
 #include <memory>
 #include <optional>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "bt_types.h"
@@ -259,6 +260,9 @@ class LeAudioDeviceGroup {
   bool IsContextSupported(types::LeAudioContextType group_context_type);
   bool IsMetadataChanged(types::LeAudioContextType group_context_type,
                          int ccid);
+  /* Drops the configurations found for the context types. Shall be called when
+   * the PACs, audio locations or ASEs of a device of the group changed. */
+  void InvalidateCachedConfigurations(void);
 
   inline types::AseState GetState(void) const { return current_state_; }
   void SetState(types::AseState state) {
@@ -293,6 +297,11 @@ class LeAudioDeviceGroup {
 
   const set_configurations::AudioSetConfiguration*
   FindFirstSupportedConfiguration(types::LeAudioContextType context_type);
+  const set_configurations::AudioSetConfiguration*
+  FindFirstSupportedConfigurationUncached(
+      types::LeAudioContextType context_type);
+  std::optional<uint64_t> GetDevicesState(
+      types::LeAudioContextType context_type);
   bool ConfigureAses(
       const set_configurations::AudioSetConfiguration* audio_set_conf,
       types::LeAudioContextType context_type, int ccid = 1);
@@ -309,6 +318,13 @@ class LeAudioDeviceGroup {
            const set_configurations::AudioSetConfiguration*>
       active_context_to_configuration_map;
 
+  /* Configurations found for the context types, by the state of the devices
+   * returned by GetDevicesState(). Dropped when the capabilities of the
+   * devices change. */
+  std::map<std::pair<types::LeAudioContextType, uint64_t>,
+           const set_configurations::AudioSetConfiguration*>
+      configuration_cache_;
+
   types::AseState target_state_;
   types::AseState current_state_;
   types::LeAudioContextType context_type_;
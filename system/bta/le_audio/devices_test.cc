@@ -38,9 +38,11 @@ namespace {
 using ::le_audio::LeAudioDevice;
 using ::le_audio::LeAudioDeviceGroup;
 using ::le_audio::LeAudioDevices;
+using ::le_audio::set_configurations::AudioSetConfiguration;
 using ::le_audio::types::AseState;
 using ::le_audio::types::AudioContexts;
 using ::le_audio::types::LeAudioContextType;
+using ::le_audio::types::LeAudioLc3Config;
 using testing::Test;
 
 RawAddress GetTestAddress(int index) {
@@ -507,6 +509,7 @@ class LeAudioAseConfigurationTest : public Test {
       data[i].device->snk_pacs_ = snk_pac_builder.Get();
       data[i].device->src_pacs_ = src_pac_builder.Get();
     }
+    group_->InvalidateCachedConfigurations();
 
     /* Stimulate update of active context map */
     group_->UpdateActiveContextsMap(static_cast<uint16_t>(context_type));
@@ -548,6 +551,7 @@ class LeAudioAseConfigurationTest : public Test {
         data[i].device->snk_pacs_ = snk_pac_builder.Get();
         data[i].device->src_pacs_ = src_pac_builder.Get();
       }
+      group_->InvalidateCachedConfigurations();
 
       /* Stimulate update of active context map */
       group_->UpdateActiveContextsMap(static_cast<uint16_t>(context_type));
@@ -630,6 +634,7 @@ class LeAudioAseConfigurationTest : public Test {
               device->snk_pacs_ = pac_builder.Get();
               device->src_pacs_ = pac_builder.Get();
             }
+            group_->InvalidateCachedConfigurations();
 
             bool success_expected = is_lc3_setting_supported;
             if (is_lc3_setting_supported &&
@@ -917,6 +922,149 @@ TEST_F(LeAudioAseConfigurationTest, test_reconnection_media) {
 
   TestActiveAses();
 }
+
+TEST_F(LeAudioAseConfigurationTest, test_configuration_cache) {
+  LeAudioDevice* left = AddTestDevice(2, 1);
+  LeAudioDevice* right = AddTestDevice(2, 1);
+
+  TestGroupAseConfigurationData data[] = {
+      {left, kLeAudioCodecLC3ChannelCountSingleChannel,
+       kLeAudioCodecLC3ChannelCountSingleChannel, 1, 0},
+      {right, kLeAudioCodecLC3ChannelCountSingleChannel,
+       kLeAudioCodecLC3ChannelCountSingleChannel, 1, 0}};
+
+  auto all_configurations =
+      ::le_audio::AudioSetConfigurationProvider::Get()->GetConfigurations(
+          LeAudioContextType::MEDIA);
+  ASSERT_NE(nullptr, all_configurations);
+  ASSERT_NE(all_configurations->end(), all_configurations->begin());
+  auto configuration = *all_configurations->begin();
+
+  TestSingleAseConfiguration(LeAudioContextType::MEDIA, data, 2, configuration);
+  ASSERT_TRUE(group_->IsContextSupported(LeAudioContextType::MEDIA));
+  group_->Deactivate();
+
+  /* The configurations found are kept for each state of the devices, until
+   * the capabilities of the devices are invalidated */
+  const LeAudioCodecId UnsupportedCodecId = {
+      .coding_format = kLeAudioCodingFormatVendorSpecific,
+      .vendor_company_id = 0xBAD,
+      .vendor_codec_id = 0xC0DE,
+  };
+  PublishedAudioCapabilitiesBuilder pac_builder;
+  pac_builder.Add(UnsupportedCodecId,
+                  GetSamplingFrequency(Lc3SettingId::LC3_16_2),
+                  GetFrameDuration(Lc3SettingId::LC3_16_2),
+                  kLeAudioCodecLC3ChannelCountSingleChannel,
+                  GetOctetsPerCodecFrame(Lc3SettingId::LC3_16_2));
+  for (auto& device : devices_) {
+    device->snk_pacs_ = pac_builder.Get();
+    device->src_pacs_ = pac_builder.Get();
+  }
+
+  uint16_t right_conn_id = right->conn_id_;
+  right->conn_id_ = GATT_INVALID_CONN_ID;
+  group_->UpdateActiveContextsMap(
+      static_cast<uint16_t>(LeAudioContextType::MEDIA));
+  ASSERT_FALSE(group_->IsContextSupported(LeAudioContextType::MEDIA));
+
+  right->conn_id_ = right_conn_id;
+  group_->UpdateActiveContextsMap(
+      static_cast<uint16_t>(LeAudioContextType::MEDIA));
+  ASSERT_TRUE(group_->IsContextSupported(LeAudioContextType::MEDIA));
+
+  group_->InvalidateCachedConfigurations();
+  group_->UpdateActiveContextsMap(
+      static_cast<uint16_t>(LeAudioContextType::MEDIA));
+  ASSERT_FALSE(group_->IsContextSupported(LeAudioContextType::MEDIA));
+}
+
+static std::string GetConfigurationProviderDump() {
+  FILE* file = tmpfile();
+  ::le_audio::AudioSetConfigurationProvider::DebugDump(fileno(file));
+  fflush(file);
+  rewind(file);
+
+  std::string dump;
+  char buf[256];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0) dump.append(buf, len);
+  fclose(file);
+  return dump;
+}
+
+/* Copies the configurations, so that they outlive their provider */
+static std::map<LeAudioContextType, std::vector<AudioSetConfiguration>>
+GetAllConfigurations() {
+  std::map<LeAudioContextType, std::vector<AudioSetConfiguration>> result;
+  for (auto context : ::le_audio::types::kLeAudioContextAllTypesArray) {
+    auto confs =
+        ::le_audio::AudioSetConfigurationProvider::Get()->GetConfigurations(
+            context);
+    if (confs == nullptr) continue;
+    for (auto conf : *confs) result[context].push_back(*conf);
+  }
+  return result;
+}
+
+static void ExpectSameConfiguration(const AudioSetConfiguration& expected,
+                                    const AudioSetConfiguration& actual) {
+  ASSERT_EQ(expected.name, actual.name);
+  ASSERT_EQ(expected.confs.size(), actual.confs.size());
+
+  for (size_t i = 0; i < expected.confs.size(); i++) {
+    auto& expected_ent = expected.confs[i];
+    auto& actual_ent = actual.confs[i];
+    EXPECT_EQ(expected_ent.direction, actual_ent.direction);
+    EXPECT_EQ(expected_ent.device_cnt, actual_ent.device_cnt);
+    EXPECT_EQ(expected_ent.ase_cnt, actual_ent.ase_cnt);
+    EXPECT_EQ(expected_ent.target_latency, actual_ent.target_latency);
+    EXPECT_EQ(expected_ent.strategy, actual_ent.strategy);
+    EXPECT_EQ(expected_ent.qos.retransmission_number,
+              actual_ent.qos.retransmission_number);
+    EXPECT_EQ(expected_ent.qos.max_transport_latency,
+              actual_ent.qos.max_transport_latency);
+    EXPECT_EQ(expected_ent.codec.id, actual_ent.codec.id);
+
+    auto& expected_lc3 = std::get<LeAudioLc3Config>(expected_ent.codec.config);
+    auto& actual_lc3 = std::get<LeAudioLc3Config>(actual_ent.codec.config);
+    EXPECT_EQ(expected_lc3.sampling_frequency, actual_lc3.sampling_frequency);
+    EXPECT_EQ(expected_lc3.frame_duration, actual_lc3.frame_duration);
+    EXPECT_EQ(expected_lc3.audio_channel_allocation,
+              actual_lc3.audio_channel_allocation);
+    EXPECT_EQ(expected_lc3.octets_per_codec_frame,
+              actual_lc3.octets_per_codec_frame);
+    EXPECT_EQ(expected_lc3.codec_frames_blocks_per_sdu,
+              actual_lc3.codec_frames_blocks_per_sdu);
+    EXPECT_EQ(expected_lc3.channel_count, actual_lc3.channel_count);
+  }
+}
+
+TEST(LeAudioSetConfigurationProviderTest, test_binary_matches_json) {
+  ::le_audio::AudioSetConfigurationProvider::Initialize(true);
+  ASSERT_THAT(GetConfigurationProviderDump(),
+              testing::HasSubstr("Loaded from JSON"));
+  auto json_configurations = GetAllConfigurations();
+  ::le_audio::AudioSetConfigurationProvider::Cleanup();
+
+  ::le_audio::AudioSetConfigurationProvider::Initialize();
+  ASSERT_THAT(GetConfigurationProviderDump(),
+              testing::HasSubstr("Loaded from binary"));
+  auto binary_configurations = GetAllConfigurations();
+  ::le_audio::AudioSetConfigurationProvider::Cleanup();
+
+  ASSERT_FALSE(json_configurations.empty());
+  ASSERT_EQ(json_configurations.size(), binary_configurations.size());
+  for (auto& [context, expected_confs] : json_configurations) {
+    SCOPED_TRACE(static_cast<int>(context));
+    ASSERT_EQ(1u, binary_configurations.count(context));
+    auto& actual_confs = binary_configurations[context];
+    ASSERT_EQ(expected_confs.size(), actual_confs.size());
+    for (size_t i = 0; i < expected_confs.size(); i++) {
+      ExpectSameConfiguration(expected_confs[i], actual_confs[i]);
+    }
+  }
+}
 }  // namespace
 }  // namespace internal
 }  // namespace le_audio
@@ -27,7 +27,10 @@ class AudioSetConfigurationProvider {
   AudioSetConfigurationProvider();
   virtual ~AudioSetConfigurationProvider() = default;
   static AudioSetConfigurationProvider* Get();
-  static void Initialize();
+  /* Loads the configurations from the JSON files instead of the precompiled
+   * binary ones when from_json is set.
+   */
+  static void Initialize(bool from_json = false);
   static void DebugDump(int fd);
   static void Cleanup();
   virtual const set_configurations::AudioSetConfigurations* GetConfigurations(
@@ -15,16 +15,24 @@
  *
  */
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mutex>
 #include <string>
 #include <string_view>
 
 #include "audio_set_configurations_generated.h"
 #include "audio_set_scenarios_generated.h"
 #include "codec_manager.h"
+#include "common/time_util.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 #include "le_audio_set_configuration_provider.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
 
 using le_audio::set_configurations::AudioSetConfiguration;
 using le_audio::set_configurations::AudioSetConfigurations;
@@ -51,6 +59,12 @@ static const std::vector<
                              "le_audio/audio_set_scenarios.bfbs",
                              "/apex/com.android.btservices/etc/bluetooth/"
                              "le_audio/audio_set_scenarios.json"}};
+static const char* kLeAudioSetConfigsBinary =
+    "/apex/com.android.btservices/etc/bluetooth/le_audio/"
+    "audio_set_configurations.bin";
+static const char* kLeAudioSetScenariosBinary =
+    "/apex/com.android.btservices/etc/bluetooth/le_audio/"
+    "audio_set_scenarios.bin";
 #else
 static const std::vector<
     std::pair<const char* /*schema*/, const char* /*content*/>>
@@ -60,19 +74,81 @@ static const std::vector<
     std::pair<const char* /*schema*/, const char* /*content*/>>
     kLeAudioSetScenarios = {
         {"audio_set_scenarios.bfbs", "audio_set_scenarios.json"}};
+static const char* kLeAudioSetConfigsBinary = "audio_set_configurations.bin";
+static const char* kLeAudioSetScenariosBinary = "audio_set_scenarios.bin";
 #endif
 
+/* Forces the configurations to be parsed from the JSON files, so that they can
+ * be overridden without rebuilding the binary ones.
+ */
+static const char* kLeAudioSetConfigsFromJsonProperty =
+    "persist.bluetooth.leaudio.set_configurations_from_json";
+
+/** Read only mapping of a binary flatbuffer file */
+class FlatBufferFileMapping {
+ public:
+  FlatBufferFileMapping() = default;
+  FlatBufferFileMapping(const FlatBufferFileMapping&) = delete;
+  FlatBufferFileMapping& operator=(const FlatBufferFileMapping&) = delete;
+  ~FlatBufferFileMapping() {
+    if (data_ != nullptr) munmap(data_, size_);
+  }
+
+  bool Map(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    data_ = data;
+    size_ = st.st_size;
+    return true;
+  }
+
+  const uint8_t* data() const { return static_cast<const uint8_t*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 /** Provides a set configurations for the given context type */
-struct AudioSetConfigurationProviderJson {
-  AudioSetConfigurationProviderJson() {
-    ASSERT_LOG(LoadContent(kLeAudioSetConfigs, kLeAudioSetScenarios),
-               ": Unable to load le audio set configuration files.");
+struct AudioSetConfigurationProviderFlat {
+  explicit AudioSetConfigurationProviderFlat(bool from_json) {
+    uint64_t start_us = bluetooth::common::time_get_os_boottime_us();
+
+    if (!from_json &&
+        !osi_property_get_bool(kLeAudioSetConfigsFromJsonProperty, false) &&
+        LoadBinaryContent(kLeAudioSetConfigsBinary,
+                          kLeAudioSetScenariosBinary)) {
+      source_ = "binary";
+    } else {
+      ASSERT_LOG(LoadContent(kLeAudioSetConfigs, kLeAudioSetScenarios),
+                 ": Unable to load le audio set configuration files.");
+      source_ = "JSON";
+    }
+
+    load_time_us_ = bluetooth::common::time_get_os_boottime_us() - start_us;
+    LOG_INFO(": Loaded le audio set configurations from %s in %llu us",
+             source_, (unsigned long long)load_time_us_);
   }
 
+  const char* GetSource() const { return source_; }
+  uint64_t GetLoadTimeUs() const { return load_time_us_; }
+
   const AudioSetConfigurations* GetConfigurationsByContextType(
       LeAudioContextType context_type) const {
-    if (context_configurations_.count(context_type))
-      return &context_configurations_.at(context_type);
+    auto confs = FindConfigurations(context_type);
+    if (confs != nullptr) return confs;
 
     LOG_WARN(": No predefined scenario for the context %d was found.",
              (int)context_type);
@@ -80,9 +156,10 @@ struct AudioSetConfigurationProviderJson {
     auto fallback_scenario = "Default";
     context_type = ScenarioToContextType(fallback_scenario);
 
-    if (context_configurations_.count(context_type)) {
+    confs = FindConfigurations(context_type);
+    if (confs != nullptr) {
       LOG_WARN(": Using %s scenario by default.", fallback_scenario);
-      return &context_configurations_.at(context_type);
+      return confs;
     }
 
     LOG_ERROR(
@@ -92,13 +169,30 @@ struct AudioSetConfigurationProviderJson {
   };
 
  private:
+  const char* source_ = nullptr;
+  uint64_t load_time_us_ = 0;
+
+  /* Guards the configurations built on demand from the binary content */
+  mutable std::mutex mutex_;
+
   /* Codec configurations */
-  std::map<std::string, const AudioSetConfiguration> configurations_;
+  mutable std::map<std::string, const AudioSetConfiguration> configurations_;
 
   /* Maps of context types to a set of configuration structs */
-  std::map<::le_audio::types::LeAudioContextType, AudioSetConfigurations>
+  mutable std::map<::le_audio::types::LeAudioContextType,
+                   AudioSetConfigurations>
       context_configurations_;
 
+  /* Binary content, from which the configurations are built on demand. Not
+   * set when the configurations were loaded from the JSON files.
+   */
+  std::unique_ptr<FlatBufferFileMapping> configs_mapping_;
+  std::unique_ptr<FlatBufferFileMapping> scenarios_mapping_;
+  const bluetooth::le_audio::AudioSetConfigurations* flat_configs_ = nullptr;
+  const bluetooth::le_audio::AudioSetScenarios* flat_scenarios_ = nullptr;
+  std::vector<const bluetooth::le_audio::CodecConfiguration*> codec_cfgs_;
+  std::vector<const bluetooth::le_audio::QosConfiguration*> qos_cfgs_;
+
   static const bluetooth::le_audio::CodecSpecificConfiguration*
   LookupCodecSpecificParam(
       const flatbuffers::Vector<
@@ -205,7 +299,7 @@ struct AudioSetConfigurationProviderJson {
     return codec;
   }
 
-  SetConfiguration SetConfigurationFromFlatSubconfig(
+  static SetConfiguration SetConfigurationFromFlatSubconfig(
       const bluetooth::le_audio::AudioSetSubConfiguration* flat_subconfig,
       QosConfigSetting qos) {
     auto strategy_int =
@@ -239,10 +333,12 @@ struct AudioSetConfigurationProviderJson {
         qos, strategy);
   }
 
-  AudioSetConfiguration AudioSetConfigurationFromFlat(
+  static AudioSetConfiguration AudioSetConfigurationFromFlat(
       const bluetooth::le_audio::AudioSetConfiguration* flat_cfg,
-      std::vector<const bluetooth::le_audio::CodecConfiguration*>* codec_cfgs,
-      std::vector<const bluetooth::le_audio::QosConfiguration*>* qos_cfgs) {
+      const std::vector<const bluetooth::le_audio::CodecConfiguration*>*
+          codec_cfgs,
+      const std::vector<const bluetooth::le_audio::QosConfiguration*>*
+          qos_cfgs) {
     ASSERT_LOG(flat_cfg != nullptr, "flat_cfg cannot be null");
     std::string codec_config_key = flat_cfg->codec_config_name()->str();
     auto* qos_config_key_array = flat_cfg->qos_config_name();
@@ -397,21 +493,60 @@ struct AudioSetConfigurationProviderJson {
     return true;
   }
 
+  const AudioSetConfiguration* FindConfiguration(
+      const std::string& name) const {
+    auto it = configurations_.find(name);
+    if (it != configurations_.end()) return &it->second;
+    if (flat_configs_ == nullptr) return nullptr;
+
+    for (auto const& flat_cfg : *flat_configs_->configurations()) {
+      if (flat_cfg->name()->str() != name) continue;
+
+      return &configurations_
+                  .insert({name, AudioSetConfigurationFromFlat(
+                                     flat_cfg, &codec_cfgs_, &qos_cfgs_)})
+                  .first->second;
+    }
+    return nullptr;
+  }
+
   AudioSetConfigurations AudioSetConfigurationsFromFlatScenario(
-      const bluetooth::le_audio::AudioSetScenario* const flat_scenario) {
+      const bluetooth::le_audio::AudioSetScenario* const flat_scenario) const {
     AudioSetConfigurations items;
     if (!flat_scenario->configurations()) return items;
 
     for (auto config_name : *flat_scenario->configurations()) {
-      if (configurations_.count(config_name->str()) == 0) continue;
-
-      auto& cfg = configurations_.at(config_name->str());
-      items.push_back(&cfg);
+      auto cfg = FindConfiguration(config_name->str());
+      if (cfg != nullptr) items.push_back(cfg);
     }
 
     return items;
   }
 
+  const AudioSetConfigurations* FindConfigurations(
+      LeAudioContextType context_type) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = context_configurations_.find(context_type);
+    if (it != context_configurations_.end()) return &it->second;
+    if (flat_scenarios_ == nullptr) return nullptr;
+
+    /* As with the JSON content, the last scenario for a context type wins */
+    const bluetooth::le_audio::AudioSetScenario* flat_scenario = nullptr;
+    for (auto const& scenario : *flat_scenarios_->scenarios()) {
+      if (ScenarioToContextType(scenario->name()->c_str()) == context_type)
+        flat_scenario = scenario;
+    }
+    if (flat_scenario == nullptr) return nullptr;
+
+    LOG_DEBUG(": Building configurations for the context %d.",
+              (int)context_type);
+    return &context_configurations_
+                .insert_or_assign(
+                    context_type,
+                    AudioSetConfigurationsFromFlatScenario(flat_scenario))
+                .first->second;
+  }
+
   bool LoadScenariosFromFiles(const char* schema_file,
                               const char* content_file) {
     flatbuffers::Parser scenarios_parser_;
@@ -454,6 +589,63 @@ struct AudioSetConfigurationProviderJson {
     return true;
   }
 
+  /* Maps the configurations precompiled into binary flatbuffers. Only the
+   * scenarios requested later are turned into configuration structs.
+   */
+  bool LoadBinaryContent(const char* config_file, const char* scenario_file) {
+    auto configs_mapping = std::make_unique<FlatBufferFileMapping>();
+    auto scenarios_mapping = std::make_unique<FlatBufferFileMapping>();
+    if (!configs_mapping->Map(config_file) ||
+        !scenarios_mapping->Map(scenario_file)) {
+      LOG_INFO(": No binary le audio set configurations, using JSON.");
+      return false;
+    }
+
+    flatbuffers::Verifier configs_verifier(configs_mapping->data(),
+                                           configs_mapping->size());
+    flatbuffers::Verifier scenarios_verifier(scenarios_mapping->data(),
+                                             scenarios_mapping->size());
+    if (!bluetooth::le_audio::VerifyAudioSetConfigurationsBuffer(
+            configs_verifier) ||
+        !bluetooth::le_audio::VerifyAudioSetScenariosBuffer(
+            scenarios_verifier)) {
+      LOG_ERROR(": Invalid binary le audio set configurations, using JSON.");
+      return false;
+    }
+
+    auto configurations_root =
+        bluetooth::le_audio::GetAudioSetConfigurations(configs_mapping->data());
+    auto scenarios_root =
+        bluetooth::le_audio::GetAudioSetScenarios(scenarios_mapping->data());
+
+    if (!configurations_root || !scenarios_root) return false;
+
+    auto flat_qos_configs = configurations_root->qos_configurations();
+    auto flat_codec_configs = configurations_root->codec_configurations();
+    auto flat_configs = configurations_root->configurations();
+    auto flat_scenarios = scenarios_root->scenarios();
+    if ((flat_qos_configs == nullptr) || (flat_qos_configs->size() == 0) ||
+        (flat_codec_configs == nullptr) || (flat_codec_configs->size() == 0) ||
+        (flat_configs == nullptr) || (flat_configs->size() == 0) ||
+        (flat_scenarios == nullptr) || (flat_scenarios->size() == 0)) {
+      LOG_ERROR(": Empty binary le audio set configurations, using JSON.");
+      return false;
+    }
+
+    for (auto const& flat_qos_cfg : *flat_qos_configs) {
+      qos_cfgs_.push_back(flat_qos_cfg);
+    }
+    for (auto const& flat_codec_cfg : *flat_codec_configs) {
+      codec_cfgs_.push_back(flat_codec_cfg);
+    }
+
+    configs_mapping_ = std::move(configs_mapping);
+    scenarios_mapping_ = std::move(scenarios_mapping);
+    flat_configs_ = configurations_root;
+    flat_scenarios_ = scenarios_root;
+    return true;
+  }
+
   bool LoadContent(
       std::vector<std::pair<const char* /*schema*/, const char* /*content*/>>
           config_files,
@@ -506,10 +698,10 @@ struct AudioSetConfigurationProvider::impl {
   impl(const AudioSetConfigurationProvider& config_provider)
       : config_provider_(config_provider) {}
 
-  void Initialize() {
+  void Initialize(bool from_json) {
     ASSERT_LOG(!config_provider_impl_, " Config provider not available.");
     config_provider_impl_ =
-        std::make_unique<AudioSetConfigurationProviderJson>();
+        std::make_unique<AudioSetConfigurationProviderFlat>(from_json);
   }
 
   void Cleanup() {
@@ -522,6 +714,9 @@ struct AudioSetConfigurationProvider::impl {
   void Dump(int fd) {
     std::stringstream stream;
 
+    stream << "  Loaded from " << config_provider_impl_->GetSource() << " in "
+           << config_provider_impl_->GetLoadTimeUs() << " us\n";
+
     for (LeAudioContextType context : types::kLeAudioContextAllTypesArray) {
       auto confs = Get()->GetConfigurations(context);
       stream << "\n  === Configurations for context type: " << (int)context
@@ -552,7 +747,7 @@ struct AudioSetConfigurationProvider::impl {
   }
 
   const AudioSetConfigurationProvider& config_provider_;
-  std::unique_ptr<AudioSetConfigurationProviderJson> config_provider_impl_;
+  std::unique_ptr<AudioSetConfigurationProviderFlat> config_provider_impl_;
 };
 
 static std::unique_ptr<AudioSetConfigurationProvider> config_provider;
@@ -560,12 +755,12 @@ static std::unique_ptr<AudioSetConfigurationProvider> config_provider;
 AudioSetConfigurationProvider::AudioSetConfigurationProvider()
     : pimpl_(std::make_unique<AudioSetConfigurationProvider::impl>(*this)) {}
 
-void AudioSetConfigurationProvider::Initialize() {
+void AudioSetConfigurationProvider::Initialize(bool from_json) {
   if (!config_provider)
     config_provider = std::make_unique<AudioSetConfigurationProvider>();
 
   if (!config_provider->pimpl_->IsRunning())
-    config_provider->pimpl_->Initialize();
+    config_provider->pimpl_->Initialize(from_json);
 }
 
 void AudioSetConfigurationProvider::DebugDump(int fd) {
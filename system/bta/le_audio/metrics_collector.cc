@@ -16,8 +16,11 @@
 
 #include "metrics_collector.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 #include "common/metrics.h"
@@ -118,6 +121,8 @@ class GroupMetricsImpl : public GroupMetrics {
   std::vector<int64_t> streaming_offset_nanos_;
   std::vector<int64_t> streaming_duration_nanos_;
   std::vector<int32_t> streaming_context_type_;
+  ClockTimePoint stream_start_requested_timepoint_ = kInvalidTimePoint;
+  std::vector<int64_t> stream_start_latency_nanos_;
 
  public:
   GroupMetricsImpl() : group_id_(kInvalidGroupId), group_size_(0) {
@@ -145,6 +150,11 @@ class GroupMetricsImpl : public GroupMetrics {
     }
   }
 
+  void AddStreamStartRequestedEvent() override {
+    stream_start_requested_timepoint_ =
+        std::chrono::high_resolution_clock::now();
+  }
+
   void AddStreamStartedEvent(
       le_audio::types::LeAudioContextType context_type) override {
     int32_t atom_context_type = to_atom_context_type(context_type);
@@ -159,9 +169,16 @@ class GroupMetricsImpl : public GroupMetrics {
         return;
       }
     }
-    streaming_offset_nanos_.push_back(get_timedelta_nanos(
-        std::chrono::high_resolution_clock::now(), beginning_timepoint_));
+    auto now = std::chrono::high_resolution_clock::now();
+    streaming_offset_nanos_.push_back(
+        get_timedelta_nanos(now, beginning_timepoint_));
     streaming_context_type_.push_back(atom_context_type);
+    // Streams resumed without a new request are not measured
+    if (stream_start_requested_timepoint_ != kInvalidTimePoint) {
+      stream_start_latency_nanos_.push_back(
+          get_timedelta_nanos(now, stream_start_requested_timepoint_));
+      stream_start_requested_timepoint_ = kInvalidTimePoint;
+    }
   }
 
   void AddStreamEndedEvent() override {
@@ -226,6 +243,25 @@ class GroupMetricsImpl : public GroupMetrics {
     }
     WriteStats();
   }
+
+  void Dump(int fd) override {
+    dprintf(fd, "    Group %d stream start latency: ", group_id_);
+    if (stream_start_latency_nanos_.empty()) {
+      dprintf(fd, "no stream started\n");
+      return;
+    }
+    int64_t max_nanos = *std::max_element(stream_start_latency_nanos_.begin(),
+                                          stream_start_latency_nanos_.end());
+    int64_t average_nanos =
+        std::accumulate(stream_start_latency_nanos_.begin(),
+                        stream_start_latency_nanos_.end(), int64_t{0}) /
+        static_cast<int64_t>(stream_start_latency_nanos_.size());
+    dprintf(fd, "last %d ms, average %d ms, max %d ms (%zu streams)\n",
+            static_cast<int>(stream_start_latency_nanos_.back() / 1000000),
+            static_cast<int>(average_nanos / 1000000),
+            static_cast<int>(max_nanos / 1000000),
+            stream_start_latency_nanos_.size());
+  }
 };
 
 /* Metrics Colloctor */
@@ -266,6 +302,14 @@ void MetricsCollector::OnConnectionStateChanged(
   }
 }
 
+void MetricsCollector::OnStreamStartRequested(int32_t group_id) {
+  if (group_id <= 0) return;
+  auto it = opened_groups_.find(group_id);
+  if (it != opened_groups_.end()) {
+    it->second->AddStreamStartRequestedEvent();
+  }
+}
+
 void MetricsCollector::OnStreamStarted(
     int32_t group_id, le_audio::types::LeAudioContextType context_type) {
   if (group_id <= 0) return;
@@ -283,6 +327,13 @@ void MetricsCollector::OnStreamEnded(int32_t group_id) {
   }
 }
 
+void MetricsCollector::Dump(int fd) {
+  dprintf(fd, "  LE Audio metrics:\n");
+  for (auto& p : opened_groups_) {
+    p.second->Dump(fd);
+  }
+}
+
 void MetricsCollector::Flush() {
   LOG(INFO) << __func__;
   for (auto& p : opened_groups_) {
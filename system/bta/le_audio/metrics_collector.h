@@ -61,6 +61,8 @@ class GroupMetrics {
                                     bluetooth::le_audio::ConnectionState state,
                                     ConnectionStatus status) = 0;
 
+  virtual void AddStreamStartRequestedEvent() = 0;
+
   virtual void AddStreamStartedEvent(
       le_audio::types::LeAudioContextType context_type) = 0;
 
@@ -73,6 +75,8 @@ class GroupMetrics {
   virtual void WriteStats() = 0;
 
   virtual void Flush() = 0;
+
+  virtual void Dump(int fd) = 0;
 };
 
 class MetricsCollector {
@@ -101,6 +105,14 @@ class MetricsCollector {
                                 bluetooth::le_audio::ConnectionState state,
                                 ConnectionStatus status);
 
+  /**
+   * When the start of a LE Audio stream is requested, to measure the time it
+   * takes until the stream is started
+   *
+   * @param group_id Group ID of the associated stream.
+   */
+  void OnStreamStartRequested(int32_t group_id);
+
   /**
    * When there is a change in LE Audio stream started
    *
@@ -123,6 +135,13 @@ class MetricsCollector {
    */
   void Flush();
 
+  /**
+   * Dump the stream start latencies of the connected groups
+   *
+   * @param fd File descriptor to write to.
+   */
+  void Dump(int fd);
+
  protected:
   MetricsCollector() {}
 
@@ -35,6 +35,8 @@ void MetricsCollector::OnConnectionStateChanged(
     int32_t group_id, const RawAddress& address,
     bluetooth::le_audio::ConnectionState state, ConnectionStatus status) {}
 
+void MetricsCollector::OnStreamStartRequested(int32_t group_id) {}
+
 void MetricsCollector::OnStreamStarted(
     int32_t group_id, le_audio::types::LeAudioContextType context_type) {}
 
@@ -42,4 +44,6 @@ void MetricsCollector::OnStreamEnded(int32_t group_id) {}
 
 void MetricsCollector::Flush() {}
 
+void MetricsCollector::Dump(int fd) {}
+
 }  // namespace le_audio
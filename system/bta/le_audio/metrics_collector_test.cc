@@ -367,4 +367,44 @@ TEST_F(MetricsCollectorTest, StreamingSessions) {
             static_cast<int32_t>(LeAudioMetricsContextType::COMMUNICATION));
 }
 
-}  // namespace le_audio
\ No newline at end of file
+TEST_F(MetricsCollectorTest, StreamStartLatency) {
+  collector->OnConnectionStateChanged(
+      group_id1, device1, bluetooth::le_audio::ConnectionState::CONNECTING,
+      ConnectionStatus::UNKNOWN);
+  collector->OnConnectionStateChanged(
+      group_id1, device1, bluetooth::le_audio::ConnectionState::CONNECTED,
+      ConnectionStatus::SUCCESS);
+
+  auto dump = [this]() {
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    collector->Dump(fds[1]);
+    close(fds[1]);
+    std::string output;
+    char buffer[256];
+    ssize_t len;
+    while ((len = read(fds[0], buffer, sizeof(buffer))) > 0) {
+      output.append(buffer, len);
+    }
+    close(fds[0]);
+    return output;
+  };
+  ASSERT_NE(dump().find("no stream started"), std::string::npos);
+
+  collector->OnStreamStartRequested(group_id1);
+  collector->OnStreamStarted(group_id1,
+                             le_audio::types::LeAudioContextType::MEDIA);
+  collector->OnStreamEnded(group_id1);
+  // Resumed without a new request, not measured
+  collector->OnStreamStarted(group_id1,
+                             le_audio::types::LeAudioContextType::MEDIA);
+  ASSERT_NE(dump().find("(1 streams)"), std::string::npos);
+
+  collector->OnStreamEnded(group_id1);
+  collector->OnStreamStartRequested(group_id1);
+  collector->OnStreamStarted(
+      group_id1, le_audio::types::LeAudioContextType::CONVERSATIONAL);
+  ASSERT_NE(dump().find("(2 streams)"), std::string::npos);
+}
+
+}  // namespace le_audio
@@ -49,3 +49,7 @@ void BtaGattQueue::ConfigureMtu(uint16_t conn_id, uint16_t mtu) {
   LOG_ASSERT(gatt_queue) << "Mock GATT queue not set!";
   gatt_queue->ConfigureMtu(conn_id, mtu);
 }
+
+void BtaGattQueue::SetReadCoalescing(uint16_t conn_id, bool enable) {}
+
+void BtaGattQueue::DebugDump(int fd) {}
@@ -285,4 +285,29 @@ TEST(GattCacheTest,
   // LOG(ERROR) << " " << base::HexEncode(&attr, len);
   EXPECT_EQ(memcmp(binary_form, &attr, len), 0);
 }
+
+/* This test makes sure that copies of a database, as held by connections to
+ * identical servers, share their services until one of them changes */
+TEST(GattDatabaseTest, copies_share_services_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  Database db = builder.Build();
+
+  Database copy = db;
+  EXPECT_TRUE(copy.SharesServicesWith(db));
+  EXPECT_EQ(&copy.Services(), &db.Services());
+  EXPECT_EQ(copy.Hash(), db.Hash());
+
+  // Building another database does not touch the shared services
+  builder.AddService(0x0001, 0x001f, SERVICE_2_UUID, true);
+  Database other = builder.Build();
+  EXPECT_FALSE(other.SharesServicesWith(db));
+  EXPECT_EQ(db.Services().front().uuid, SERVICE_1_UUID);
+
+  copy.Clear();
+  EXPECT_TRUE(copy.IsEmpty());
+  EXPECT_FALSE(db.IsEmpty());
+  EXPECT_EQ(db.Services().front().characteristics.size(), 1u);
+}
 }  // namespace gatt
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "bt_trace.h"
+#include "bta/include/bta_gatt_queue.h"
+
+uint8_t appl_trace_level = BT_TRACE_LEVEL_WARNING;
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr uint16_t kConnId = 0x0005;
+
+/* Fake remote GATT server. Every request is answered on the next call to
+ * Pump(), so each answer counts as one round trip on the link. */
+struct FakePeer {
+  std::map<uint16_t, std::vector<uint8_t>> attributes;
+  uint16_t mtu = 23;
+  bool read_multi_var_supported = true;
+  int round_trips = 0;
+  std::deque<std::function<void()>> pending;
+
+  void Pump(int max_round_trips = INT_MAX) {
+    while (!pending.empty() && max_round_trips-- > 0) {
+      auto response = std::move(pending.front());
+      pending.pop_front();
+      round_trips++;
+      response();
+    }
+  }
+} peer;
+
+void queue_read_response(uint16_t conn_id, uint16_t handle,
+                         GATT_READ_OP_CB callback, void* cb_data) {
+  peer.pending.push_back([=] {
+    std::vector<uint8_t> value = peer.attributes[handle];
+    if (value.size() > peer.mtu - 1u) value.resize(peer.mtu - 1);
+    callback(conn_id, GATT_SUCCESS, handle, value.size(), value.data(),
+             cb_data);
+  });
+}
+
+void queue_write_response(uint16_t conn_id, uint16_t handle,
+                          std::vector<uint8_t> value, GATT_WRITE_OP_CB callback,
+                          void* cb_data) {
+  peer.pending.push_back([=] {
+    peer.attributes[handle] = value;
+    if (callback) {
+      callback(conn_id, GATT_SUCCESS, handle, value.size(), value.data(),
+               cb_data);
+    }
+  });
+}
+
+struct ReadResult {
+  tGATT_STATUS status;
+  uint16_t handle;
+  std::vector<uint8_t> value;
+};
+
+std::vector<ReadResult> reads;
+
+void on_read(uint16_t conn_id, tGATT_STATUS status, uint16_t handle,
+             uint16_t len, uint8_t* value, void* data) {
+  reads.push_back({status, handle, std::vector<uint8_t>(value, value + len)});
+}
+
+}  // namespace
+
+void BTA_GATTC_ReadCharacteristic(uint16_t conn_id, uint16_t handle,
+                                  tGATT_AUTH_REQ auth_req,
+                                  GATT_READ_OP_CB callback, void* cb_data) {
+  queue_read_response(conn_id, handle, callback, cb_data);
+}
+
+void BTA_GATTC_ReadCharDescr(uint16_t conn_id, uint16_t handle,
+                             tGATT_AUTH_REQ auth_req, GATT_READ_OP_CB callback,
+                             void* cb_data) {
+  queue_read_response(conn_id, handle, callback, cb_data);
+}
+
+void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
+                              tGATT_WRITE_TYPE write_type,
+                              std::vector<uint8_t> value,
+                              tGATT_AUTH_REQ auth_req,
+                              GATT_WRITE_OP_CB callback, void* cb_data) {
+  queue_write_response(conn_id, handle, std::move(value), callback, cb_data);
+}
+
+void BTA_GATTC_WriteCharDescr(uint16_t conn_id, uint16_t handle,
+                              std::vector<uint8_t> value,
+                              tGATT_AUTH_REQ auth_req,
+                              GATT_WRITE_OP_CB callback, void* cb_data) {
+  queue_write_response(conn_id, handle, std::move(value), callback, cb_data);
+}
+
+void BTA_GATTC_ConfigureMTU(uint16_t conn_id, uint16_t mtu) {
+  peer.pending.push_back([=] { peer.mtu = mtu; });
+}
+
+void BTA_GATTC_ConfigureMTU(uint16_t conn_id, uint16_t mtu,
+                            GATT_CONFIGURE_MTU_OP_CB callback, void* cb_data) {
+  peer.pending.push_back([=] {
+    peer.mtu = mtu;
+    callback(conn_id, GATT_SUCCESS, cb_data);
+  });
+}
+
+void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
+                            bool variable_len, tGATT_AUTH_REQ auth_req,
+                            GATT_READ_MULTI_OP_CB callback, void* cb_data) {
+  ASSERT_TRUE(variable_len);
+  tBTA_GATTC_MULTI handles = *p_read_multi;
+  peer.pending.push_back([=] {
+    if (!peer.read_multi_var_supported) {
+      callback(conn_id, GATT_REQ_NOT_SUPPORTED, handles, 0, NULL, cb_data);
+      return;
+    }
+    std::vector<uint8_t> rsp;
+    for (uint8_t i = 0; i < handles.num_attr; i++) {
+      const std::vector<uint8_t>& value = peer.attributes[handles.handles[i]];
+      rsp.push_back(value.size() & 0xff);
+      rsp.push_back(value.size() >> 8);
+      rsp.insert(rsp.end(), value.begin(), value.end());
+    }
+    if (rsp.size() > peer.mtu - 1u) rsp.resize(peer.mtu - 1);
+    callback(conn_id, GATT_SUCCESS, handles, rsp.size(), rsp.data(), cb_data);
+  });
+}
+
+class BtaGattQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    peer = FakePeer();
+    reads.clear();
+  }
+
+  void TearDown() override { BtaGattQueue::Clean(kConnId); }
+
+  /* Lays out |num_services| services, each with a few characteristics and a
+   * client characteristic configuration descriptor, like a typical LE Audio
+   * device does. Returns the handles in discovery order. */
+  std::vector<uint16_t> AddServices(int num_services, size_t value_len) {
+    std::vector<uint16_t> handles;
+    uint16_t handle = 1;
+    for (int service = 0; service < num_services; service++) {
+      handle++;  // Service declaration
+      for (int characteristic = 0; characteristic < 3; characteristic++) {
+        handle++;  // Characteristic declaration
+        peer.attributes[handle] = std::vector<uint8_t>(value_len, handle);
+        handles.push_back(handle++);
+      }
+      peer.attributes[handle] = {0x01, 0x00};
+      handles.push_back(handle++);
+    }
+    return handles;
+  }
+
+  void ReadAll(const std::vector<uint16_t>& handles) {
+    for (uint16_t handle : handles) {
+      BtaGattQueue::ReadCharacteristic(kConnId, handle, on_read, nullptr);
+    }
+  }
+
+  void ExpectAllRead(const std::vector<uint16_t>& handles) {
+    ASSERT_EQ(reads.size(), handles.size());
+    for (size_t i = 0; i < handles.size(); i++) {
+      EXPECT_EQ(reads[i].status, GATT_SUCCESS);
+      EXPECT_EQ(reads[i].handle, handles[i]);
+      EXPECT_EQ(reads[i].value, peer.attributes[handles[i]]);
+    }
+  }
+};
+
+TEST_F(BtaGattQueueTest, reads_are_sent_one_at_a_time_by_default) {
+  auto handles = AddServices(3, 2);
+  ReadAll(handles);
+  peer.Pump();
+
+  ExpectAllRead(handles);
+  EXPECT_EQ(peer.round_trips, 12);
+}
+
+TEST_F(BtaGattQueueTest, coalesced_reads) {
+  auto handles = AddServices(3, 2);
+  peer.mtu = 128;
+  BtaGattQueue::SetReadCoalescing(kConnId, true);
+  ReadAll(handles);
+  peer.Pump();
+
+  ExpectAllRead(handles);
+  // The first read goes out as soon as it is queued, the rest wait behind it
+  // and are sent in batches of GATT_MAX_READ_MULTI_HANDLES
+  EXPECT_EQ(peer.round_trips, 3);
+}
+
+TEST_F(BtaGattQueueTest, coalescing_stops_at_write) {
+  auto handles = AddServices(1, 2);
+  peer.mtu = 128;
+  BtaGattQueue::SetReadCoalescing(kConnId, true);
+  BtaGattQueue::ReadCharacteristic(kConnId, handles[0], on_read, nullptr);
+  BtaGattQueue::ReadCharacteristic(kConnId, handles[1], on_read, nullptr);
+  BtaGattQueue::WriteDescriptor(kConnId, handles[3], {0x02, 0x00},
+                                GATT_WRITE, nullptr, nullptr);
+  BtaGattQueue::ReadDescriptor(kConnId, handles[3], on_read, nullptr);
+  BtaGattQueue::ReadCharacteristic(kConnId, handles[2], on_read, nullptr);
+  peer.Pump();
+
+  ASSERT_EQ(reads.size(), 4u);
+  // The read issued after the write sees the written value
+  EXPECT_EQ(reads[2].handle, handles[3]);
+  EXPECT_EQ(reads[2].value, std::vector<uint8_t>({0x02, 0x00}));
+  // Both reads before the write are alone in the queue when they are sent
+  EXPECT_EQ(peer.round_trips, 4);
+}
+
+TEST_F(BtaGattQueueTest, truncated_response_requeues_remaining_reads) {
+  auto handles = AddServices(3, 8);
+  for (uint16_t handle : handles) {
+    peer.attributes[handle] = std::vector<uint8_t>(8, handle);
+  }
+  BtaGattQueue::SetReadCoalescing(kConnId, true);
+  ReadAll(handles);
+  peer.Pump();
+
+  // Only two values fit in each response at the default MTU, the one cut short
+  // is read on its own
+  ExpectAllRead(handles);
+  EXPECT_EQ(peer.round_trips, 8);
+}
+
+TEST_F(BtaGattQueueTest, unsupported_read_multiple_falls_back_to_single_reads) {
+  auto handles = AddServices(3, 2);
+  peer.mtu = 128;
+  peer.read_multi_var_supported = false;
+  BtaGattQueue::SetReadCoalescing(kConnId, true);
+  ReadAll(handles);
+  peer.Pump();
+
+  ExpectAllRead(handles);
+  // One failed Read Multiple, then coalescing is off for the connection
+  EXPECT_EQ(peer.round_trips, 13);
+}
+
+TEST_F(BtaGattQueueTest, clean_during_read_multiple_fails_reads) {
+  auto handles = AddServices(1, 2);
+  BtaGattQueue::SetReadCoalescing(kConnId, true);
+  BtaGattQueue::ConfigureMtu(kConnId, 64);
+  ReadAll(handles);
+  // Answer the MTU exchange, which sends the Read Multiple
+  peer.Pump(1);
+  BtaGattQueue::Clean(kConnId);
+  peer.read_multi_var_supported = false;
+  peer.Pump();
+
+  ASSERT_EQ(reads.size(), handles.size());
+  for (const auto& read : reads) EXPECT_NE(read.status, GATT_SUCCESS);
+  EXPECT_EQ(peer.round_trips, 2);
+}
+
+TEST_F(BtaGattQueueTest, reconnect_state_restore) {
+  // Restoring state after reconnection to a device with a dozen services
+  auto handles = AddServices(12, 4);
+  ASSERT_EQ(handles.size(), 48u);
+  auto restore = [&](bool coalesce) {
+    BtaGattQueue::Clean(kConnId);
+    reads.clear();
+    peer.mtu = 23;
+    peer.round_trips = 0;
+    BtaGattQueue::SetReadCoalescing(kConnId, coalesce);
+    BtaGattQueue::ConfigureMtu(kConnId, 247);
+    ReadAll(handles);
+    peer.Pump();
+    ExpectAllRead(handles);
+    return peer.round_trips;
+  };
+  // The MTU exchange, then one read per request
+  EXPECT_EQ(restore(false), 1 + 48);
+  // The MTU exchange, then batches of GATT_MAX_READ_MULTI_HANDLES reads
+  EXPECT_EQ(restore(true), 1 + 5);
+}
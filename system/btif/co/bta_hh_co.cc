@@ -25,6 +25,7 @@
 #include <linux/uhid.h>
 #include <poll.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -34,6 +35,7 @@
 #include "bta_hh_api.h"
 #include "btif_hh.h"
 #include "btif_util.h"
+#include "common/time_util.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/osi.h"
@@ -63,17 +65,18 @@ void uhid_set_non_blocking(int fd) {
 }
 
 /*Internal function to perform UHID write and error checking*/
-static int uhid_write(int fd, const struct uhid_event* ev) {
+static int uhid_write(int fd, const struct uhid_event* ev,
+                      size_t len = sizeof(struct uhid_event)) {
   ssize_t ret;
-  OSI_NO_INTR(ret = write(fd, ev, sizeof(*ev)));
+  OSI_NO_INTR(ret = write(fd, ev, len));
 
   if (ret < 0) {
     int rtn = -errno;
     APPL_TRACE_ERROR("%s: Cannot write to uhid:%s", __func__, strerror(errno));
     return rtn;
-  } else if (ret != (ssize_t)sizeof(*ev)) {
+  } else if (ret != (ssize_t)len) {
     APPL_TRACE_ERROR("%s: Wrong size written to uhid: %zd != %zu", __func__,
-                     ret, sizeof(*ev));
+                     ret, len);
     return -EFAULT;
   }
 
@@ -286,6 +289,19 @@ static void* btif_hh_poll_event_thread(void* arg) {
   return 0;
 }
 
+/* Wait a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
+ * device creation is pending. Returns true if the device can take data. */
+static bool uhid_wait_ready(btif_hh_device_t* p_dev) {
+  if (p_dev->fd < 0) return false;
+
+  uint32_t polling_attempts = 0;
+  while (!p_dev->ready_for_data &&
+         polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
+    usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
+  }
+  return p_dev->ready_for_data;
+}
+
 static inline void btif_hh_close_poll_thread(btif_hh_device_t* p_dev) {
   APPL_TRACE_DEBUG("%s", __func__);
   p_dev->hh_keep_polling = 0;
@@ -495,18 +511,8 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
     return;
   }
 
-  // Wait a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
-  // device creation is pending.
-  if (p_dev->fd >= 0) {
-    uint32_t polling_attempts = 0;
-    while (!p_dev->ready_for_data &&
-           polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
-      usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
-    }
-  }
-
   // Send the HID data to the kernel.
-  if ((p_dev->fd >= 0) && p_dev->ready_for_data) {
+  if (uhid_wait_ready(p_dev)) {
     bta_hh_co_write(p_dev->fd, p_rpt, len);
   } else {
     APPL_TRACE_WARNING("%s: Error: fd = %d, ready %d, len = %d", __func__,
@@ -514,6 +520,68 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_le_input_data
+ *
+ * Description      This function is executed by BTA when an input report is
+ *                  notified by a LE HID device. The report is written to uhid
+ *                  from the receiving thread, without an intermediate copy.
+ *
+ * Parameters       dev_handle  - device handle
+ *                  rpt_id      - report ID, put in front of the data unless 0
+ *                  *p_data     - pointer to the report data
+ *                  len         - length of report data
+ *                  rx_time_us  - time the notification was received at
+ *
+ * Returns          void
+ ******************************************************************************/
+void bta_hh_co_le_input_data(uint8_t dev_handle, uint8_t rpt_id,
+                             const uint8_t* p_data, uint16_t len,
+                             uint64_t rx_time_us) {
+  btif_hh_device_t* p_dev = btif_hh_find_connected_dev_by_handle(dev_handle);
+  if (p_dev == NULL) {
+    APPL_TRACE_WARNING("%s: Error: unknown HID device handle %d", __func__,
+                       dev_handle);
+    return;
+  }
+
+  if (!uhid_wait_ready(p_dev)) {
+    APPL_TRACE_WARNING("%s: Error: fd = %d, ready %d, len = %d", __func__,
+                       p_dev->fd, p_dev->ready_for_data, len);
+    return;
+  }
+
+  size_t size = len + (rpt_id != 0 ? 1 : 0);
+  if (size > UHID_DATA_MAX) {
+    APPL_TRACE_WARNING("%s: Report size greater than allowed size", __func__);
+    return;
+  }
+
+  struct uhid_event ev;
+#ifdef OS_ANDROID  // Host kernel does not support UHID_INPUT2
+  // Only the used part of the event is written, no need to clear the rest
+  ev.type = UHID_INPUT2;
+  ev.u.input2.size = size;
+  uint8_t* data = ev.u.input2.data;
+  size_t ev_len = offsetof(struct uhid_event, u.input2.data) + size;
+#else
+  memset(&ev, 0, sizeof(ev));
+  ev.type = UHID_INPUT;
+  ev.u.input.size = size;
+  uint8_t* data = ev.u.input.data;
+  size_t ev_len = sizeof(ev);
+#endif  // OS_ANDROID
+
+  if (rpt_id != 0) *data++ = rpt_id;
+  memcpy(data, p_data, len);
+
+  if (uhid_write(p_dev->fd, &ev, ev_len) == 0) {
+    btif_hh_record_input_latency(bluetooth::common::time_get_os_boottime_us() -
+                                 rx_time_us);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_send_hid_info
@@ -142,5 +142,7 @@ extern void btif_hh_getreport(btif_hh_device_t* p_dev,
                               bthh_report_type_t r_type, uint8_t reportId,
                               uint16_t bufferSize);
 extern void btif_hh_service_registration(bool enable);
+extern void btif_hh_record_input_latency(uint64_t latency_us);
+extern void btif_debug_hh_dump(int fd);
 
 #endif
@@ -35,6 +35,10 @@
 /* Add BT socket fd in current socket poll thread context immediately */
 #define SOCK_THREAD_ADD_FD_SYNC (1 << 3)
 
+/* Keep the fd watched after it is signaled, reporting readiness edge-triggered.
+ * The callback must drain the fd, it is only signaled again on new activity. */
+#define SOCK_THREAD_FD_EDGE (1 << 4)
+
 /*******************************************************************************
  *  Functions
  ******************************************************************************/
@@ -51,6 +51,7 @@
 #include "audio_hal_interface/a2dp_encoding.h"
 #include "bt_utils.h"
 #include "bta/include/bta_csis_api.h"
+#include "bta/include/bta_gatt_queue.h"
 #include "bta/include/bta_has_api.h"
 #include "bta/include/bta_hearing_aid_api.h"
 #include "bta/include/bta_hf_client_api.h"
@@ -67,6 +68,7 @@
 #include "btif_config.h"
 #include "btif_debug_conn.h"
 #include "btif_hf.h"
+#include "btif_hh.h"
 #include "btif_keystore.h"
 #include "btif_metrics_logging.h"
 #include "btif_storage.h"
@@ -85,6 +87,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/wakelock.h"
+#include "stack/eatt/eatt.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack/include/avdt_api.h"
 #include "stack/include/btm_api.h"
@@ -438,6 +441,7 @@ static void dump(int fd, const char** arguments) {
   btif_debug_a2dp_dump(fd);
   btif_debug_av_dump(fd);
   bta_debug_av_dump(fd);
+  btif_debug_hh_dump(fd);
   stack_debug_avdtp_api_dump(fd);
   bluetooth::avrcp::AvrcpService::DebugDump(fd);
   btif_debug_config_dump(fd);
@@ -456,6 +460,8 @@ static void dump(int fd, const char** arguments) {
   VolumeControl::DebugDump(fd);
 #endif
   connection_manager::dump(fd);
+  bluetooth::eatt::EattExtension::Dump(fd);
+  BtaGattQueue::DebugDump(fd);
   bluetooth::bqr::DebugDump(fd);
   bluetooth::shim::Dump(fd, arguments);
 }
@@ -49,6 +49,8 @@ static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 
 /* We can have max one command pending */
 static tA2DP_CTRL_CMD a2dp_cmd_pending = A2DP_CTRL_CMD_NONE;
+/* The Audio HAL sends a shared memory ring on the next audio connection */
+static bool a2dp_audio_ring_accepted = false;
 std::unique_ptr<tUIPC_STATE> a2dp_uipc = nullptr;
 
 void btif_a2dp_control_init(void) {
@@ -127,6 +129,17 @@ static tA2DP_CTRL_ACK btif_a2dp_control_on_start() {
   return A2DP_CTRL_ACK_FAILURE;
 }
 
+/* The ring is offered after START and sent right after the audio channel
+ * connects, so that both sides agree on whether the first bytes on the audio
+ * socket are the ring handshake or audio data. */
+static tA2DP_CTRL_ACK btif_a2dp_control_on_offer_audio_ring() {
+  if (btif_av_get_peer_sep() != AVDT_TSEP_SNK || !audio_ring_enabled()) {
+    return A2DP_CTRL_ACK_UNSUPPORTED;
+  }
+  a2dp_audio_ring_accepted = true;
+  return A2DP_CTRL_ACK_SUCCESS;
+}
+
 static tA2DP_CTRL_ACK btif_a2dp_control_on_stop() {
   if (btif_av_get_peer_sep() == AVDT_TSEP_SNK &&
       !btif_a2dp_source_is_streaming()) {
@@ -289,6 +302,8 @@ static void btif_a2dp_recv_ctrl_data(void) {
       break;
 
     case A2DP_CTRL_CMD_START:
+      /* a ring is only sent if offered again after this START */
+      a2dp_audio_ring_accepted = false;
       btif_a2dp_command_ack(btif_a2dp_control_on_start());
       break;
 
@@ -316,6 +331,10 @@ static void btif_a2dp_recv_ctrl_data(void) {
       btif_a2dp_control_on_get_presentation_position();
       break;
 
+    case A2DP_CTRL_CMD_OFFER_AUDIO_RING:
+      btif_a2dp_command_ack(btif_a2dp_control_on_offer_audio_ring());
+      break;
+
     default:
       APPL_TRACE_ERROR("%s: UNSUPPORTED CMD (%d)", __func__, cmd);
       btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
@@ -383,6 +402,14 @@ static void btif_a2dp_data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id,
       UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
                  reinterpret_cast<void*>(A2DP_DATA_READ_POLL_MS));
 
+      /* The Audio HAL output stream hands over the shared memory ring it
+       * offered on the control channel */
+      if (a2dp_audio_ring_accepted) {
+        a2dp_audio_ring_accepted = false;
+        UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RING_ATTACH,
+                   NULL);
+      }
+
       if (btif_av_get_peer_sep() == AVDT_TSEP_SNK) {
         /* Start the media task to encode the audio */
         btif_a2dp_source_start_audio_req();
@@ -46,12 +46,14 @@
 #include "common/repeating_timer.h"
 #include "common/time_util.h"
 #include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/wakelock.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/acl_api_types.h"
+#include "stack/include/a2dp_media_buffer.h"
 #include "stack/include/bt_hdr.h"
 #include "types/raw_address.h"
 #include "uipc.h"
@@ -69,6 +71,12 @@ extern std::unique_ptr<tUIPC_STATE> a2dp_uipc;
  */
 #define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
+/**
+ * Media packets which may be held by BTA AV and L2CAP, on top of the tx queue,
+ * before they are copied to the controller.
+ */
+#define A2DP_MEDIA_BUFFERS_IN_FLIGHT 8
+
 class SchedulingStats {
  public:
   SchedulingStats() { Reset(); }
@@ -126,6 +134,7 @@ class BtifMediaStats {
     tx_queue_dequeue_stats.Reset();
     tx_queue_total_frames = 0;
     tx_queue_max_frames_per_packet = 0;
+    tx_queue_max_length = 0;
     tx_queue_total_queueing_time_us = 0;
     tx_queue_max_queueing_time_us = 0;
     tx_queue_total_readbuf_calls = 0;
@@ -150,6 +159,7 @@ class BtifMediaStats {
 
   size_t tx_queue_total_frames;
   size_t tx_queue_max_frames_per_packet;
+  size_t tx_queue_max_length;
 
   uint64_t tx_queue_total_queueing_time_us;
   uint64_t tx_queue_max_queueing_time_us;
@@ -301,6 +311,8 @@ void btif_a2dp_source_accumulate_stats(BtifMediaStats* src,
   dst->tx_queue_total_frames += src->tx_queue_total_frames;
   dst->tx_queue_max_frames_per_packet = std::max(
       dst->tx_queue_max_frames_per_packet, src->tx_queue_max_frames_per_packet);
+  dst->tx_queue_max_length =
+      std::max(dst->tx_queue_max_length, src->tx_queue_max_length);
   dst->tx_queue_total_queueing_time_us += src->tx_queue_total_queueing_time_us;
   dst->tx_queue_max_queueing_time_us = std::max(
       dst->tx_queue_max_queueing_time_us, src->tx_queue_max_queueing_time_us);
@@ -512,6 +524,7 @@ static void btif_a2dp_source_shutdown_delayed(void) {
   }
   fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
   btif_a2dp_source_cb.tx_audio_queue = nullptr;
+  a2dp_media_buffer_pool_cleanup();
 
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 }
@@ -595,6 +608,13 @@ static void btif_a2dp_source_setup_codec_delayed(
   btif_a2dp_source_cb.encoder_interval_ms =
       btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms();
 
+  // Preallocate the media packets for the tx queue and the lower layers,
+  // sized for the MTU and frame size the encoder settled on
+  a2dp_media_buffer_pool_init(
+      btif_a2dp_source_cb.encoder_interface->get_media_buffer_size(),
+      btif_a2dp_source_dynamic_audio_buffer_size +
+          A2DP_MEDIA_BUFFERS_IN_FLIGHT);
+
   if (bluetooth::audio::a2dp::is_hal_enabled()) {
     bluetooth::audio::a2dp::setup_codec();
   }
@@ -1028,6 +1048,9 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
   CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
 
   fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+  btif_a2dp_source_cb.stats.tx_queue_max_length =
+      std::max(fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue),
+               btif_a2dp_source_cb.stats.tx_queue_max_length);
 
   return true;
 }
@@ -1169,6 +1192,12 @@ void btif_a2dp_source_debug_dump(int fd) {
           accumulated_stats->tx_queue_total_frames,
           accumulated_stats->tx_queue_max_frames_per_packet, ave_size);
 
+  dprintf(fd,
+          "  Queue length (current/max)                              : %zu / "
+          "%zu\n",
+          fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue),
+          accumulated_stats->tx_queue_max_length);
+
   dprintf(fd,
           "  Counts (flushed/dropped/dropouts)                       : %zu / "
           "%zu / %zu\n",
@@ -1212,6 +1241,33 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  //
+  // Media buffer pool stats
+  //
+  buffer_pool_stats_t pool_stats;
+  if (a2dp_media_buffer_pool_get_stats(&pool_stats)) {
+    dprintf(fd,
+            "  Media buffers (size/count/in use/max in use)            : "
+            "%zu / %zu / %zu / %zu\n",
+            pool_stats.buffer_size, pool_stats.buffer_count,
+            pool_stats.buffers_in_use, pool_stats.max_buffers_in_use);
+
+    dprintf(fd,
+            "  Media buffer counts (taken/exhausted)                   : "
+            "%zu / %zu\n",
+            pool_stats.total_taken, pool_stats.total_exhausted);
+
+    ave_time_us = 0;
+    if (pool_stats.total_released != 0) {
+      ave_time_us = pool_stats.total_lifetime_us / pool_stats.total_released;
+    }
+    dprintf(fd,
+            "  Encode to HCI send time in us (max/ave)                 : "
+            "%llu / %llu\n",
+            (unsigned long long)pool_stats.max_lifetime_us,
+            (unsigned long long)ave_time_us);
+  }
+
   //
   // TxQueue enqueue stats
   //
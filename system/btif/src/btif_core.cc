@@ -49,6 +49,7 @@
 #include "btif/include/stack_manager.h"
 #include "common/message_loop_thread.h"
 #include "device/include/controller.h"
+#include "main/shim/le_scanning_manager.h"
 #include "osi/include/allocator.h"
 #include "osi/include/future.h"
 #include "osi/include/log.h"
@@ -584,7 +585,8 @@ void btif_get_adapter_property(bt_property_type_t type) {
     if (cmn_vsc_cb.filter_support == 1)
       local_le_features.max_adv_filter_supported = cmn_vsc_cb.max_filter;
     else
-      local_le_features.max_adv_filter_supported = 0;
+      local_le_features.max_adv_filter_supported =
+          bluetooth::shim::get_number_of_software_scan_filters();
     local_le_features.max_adv_instance = cmn_vsc_cb.adv_inst_max;
     local_le_features.max_irk_list_size = cmn_vsc_cb.max_irk_list_sz;
     local_le_features.rpa_offload_supported = cmn_vsc_cb.rpa_offloading;
@@ -31,6 +31,8 @@
 
 #include <base/logging.h>
 
+#include <atomic>
+#include <cinttypes>
 #include <cstdint>
 
 #include "bta_hh_co.h"
@@ -68,6 +70,11 @@ static int btif_hh_keylockstates = 0;  // The current key state of each key
 
 #define BTIF_TIMEOUT_VUP_MS (3 * 1000)
 
+/* Buckets of the LE input report latency histogram, each one twice as wide as
+ * the previous one. The last bucket takes everything above. */
+#define BTIF_HH_LATENCY_BUCKETS 8
+#define BTIF_HH_LATENCY_FIRST_BUCKET_US 250
+
 /* HH request events */
 typedef enum {
   BTIF_HH_CONNECT_REQ_EVT = 0,
@@ -89,6 +96,15 @@ typedef struct hid_kb_list {
   const char* kb_name;
 } tHID_KB_LIST;
 
+/* Latency of the LE input reports from their notification to their write to
+ * uhid. Recorded from the BTA thread and read when dumping the state. */
+typedef struct {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total_us;
+  std::atomic<uint64_t> max_us;
+  std::atomic<uint64_t> buckets[BTIF_HH_LATENCY_BUCKETS];
+} btif_hh_input_latency_t;
+
 /*******************************************************************************
  *  Static variables
  ******************************************************************************/
@@ -96,6 +112,8 @@ btif_hh_cb_t btif_hh_cb;
 
 static bthh_callbacks_t* bt_hh_callbacks = NULL;
 
+static btif_hh_input_latency_t btif_hh_input_latency;
+
 /* List of HID keyboards for which the NUMLOCK state needs to be
  * turned ON by default. Add devices to this list to apply the
  * NUMLOCK state toggle on fpr first connect.*/
@@ -1789,3 +1807,72 @@ const bthh_interface_t* btif_hh_get_interface() {
   BTIF_TRACE_EVENT("%s", __func__);
   return &bthhInterface;
 }
+
+/*******************************************************************************
+ *
+ * Function         btif_hh_record_input_latency
+ *
+ * Description      Records the time a LE input report took from its
+ *                  notification to its write to uhid
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_hh_record_input_latency(uint64_t latency_us) {
+  btif_hh_input_latency_t* p_stats = &btif_hh_input_latency;
+
+  size_t bucket = 0;
+  uint64_t limit_us = BTIF_HH_LATENCY_FIRST_BUCKET_US;
+  while (bucket < BTIF_HH_LATENCY_BUCKETS - 1 && latency_us >= limit_us) {
+    bucket++;
+    limit_us *= 2;
+  }
+
+  p_stats->count++;
+  p_stats->total_us += latency_us;
+  p_stats->buckets[bucket]++;
+  uint64_t max_us = p_stats->max_us;
+  while (latency_us > max_us &&
+         !p_stats->max_us.compare_exchange_weak(max_us, latency_us)) {
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_debug_hh_dump
+ *
+ * Description      Dumps the connected HID devices and the LE input report
+ *                  latency
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_debug_hh_dump(int fd) {
+  dprintf(fd, "\nHID Host:\n");
+
+  for (uint32_t i = 0; i < BTIF_HH_MAX_HID; i++) {
+    const btif_hh_device_t* p_dev = &btif_hh_cb.devices[i];
+    if (p_dev->dev_status != BTHH_CONN_STATE_CONNECTED) continue;
+    dprintf(fd, "  %s: handle=%d le=%s fd=%d ready=%s\n",
+            PRIVATE_ADDRESS(p_dev->bd_addr), p_dev->dev_handle,
+            p_dev->le_hid ? "true" : "false", p_dev->fd,
+            p_dev->ready_for_data ? "true" : "false");
+  }
+
+  const btif_hh_input_latency_t* p_stats = &btif_hh_input_latency;
+  uint64_t count = p_stats->count;
+  dprintf(fd, "  LE input reports written to uhid: %" PRIu64 "\n", count);
+  if (count == 0) return;
+
+  dprintf(fd,
+          "  LE input report to uhid write latency in us (max/ave): "
+          "%" PRIu64 " / %" PRIu64 "\n",
+          p_stats->max_us.load(), p_stats->total_us.load() / count);
+  uint64_t limit_us = BTIF_HH_LATENCY_FIRST_BUCKET_US;
+  for (size_t i = 0; i < BTIF_HH_LATENCY_BUCKETS - 1; i++, limit_us *= 2) {
+    dprintf(fd, "    < %6" PRIu64 " us: %" PRIu64 "\n", limit_us,
+            p_stats->buckets[i].load());
+  }
+  dprintf(fd, "    >= %5" PRIu64 " us: %" PRIu64 "\n", limit_us / 2,
+          p_stats->buckets[BTIF_HH_LATENCY_BUCKETS - 1].load());
+}
@@ -222,7 +222,11 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
     socks = sock->next;
 
   shutdown(sock->our_fd, SHUT_RDWR);
-  close(sock->our_fd);
+  // The poll thread closes the fd once it stops watching it, epoll would not
+  // report an fd closed behind its back
+  if (pth == -1 || !btsock_thread_remove_fd_and_close(pth, sock->our_fd)) {
+    close(sock->our_fd);
+  }
   if (sock->app_fd != -1) {
     close(sock->app_fd);
   } else {
@@ -403,7 +403,11 @@ static void free_rfc_slot_scn(rfc_slot_t* slot) {
 static void cleanup_rfc_slot(rfc_slot_t* slot) {
   if (slot->fd != INVALID_FD) {
     shutdown(slot->fd, SHUT_RDWR);
-    close(slot->fd);
+    // The poll thread closes the fd once it stops watching it, epoll would
+    // not report an fd closed behind its back
+    if (pth == -1 || !btsock_thread_remove_fd_and_close(pth, slot->fd)) {
+      close(slot->fd);
+    }
     log_socket_connection_state(
         slot->addr, slot->id, BTSOCK_RFCOMM,
         android::bluetooth::SOCKET_CONNECTION_STATE_DISCONNECTED,
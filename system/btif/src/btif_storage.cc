@@ -54,6 +54,7 @@
 #include "btif_hh.h"
 #include "btif_util.h"
 #include "device/include/controller.h"
+#include "main/shim/acl_api.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/config.h"
@@ -530,6 +531,23 @@ static void btif_read_le_key(const uint8_t key_type, const size_t key_len,
   }
 }
 
+/* The profiles add their bonded devices on the main thread, from tasks posted
+ * by the loading, and request the background connections from there with
+ * tasks of their own. The acceptlist batch covering these requests ends one
+ * task later, once the main thread handled them all. */
+static void btif_begin_acceptlist_batch() {
+  do_in_main_thread(FROM_HERE,
+                    Bind(&bluetooth::shim::ACL_BeginAcceptListBatch));
+}
+
+static void btif_end_acceptlist_batch() {
+  do_in_main_thread(FROM_HERE, Bind([]() {
+                      do_in_main_thread(
+                          FROM_HERE,
+                          Bind(&bluetooth::shim::ACL_EndAcceptListBatch));
+                    }));
+}
+
 /*******************************************************************************
  * Functions
  *
@@ -1032,7 +1050,13 @@ bt_status_t btif_storage_load_bonded_devices(void) {
 
   remove_devices_with_sample_ltk();
 
+  // The identity keys of the bonded devices are loaded into the address
+  // resolution list of the controller in a single batch
+  do_in_main_thread(FROM_HERE,
+                    Bind(&bluetooth::shim::ACL_BeginAddressResolutionBatch));
   btif_in_fetch_bonded_devices(&bonded_devices, 1);
+  do_in_main_thread(FROM_HERE,
+                    Bind(&bluetooth::shim::ACL_EndAddressResolutionBatch));
 
   /* Now send the adapter_properties_cb with all adapter_properties */
   {
@@ -1509,6 +1533,7 @@ bt_status_t btif_storage_add_hid_device_info(
  *
  ******************************************************************************/
 bt_status_t btif_storage_load_bonded_hid_info(void) {
+  btif_begin_acceptlist_batch();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
@@ -1565,6 +1590,7 @@ bt_status_t btif_storage_load_bonded_hid_info(void) {
       BTA_HhAddDev(bd_addr, attr_mask, sub_class, app_id, dscp_info);
     }
   }
+  btif_end_acceptlist_batch();
 
   return BT_STATUS_SUCCESS;
 }
@@ -1650,6 +1676,7 @@ void btif_storage_add_hearing_aid(const HearingDevice& dev_info) {
 
 /** Loads information about bonded hearing aid devices */
 void btif_storage_load_bonded_hearing_aids() {
+  btif_begin_acceptlist_batch();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     const std::string& name = bd_addr.ToString();
 
@@ -1740,6 +1767,7 @@ void btif_storage_load_bonded_hearing_aids() {
                            render_delay, preparation_delay),
              is_acceptlisted));
   }
+  btif_end_acceptlist_batch();
 }
 
 /** Deletes the bonded hearing aid device info from NVRAM */
@@ -1856,6 +1884,7 @@ void btif_storage_set_leaudio_autoconnect(const RawAddress& addr,
 
 /** Loads information about bonded Le Audio devices */
 void btif_storage_load_bonded_leaudio() {
+  btif_begin_acceptlist_batch();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
@@ -1888,6 +1917,7 @@ void btif_storage_load_bonded_leaudio() {
     do_in_main_thread(
         FROM_HERE, Bind(&LeAudioClient::AddFromStorage, bd_addr, autoconnect));
   }
+  btif_end_acceptlist_batch();
 }
 
 /** Remove the Le Audio device from storage */
@@ -1962,6 +1992,7 @@ void btif_storage_set_leaudio_has_features(const RawAddress& address,
 }
 
 void btif_storage_load_bonded_leaudio_has_devices() {
+  btif_begin_acceptlist_batch();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     const std::string& name = bd_addr.ToString();
 
@@ -1984,6 +2015,7 @@ void btif_storage_load_bonded_leaudio_has_devices() {
     ASSERT_LOG(false, "TODO - Fix LE audio build.");
 #endif
   }
+  btif_end_acceptlist_batch();
 }
 
 void btif_storage_remove_leaudio_has(const RawAddress& address) {
@@ -2114,6 +2146,7 @@ void btif_storage_update_csis_info(const RawAddress& addr) {
 
 /** Loads information about the bonded CSIS device */
 void btif_storage_load_bonded_csis_devices(void) {
+  btif_begin_acceptlist_batch();
   for (const auto& bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
@@ -2135,6 +2168,7 @@ void btif_storage_load_bonded_csis_devices(void) {
       do_in_main_thread(FROM_HERE, Bind(&CsisClient::AddFromStorage, bd_addr,
                                         std::move(in), autoconnect));
   }
+  btif_end_acceptlist_batch();
 }
 
 /** Removes information about the bonded CSIS device */
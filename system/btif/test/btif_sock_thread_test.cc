@@ -0,0 +1,227 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "btif/include/btif_sock_thread.h"
+
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bt_trace.h"
+
+uint8_t appl_trace_level = BT_TRACE_LEVEL_WARNING;
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr int kTestSocketType = 1;
+constexpr size_t kNumChannels = 200;
+constexpr std::chrono::seconds kTimeout(10);
+
+int sThreadHandle = -1;
+std::mutex sLock;
+std::condition_variable sCondition;
+std::atomic<uint64_t> sWakeups;
+std::atomic<uint64_t> sBytesReceived;
+std::atomic<uint64_t> sExceptions;
+std::atomic<int> sSignalFlags(SOCK_THREAD_FD_RD);
+std::atomic<bool> sRearm(true);
+
+// Reads everything pending on |fd|, as the RFCOMM and L2CAP callbacks do, and
+// re-arms one-shot watches from the poll thread.
+void drain_on_signaled(int fd, int type, int flags, uint32_t user_id) {
+  sWakeups++;
+  if (flags & SOCK_THREAD_FD_RD) {
+    char buf[4096];
+    ssize_t count;
+    do {
+      count = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (count > 0) sBytesReceived += count;
+    } while (count > 0 || (count == -1 && errno == EINTR));
+  }
+  if (flags & SOCK_THREAD_FD_EXCEPTION) {
+    sExceptions++;
+  } else if (sRearm) {
+    btsock_thread_add_fd(sThreadHandle, fd, type,
+                         sSignalFlags | SOCK_THREAD_ADD_FD_SYNC, user_id);
+  }
+  std::lock_guard<std::mutex> lock(sLock);
+  sCondition.notify_all();
+}
+
+template <typename Predicate>
+bool wait_for(Predicate predicate) {
+  std::unique_lock<std::mutex> lock(sLock);
+  return sCondition.wait_for(lock, kTimeout, predicate);
+}
+
+}  // namespace
+
+class BtifSockThreadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sWakeups = 0;
+    sBytesReceived = 0;
+    sExceptions = 0;
+    sSignalFlags = SOCK_THREAD_FD_RD;
+    sRearm = true;
+    btsock_thread_init();
+    sThreadHandle = btsock_thread_create(drain_on_signaled, nullptr);
+    ASSERT_GE(sThreadHandle, 0);
+  }
+
+  void TearDown() override {
+    btsock_thread_exit(sThreadHandle);
+    sThreadHandle = -1;
+    for (auto& channel : channels_) {
+      close(channel.app_fd);
+      close(channel.stack_fd);
+    }
+    channels_.clear();
+  }
+
+  struct Channel {
+    int app_fd;
+    int stack_fd;
+  };
+
+  void OpenChannels(size_t count, int flags) {
+    sSignalFlags = flags;
+    sRearm = !(flags & SOCK_THREAD_FD_EDGE);
+    for (size_t i = 0; i < count; i++) {
+      int fds[2];
+      ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+      channels_.push_back({fds[0], fds[1]});
+      ASSERT_TRUE(btsock_thread_add_fd(sThreadHandle, fds[1], kTestSocketType,
+                                       flags, i));
+    }
+  }
+
+  std::vector<Channel> channels_;
+};
+
+TEST_F(BtifSockThreadTest, signals_more_sockets_than_old_poll_limit) {
+  OpenChannels(kNumChannels, SOCK_THREAD_FD_RD);
+
+  for (auto& channel : channels_) {
+    ASSERT_EQ(send(channel.app_fd, "x", 1, 0), 1);
+  }
+  ASSERT_TRUE(wait_for([] { return sBytesReceived == kNumChannels; }));
+}
+
+TEST_F(BtifSockThreadTest, one_shot_watch_needs_rearm) {
+  OpenChannels(1, SOCK_THREAD_FD_RD);
+  sRearm = false;
+  ASSERT_EQ(send(channels_[0].app_fd, "x", 1, 0), 1);
+  ASSERT_TRUE(wait_for([] { return sBytesReceived == 1; }));
+
+  ASSERT_EQ(send(channels_[0].app_fd, "y", 1, 0), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(sBytesReceived, 1u);
+
+  ASSERT_TRUE(btsock_thread_add_fd(sThreadHandle, channels_[0].stack_fd,
+                                   kTestSocketType, SOCK_THREAD_FD_RD, 0));
+  ASSERT_TRUE(wait_for([] { return sBytesReceived == 2; }));
+}
+
+TEST_F(BtifSockThreadTest, edge_triggered_watch_stays_armed) {
+  OpenChannels(1, SOCK_THREAD_FD_RD | SOCK_THREAD_FD_EDGE);
+
+  for (uint64_t i = 1; i <= 5; i++) {
+    ASSERT_EQ(send(channels_[0].app_fd, "x", 1, 0), 1);
+    ASSERT_TRUE(wait_for([i] { return sBytesReceived == i; }));
+  }
+  ASSERT_EQ(sWakeups, 5u);
+}
+
+TEST_F(BtifSockThreadTest, exception_on_peer_close) {
+  OpenChannels(1, SOCK_THREAD_FD_RD);
+
+  close(channels_[0].app_fd);
+  channels_[0].app_fd = -1;
+  ASSERT_TRUE(wait_for([] { return sExceptions == 1; }));
+}
+
+TEST_F(BtifSockThreadTest, removed_fd_is_not_signaled) {
+  OpenChannels(2, SOCK_THREAD_FD_RD);
+
+  ASSERT_TRUE(
+      btsock_thread_remove_fd_and_close(sThreadHandle, channels_[0].stack_fd));
+  channels_[0].stack_fd = -1;
+  // Round trip through the cmd socket so the removal has been processed
+  ASSERT_EQ(send(channels_[1].app_fd, "x", 1, 0), 1);
+  ASSERT_TRUE(wait_for([] { return sBytesReceived == 1; }));
+
+  ASSERT_EQ(send(channels_[0].app_fd, "y", 1, MSG_NOSIGNAL), -1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(sWakeups, 1u);
+  ASSERT_EQ(sExceptions, 0u);
+}
+
+TEST_F(BtifSockThreadTest, stress_concurrent_channels) {
+  constexpr size_t kMessagesPerChannel = 100;
+  constexpr size_t kMessageSize = 512;
+  OpenChannels(kNumChannels, SOCK_THREAD_FD_RD);
+
+  const std::vector<char> message(kMessageSize, 'x');
+  for (size_t i = 0; i < kMessagesPerChannel; i++) {
+    for (auto& channel : channels_) {
+      ASSERT_EQ(send(channel.app_fd, message.data(), message.size(), 0),
+                (ssize_t)message.size());
+    }
+  }
+  const uint64_t total = kNumChannels * kMessagesPerChannel * kMessageSize;
+  ASSERT_TRUE(wait_for([total] { return sBytesReceived == total; }));
+
+  // Every channel is signaled, and draining on each wakeup means a channel is
+  // never signaled more often than it was written to.
+  ASSERT_GE(sWakeups, kNumChannels);
+  ASSERT_LE(sWakeups, kNumChannels * kMessagesPerChannel);
+  ASSERT_EQ(sExceptions, 0u);
+}
+
+TEST_F(BtifSockThreadTest, fd_shut_down_by_owner_is_signaled) {
+  OpenChannels(2, SOCK_THREAD_FD_RD);
+
+  // As the RFCOMM and L2CAP cleanups do before removing the fd
+  shutdown(channels_[0].stack_fd, SHUT_RDWR);
+  ASSERT_TRUE(wait_for([] { return sExceptions == 1; }));
+
+  // The other watch is unaffected
+  ASSERT_EQ(send(channels_[1].app_fd, "x", 1, 0), 1);
+  ASSERT_TRUE(wait_for([] { return sBytesReceived == 1; }));
+  ASSERT_EQ(sExceptions, 1u);
+}
+
+TEST_F(BtifSockThreadTest, fd_closed_before_being_added_is_signaled) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  ASSERT_TRUE(btsock_thread_add_fd(sThreadHandle, fds[1], kTestSocketType,
+                                   SOCK_THREAD_FD_RD, 0));
+  ASSERT_TRUE(wait_for([] { return sExceptions == 1; }));
+}
@@ -201,6 +201,11 @@ class HciHalHidl : public HciHal {
     }
   }
 
+  // Start() only sets up the HAL service, which reports to the module's own callbacks and its dependencies
+  bool CanStartConcurrently() const override {
+    return true;
+  }
+
   void Start() override {
     if (common::init_flags::btaa_hci_is_enabled()) {
       btaa_logger_ = GetDependency<activity_attribution::ActivityAttribution>();
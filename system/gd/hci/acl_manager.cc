@@ -237,6 +237,14 @@ void AclManager::ClearFilterAcceptList() {
   CallOn(pimpl_->le_impl_, &le_impl::clear_connect_list);
 }
 
+void AclManager::BeginFilterAcceptListBatch() {
+  CallOn(pimpl_->le_impl_, &le_impl::begin_connect_list_batch);
+}
+
+void AclManager::EndFilterAcceptListBatch() {
+  CallOn(pimpl_->le_impl_, &le_impl::end_connect_list_batch);
+}
+
 void AclManager::AddDeviceToResolvingList(
     AddressWithType address_with_type,
     const std::array<uint8_t, 16>& peer_irk,
@@ -252,6 +260,10 @@ void AclManager::ClearResolvingList() {
   CallOn(pimpl_->le_impl_, &le_impl::clear_resolving_list);
 }
 
+void AclManager::CommitListUpdate(LeAddressManager::ListUpdate update) {
+  CallOn(pimpl_->le_impl_, &le_impl::commit_list_update, std::move(update));
+}
+
 void AclManager::CentralLinkKey(KeyFlag key_flag) {
   CallOn(pimpl_->classic_impl_, &classic_impl::central_link_key, key_flag);
 }
@@ -112,6 +112,10 @@ public:
  virtual void AddDeviceToFilterAcceptList(AddressWithType address_with_type);
  virtual void RemoveDeviceFromFilterAcceptList(AddressWithType address_with_type);
  virtual void ClearFilterAcceptList();
+ // Sends the filter accept list changes made between the two calls, background and direct connections included, to
+ // the controller in one batch
+ virtual void BeginFilterAcceptListBatch();
+ virtual void EndFilterAcceptListBatch();
 
  virtual void AddDeviceToResolvingList(
      AddressWithType address_with_type,
@@ -119,6 +123,8 @@ public:
      const std::array<uint8_t, 16>& local_irk);
  virtual void RemoveDeviceFromResolvingList(AddressWithType address_with_type);
  virtual void ClearResolvingList();
+ // Applies the changes to the filter accept list and the resolving list in one batch
+ virtual void CommitListUpdate(LeAddressManager::ListUpdate update);
 
  virtual void CentralLinkKey(KeyFlag key_flag);
  virtual void SwitchRole(Address address, Role role);
@@ -22,6 +22,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
@@ -573,6 +574,11 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
 
     connect_list.insert(address_with_type);
     register_with_address_manager();
+    if (connect_list_batch_.has_value()) {
+      connect_list_batch_->AddDeviceToFilterAcceptList(
+          address_with_type.ToFilterAcceptListAddressType(), address_with_type.GetAddress());
+      return;
+    }
     le_address_manager_->AddDeviceToFilterAcceptList(
         address_with_type.ToFilterAcceptListAddressType(), address_with_type.GetAddress());
   }
@@ -590,6 +596,11 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     connecting_le_.erase(address_with_type);
     direct_connections_.erase(address_with_type);
     register_with_address_manager();
+    if (connect_list_batch_.has_value()) {
+      connect_list_batch_->RemoveDeviceFromFilterAcceptList(
+          address_with_type.ToFilterAcceptListAddressType(), address_with_type.GetAddress());
+      return;
+    }
     le_address_manager_->RemoveDeviceFromFilterAcceptList(
         address_with_type.ToFilterAcceptListAddressType(), address_with_type.GetAddress());
   }
@@ -597,9 +608,34 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   void clear_connect_list() {
     connect_list.clear();
     register_with_address_manager();
+    if (connect_list_batch_.has_value()) {
+      connect_list_batch_->ClearFilterAcceptList();
+      return;
+    }
     le_address_manager_->ClearFilterAcceptList();
   }
 
+  // Until the outermost batch ends, the filter accept list changes are collected and then committed together, with
+  // the clients of the controller lists paused once. Batches may overlap.
+  void begin_connect_list_batch() {
+    if (connect_list_batch_depth_++ == 0) {
+      connect_list_batch_.emplace();
+    }
+  }
+
+  void end_connect_list_batch() {
+    if (connect_list_batch_depth_ == 0) {
+      LOG_WARN("No filter accept list batch in progress");
+      return;
+    }
+    if (--connect_list_batch_depth_ > 0) {
+      return;
+    }
+    LeAddressManager::ListUpdate update = std::move(*connect_list_batch_);
+    connect_list_batch_.reset();
+    commit_list_update(std::move(update));
+  }
+
   void add_device_to_resolving_list(
       AddressWithType address_with_type,
       const std::array<uint8_t, 16>& peer_irk,
@@ -866,6 +902,11 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     le_address_manager_->ClearResolvingList();
   }
 
+  void commit_list_update(LeAddressManager::ListUpdate update) {
+    register_with_address_manager();
+    le_address_manager_->CommitListUpdate(std::move(update));
+  }
+
   void set_privacy_policy_for_initiator_address(
       LeAddressManager::AddressPolicy address_policy,
       AddressWithType fixed_address,
@@ -1018,6 +1059,8 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   // Set of devices that will not be removed from connect list after direct connect timeout
   std::unordered_set<AddressWithType> background_connections_;
   std::unordered_set<AddressWithType> connect_list;
+  std::optional<LeAddressManager::ListUpdate> connect_list_batch_;
+  size_t connect_list_batch_depth_ = 0;
   AddressWithType connection_peer_address_with_type_;  // Direct peer address UNSUPPORTEDD
   bool address_manager_registered = false;
   bool ready_to_unregister = false;
@@ -228,6 +228,26 @@ TEST_F(LeImplTest, remove_device_from_connect_list) {
   ASSERT_EQ(0UL, le_impl_->connect_list.size());
 }
 
+TEST_F(LeImplTest, connect_list_batch) {
+  le_impl_->begin_connect_list_batch();
+  le_impl_->begin_connect_list_batch();
+  le_impl_->add_device_to_connect_list({{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}, AddressType::PUBLIC_DEVICE_ADDRESS});
+  le_impl_->add_device_to_connect_list({{0x11, 0x12, 0x13, 0x14, 0x15, 0x16}, AddressType::PUBLIC_DEVICE_ADDRESS});
+  le_impl_->remove_device_from_connect_list({{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}, AddressType::PUBLIC_DEVICE_ADDRESS});
+  ASSERT_EQ(1UL, le_impl_->connect_list.size());
+
+  // The changes are committed when the outermost batch ends
+  le_impl_->end_connect_list_batch();
+  ASSERT_TRUE(le_impl_->connect_list_batch_.has_value());
+  le_impl_->end_connect_list_batch();
+  ASSERT_FALSE(le_impl_->connect_list_batch_.has_value());
+  ASSERT_EQ(1UL, le_impl_->connect_list.size());
+
+  // Ending a batch that was not begun does nothing
+  le_impl_->end_connect_list_batch();
+  ASSERT_FALSE(le_impl_->connect_list_batch_.has_value());
+}
+
 }  // namespace acl_manager
 }  // namespace hci
 }  // namespace bluetooth
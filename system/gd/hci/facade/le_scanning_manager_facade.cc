@@ -122,13 +122,13 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
       int8_t tx_power,
       int8_t rssi,
       uint16_t periodic_advertising_interval,
-      std::vector<uint8_t> advertising_data) {
+      SharedAdvertisingData advertising_data) {
     AdvertisingReportMsg advertising_report_msg;
     std::vector<LeExtendedAdvertisingResponse> advertisements;
     LeExtendedAdvertisingResponse le_extended_advertising_report;
     le_extended_advertising_report.address_type_ = (DirectAdvertisingAddressType)address_type;
     le_extended_advertising_report.address_ = address;
-    le_extended_advertising_report.advertising_data_ = advertising_data;
+    le_extended_advertising_report.advertising_data_ = *advertising_data;
     le_extended_advertising_report.rssi_ = rssi;
     advertisements.push_back(le_extended_advertising_report);
 
@@ -16,6 +16,8 @@
 
 #include "hci/hci_layer.h"
 
+#include <algorithm>
+
 #include "common/bind.h"
 #include "common/init_flags.h"
 #include "common/stop_watch.h"
@@ -23,6 +25,7 @@
 #include "os/alarm.h"
 #include "os/metrics.h"
 #include "os/queue.h"
+#include "os/system_properties.h"
 #include "packet/packet_builder.h"
 #include "storage/storage_module.h"
 
@@ -47,6 +50,12 @@ using os::Handler;
 using std::move;
 using std::unique_ptr;
 
+// Allows several commands to be sent before the first one completes, as long as the controller grants credits
+static constexpr char kPipelinedCommandsProperty[] = "bluetooth.hci.pipelined_commands.enabled";
+
+// Number of serialized command buffers kept for reuse
+static constexpr size_t kCommandBufferPoolSize = 8;
+
 static void fail_if_reset_complete_not_success(CommandCompleteView complete) {
   auto reset_complete = ResetCompleteView::Create(complete);
   ASSERT(reset_complete.IsValid());
@@ -70,6 +79,9 @@ class CommandQueueEntry {
 
   unique_ptr<CommandBuilder> command;
   unique_ptr<CommandView> command_view;
+  std::shared_ptr<std::vector<uint8_t>> bytes;
+  OpCode op_code{OpCode::NONE};
+  std::chrono::steady_clock::time_point sent_time;
 
   bool waiting_for_status_;
   ContextualOnceCallback<void(CommandStatusView)> on_status;
@@ -92,7 +104,8 @@ class CommandQueueEntry {
 };
 
 struct HciLayer::impl {
-  impl(hal::HciHal* hal, HciLayer& module) : hal_(hal), module_(module) {
+  impl(hal::HciHal* hal, HciLayer& module)
+      : hal_(hal), module_(module), pipelined_commands_(os::GetSystemProperty(kPipelinedCommandsProperty) == "true") {
     hci_timeout_alarm_ = new Alarm(module.GetHandler());
   }
 
@@ -107,6 +120,8 @@ struct HciLayer::impl {
       delete hci_abort_alarm_;
     }
     command_queue_.clear();
+    sent_commands_.clear();
+    command_buffer_pool_.clear();
   }
 
   void drop(EventView event) {
@@ -174,18 +189,20 @@ struct HciLayer::impl {
     }
     bool is_status = logging_id == "status";
 
-    ASSERT_LOG(!command_queue_.empty(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(), op_code,
+    ASSERT_LOG(!sent_commands_.empty(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(), op_code,
                OpCodeText(op_code).c_str());
-    if (waiting_command_ == OpCode::CONTROLLER_DEBUG_INFO && op_code != OpCode::CONTROLLER_DEBUG_INFO) {
+    OpCode waiting_command = sent_commands_.front().op_code;
+    if (waiting_command == OpCode::CONTROLLER_DEBUG_INFO && op_code != OpCode::CONTROLLER_DEBUG_INFO) {
       LOG_ERROR("Discarding event that came after timeout 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
       return;
     }
-    ASSERT_LOG(waiting_command_ == op_code, "Waiting for 0x%02hx (%s), got 0x%02hx (%s)", waiting_command_,
-               OpCodeText(waiting_command_).c_str(), op_code, OpCodeText(op_code).c_str());
+    auto command = find_sent_command(op_code);
+    ASSERT_LOG(command != sent_commands_.end(), "Waiting for 0x%02hx (%s), got 0x%02hx (%s)", waiting_command,
+               OpCodeText(waiting_command).c_str(), op_code, OpCodeText(op_code).c_str());
 
     bool is_vendor_specific = static_cast<int>(op_code) & (0x3f << 10);
     CommandStatusView status_view = CommandStatusView::Create(event);
-    if (is_vendor_specific && (is_status && !command_queue_.front().waiting_for_status_) &&
+    if (is_vendor_specific && (is_status && !command->waiting_for_status_) &&
         (status_view.IsValid() && status_view.GetStatus() == ErrorCode::UNKNOWN_HCI_COMMAND)) {
       // If this is a command status of a vendor specific command, and command complete is expected, we can't treat
       // this as hard failure since we have no way of probing this lack of support at earlier time. Instead we let
@@ -193,35 +210,55 @@ struct HciLayer::impl {
       // response.
       CommandCompleteView command_complete_view = CommandCompleteView::Create(
           EventView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>()))));
-      command_queue_.front().GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
+      command->GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
     } else {
-      if (command_queue_.front().waiting_for_status_ == is_status) {
-        command_queue_.front().GetCallback<TResponse>()->Invoke(move(response_view));
+      if (command->waiting_for_status_ == is_status) {
+        command->GetCallback<TResponse>()->Invoke(move(response_view));
       } else {
         CommandCompleteView command_complete_view = CommandCompleteView::Create(
             EventView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::vector<uint8_t>()))));
-        command_queue_.front().GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
+        command->GetCallback<CommandCompleteView>()->Invoke(move(command_complete_view));
       }
     }
 
-    command_queue_.pop_front();
-    waiting_command_ = OpCode::NONE;
+    recycle_command_buffer(*command);
+    sent_commands_.erase(command);
     if (hci_timeout_alarm_ != nullptr) {
       hci_timeout_alarm_->Cancel();
+      schedule_hci_timeout();
       send_next_command();
     }
   }
 
+  // The controller answers the commands of a given opcode in the order they were sent, so the response is for the
+  // oldest one
+  std::list<CommandQueueEntry>::iterator find_sent_command(OpCode op_code) {
+    return std::find_if(sent_commands_.begin(), sent_commands_.end(),
+                        [op_code](const CommandQueueEntry& command) { return command.op_code == op_code; });
+  }
+
+  // The timeout is for the oldest command waiting for its response
+  void schedule_hci_timeout() {
+    if (sent_commands_.empty()) {
+      return;
+    }
+    const CommandQueueEntry& oldest = sent_commands_.front();
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - oldest.sent_time);
+    auto delay = elapsed < kHciTimeoutMs ? kHciTimeoutMs - elapsed : std::chrono::milliseconds(0);
+    hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), oldest.op_code), delay);
+  }
+
   void on_hci_timeout(OpCode op_code) {
     common::StopWatch::DumpStopWatchLog();
     LOG_ERROR("Timed out waiting for 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
     // TODO: LogMetricHciTimeoutEvent(static_cast<uint32_t>(op_code));
 
-    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size());
+    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size() + sent_commands_.size());
     // Clear any waiting commands (there is an abort coming anyway)
     command_queue_.clear();
+    sent_commands_.clear();
     command_credits_ = 1;
-    waiting_command_ = OpCode::NONE;
     enqueue_command(
         ControllerDebugInfoBuilder::Create(), module_.GetHandler()->BindOnce(&fail_if_reset_complete_not_success));
     // Don't time out for this one;
@@ -238,33 +275,80 @@ struct HciLayer::impl {
     }
   }
 
-  void send_next_command() {
-    if (command_credits_ == 0) {
-      return;
+  std::shared_ptr<std::vector<uint8_t>> take_command_buffer() {
+    if (command_buffer_pool_.empty()) {
+      return std::make_shared<std::vector<uint8_t>>();
     }
-    if (waiting_command_ != OpCode::NONE) {
-      return;
+    auto buffer = std::move(command_buffer_pool_.back());
+    command_buffer_pool_.pop_back();
+    buffer->clear();
+    return buffer;
+  }
+
+  // Keeps the buffer of an answered command for the next ones, unless a view of it is still alive
+  void recycle_command_buffer(CommandQueueEntry& command) {
+    command.command_view.reset();
+    if (command.bytes.use_count() == 1 && command_buffer_pool_.size() < kCommandBufferPoolSize) {
+      command_buffer_pool_.push_back(std::move(command.bytes));
     }
-    if (command_queue_.size() == 0) {
-      return;
+  }
+
+  // Serializes the command once, when it is first considered for sending. The opcode is the first field of every
+  // command, so it is read from the serialized bytes rather than by parsing them again.
+  OpCode prepare_command(CommandQueueEntry& command) {
+    if (command.command_view == nullptr) {
+      command.bytes = take_command_buffer();
+      command.bytes->reserve(command.command->size());
+      BitInserter bi(*command.bytes);
+      command.command->Serialize(bi);
+      command.command.reset();
+      command.op_code = static_cast<OpCode>((*command.bytes)[0] | ((*command.bytes)[1] << 8));
+      command.command_view =
+          std::make_unique<CommandView>(CommandView::Create(PacketView<kLittleEndian>(command.bytes)));
     }
-    std::shared_ptr<std::vector<uint8_t>> bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter bi(*bytes);
-    command_queue_.front().command->Serialize(bi);
-    hal_->sendHciCommand(*bytes);
-
-    auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(bytes));
-    ASSERT(cmd_view.IsValid());
-    OpCode op_code = cmd_view.GetOpCode();
-    command_queue_.front().command_view = std::make_unique<CommandView>(std::move(cmd_view));
-    log_link_layer_connection_command(command_queue_.front().command_view);
-    log_classic_pairing_command_status(command_queue_.front().command_view, ErrorCode::STATUS_UNKNOWN);
-    waiting_command_ = op_code;
-    command_credits_ = 0;  // Only allow one outstanding command
-    if (hci_timeout_alarm_ != nullptr) {
-      hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), op_code), kHciTimeoutMs);
-    } else {
-      LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(op_code).c_str());
+    return command.op_code;
+  }
+
+  // Reset changes the state of the controller for every other command, and the responses of vendor specific commands
+  // (including the debug information requested after a timeout) are not reliable enough to be matched among others.
+  // These are sent alone.
+  static bool must_be_sent_alone(OpCode op_code) {
+    bool is_vendor_specific = static_cast<int>(op_code) & (0x3f << 10);
+    return op_code == OpCode::RESET || is_vendor_specific;
+  }
+
+  bool can_send_next_command() {
+    if (command_credits_ == 0 || command_queue_.empty()) {
+      return false;
+    }
+    if (sent_commands_.empty()) {
+      return true;
+    }
+    if (!pipelined_commands_ || must_be_sent_alone(sent_commands_.front().op_code)) {
+      return false;
+    }
+    return !must_be_sent_alone(prepare_command(command_queue_.front()));
+  }
+
+  void send_next_command() {
+    while (can_send_next_command()) {
+      CommandQueueEntry& command = command_queue_.front();
+      OpCode op_code = prepare_command(command);
+      hal_->sendHciCommand(*command.bytes);
+      command.sent_time = std::chrono::steady_clock::now();
+
+      log_link_layer_connection_command(command.command_view);
+      log_classic_pairing_command_status(command.command_view, ErrorCode::STATUS_UNKNOWN);
+      command_credits_--;
+      bool first_sent = sent_commands_.empty();
+      sent_commands_.splice(sent_commands_.end(), command_queue_, command_queue_.begin());
+      if (hci_timeout_alarm_ != nullptr) {
+        if (first_sent) {
+          schedule_hci_timeout();
+        }
+      } else {
+        LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(op_code).c_str());
+      }
     }
   }
 
@@ -330,7 +414,7 @@ struct HciLayer::impl {
 
   void on_hci_event(EventView event) {
     ASSERT(event.IsValid());
-    if (command_queue_.empty()) {
+    if (sent_commands_.empty()) {
       auto event_code = event.GetEventCode();
       // BT Core spec 5.2 (Volume 4, Part E section 4.4) allows anytime
       // COMMAND_COMPLETE and COMMAND_STATUS with opcode 0x0 for flow control
@@ -355,7 +439,7 @@ struct HciLayer::impl {
       std::unique_ptr<CommandView> no_waiting_command{nullptr};
       log_hci_event(no_waiting_command, event, module_.GetDependency<storage::StorageModule>());
     } else {
-      log_hci_event(command_queue_.front().command_view, event, module_.GetDependency<storage::StorageModule>());
+      log_hci_event(find_response_command_view(event), event, module_.GetDependency<storage::StorageModule>());
     }
     EventCode event_code = event.GetEventCode();
     // Root Inflamation is a special case, since it aborts here
@@ -378,6 +462,23 @@ struct HciLayer::impl {
     event_handlers_[event_code].Invoke(event);
   }
 
+  // Command view of the command |event| is a response to, or of the oldest command sent for any other event
+  std::unique_ptr<CommandView>& find_response_command_view(EventView event) {
+    if (sent_commands_.size() == 1) {
+      return sent_commands_.front().command_view;
+    }
+    OpCode op_code = OpCode::NONE;
+    if (event.GetEventCode() == EventCode::COMMAND_COMPLETE) {
+      auto view = CommandCompleteView::Create(event);
+      op_code = view.IsValid() ? view.GetCommandOpCode() : OpCode::NONE;
+    } else if (event.GetEventCode() == EventCode::COMMAND_STATUS) {
+      auto view = CommandStatusView::Create(event);
+      op_code = view.IsValid() ? view.GetCommandOpCode() : OpCode::NONE;
+    }
+    auto command = find_sent_command(op_code);
+    return command != sent_commands_.end() ? command->command_view : sent_commands_.front().command_view;
+  }
+
   void on_le_meta_event(EventView event) {
     LeMetaEventView meta_event_view = LeMetaEventView::Create(event);
     ASSERT(meta_event_view.IsValid());
@@ -394,10 +495,13 @@ struct HciLayer::impl {
 
   // Command Handling
   std::list<CommandQueueEntry> command_queue_;
+  // Commands sent to the controller and waiting for their response, oldest first
+  std::list<CommandQueueEntry> sent_commands_;
+  const bool pipelined_commands_;
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> command_buffer_pool_;
 
   std::map<EventCode, ContextualCallback<void(EventView)>> event_handlers_;
   std::map<SubeventCode, ContextualCallback<void(LeMetaEventView)>> subevent_handlers_;
-  OpCode waiting_command_{OpCode::NONE};
   uint8_t command_credits_{1};  // Send reset first
   Alarm* hci_timeout_alarm_{nullptr};
   Alarm* hci_abort_alarm_{nullptr};
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "hal/hci_hal.h"
+#include "hci/hci_layer.h"
+#include "hci/hci_packets.h"
+#include "module.h"
+#include "os/handler.h"
+#include "os/system_properties.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+
+constexpr size_t kCommandsPerIteration = 32;
+constexpr uint16_t kConnectionsPerIteration = 4;
+
+// Controller answering each command |latency| after receiving it, with up to |credits| commands in flight. The
+// responses are sent from a thread of their own, as the HAL does.
+class FakeControllerHal : public hal::HciHal {
+ public:
+  FakeControllerHal(uint8_t credits, std::chrono::microseconds latency)
+      : credits_(credits), latency_(latency), controller_thread_(&FakeControllerHal::Run, this) {}
+
+  ~FakeControllerHal() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    condition_.notify_one();
+    controller_thread_.join();
+  }
+
+  void registerIncomingPacketCallback(hal::HciHalCallbacks* callbacks) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_ = callbacks;
+  }
+
+  void unregisterIncomingPacketCallback() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_ = nullptr;
+  }
+
+  void sendHciCommand(hal::HciPacket command) override {
+    auto view = CommandView::Create(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(command)));
+    ASSERT(view.IsValid());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ASSERT_LOG(received_.size() < credits_, "The host sent more commands than the credits granted");
+      received_.push_back({view.GetOpCode(), std::chrono::steady_clock::now() + latency_});
+    }
+    condition_.notify_one();
+  }
+
+  void sendAclData(hal::HciPacket) override {}
+  void sendScoData(hal::HciPacket) override {}
+  void sendIsoData(hal::HciPacket) override {}
+
+  void Start() {}
+  void Stop() {}
+  void ListDependencies(ModuleList*) const {}
+  std::string ToString() const override {
+    return std::string("FakeControllerHal");
+  }
+
+ private:
+  struct ReceivedCommand {
+    OpCode op_code;
+    std::chrono::steady_clock::time_point response_time;
+  };
+
+  static bool IsAnsweredWithStatus(OpCode op_code) {
+    return op_code == OpCode::LE_READ_REMOTE_FEATURES || op_code == OpCode::READ_REMOTE_VERSION_INFORMATION;
+  }
+
+  static std::vector<uint8_t> MakeResponse(OpCode op_code, uint8_t num_packets) {
+    std::unique_ptr<EventBuilder> event;
+    if (IsAnsweredWithStatus(op_code)) {
+      event = CommandStatusBuilder::Create(
+          ErrorCode::SUCCESS, num_packets, op_code, std::make_unique<packet::RawBuilder>());
+    } else {
+      event = CommandCompleteBuilder::Create(
+          num_packets, op_code, std::make_unique<packet::RawBuilder>(std::vector<uint8_t>{0x00 /* SUCCESS */}));
+    }
+    std::vector<uint8_t> bytes;
+    packet::BitInserter inserter(bytes);
+    event->Serialize(inserter);
+    return bytes;
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+      if (received_.empty()) {
+        condition_.wait(lock);
+        continue;
+      }
+      auto response_time = received_.front().response_time;
+      if (std::chrono::steady_clock::now() < response_time) {
+        condition_.wait_until(lock, response_time);
+        continue;
+      }
+      OpCode op_code = received_.front().op_code;
+      received_.pop_front();
+      auto response = MakeResponse(op_code, credits_ - received_.size());
+      auto callbacks = callbacks_;
+      lock.unlock();
+      if (callbacks != nullptr) {
+        callbacks->hciEventReceived(std::move(response));
+      }
+      lock.lock();
+    }
+  }
+
+  const uint8_t credits_;
+  const std::chrono::microseconds latency_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::list<ReceivedCommand> received_;
+  hal::HciHalCallbacks* callbacks_ = nullptr;
+  bool stopped_ = false;
+  std::thread controller_thread_;
+};
+
+static void OnComplete(std::function<void()> on_response, CommandCompleteView) {
+  on_response();
+}
+
+static void OnStatus(std::function<void()> on_response, CommandStatusView) {
+  on_response();
+}
+
+// state.range(0) enables the pipelined commands, state.range(1) is the number of credits of the controller and
+// state.range(2) its latency in microseconds
+class BM_HciLayer : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    os::SetSystemProperty("bluetooth.hci.pipelined_commands.enabled", st.range(0) ? "true" : "false");
+    registry_ = std::make_unique<TestModuleRegistry>();
+    registry_->InjectTestModule(
+        &hal::HciHal::Factory,
+        new FakeControllerHal(static_cast<uint8_t>(st.range(1)), std::chrono::microseconds(st.range(2))));
+    hci_ = registry_->Start<HciLayer>(&registry_->GetTestThread());
+    handler_ = new os::Handler(&registry_->GetTestThread());
+    // A first round trip, so that the reset sent when starting is done
+    SendAndWait(
+        [](HciLayer* hci, os::Handler* handler, std::function<void()> on_response) {
+          hci->EnqueueCommand(
+              ReadLocalVersionInformationBuilder::Create(), handler->BindOnce(&OnComplete, on_response));
+        },
+        1);
+  }
+
+  void TearDown(State& st) override {
+    handler_->Clear();
+    delete handler_;
+    registry_->StopAll();
+    registry_.reset();
+    os::ClearSystemPropertiesForHost();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Calls |send| with a callback to invoke on each response, and waits for |num_responses| of them
+  void SendAndWait(std::function<void(HciLayer*, os::Handler*, std::function<void()>)> send, size_t num_responses) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    size_t remaining = num_responses;
+    send(hci_, handler_, [&promise, &remaining]() {
+      if (--remaining == 0) {
+        promise.set_value();
+      }
+    });
+    future.wait();
+  }
+
+  std::unique_ptr<TestModuleRegistry> registry_;
+  HciLayer* hci_ = nullptr;
+  os::Handler* handler_ = nullptr;
+};
+
+// Independent commands, as sent when reading the RSSI of every connection
+BENCHMARK_DEFINE_F(BM_HciLayer, commands_per_second)(State& state) {
+  for (auto _ : state) {
+    SendAndWait(
+        [](HciLayer* hci, os::Handler* handler, std::function<void()> on_response) {
+          for (uint16_t handle = 0; handle < kCommandsPerIteration; handle++) {
+            hci->EnqueueCommand(ReadRssiBuilder::Create(handle), handler->BindOnce(&OnComplete, on_response));
+          }
+        },
+        kCommandsPerIteration);
+  }
+  state.SetItemsProcessed(state.iterations() * kCommandsPerIteration);
+}
+BENCHMARK_REGISTER_F(BM_HciLayer, commands_per_second)
+    ->Args({0, 4, 200})
+    ->Args({1, 1, 200})
+    ->Args({1, 4, 200})
+    ->UseRealTime();
+
+// Commands answered as soon as they are sent, so that the cost of sending and matching them in the host dominates
+BENCHMARK_DEFINE_F(BM_HciLayer, host_commands_per_second)(State& state) {
+  for (auto _ : state) {
+    SendAndWait(
+        [](HciLayer* hci, os::Handler* handler, std::function<void()> on_response) {
+          for (uint16_t handle = 0; handle < kCommandsPerIteration; handle++) {
+            hci->EnqueueCommand(ReadRssiBuilder::Create(handle), handler->BindOnce(&OnComplete, on_response));
+          }
+        },
+        kCommandsPerIteration);
+  }
+  state.SetItemsProcessed(state.iterations() * kCommandsPerIteration);
+}
+BENCHMARK_REGISTER_F(BM_HciLayer, host_commands_per_second)->Args({0, 1, 0})->UseRealTime();
+
+// Commands sent by the stack when LE connections complete, until the controller answered all of them
+BENCHMARK_DEFINE_F(BM_HciLayer, connection_setup)(State& state) {
+  for (auto _ : state) {
+    SendAndWait(
+        [](HciLayer* hci, os::Handler* handler, std::function<void()> on_response) {
+          for (uint16_t handle = 0; handle < kConnectionsPerIteration; handle++) {
+            hci->EnqueueCommand(LeReadRemoteFeaturesBuilder::Create(handle), handler->BindOnce(&OnStatus, on_response));
+            hci->EnqueueCommand(
+                ReadRemoteVersionInformationBuilder::Create(handle), handler->BindOnce(&OnStatus, on_response));
+            hci->EnqueueCommand(
+                LeSetDataLengthBuilder::Create(handle, 0x00fb, 0x0848), handler->BindOnce(&OnComplete, on_response));
+            hci->EnqueueCommand(LeReadPhyBuilder::Create(handle), handler->BindOnce(&OnComplete, on_response));
+          }
+        },
+        kConnectionsPerIteration * 4);
+  }
+  state.SetItemsProcessed(state.iterations() * kConnectionsPerIteration);
+}
+BENCHMARK_REGISTER_F(BM_HciLayer, connection_setup)->Args({0, 4, 200})->Args({1, 4, 200})->UseRealTime();
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -24,6 +24,7 @@
 #include "hci/hci_packets.h"
 #include "module.h"
 #include "os/log.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 #include "packet/bit_inserter.h"
 #include "packet/raw_builder.h"
@@ -621,6 +622,150 @@ TEST_F(HciTest, creditsTest) {
       ReadLocalSupportedFeaturesCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
 }
 
+TEST_F(HciTest, commandSentFromReusedBuffer) {
+  // Send a long command, whose buffer is reused once it completes
+  auto command_future = hal->GetSentCommandFuture();
+  std::array<uint8_t, 248> local_name;
+  local_name.fill('a');
+  upper->SendHciCommandExpectingComplete(WriteLocalNameBuilder::Create(local_name));
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  auto sent_command = hal->GetSentCommand();
+  ASSERT_TRUE(sent_command.IsValid());
+  ASSERT_EQ(OpCode::WRITE_LOCAL_NAME, sent_command.GetOpCode());
+  ASSERT_TRUE(WriteLocalNameView::Create(sent_command).IsValid());
+
+  auto event_future = upper->GetReceivedEventFuture();
+  uint8_t num_packets = 1;
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  hal->callbacks->hciEventReceived(GetPacketBytes(WriteLocalNameCompleteBuilder::Create(num_packets, error_code)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(WriteLocalNameCompleteView::Create(CommandCompleteView::Create(upper->GetReceivedEvent())).IsValid());
+
+  // Verify that a shorter command sent next carries none of the previous bytes
+  command_future = hal->GetSentCommandFuture();
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  sent_command = hal->GetSentCommand();
+  ASSERT_TRUE(sent_command.IsValid());
+  ASSERT_EQ(OpCode::READ_LOCAL_VERSION_INFORMATION, sent_command.GetOpCode());
+  ASSERT_EQ(GetPacketBytes(ReadLocalVersionInformationBuilder::Create()).size(), sent_command.size());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(sent_command).IsValid());
+
+  event_future = upper->GetReceivedEventFuture();
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  local_version_information.lmp_version_ = LmpVersion::V_4_2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  auto event = upper->GetReceivedEvent();
+  ASSERT_TRUE(ReadLocalVersionInformationCompleteView::Create(CommandCompleteView::Create(event)).IsValid());
+}
+
+class HciPipelinedTest : public HciTest {
+ public:
+  void SetUp() override {
+    os::SetSystemProperty("bluetooth.hci.pipelined_commands.enabled", "true");
+    HciTest::SetUp();
+  }
+
+  void TearDown() override {
+    HciTest::TearDown();
+    os::ClearSystemPropertiesForHost();
+  }
+
+  void Synchronize() {
+    ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+    ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&DependsOnHci::Factory, kTimeout));
+  }
+};
+
+TEST_F(HciPipelinedTest, commandsSentUpToCredits) {
+  uint8_t num_packets = 2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedFeaturesBuilder::Create());
+  Synchronize();
+
+  // Verify that two were sent, in order
+  ASSERT_EQ(2, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(hal->GetSentCommand()).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedCommandsView::Create(hal->GetSentCommand()).IsValid());
+
+  // The controller completes the second one first
+  num_packets = 1;
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  std::array<uint8_t, 64> supported_commands{};
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedCommandsCompleteBuilder::Create(num_packets, error_code, supported_commands)));
+  Synchronize();
+
+  auto event = upper->GetReceivedEvent();
+  ASSERT_TRUE(
+      ReadLocalSupportedCommandsCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
+
+  // Verify that the third one is sent with the returned credit
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalSupportedFeaturesView::Create(hal->GetSentCommand()).IsValid());
+
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  local_version_information.lmp_version_ = LmpVersion::V_4_2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  uint64_t lmp_features = 0x012345678abcdef;
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedFeaturesCompleteBuilder::Create(num_packets, error_code, lmp_features)));
+  Synchronize();
+
+  event = upper->GetReceivedEvent();
+  ASSERT_TRUE(
+      ReadLocalVersionInformationCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
+  event = upper->GetReceivedEvent();
+  ASSERT_TRUE(
+      ReadLocalSupportedFeaturesCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+}
+
+TEST_F(HciPipelinedTest, resetSentAlone) {
+  uint8_t num_packets = 3;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ResetBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  Synchronize();
+
+  // Verify that the reset waits for the first command
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(hal->GetSentCommand()).IsValid());
+
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  local_version_information.lmp_version_ = LmpVersion::V_4_2;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  Synchronize();
+
+  // Verify that nothing is sent with the reset
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ResetView::Create(hal->GetSentCommand()).IsValid());
+
+  hal->callbacks->hciEventReceived(GetPacketBytes(ResetCompleteBuilder::Create(num_packets, error_code)));
+  Synchronize();
+
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalSupportedCommandsView::Create(hal->GetSentCommand()).IsValid());
+  auto event = upper->GetReceivedEvent();
+  ASSERT_TRUE(
+      ReadLocalVersionInformationCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
+  event = upper->GetReceivedEvent();
+  ASSERT_TRUE(ResetCompleteView::Create(CommandCompleteView::Create(EventView::Create(event))).IsValid());
+}
+
 TEST_F(HciTest, leSecurityInterfaceTest) {
   // Send LeRand to the controller
   auto command_future = hal->GetSentCommandFuture();
@@ -15,6 +15,10 @@
  */
 
 #include "hci/le_address_manager.h"
+
+#include <algorithm>
+#include <iterator>
+
 #include "common/init_flags.h"
 #include "os/log.h"
 #include "os/rand.h"
@@ -231,7 +235,7 @@ void LeAddressManager::pause_registered_clients() {
 
 void LeAddressManager::push_command(Command command) {
   pause_registered_clients();
-  cached_commands_.push(std::move(command));
+  cached_commands_.push_back(std::move(command));
 }
 
 void LeAddressManager::ack_pause(LeAddressManagerCallback* callback) {
@@ -277,7 +281,7 @@ void LeAddressManager::ack_resume(LeAddressManagerCallback* callback) {
 
 void LeAddressManager::prepare_to_rotate() {
   Command command = {CommandType::ROTATE_RANDOM_ADDRESS, nullptr};
-  cached_commands_.push(std::move(command));
+  cached_commands_.push_back(std::move(command));
   pause_registered_clients();
 }
 
@@ -394,11 +398,16 @@ void LeAddressManager::handle_next_command() {
 
   ASSERT(!cached_commands_.empty());
   auto command = std::move(cached_commands_.front());
-  cached_commands_.pop();
+  cached_commands_.pop_front();
 
   if (command.command_type == CommandType::ROTATE_RANDOM_ADDRESS) {
     rotate_random_address();
+  } else if (exceeds_list_sizes(command.list_update)) {
+    // The commands before this one have completed, so the tracked lists are those of the controller
+    LOG_WARN("Dropping a device that does not fit in the filter accept list or the resolving list");
+    handler_->BindOnceOn(this, &LeAddressManager::check_cached_commands).Invoke();
   } else {
+    sent_list_update_ = std::move(command.list_update);
     enqueue_command_.Run(std::move(command.command_packet));
   }
 }
@@ -406,7 +415,9 @@ void LeAddressManager::handle_next_command() {
 void LeAddressManager::AddDeviceToFilterAcceptList(
     FilterAcceptListAddressType connect_list_address_type, bluetooth::hci::Address address) {
   auto packet_builder = hci::LeAddDeviceToFilterAcceptListBuilder::Create(connect_list_address_type, address);
-  Command command = {CommandType::ADD_DEVICE_TO_CONNECT_LIST, std::move(packet_builder)};
+  ListUpdate update;
+  update.AddDeviceToFilterAcceptList(connect_list_address_type, address);
+  Command command = {CommandType::ADD_DEVICE_TO_CONNECT_LIST, std::move(packet_builder), std::move(update)};
   handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
 }
 
@@ -418,24 +429,26 @@ void LeAddressManager::AddDeviceToResolvingList(
   // Disable Address resolution
   auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
   Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(disable_builder)};
-  cached_commands_.push(std::move(disable));
+  cached_commands_.push_back(std::move(disable));
 
   auto packet_builder = hci::LeAddDeviceToResolvingListBuilder::Create(
       peer_identity_address_type, peer_identity_address, peer_irk, local_irk);
-  Command command = {CommandType::ADD_DEVICE_TO_RESOLVING_LIST, std::move(packet_builder)};
-  cached_commands_.push(std::move(command));
+  ListUpdate update;
+  update.AddDeviceToResolvingList(peer_identity_address_type, peer_identity_address, peer_irk, local_irk);
+  Command command = {CommandType::ADD_DEVICE_TO_RESOLVING_LIST, std::move(packet_builder), std::move(update)};
+  cached_commands_.push_back(std::move(command));
 
   if (supports_ble_privacy_) {
     auto packet_builder =
         hci::LeSetPrivacyModeBuilder::Create(peer_identity_address_type, peer_identity_address, PrivacyMode::DEVICE);
     Command command = {CommandType::LE_SET_PRIVACY_MODE, std::move(packet_builder)};
-    cached_commands_.push(std::move(command));
+    cached_commands_.push_back(std::move(command));
   }
 
   // Enable Address resolution
   auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
   Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(enable_builder)};
-  cached_commands_.push(std::move(enable));
+  cached_commands_.push_back(std::move(enable));
 
   if (registered_clients_.empty()) {
     handler_->BindOnceOn(this, &LeAddressManager::handle_next_command).Invoke();
@@ -447,7 +460,9 @@ void LeAddressManager::AddDeviceToResolvingList(
 void LeAddressManager::RemoveDeviceFromFilterAcceptList(
     FilterAcceptListAddressType connect_list_address_type, bluetooth::hci::Address address) {
   auto packet_builder = hci::LeRemoveDeviceFromFilterAcceptListBuilder::Create(connect_list_address_type, address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST, std::move(packet_builder)};
+  ListUpdate update;
+  update.RemoveDeviceFromFilterAcceptList(connect_list_address_type, address);
+  Command command = {CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST, std::move(packet_builder), std::move(update)};
   handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
 }
 
@@ -456,17 +471,19 @@ void LeAddressManager::RemoveDeviceFromResolvingList(
   // Disable Address resolution
   auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
   Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(disable_builder)};
-  cached_commands_.push(std::move(disable));
+  cached_commands_.push_back(std::move(disable));
 
   auto packet_builder =
       hci::LeRemoveDeviceFromResolvingListBuilder::Create(peer_identity_address_type, peer_identity_address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, std::move(packet_builder)};
-  cached_commands_.push(std::move(command));
+  ListUpdate update;
+  update.RemoveDeviceFromResolvingList(peer_identity_address_type, peer_identity_address);
+  Command command = {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, std::move(packet_builder), std::move(update)};
+  cached_commands_.push_back(std::move(command));
 
   // Enable Address resolution
   auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
   Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(enable_builder)};
-  cached_commands_.push(std::move(enable));
+  cached_commands_.push_back(std::move(enable));
 
   if (registered_clients_.empty()) {
     handler_->BindOnceOn(this, &LeAddressManager::handle_next_command).Invoke();
@@ -477,7 +494,9 @@ void LeAddressManager::RemoveDeviceFromResolvingList(
 
 void LeAddressManager::ClearFilterAcceptList() {
   auto packet_builder = hci::LeClearFilterAcceptListBuilder::Create();
-  Command command = {CommandType::CLEAR_CONNECT_LIST, std::move(packet_builder)};
+  ListUpdate update;
+  update.ClearFilterAcceptList();
+  Command command = {CommandType::CLEAR_CONNECT_LIST, std::move(packet_builder), std::move(update)};
   handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
 }
 
@@ -485,20 +504,233 @@ void LeAddressManager::ClearResolvingList() {
   // Disable Address resolution
   auto disable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED);
   Command disable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(disable_builder)};
-  cached_commands_.push(std::move(disable));
+  cached_commands_.push_back(std::move(disable));
 
   auto packet_builder = hci::LeClearResolvingListBuilder::Create();
-  Command command = {CommandType::CLEAR_RESOLVING_LIST, std::move(packet_builder)};
-  cached_commands_.push(std::move(command));
+  ListUpdate update;
+  update.ClearResolvingList();
+  Command command = {CommandType::CLEAR_RESOLVING_LIST, std::move(packet_builder), std::move(update)};
+  cached_commands_.push_back(std::move(command));
 
   // Enable Address resolution
   auto enable_builder = hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED);
   Command enable = {CommandType::SET_ADDRESS_RESOLUTION_ENABLE, std::move(enable_builder)};
-  cached_commands_.push(std::move(enable));
+  cached_commands_.push_back(std::move(enable));
 
   handler_->BindOnceOn(this, &LeAddressManager::pause_registered_clients).Invoke();
 }
 
+void LeAddressManager::ListUpdate::AddDeviceToFilterAcceptList(
+    FilterAcceptListAddressType connect_list_address_type, Address address) {
+  filter_accept_list_changes_.push_back({Operation::ADD, {connect_list_address_type, address}});
+}
+
+void LeAddressManager::ListUpdate::RemoveDeviceFromFilterAcceptList(
+    FilterAcceptListAddressType connect_list_address_type, Address address) {
+  filter_accept_list_changes_.push_back({Operation::REMOVE, {connect_list_address_type, address}});
+}
+
+void LeAddressManager::ListUpdate::ClearFilterAcceptList() {
+  filter_accept_list_changes_.push_back({Operation::CLEAR, {}});
+}
+
+void LeAddressManager::ListUpdate::AddDeviceToResolvingList(
+    PeerAddressType peer_identity_address_type,
+    Address peer_identity_address,
+    const std::array<uint8_t, 16>& peer_irk,
+    const std::array<uint8_t, 16>& local_irk) {
+  resolving_list_changes_.push_back(
+      {Operation::ADD, {peer_identity_address_type, peer_identity_address}, {peer_irk, local_irk}});
+}
+
+void LeAddressManager::ListUpdate::RemoveDeviceFromResolvingList(
+    PeerAddressType peer_identity_address_type, Address peer_identity_address) {
+  resolving_list_changes_.push_back({Operation::REMOVE, {peer_identity_address_type, peer_identity_address}, {}});
+}
+
+void LeAddressManager::ListUpdate::ClearResolvingList() {
+  resolving_list_changes_.push_back({Operation::CLEAR, {}, {}});
+}
+
+void LeAddressManager::ListUpdate::Apply(FilterAcceptList* filter_accept_list, ResolvingList* resolving_list) const {
+  for (const auto& change : filter_accept_list_changes_) {
+    switch (change.operation) {
+      case Operation::ADD:
+        filter_accept_list->insert(change.entry);
+        break;
+      case Operation::REMOVE:
+        filter_accept_list->erase(change.entry);
+        break;
+      case Operation::CLEAR:
+        filter_accept_list->clear();
+        break;
+    }
+  }
+  for (const auto& change : resolving_list_changes_) {
+    switch (change.operation) {
+      case Operation::ADD:
+        (*resolving_list)[change.entry] = change.irks;
+        break;
+      case Operation::REMOVE:
+        resolving_list->erase(change.entry);
+        break;
+      case Operation::CLEAR:
+        resolving_list->clear();
+        break;
+    }
+  }
+}
+
+void LeAddressManager::CommitListUpdate(ListUpdate update) {
+  handler_->BindOnceOn(this, &LeAddressManager::commit_list_update, std::move(update)).Invoke();
+}
+
+void LeAddressManager::commit_list_update(ListUpdate update) {
+  // Diff against the lists the controller has once the commands sent and cached complete
+  FilterAcceptList current_filter_accept_list = filter_accept_list_;
+  ResolvingList current_resolving_list = resolving_list_;
+  sent_list_update_.Apply(&current_filter_accept_list, &current_resolving_list);
+  for (const auto& command : cached_commands_) {
+    command.list_update.Apply(&current_filter_accept_list, &current_resolving_list);
+  }
+  FilterAcceptList filter_accept_list = current_filter_accept_list;
+  ResolvingList resolving_list = current_resolving_list;
+  update.Apply(&filter_accept_list, &resolving_list);
+  std::vector<Command> commands;
+
+  std::vector<FilterAcceptListEntry> removed_devices;
+  std::set_difference(
+      current_filter_accept_list.begin(),
+      current_filter_accept_list.end(),
+      filter_accept_list.begin(),
+      filter_accept_list.end(),
+      std::back_inserter(removed_devices));
+  std::vector<FilterAcceptListEntry> added_devices;
+  std::set_difference(
+      filter_accept_list.begin(),
+      filter_accept_list.end(),
+      current_filter_accept_list.begin(),
+      current_filter_accept_list.end(),
+      std::back_inserter(added_devices));
+  // Removals first, so that the additions find room in the list
+  if (filter_accept_list.empty() && removed_devices.size() > 1) {
+    ListUpdate list_update;
+    list_update.ClearFilterAcceptList();
+    commands.push_back(
+        {CommandType::CLEAR_CONNECT_LIST, hci::LeClearFilterAcceptListBuilder::Create(), std::move(list_update)});
+  } else {
+    for (const auto& device : removed_devices) {
+      ListUpdate list_update;
+      list_update.RemoveDeviceFromFilterAcceptList(device.first, device.second);
+      commands.push_back(
+          {CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST,
+           hci::LeRemoveDeviceFromFilterAcceptListBuilder::Create(device.first, device.second),
+           std::move(list_update)});
+    }
+  }
+  size_t room = current_filter_accept_list.size() - removed_devices.size() < connect_list_size_
+                    ? connect_list_size_ - (current_filter_accept_list.size() - removed_devices.size())
+                    : 0;
+  if (added_devices.size() > room) {
+    LOG_WARN("Filter accept list full, leaving out %zu devices", added_devices.size() - room);
+    added_devices.resize(room);
+  }
+  for (const auto& device : added_devices) {
+    ListUpdate list_update;
+    list_update.AddDeviceToFilterAcceptList(device.first, device.second);
+    commands.push_back(
+        {CommandType::ADD_DEVICE_TO_CONNECT_LIST,
+         hci::LeAddDeviceToFilterAcceptListBuilder::Create(device.first, device.second),
+         std::move(list_update)});
+  }
+
+  // A peer whose keys changed is removed and added again
+  std::vector<ResolvingListEntry> removed_peers;
+  for (const auto& peer : current_resolving_list) {
+    auto it = resolving_list.find(peer.first);
+    if (it == resolving_list.end() || !(it->second == peer.second)) {
+      removed_peers.push_back(peer.first);
+    }
+  }
+  std::vector<ResolvingListEntry> added_peers;
+  for (const auto& peer : resolving_list) {
+    auto it = current_resolving_list.find(peer.first);
+    if (it == current_resolving_list.end() || !(it->second == peer.second)) {
+      added_peers.push_back(peer.first);
+    }
+  }
+  room = current_resolving_list.size() - removed_peers.size() < resolving_list_size_
+             ? resolving_list_size_ - (current_resolving_list.size() - removed_peers.size())
+             : 0;
+  if (added_peers.size() > room) {
+    LOG_WARN("Resolving list full, leaving out %zu devices", added_peers.size() - room);
+    added_peers.resize(room);
+  }
+  if (!removed_peers.empty() || !added_peers.empty()) {
+    // Address resolution is disabled once for all the changes
+    commands.push_back(
+        {CommandType::SET_ADDRESS_RESOLUTION_ENABLE,
+         hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::DISABLED)});
+    if (resolving_list.empty() && removed_peers.size() > 1) {
+      ListUpdate list_update;
+      list_update.ClearResolvingList();
+      commands.push_back(
+          {CommandType::CLEAR_RESOLVING_LIST, hci::LeClearResolvingListBuilder::Create(), std::move(list_update)});
+    } else {
+      for (const auto& peer : removed_peers) {
+        ListUpdate list_update;
+        list_update.RemoveDeviceFromResolvingList(peer.first, peer.second);
+        commands.push_back(
+            {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST,
+             hci::LeRemoveDeviceFromResolvingListBuilder::Create(peer.first, peer.second),
+             std::move(list_update)});
+      }
+    }
+    for (const auto& peer : added_peers) {
+      const auto& irks = resolving_list[peer];
+      ListUpdate list_update;
+      list_update.AddDeviceToResolvingList(peer.first, peer.second, irks.peer_irk, irks.local_irk);
+      commands.push_back(
+          {CommandType::ADD_DEVICE_TO_RESOLVING_LIST,
+           hci::LeAddDeviceToResolvingListBuilder::Create(peer.first, peer.second, irks.peer_irk, irks.local_irk),
+           std::move(list_update)});
+      if (supports_ble_privacy_) {
+        commands.push_back(
+            {CommandType::LE_SET_PRIVACY_MODE,
+             hci::LeSetPrivacyModeBuilder::Create(peer.first, peer.second, PrivacyMode::DEVICE)});
+      }
+    }
+    commands.push_back(
+        {CommandType::SET_ADDRESS_RESOLUTION_ENABLE,
+         hci::LeSetAddressResolutionEnableBuilder::Create(hci::Enable::ENABLED)});
+  }
+
+  push_list_commands(std::move(commands));
+}
+
+bool LeAddressManager::exceeds_list_sizes(const ListUpdate& update) const {
+  FilterAcceptList filter_accept_list = filter_accept_list_;
+  ResolvingList resolving_list = resolving_list_;
+  update.Apply(&filter_accept_list, &resolving_list);
+  return (filter_accept_list.size() > filter_accept_list_.size() && filter_accept_list.size() > connect_list_size_) ||
+         (resolving_list.size() > resolving_list_.size() && resolving_list.size() > resolving_list_size_);
+}
+
+void LeAddressManager::push_list_commands(std::vector<Command> commands) {
+  if (commands.empty()) {
+    return;
+  }
+  LOG_INFO("Updating the filter accept list and the resolving list with %zu commands", commands.size());
+  for (auto& command : commands) {
+    cached_commands_.push_back(std::move(command));
+  }
+  if (registered_clients_.empty()) {
+    handle_next_command();
+  } else {
+    pause_registered_clients();
+  }
+}
+
 template <class View>
 void LeAddressManager::on_command_complete(CommandCompleteView view) {
   auto op_code = view.GetCommandOpCode();
@@ -514,7 +746,10 @@ void LeAddressManager::on_command_complete(CommandCompleteView view) {
         "Received %s complete with status %s",
         hci::OpCodeText(op_code).c_str(),
         ErrorCodeText(complete_view.GetStatus()).c_str());
+    return;
   }
+  // The lists of the controller only change when the command succeeds
+  sent_list_update_.Apply(&filter_accept_list_, &resolving_list_);
 }
 
 void LeAddressManager::OnCommandComplete(bluetooth::hci::CommandCompleteView view) {
@@ -584,6 +819,7 @@ void LeAddressManager::OnCommandComplete(bluetooth::hci::CommandCompleteView vie
       LOG_ERROR("Received UNSUPPORTED command %s complete", hci::OpCodeText(op_code).c_str());
       break;
   }
+  sent_list_update_ = ListUpdate();
 
   handler_->BindOnceOn(this, &LeAddressManager::check_cached_commands).Invoke();
 }
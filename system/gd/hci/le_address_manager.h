@@ -15,9 +15,13 @@
  */
 #pragma once
 
+#include <array>
+#include <deque>
 #include <map>
 #include <mutex>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include "common/callback.h"
 #include "hci/address_with_type.h"
@@ -46,6 +50,51 @@ class LeAddressManager {
       uint8_t resolving_list_size);
   virtual ~LeAddressManager();
 
+  using FilterAcceptListEntry = std::pair<FilterAcceptListAddressType, Address>;
+  using ResolvingListEntry = std::pair<PeerAddressType, Address>;
+  struct ResolvingListIrks {
+    std::array<uint8_t, 16> peer_irk;
+    std::array<uint8_t, 16> local_irk;
+    bool operator==(const ResolvingListIrks& other) const {
+      return peer_irk == other.peer_irk && local_irk == other.local_irk;
+    }
+  };
+  using FilterAcceptList = std::set<FilterAcceptListEntry>;
+  using ResolvingList = std::map<ResolvingListEntry, ResolvingListIrks>;
+
+  // Changes to the filter accept list and the resolving list, recorded in order and applied together by
+  // CommitListUpdate()
+  class ListUpdate {
+   public:
+    void AddDeviceToFilterAcceptList(FilterAcceptListAddressType connect_list_address_type, Address address);
+    void RemoveDeviceFromFilterAcceptList(FilterAcceptListAddressType connect_list_address_type, Address address);
+    void ClearFilterAcceptList();
+    void AddDeviceToResolvingList(
+        PeerAddressType peer_identity_address_type,
+        Address peer_identity_address,
+        const std::array<uint8_t, 16>& peer_irk,
+        const std::array<uint8_t, 16>& local_irk);
+    void RemoveDeviceFromResolvingList(PeerAddressType peer_identity_address_type, Address peer_identity_address);
+    void ClearResolvingList();
+
+    // Applies the changes to the lists, in the order they were recorded for each list
+    void Apply(FilterAcceptList* filter_accept_list, ResolvingList* resolving_list) const;
+
+   private:
+    enum class Operation { ADD, REMOVE, CLEAR };
+    struct FilterAcceptListChange {
+      Operation operation;
+      FilterAcceptListEntry entry;
+    };
+    struct ResolvingListChange {
+      Operation operation;
+      ResolvingListEntry entry;
+      ResolvingListIrks irks;
+    };
+    std::vector<FilterAcceptListChange> filter_accept_list_changes_;
+    std::vector<ResolvingListChange> resolving_list_changes_;
+  };
+
   enum AddressPolicy {
     POLICY_NOT_SET,
     USE_PUBLIC_ADDRESS,
@@ -91,6 +140,10 @@ class LeAddressManager {
   void RemoveDeviceFromResolvingList(PeerAddressType peer_identity_address_type, Address peer_identity_address);
   void ClearFilterAcceptList();
   void ClearResolvingList();
+  // Sends the commands bringing the lists of the controller from their current content to the content after |update|,
+  // while the clients are paused once. Devices added and removed by |update| cost no command, and devices that do not
+  // fit in the lists of the controller are left out.
+  void CommitListUpdate(ListUpdate update);
   void OnCommandComplete(CommandCompleteView view);
   std::chrono::milliseconds GetNextPrivateAddressIntervalMs();
 
@@ -115,8 +168,12 @@ class LeAddressManager {
   };
 
   struct Command {
+    Command(CommandType command_type, std::unique_ptr<CommandBuilder> command_packet, ListUpdate list_update = {})
+        : command_type(command_type), command_packet(std::move(command_packet)), list_update(std::move(list_update)) {}
     CommandType command_type;
     std::unique_ptr<CommandBuilder> command_packet;
+    // Change to the lists of the controller once the command completes successfully
+    ListUpdate list_update;
   };
 
   void pause_registered_clients();
@@ -134,6 +191,9 @@ class LeAddressManager {
   hci::Address generate_nrpa();
   void handle_next_command();
   void check_cached_commands();
+  void commit_list_update(ListUpdate update);
+  void push_list_commands(std::vector<Command> commands);
+  bool exceeds_list_sizes(const ListUpdate& update) const;
   template <class View>
   void on_command_complete(CommandCompleteView view);
 
@@ -151,7 +211,12 @@ class LeAddressManager {
   std::chrono::milliseconds maximum_rotation_time_;
   uint8_t connect_list_size_;
   uint8_t resolving_list_size_;
-  std::queue<Command> cached_commands_;
+  std::deque<Command> cached_commands_;
+  // Content of the lists of the controller, as confirmed by the completed commands
+  FilterAcceptList filter_accept_list_;
+  ResolvingList resolving_list_;
+  // Change made by the command sent to the controller, applied when it completes successfully
+  ListUpdate sent_list_update_;
   bool supports_ble_privacy_{false};
 };
 
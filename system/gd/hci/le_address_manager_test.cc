@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+
 #include "common/init_flags.h"
 #include "os/log.h"
 #include "packet/raw_builder.h"
@@ -90,6 +93,24 @@ class TestHciLayer : public HciLayer {
     return command_packet_view;
   }
 
+  CommandView GetNextCommand() {
+    if (!command_queue_.empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (command_future_ != nullptr) {
+        command_future_.reset();
+        command_promise_.reset();
+      }
+    } else if (command_future_ != nullptr) {
+      auto result = command_future_->wait_for(std::chrono::milliseconds(1000));
+      EXPECT_NE(std::future_status::timeout, result);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT_LOG(!command_queue_.empty(), "Expecting a command but command queue was empty");
+    CommandView command_packet_view = GetLastCommand();
+    EXPECT_TRUE(command_packet_view.IsValid());
+    return command_packet_view;
+  }
+
   void IncomingEvent(std::unique_ptr<EventBuilder> event_builder) {
     auto packet = GetPacketView(std::move(event_builder));
     EventView event = EventView::Create(packet);
@@ -122,6 +143,7 @@ class RotatorClient : public LeAddressManagerCallback {
 
   void OnPause() {
     paused = true;
+    pause_count++;
     le_address_manager_->AckPause(this);
   }
 
@@ -144,6 +166,7 @@ class RotatorClient : public LeAddressManagerCallback {
   }
 
   bool paused{false};
+  size_t pause_count{0};
   LeAddressManager* le_address_manager_;
   size_t id_;
   std::unique_ptr<std::promise<void>> resume_promise_;
@@ -216,6 +239,7 @@ TEST_F(LeAddressManagerTest, rotator_address_for_single_client) {
       LeAddressManager::AddressPolicy::USE_RESOLVABLE_ADDRESS,
       remote_address,
       irk,
+      false,
       minimum_rotation_time,
       maximum_rotation_time);
 
@@ -238,6 +262,7 @@ TEST_F(LeAddressManagerTest, rotator_non_resolvable_address_for_single_client) {
       LeAddressManager::AddressPolicy::USE_NON_RESOLVABLE_ADDRESS,
       remote_address,
       irk,
+      false,
       minimum_rotation_time,
       maximum_rotation_time);
 
@@ -262,6 +287,7 @@ TEST_F(LeAddressManagerTest, DISABLED_rotator_address_for_multiple_clients) {
       LeAddressManager::AddressPolicy::USE_RESOLVABLE_ADDRESS,
       remote_address,
       irk,
+      false,
       minimum_rotation_time,
       maximum_rotation_time);
   le_address_manager_->Register(clients[0].get());
@@ -299,6 +325,7 @@ class LeAddressManagerWithSingleClientTest : public LeAddressManagerTest {
         LeAddressManager::AddressPolicy::USE_RESOLVABLE_ADDRESS,
         remote_address,
         irk,
+        false,
         minimum_rotation_time,
         maximum_rotation_time);
 
@@ -315,6 +342,23 @@ class LeAddressManagerWithSingleClientTest : public LeAddressManagerTest {
         handler_->BindOnce(&LeAddressManager::OnCommandComplete, common::Unretained(le_address_manager_)));
   }
 
+  // Answers the next |num_commands| commands with a Command Complete of |status|, as the controller does. With
+  // |more_commands|, the command sent after them is waited for by the next call.
+  std::vector<OpCode> CompleteCommands(
+      size_t num_commands, ErrorCode status = ErrorCode::SUCCESS, bool more_commands = false) {
+    std::vector<OpCode> op_codes;
+    for (size_t i = 0; i < num_commands; i++) {
+      auto command = test_hci_layer_->GetNextCommand();
+      op_codes.push_back(command.GetOpCode());
+      if (i + 1 < num_commands || more_commands) {
+        test_hci_layer_->SetCommandFuture();
+      }
+      test_hci_layer_->IncomingEvent(CommandCompleteBuilder::Create(
+          0x01, command.GetOpCode(), std::make_unique<RawBuilder>(std::vector<uint8_t>{static_cast<uint8_t>(status)})));
+    }
+    return op_codes;
+  }
+
   void TearDown() override {
     le_address_manager_->Unregister(clients[0].get());
     sync_handler(handler_);
@@ -459,5 +503,164 @@ TEST_F(LeAddressManagerWithSingleClientTest, register_during_command_complete) {
   clients[1].get()->WaitForResume();
 }
 
+TEST_F(LeAddressManagerWithSingleClientTest, commit_list_update_pauses_once) {
+  constexpr size_t kNumDevices = 50;
+  // The controller answers at once, so the time goes to the host side
+  constexpr auto kMaxTimeToLists = std::chrono::seconds(1);
+  Octet16 peer_irk = {0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  Octet16 local_irk = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+  clients[0].get()->WaitForResume();
+  size_t pause_count = clients[0].get()->pause_count;
+
+  // Bonded devices reconnected after boot
+  LeAddressManager::ListUpdate update;
+  for (size_t i = 0; i < kNumDevices; i++) {
+    Address address({0x11, 0x22, 0x33, 0x44, 0x55, static_cast<uint8_t>(i)});
+    update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address);
+    update.AddDeviceToResolvingList(PeerAddressType::RANDOM_DEVICE_OR_IDENTITY_ADDRESS, address, peer_irk, local_irk);
+  }
+  auto start = std::chrono::steady_clock::now();
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  // The filter accept list additions go first
+  auto op_codes = CompleteCommands(kNumDevices, ErrorCode::SUCCESS, /* more_commands */ true);
+  auto time_to_filter_accept_list = std::chrono::steady_clock::now() - start;
+  auto resolving_list_op_codes = CompleteCommands(kNumDevices + 2);
+  clients[0].get()->WaitForResume();
+  auto time_to_lists = std::chrono::steady_clock::now() - start;
+  op_codes.insert(op_codes.end(), resolving_list_op_codes.begin(), resolving_list_op_codes.end());
+  LOG_INFO(
+      "%zu devices in the filter accept list after %lld us, and in the resolving list after %lld us",
+      kNumDevices,
+      static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(time_to_filter_accept_list).count()),
+      static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(time_to_lists).count()));
+  ASSERT_LT(time_to_lists, kMaxTimeToLists);
+
+  ASSERT_EQ(pause_count + 1, clients[0].get()->pause_count);
+  ASSERT_TRUE(std::all_of(op_codes.begin(), op_codes.begin() + kNumDevices, [](OpCode op_code) {
+    return op_code == OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST;
+  }));
+  auto count = [&op_codes](OpCode op_code) {
+    return static_cast<size_t>(std::count(op_codes.begin(), op_codes.end(), op_code));
+  };
+  ASSERT_EQ(kNumDevices, count(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST));
+  ASSERT_EQ(kNumDevices, count(OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST));
+  ASSERT_EQ(2u, count(OpCode::LE_SET_ADDRESS_RESOLUTION_ENABLE));
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, commit_list_update_sends_changes_only) {
+  Address address_a({0x11, 0x22, 0x33, 0x44, 0x55, 0x01});
+  Address address_b({0x11, 0x22, 0x33, 0x44, 0x55, 0x02});
+  Address address_c({0x11, 0x22, 0x33, 0x44, 0x55, 0x03});
+  Address address_d({0x11, 0x22, 0x33, 0x44, 0x55, 0x04});
+  clients[0].get()->WaitForResume();
+
+  LeAddressManager::ListUpdate update;
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_c);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  CompleteCommands(3);
+  clients[0].get()->WaitForResume();
+
+  // Devices already in the list, or added then removed, cost no command
+  update = LeAddressManager::ListUpdate();
+  update.RemoveDeviceFromFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_d);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::PUBLIC, address_d);
+  update.RemoveDeviceFromFilterAcceptList(FilterAcceptListAddressType::PUBLIC, address_d);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  auto op_codes = CompleteCommands(2);
+  ASSERT_EQ(OpCode::LE_REMOVE_DEVICE_FROM_FILTER_ACCEPT_LIST, op_codes[0]);
+  ASSERT_EQ(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST, op_codes[1]);
+  clients[0].get()->WaitForResume();
+
+  // Nothing to change
+  size_t pause_count = clients[0].get()->pause_count;
+  update = LeAddressManager::ListUpdate();
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_d);
+  le_address_manager_->CommitListUpdate(std::move(update));
+  sync_handler(handler_);
+  ASSERT_EQ(pause_count, clients[0].get()->pause_count);
+  ASSERT_FALSE(test_hci_layer_->GetLastCommand().IsValid());
+
+  // Emptying the list is a single command
+  update = LeAddressManager::ListUpdate();
+  update.ClearFilterAcceptList();
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  op_codes = CompleteCommands(1);
+  ASSERT_EQ(OpCode::LE_CLEAR_FILTER_ACCEPT_LIST, op_codes[0]);
+  clients[0].get()->WaitForResume();
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, commit_list_update_tracks_successful_commands_only) {
+  Address address_a({0x11, 0x22, 0x33, 0x44, 0x55, 0x01});
+  Address address_b({0x11, 0x22, 0x33, 0x44, 0x55, 0x02});
+  clients[0].get()->WaitForResume();
+
+  LeAddressManager::ListUpdate update;
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  CompleteCommands(1);
+  test_hci_layer_->SetCommandFuture();
+  CompleteCommands(1, ErrorCode::MEMORY_CAPACITY_EXCEEDED);
+  clients[0].get()->WaitForResume();
+
+  // The device the controller refused is added again
+  update = LeAddressManager::ListUpdate();
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_a);
+  update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address_b);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  auto packet = test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST);
+  auto packet_view = LeAddDeviceToFilterAcceptListView::Create(
+      LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+  ASSERT_TRUE(packet_view.IsValid());
+  ASSERT_EQ(address_b, packet_view.GetAddress());
+  test_hci_layer_->IncomingEvent(LeAddDeviceToFilterAcceptListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+  sync_handler(handler_);
+  ASSERT_FALSE(test_hci_layer_->GetLastCommand().IsValid());
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, commit_list_update_leaves_out_devices_beyond_list_size) {
+  constexpr size_t kListSize = 0x3F;
+  Octet16 peer_irk = {0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  Octet16 local_irk = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+  clients[0].get()->WaitForResume();
+
+  LeAddressManager::ListUpdate update;
+  for (size_t i = 0; i < kListSize + 2; i++) {
+    Address address({0x11, 0x22, 0x33, 0x44, 0x55, static_cast<uint8_t>(i)});
+    update.AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address);
+    update.AddDeviceToResolvingList(PeerAddressType::RANDOM_DEVICE_OR_IDENTITY_ADDRESS, address, peer_irk, local_irk);
+  }
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->CommitListUpdate(std::move(update));
+  auto op_codes = CompleteCommands(2 * kListSize + 2);
+  clients[0].get()->WaitForResume();
+  sync_handler(handler_);
+  ASSERT_FALSE(test_hci_layer_->GetLastCommand().IsValid());
+  auto count = [&op_codes](OpCode op_code) {
+    return static_cast<size_t>(std::count(op_codes.begin(), op_codes.end(), op_code));
+  };
+  ASSERT_EQ(kListSize, count(OpCode::LE_ADD_DEVICE_TO_FILTER_ACCEPT_LIST));
+  ASSERT_EQ(kListSize, count(OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST));
+
+  // A single device added to the full list never reaches the controller
+  Address address({0x11, 0x22, 0x33, 0x44, 0x66, 0x01});
+  le_address_manager_->AddDeviceToFilterAcceptList(FilterAcceptListAddressType::RANDOM, address);
+  sync_handler(handler_);
+  clients[0].get()->WaitForResume();
+  sync_handler(handler_);
+  ASSERT_FALSE(test_hci_layer_->GetLastCommand().IsValid());
+}
+
 }  // namespace hci
 }  // namespace bluetooth
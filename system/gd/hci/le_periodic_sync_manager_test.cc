@@ -173,7 +173,7 @@ class PeriodicSyncManagerTest : public ::testing::Test {
          int8_t tx_power,
          int8_t rssi,
          uint16_t periodic_advertising_interval,
-         std::vector<uint8_t> advertising_data),
+         SharedAdvertisingData advertising_data),
         (override));
     MOCK_METHOD(
         void,
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "common/callback.h"
 #include "hci/address_with_type.h"
@@ -27,6 +28,10 @@ namespace hci {
 
 using ScannerId = uint8_t;
 
+// Advertising data of a scan result. It is not modified once reported, so all
+// the consumers of a scan result share the same buffer instead of a copy each.
+using SharedAdvertisingData = std::shared_ptr<const std::vector<uint8_t>>;
+
 class AdvertisingFilterOnFoundOnLostInfo {
  public:
   uint8_t scanner_id;
@@ -65,7 +70,7 @@ class ScanningCallback {
       int8_t tx_power,
       int8_t rssi,
       uint16_t periodic_advertising_interval,
-      std::vector<uint8_t> advertising_data) = 0;
+      SharedAdvertisingData advertising_data) = 0;
   virtual void OnTrackAdvFoundLost(AdvertisingFilterOnFoundOnLostInfo on_found_on_lost_info) = 0;
   virtual void OnBatchScanReports(
       int client_if, int status, int report_format, int num_records, std::vector<uint8_t> data) = 0;
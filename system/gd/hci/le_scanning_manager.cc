@@ -24,10 +24,12 @@
 #include "hci/hci_packets.h"
 #include "hci/le_periodic_sync_manager.h"
 #include "hci/le_scanning_interface.h"
+#include "hci/le_scanning_software_filter.h"
 #include "hci/vendor_specific_event_manager.h"
 #include "module.h"
 #include "os/handler.h"
 #include "os/log.h"
+#include "os/system_properties.h"
 
 namespace bluetooth {
 namespace hci {
@@ -47,6 +49,9 @@ constexpr uint8_t kScanResponseBit = 3;
 constexpr uint8_t kLegacyBit = 4;
 constexpr uint8_t kDataStatusBits = 5;
 
+// Filters the advertising reports in the host when the controller does not support APCF
+constexpr char kSoftwareScanFilterProperty[] = "bluetooth.le.software_scan_filter.enabled";
+
 const ModuleFactory LeScanningManager::Factory = ModuleFactory([]() { return new LeScanningManager(); });
 
 enum class ScanApiType {
@@ -62,11 +67,11 @@ struct Scanner {
 
 class AdvertisingCache {
  public:
-  const std::vector<uint8_t>& Set(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
+  void Set(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
     auto it = Find(address_with_type);
     if (it != items.end()) {
       it->data = std::move(data);
-      return it->data;
+      return;
     }
 
     if (items.size() > cache_max) {
@@ -74,7 +79,6 @@ class AdvertisingCache {
     }
 
     items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
   }
 
   bool Exist(const AddressWithType& address_with_type) {
@@ -85,11 +89,11 @@ class AdvertisingCache {
     return true;
   }
 
-  const std::vector<uint8_t>& Append(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
+  void Append(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
     auto it = Find(address_with_type);
     if (it != items.end()) {
       it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
+      return;
     }
 
     if (items.size() > cache_max) {
@@ -97,7 +101,17 @@ class AdvertisingCache {
     }
 
     items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
+  }
+
+  /* Remove the data for device |address_with_type| and hand it over without copying it */
+  SharedAdvertisingData Take(const AddressWithType& address_with_type) {
+    auto it = Find(address_with_type);
+    if (it == items.end()) {
+      return std::make_shared<const std::vector<uint8_t>>();
+    }
+    auto data = std::make_shared<const std::vector<uint8_t>>(std::move(it->data));
+    items.erase(it);
+    return data;
   }
 
   /* Clear data for device |addr_type, addr| */
@@ -117,7 +131,7 @@ class AdvertisingCache {
     std::vector<uint8_t> data;
 
     Item(const AddressWithType& address_with_type, std::vector<uint8_t> data)
-        : address_with_type(address_with_type), data(data) {}
+        : address_with_type(address_with_type), data(std::move(data)) {}
   };
 
   std::list<Item>::iterator Find(const AddressWithType& address_with_type) {
@@ -151,7 +165,7 @@ class NullScanningCallback : public ScanningCallback {
       int8_t tx_power,
       int8_t rssi,
       uint16_t periodic_advertising_interval,
-      std::vector<uint8_t> advertising_data) override {
+      SharedAdvertisingData advertising_data) override {
     LOG_INFO("OnScanResult in NullScanningCallback");
   }
   void OnTrackAdvFoundLost(AdvertisingFilterOnFoundOnLostInfo on_found_on_lost_info) override {
@@ -257,6 +271,10 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       api_type_ = ScanApiType::LEGACY;
     }
     is_filter_support_ = controller_->IsSupported(OpCode::LE_ADV_FILTER);
+    use_software_filter_ = !is_filter_support_ && os::GetSystemProperty(kSoftwareScanFilterProperty) == "true";
+    if (use_software_filter_) {
+      LOG_INFO("Advertising filter is not supported by the controller, filtering in the host");
+    }
     is_batch_scan_support_ = controller->IsSupported(OpCode::LE_BATCH_SCAN);
     is_periodic_advertising_sync_transfer_sender_support_ =
         controller_->SupportsBlePeriodicAdvertisingSyncTransferSender();
@@ -355,7 +373,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       return;
     }
 
-    for (LeAdvertisingResponse report : reports) {
+    for (LeAdvertisingResponse& report : reports) {
       uint16_t extended_event_type = 0;
       switch (report.event_type_) {
         case hci::AdvertisingEventType::ADV_IND:
@@ -398,7 +416,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
           kTxPowerInformationNotPresent,
           report.rssi_,
           kNotPeriodicAdvertisement,
-          advertising_data);
+          std::move(advertising_data));
     }
   }
 
@@ -428,7 +446,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       return;
     }
 
-    for (LeExtendedAdvertisingResponse report : reports) {
+    for (LeExtendedAdvertisingResponse& report : reports) {
       uint16_t event_type = report.connectable_ | (report.scannable_ << kScannableBit) |
                             (report.directed_ << kDirectedBit) | (report.scan_response_ << kScanResponseBit) |
                             (report.legacy_ << kLegacyBit) | ((uint16_t)report.data_status_ << kDataStatusBits);
@@ -442,7 +460,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
           report.tx_power_,
           report.rssi_,
           report.periodic_advertising_interval_,
-          report.advertising_data_);
+          std::move(report.advertising_data_));
     }
   }
 
@@ -462,6 +480,9 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     bool is_legacy = event_type & (1 << kLegacyBit);
 
     if (address_type == (uint8_t)DirectAdvertisingAddressType::NO_ADDRESS) {
+      if (!software_filter_.Match(address, rssi, advertising_data)) {
+        return;
+      }
       scanning_callbacks_->OnScanResult(
           event_type,
           address_type,
@@ -472,7 +493,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
           tx_power,
           rssi,
           periodic_advertising_interval,
-          advertising_data);
+          std::make_shared<const std::vector<uint8_t>>(std::move(advertising_data)));
       return;
     } else if (address == Address::kEmpty) {
       LOG_WARN("Receive non-anonymous advertising report with empty address, skip!");
@@ -486,11 +507,34 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     }
 
     bool is_start = is_legacy && is_scannable && !is_scan_response;
+    uint8_t data_status = event_type >> kDataStatusBits;
+    bool is_complete = data_status != (uint8_t)DataStatus::CONTINUING && !(is_scannable && !is_scan_response);
 
-    std::vector<uint8_t> const& adv_data = is_start ? advertising_cache_.Set(address_with_type, advertising_data)
-                                                    : advertising_cache_.Append(address_with_type, advertising_data);
+    if (is_complete && !advertising_cache_.Exist(address_with_type)) {
+      // Whole data in a single report, it does not need to go through the cache
+      if (!software_filter_.Match(address, rssi, advertising_data)) {
+        return;
+      }
+      scanning_callbacks_->OnScanResult(
+          event_type,
+          address_type,
+          address,
+          primary_phy,
+          secondary_phy,
+          advertising_sid,
+          tx_power,
+          rssi,
+          periodic_advertising_interval,
+          std::make_shared<const std::vector<uint8_t>>(std::move(advertising_data)));
+      return;
+    }
+
+    if (is_start) {
+      advertising_cache_.Set(address_with_type, std::move(advertising_data));
+    } else {
+      advertising_cache_.Append(address_with_type, std::move(advertising_data));
+    }
 
-    uint8_t data_status = event_type >> kDataStatusBits;
     if (data_status == (uint8_t)DataStatus::CONTINUING) {
       // Waiting for whole data
       return;
@@ -501,6 +545,10 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       return;
     }
 
+    auto whole_data = advertising_cache_.Take(address_with_type);
+    if (!software_filter_.Match(address, rssi, *whole_data)) {
+      return;
+    }
     scanning_callbacks_->OnScanResult(
         event_type,
         address_type,
@@ -511,9 +559,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
         tx_power,
         rssi,
         periodic_advertising_interval,
-        adv_data);
-
-    advertising_cache_.Clear(address_with_type);
+        std::move(whole_data));
   }
 
   void configure_scan() {
@@ -690,6 +736,11 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   }
 
   void scan_filter_enable(bool enable) {
+    if (use_software_filter_) {
+      software_filter_.SetEnabled(enable);
+      scanning_callbacks_->OnFilterEnable(enable ? Enable::ENABLED : Enable::DISABLED, (uint8_t)ErrorCode::SUCCESS);
+      return;
+    }
     if (!is_filter_support_) {
       LOG_WARN("Advertising filter is not supported");
       return;
@@ -703,6 +754,16 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
 
   void scan_filter_parameter_setup(
       ApcfAction action, uint8_t filter_index, AdvertisingFilterParameter advertising_filter_parameter) {
+    if (use_software_filter_) {
+      if (action == ApcfAction::DELETE) {
+        tracker_id_map_.erase(filter_index);
+      }
+      ErrorCode status = software_filter_.SetFilterParameters(action, filter_index, advertising_filter_parameter)
+                             ? ErrorCode::SUCCESS
+                             : ErrorCode::INVALID_HCI_COMMAND_PARAMETERS;
+      scanning_callbacks_->OnFilterParamSetup(software_filter_.GetAvailableSpaces(), action, (uint8_t)status);
+      return;
+    }
     if (!is_filter_support_) {
       LOG_WARN("Advertising filter is not supported");
       return;
@@ -743,6 +804,10 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   }
 
   void scan_filter_add(uint8_t filter_index, std::vector<AdvertisingPacketContentFilterCommand> filters) {
+    if (use_software_filter_) {
+      software_filter_add(filter_index, filters);
+      return;
+    }
     if (!is_filter_support_) {
       LOG_WARN("Advertising filter is not supported");
       return;
@@ -786,6 +851,21 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     }
   }
 
+  void software_filter_add(uint8_t filter_index, const std::vector<AdvertisingPacketContentFilterCommand>& filters) {
+    ErrorCode status = software_filter_.AddFilters(filter_index, filters) ? ErrorCode::SUCCESS
+                                                                           : ErrorCode::INVALID_HCI_COMMAND_PARAMETERS;
+    for (const auto& filter : filters) {
+      // The controller still resolves the private addresses of the filtered devices
+      if (filter.filter_type == ApcfFilterType::BROADCASTER_ADDRESS && !is_empty_128bit(filter.irk)) {
+        std::array<uint8_t, 16> empty_irk;
+        le_address_manager_->AddDeviceToResolvingList(
+            static_cast<PeerAddressType>(filter.application_address_type), filter.address, filter.irk, empty_irk);
+      }
+      scanning_callbacks_->OnFilterConfigCallback(
+          filter.filter_type, software_filter_.GetAvailableSpaces(), ApcfAction::ADD, (uint8_t)status);
+    }
+  }
+
   void update_address_filter(
       ApcfAction action,
       uint8_t filter_index,
@@ -1446,6 +1526,8 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   bool paused_ = false;
   AdvertisingCache advertising_cache_;
   bool is_filter_support_ = false;
+  bool use_software_filter_ = false;
+  LeScanningSoftwareFilter software_filter_;
   bool is_batch_scan_support_ = false;
   bool is_periodic_advertising_sync_transfer_sender_support_ = false;
 
@@ -1543,6 +1625,10 @@ void LeScanningManager::ScanFilterAdd(
   CallOn(pimpl_.get(), &impl::scan_filter_add, filter_index, filters);
 }
 
+uint8_t LeScanningManager::GetNumberOfSoftwareFilters() const {
+  return pimpl_->use_software_filter_ ? LeScanningSoftwareFilter::kMaxFilters : 0;
+}
+
 void LeScanningManager::BatchScanConifgStorage(
     uint8_t batch_scan_full_max,
     uint8_t batch_scan_truncated_max,
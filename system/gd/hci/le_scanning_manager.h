@@ -62,6 +62,9 @@ class LeScanningManager : public bluetooth::Module {
 
   virtual void ScanFilterAdd(uint8_t filter_index, std::vector<AdvertisingPacketContentFilterCommand> filters);
 
+  // Number of filter indexes of the host side filtering, 0 if the advertising reports are not filtered in the host
+  virtual uint8_t GetNumberOfSoftwareFilters() const;
+
   /*Batch Scan*/
   virtual void BatchScanConifgStorage(
       uint8_t batch_scan_full_max,
@@ -33,7 +33,7 @@ class MockScanningCallback : public ScanningCallback {
   MOCK_METHOD(
       void,
       OnScanResult,
-      (uint16_t, uint8_t, Address, uint8_t, uint8_t, uint8_t, int8_t, int8_t, uint16_t, std::vector<uint8_t>));
+      (uint16_t, uint8_t, Address, uint8_t, uint8_t, uint8_t, int8_t, int8_t, uint16_t, SharedAdvertisingData));
   MOCK_METHOD(void, OnTrackAdvFoundLost, (AdvertisingFilterOnFoundOnLostInfo));
   MOCK_METHOD(void, OnBatchScanReports, (int, int, int, int, std::vector<uint8_t>));
   MOCK_METHOD(void, OnBatchScanThresholdCrossed, (int));
@@ -56,6 +56,7 @@ class MockLeScanningManager : public LeScanningManager {
   MOCK_METHOD(void, ScanFilterEnable, (bool));
   MOCK_METHOD(void, ScanFilterParameterSetup, (ApcfAction, uint8_t, AdvertisingFilterParameter));
   MOCK_METHOD(void, ScanFilterAdd, (uint8_t, std::vector<AdvertisingPacketContentFilterCommand>));
+  MOCK_METHOD(uint8_t, GetNumberOfSoftwareFilters, (), (const));
   MOCK_METHOD(void, BatchScanConifgStorage, (uint8_t, uint8_t, uint8_t, ScannerId));
   MOCK_METHOD(void, BatchScanEnable, (BatchScanMode, uint32_t, uint32_t, BatchScanDiscardRule));
   MOCK_METHOD(void, BatchScanDisable, ());
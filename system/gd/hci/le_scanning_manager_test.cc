@@ -28,6 +28,8 @@
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "hci/le_scanning_manager.h"
+#include "hci/le_scanning_software_filter.h"
+#include "os/system_properties.h"
 #include "os/thread.h"
 #include "packet/raw_builder.h"
 
@@ -38,6 +40,7 @@ namespace {
 using packet::kLittleEndian;
 using packet::PacketView;
 using packet::RawBuilder;
+using ::testing::_;
 
 PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilder> packet) {
   auto bytes = std::make_shared<std::vector<uint8_t>>();
@@ -96,6 +99,10 @@ class TestHciLayer : public HciLayer {
     return command_promise_->get_future();
   }
 
+  bool CommandQueueEmpty() const {
+    return command_queue_.empty();
+  }
+
   CommandView GetLastCommand() {
     if (command_queue_.empty()) {
       return CommandView::Create(GetPacketView(nullptr));
@@ -313,7 +320,7 @@ class LeScanningManagerTest : public ::testing::Test {
          int8_t tx_power,
          int8_t rssi,
          uint16_t periodic_advertising_interval,
-         std::vector<uint8_t> advertising_data),
+         SharedAdvertisingData advertising_data),
         (override));
     MOCK_METHOD(
         void,
@@ -372,6 +379,19 @@ class LeExtendedScanningManagerTest : public LeScanningManagerTest {
   }
 };
 
+class LeSoftwareFilterScanningManagerTest : public LeExtendedScanningManagerTest {
+ protected:
+  void SetUp() override {
+    os::SetSystemProperty("bluetooth.le.software_scan_filter.enabled", "true");
+    LeExtendedScanningManagerTest::SetUp();
+  }
+
+  void TearDown() override {
+    LeExtendedScanningManagerTest::TearDown();
+    os::ClearSystemPropertiesForHost();
+  }
+};
+
 TEST_F(LeScanningManagerTest, startup_teardown) {}
 
 TEST_F(LeScanningManagerTest, start_scan_test) {
@@ -554,6 +574,107 @@ TEST_F(LeExtendedScanningManagerTest, start_scan_test) {
   test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
 }
 
+TEST_F(LeExtendedScanningManagerTest, fragmented_scan_result_test) {
+  auto next_command_future = test_hci_layer_->GetCommandFuture();
+  le_scanning_manager->Scan(true);
+
+  auto result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_ENABLE);
+  test_hci_layer_->IncomingEvent(LeSetScanEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_PARAMETERS);
+  test_hci_layer_->IncomingEvent(LeSetExtendedScanParametersCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_ENABLE);
+
+  test_hci_layer_->IncomingEvent(LeSetScanEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  LeExtendedAdvertisingResponse report{};
+  report.connectable_ = 1;
+  report.scannable_ = 0;
+  report.address_type_ = DirectAdvertisingAddressType::PUBLIC_DEVICE_ADDRESS;
+  Address::FromString("12:34:56:78:9a:bc", report.address_);
+
+  // The first fragment is held until the rest of the data is received
+  report.data_status_ = DataStatus::CONTINUING;
+  report.advertising_data_ = {0x02, 0x01, 0x34};
+  EXPECT_CALL(mock_callbacks_, OnScanResult).Times(0);
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+  testing::Mock::VerifyAndClearExpectations(&mock_callbacks_);
+
+  SharedAdvertisingData advertising_data;
+  EXPECT_CALL(mock_callbacks_, OnScanResult).WillOnce(testing::SaveArg<9>(&advertising_data));
+  report.data_status_ = DataStatus::COMPLETE;
+  report.advertising_data_ = {0x02, 0x0a, 0x05};
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+
+  ASSERT_NE(nullptr, advertising_data);
+  std::vector<uint8_t> expected = {0x02, 0x01, 0x34, 0x02, 0x0a, 0x05};
+  ASSERT_EQ(expected, *advertising_data);
+}
+
+TEST_F(LeSoftwareFilterScanningManagerTest, software_filter_test) {
+  ASSERT_EQ(LeScanningSoftwareFilter::kMaxFilters, le_scanning_manager->GetNumberOfSoftwareFilters());
+
+  Address filtered_address;
+  Address::FromString("12:34:56:78:9a:bc", filtered_address);
+  EXPECT_CALL(mock_callbacks_, OnFilterEnable(Enable::ENABLED, 0));
+  EXPECT_CALL(mock_callbacks_, OnFilterParamSetup(LeScanningSoftwareFilter::kMaxFilters - 1, ApcfAction::ADD, 0));
+  EXPECT_CALL(mock_callbacks_, OnFilterConfigCallback(ApcfFilterType::BROADCASTER_ADDRESS, _, ApcfAction::ADD, 0));
+  le_scanning_manager->ScanFilterEnable(true);
+  AdvertisingFilterParameter advertising_filter_parameter{};
+  advertising_filter_parameter.feature_selection = 1 << static_cast<uint8_t>(ApcfFilterType::BROADCASTER_ADDRESS);
+  advertising_filter_parameter.rssi_high_thresh = static_cast<uint8_t>(-128);
+  le_scanning_manager->ScanFilterParameterSetup(ApcfAction::ADD, 0x01, advertising_filter_parameter);
+  AdvertisingPacketContentFilterCommand filter{};
+  filter.filter_type = ApcfFilterType::BROADCASTER_ADDRESS;
+  filter.address = filtered_address;
+  le_scanning_manager->ScanFilterAdd(0x01, {filter});
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+
+  // No command is sent to the controller
+  ASSERT_TRUE(test_hci_layer_->CommandQueueEmpty());
+
+  auto next_command_future = test_hci_layer_->GetCommandFuture();
+  le_scanning_manager->Scan(true);
+
+  auto result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_ENABLE);
+  test_hci_layer_->IncomingEvent(LeSetScanEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_PARAMETERS);
+  test_hci_layer_->IncomingEvent(LeSetExtendedScanParametersCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_SCAN_ENABLE);
+
+  test_hci_layer_->IncomingEvent(LeSetScanEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  LeExtendedAdvertisingResponse report{};
+  report.connectable_ = 1;
+  report.scannable_ = 0;
+  report.address_type_ = DirectAdvertisingAddressType::PUBLIC_DEVICE_ADDRESS;
+  report.advertising_data_ = {0x02, 0x01, 0x06};
+  Address::FromString("12:34:56:78:9a:bd", report.address_);
+  LeExtendedAdvertisingResponse filtered_report = report;
+  filtered_report.address_ = filtered_address;
+
+  EXPECT_CALL(mock_callbacks_, OnScanResult(_, _, filtered_address, _, _, _, _, _, _, _)).Times(1);
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report, filtered_report}));
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+}
+
 }  // namespace
 }  // namespace hci
 }  // namespace bluetooth
@@ -0,0 +1,459 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_scanning_software_filter.h"
+
+#include <cstring>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+// AD types of the conditions, from the Bluetooth Assigned Numbers
+constexpr uint8_t kIncompleteListOf16BitUuids = 0x02;
+constexpr uint8_t kCompleteListOf16BitUuids = 0x03;
+constexpr uint8_t kIncompleteListOf32BitUuids = 0x04;
+constexpr uint8_t kCompleteListOf32BitUuids = 0x05;
+constexpr uint8_t kIncompleteListOf128BitUuids = 0x06;
+constexpr uint8_t kCompleteListOf128BitUuids = 0x07;
+constexpr uint8_t kShortenedLocalName = 0x08;
+constexpr uint8_t kCompleteLocalName = 0x09;
+constexpr uint8_t kListOf16BitSolicitationUuids = 0x14;
+constexpr uint8_t kListOf128BitSolicitationUuids = 0x15;
+constexpr uint8_t kServiceData16BitUuid = 0x16;
+constexpr uint8_t kListOf32BitSolicitationUuids = 0x1f;
+constexpr uint8_t kServiceData32BitUuid = 0x20;
+constexpr uint8_t kServiceData128BitUuid = 0x21;
+constexpr uint8_t kManufacturerSpecificData = 0xff;
+
+constexpr int8_t kLowestRssiValue = -128;
+
+}  // namespace
+
+LeScanningSoftwareFilter::UuidTrie::UuidTrie(const Uuid::UUID128Bit& mask) : mask_(mask) {
+  nodes_.push_back(Node{0, kNone, kNone, FilterSet()});
+}
+
+uint32_t LeScanningSoftwareFilter::UuidTrie::FindChild(uint32_t node, uint8_t value) const {
+  for (uint32_t child = nodes_[node].first_child; child != kNone; child = nodes_[child].next_sibling) {
+    if (nodes_[child].value == value) {
+      return child;
+    }
+  }
+  return kNone;
+}
+
+void LeScanningSoftwareFilter::UuidTrie::Insert(const Uuid::UUID128Bit& uuid, uint8_t filter_index) {
+  uint32_t node = 0;
+  for (size_t i = 0; i < uuid.size(); i++) {
+    uint8_t value = uuid[i] & mask_[i];
+    uint32_t child = FindChild(node, value);
+    if (child == kNone) {
+      child = nodes_.size();
+      nodes_.push_back(Node{value, kNone, nodes_[node].first_child, FilterSet()});
+      nodes_[node].first_child = child;
+    }
+    node = child;
+  }
+  nodes_[node].filters.set(filter_index);
+}
+
+LeScanningSoftwareFilter::FilterSet LeScanningSoftwareFilter::UuidTrie::Find(const Uuid::UUID128Bit& uuid) const {
+  uint32_t node = 0;
+  for (size_t i = 0; i < uuid.size(); i++) {
+    node = FindChild(node, uuid[i] & mask_[i]);
+    if (node == kNone) {
+      return FilterSet();
+    }
+  }
+  return nodes_[node].filters;
+}
+
+bool LeScanningSoftwareFilter::SetFilterParameters(
+    ApcfAction action, uint8_t filter_index, const AdvertisingFilterParameter& parameter) {
+  switch (action) {
+    case ApcfAction::ADD:
+      if (filter_index >= kMaxFilters) {
+        LOG_ERROR("Invalid filter index %hhu", filter_index);
+        return false;
+      }
+      filters_[filter_index].has_parameters = true;
+      filters_[filter_index].parameter = parameter;
+      break;
+    case ApcfAction::DELETE:
+      if (filter_index >= kMaxFilters) {
+        LOG_ERROR("Invalid filter index %hhu", filter_index);
+        return false;
+      }
+      filters_[filter_index] = FilterEntry();
+      break;
+    case ApcfAction::CLEAR:
+      filters_.fill(FilterEntry());
+      break;
+    default:
+      LOG_ERROR("Unknown action type: %hhu", static_cast<uint8_t>(action));
+      return false;
+  }
+  Compile();
+  return true;
+}
+
+bool LeScanningSoftwareFilter::AddFilters(
+    uint8_t filter_index, const std::vector<AdvertisingPacketContentFilterCommand>& filters) {
+  if (filter_index >= kMaxFilters) {
+    LOG_ERROR("Invalid filter index %hhu", filter_index);
+    return false;
+  }
+  bool valid = true;
+  for (const auto& filter : filters) {
+    if (filter.data.size() != filter.data_mask.size() && filter.data_mask.size() != 0) {
+      LOG_ERROR("data and data_mask are of different size");
+      valid = false;
+      continue;
+    }
+    switch (filter.filter_type) {
+      case ApcfFilterType::BROADCASTER_ADDRESS:
+      case ApcfFilterType::LOCAL_NAME:
+      case ApcfFilterType::MANUFACTURER_DATA:
+      case ApcfFilterType::SERVICE_DATA:
+        break;
+      case ApcfFilterType::SERVICE_UUID:
+      case ApcfFilterType::SERVICE_SOLICITATION_UUID: {
+        size_t uuid_len = filter.uuid.GetShortestRepresentationSize();
+        if (uuid_len != Uuid::kNumBytes16 && uuid_len != Uuid::kNumBytes32 && uuid_len != Uuid::kNumBytes128) {
+          LOG_ERROR("illegal UUID length: %zu", uuid_len);
+          valid = false;
+          continue;
+        }
+      } break;
+      default:
+        LOG_ERROR("Unknown filter type: %hhu", static_cast<uint8_t>(filter.filter_type));
+        valid = false;
+        continue;
+    }
+    filters_[filter_index].conditions.push_back(filter);
+  }
+  Compile();
+  return valid;
+}
+
+uint8_t LeScanningSoftwareFilter::GetAvailableSpaces() const {
+  uint8_t available_spaces = 0;
+  for (const auto& entry : filters_) {
+    if (!entry.has_parameters) {
+      available_spaces++;
+    }
+  }
+  return available_spaces;
+}
+
+void LeScanningSoftwareFilter::InsertUuid(
+    std::vector<UuidTrie>& tries, const Uuid& uuid, const Uuid& uuid_mask, uint8_t filter_index) {
+  // Like the controller, a mask applies to the shortest representation of the UUID only
+  Uuid::UUID128Bit mask;
+  mask.fill(0xff);
+  if (!uuid_mask.IsEmpty()) {
+    size_t uuid_len = uuid.GetShortestRepresentationSize();
+    if (uuid_len == Uuid::kNumBytes16) {
+      uint16_t value = uuid_mask.As16Bit();
+      mask[12] = static_cast<uint8_t>(value);
+      mask[13] = static_cast<uint8_t>(value >> 8);
+    } else if (uuid_len == Uuid::kNumBytes32) {
+      uint32_t value = uuid_mask.As32Bit();
+      mask[12] = static_cast<uint8_t>(value);
+      mask[13] = static_cast<uint8_t>(value >> 8);
+      mask[14] = static_cast<uint8_t>(value >> 16);
+      mask[15] = static_cast<uint8_t>(value >> 24);
+    } else {
+      mask = uuid_mask.To128BitLE();
+    }
+  }
+
+  for (auto& trie : tries) {
+    if (trie.GetMask() == mask) {
+      trie.Insert(uuid.To128BitLE(), filter_index);
+      return;
+    }
+  }
+  tries.emplace_back(mask);
+  tries.back().Insert(uuid.To128BitLE(), filter_index);
+}
+
+LeScanningSoftwareFilter::FilterSet LeScanningSoftwareFilter::FindUuid(
+    const std::vector<UuidTrie>& tries, const Uuid& uuid) {
+  FilterSet found;
+  auto uuid_le = uuid.To128BitLE();
+  for (const auto& trie : tries) {
+    found |= trie.Find(uuid_le);
+  }
+  return found;
+}
+
+void LeScanningSoftwareFilter::Compile() {
+  active_.reset();
+  all_pass_.reset();
+  and_logic_.reset();
+  rssi_filtered_.reset();
+  rssi_threshold_.fill(kLowestRssiValue);
+  required_.fill(FilterSet());
+  addresses_.clear();
+  service_uuids_.clear();
+  solicitation_uuids_.clear();
+  local_names_.clear();
+  manufacturer_data_.clear();
+  masked_manufacturer_data_.clear();
+  service_data_.clear();
+
+  for (uint8_t filter_index = 0; filter_index < kMaxFilters; filter_index++) {
+    const FilterEntry& entry = filters_[filter_index];
+    if (!entry.has_parameters) {
+      continue;
+    }
+    active_.set(filter_index);
+    if (entry.parameter.filter_logic_type != 0) {
+      and_logic_.set(filter_index);
+    }
+    int8_t rssi_threshold = static_cast<int8_t>(entry.parameter.rssi_high_thresh);
+    if (rssi_threshold > kLowestRssiValue) {
+      rssi_filtered_.set(filter_index);
+      rssi_threshold_[filter_index] = rssi_threshold;
+    }
+
+    for (const auto& condition : entry.conditions) {
+      auto feature = static_cast<Feature>(condition.filter_type);
+      if ((entry.parameter.feature_selection & (1 << feature)) == 0) {
+        continue;
+      }
+
+      // Data compared with a mask is stored masked
+      std::vector<uint8_t> mask = condition.data_mask;
+      if (mask.empty()) {
+        mask.assign(condition.data.size(), 0xff);
+      }
+      std::vector<uint8_t> data = condition.data;
+      for (size_t i = 0; i < data.size(); i++) {
+        data[i] &= mask[i];
+      }
+
+      switch (condition.filter_type) {
+        case ApcfFilterType::BROADCASTER_ADDRESS:
+          addresses_[condition.address].set(filter_index);
+          break;
+        case ApcfFilterType::SERVICE_UUID:
+          InsertUuid(service_uuids_, condition.uuid, condition.uuid_mask, filter_index);
+          break;
+        case ApcfFilterType::SERVICE_SOLICITATION_UUID:
+          InsertUuid(solicitation_uuids_, condition.uuid, condition.uuid_mask, filter_index);
+          break;
+        case ApcfFilterType::LOCAL_NAME:
+          local_names_.push_back(
+              DataCondition{filter_index, condition.name, std::vector<uint8_t>(condition.name.size(), 0xff)});
+          break;
+        case ApcfFilterType::MANUFACTURER_DATA: {
+          uint16_t company_mask = condition.company_mask != 0 ? condition.company_mask : 0xffff;
+          ManufacturerCondition manufacturer{
+              filter_index,
+              static_cast<uint16_t>(condition.company & company_mask),
+              company_mask,
+              DataCondition{filter_index, std::move(data), std::move(mask)}};
+          if (company_mask == 0xffff) {
+            manufacturer_data_[manufacturer.company].push_back(std::move(manufacturer));
+          } else {
+            masked_manufacturer_data_.push_back(std::move(manufacturer));
+          }
+        } break;
+        case ApcfFilterType::SERVICE_DATA:
+          service_data_.push_back(DataCondition{filter_index, std::move(data), std::move(mask)});
+          break;
+        default:
+          continue;
+      }
+      required_[feature].set(filter_index);
+    }
+
+    bool has_condition = false;
+    for (const auto& required : required_) {
+      has_condition |= required.test(filter_index);
+    }
+    if (!has_condition) {
+      all_pass_.set(filter_index);
+    }
+  }
+}
+
+bool LeScanningSoftwareFilter::MatchData(const DataCondition& condition, const uint8_t* data, size_t length) {
+  if (length < condition.data.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < condition.data.size(); i++) {
+    if ((data[i] & condition.mask[i]) != condition.data[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LeScanningSoftwareFilter::MatchUuids(
+    const uint8_t* data, size_t length, size_t uuid_size, Feature feature, FilterSet* hits) const {
+  const auto& tries = feature == kServiceUuid ? service_uuids_ : solicitation_uuids_;
+  for (size_t offset = 0; offset + uuid_size <= length; offset += uuid_size) {
+    const uint8_t* p = data + offset;
+    Uuid uuid;
+    if (uuid_size == Uuid::kNumBytes16) {
+      uuid = Uuid::From16Bit(p[0] | (p[1] << 8));
+    } else if (uuid_size == Uuid::kNumBytes32) {
+      uuid = Uuid::From32Bit(p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+    } else {
+      uuid = Uuid::From128BitLE(p);
+    }
+    hits[feature] |= FindUuid(tries, uuid);
+  }
+}
+
+void LeScanningSoftwareFilter::MatchAdStructure(uint8_t type, const uint8_t* data, size_t length, FilterSet* hits)
+    const {
+  switch (type) {
+    case kIncompleteListOf16BitUuids:
+    case kCompleteListOf16BitUuids:
+      if (required_[kServiceUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes16, kServiceUuid, hits);
+      }
+      break;
+    case kIncompleteListOf32BitUuids:
+    case kCompleteListOf32BitUuids:
+      if (required_[kServiceUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes32, kServiceUuid, hits);
+      }
+      break;
+    case kIncompleteListOf128BitUuids:
+    case kCompleteListOf128BitUuids:
+      if (required_[kServiceUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes128, kServiceUuid, hits);
+      }
+      break;
+    case kListOf16BitSolicitationUuids:
+      if (required_[kServiceSolicitationUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes16, kServiceSolicitationUuid, hits);
+      }
+      break;
+    case kListOf32BitSolicitationUuids:
+      if (required_[kServiceSolicitationUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes32, kServiceSolicitationUuid, hits);
+      }
+      break;
+    case kListOf128BitSolicitationUuids:
+      if (required_[kServiceSolicitationUuid].any()) {
+        MatchUuids(data, length, Uuid::kNumBytes128, kServiceSolicitationUuid, hits);
+      }
+      break;
+    case kShortenedLocalName:
+    case kCompleteLocalName:
+      // The name of the filter matches the beginning of the local name
+      for (const auto& condition : local_names_) {
+        if (MatchData(condition, data, length)) {
+          hits[kLocalName].set(condition.filter_index);
+        }
+      }
+      break;
+    case kManufacturerSpecificData: {
+      if (length < 2) {
+        break;
+      }
+      uint16_t company = data[0] | (data[1] << 8);
+      auto it = manufacturer_data_.find(company);
+      if (it != manufacturer_data_.end()) {
+        for (const auto& condition : it->second) {
+          if (MatchData(condition.data, data + 2, length - 2)) {
+            hits[kManufacturerData].set(condition.filter_index);
+          }
+        }
+      }
+      for (const auto& condition : masked_manufacturer_data_) {
+        if ((company & condition.company_mask) == condition.company &&
+            MatchData(condition.data, data + 2, length - 2)) {
+          hits[kManufacturerData].set(condition.filter_index);
+        }
+      }
+    } break;
+    case kServiceData16BitUuid:
+    case kServiceData32BitUuid:
+    case kServiceData128BitUuid:
+      // The data of the filter starts with the UUID of the service
+      for (const auto& condition : service_data_) {
+        if (MatchData(condition, data, length)) {
+          hits[kServiceData].set(condition.filter_index);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+bool LeScanningSoftwareFilter::Match(
+    const Address& address, int8_t rssi, const std::vector<uint8_t>& advertising_data) const {
+  if (!enabled_) {
+    return true;
+  }
+  if (active_.none()) {
+    return false;
+  }
+
+  FilterSet hits[kFeatureCount];
+  if (required_[kBroadcasterAddress].any()) {
+    auto it = addresses_.find(address);
+    if (it != addresses_.end()) {
+      hits[kBroadcasterAddress] = it->second;
+    }
+  }
+
+  const uint8_t* data = advertising_data.data();
+  size_t size = advertising_data.size();
+  size_t offset = 0;
+  while (offset < size) {
+    uint8_t length = data[offset];
+    // A zero length AD structure terminates the significant part of the data
+    if (length == 0 || offset + 1 + length > size) {
+      break;
+    }
+    MatchAdStructure(data[offset + 1], data + offset + 2, length - 1, hits);
+    offset += length + 1;
+  }
+
+  FilterSet missed;
+  FilterSet found;
+  for (uint8_t feature = 0; feature < kFeatureCount; feature++) {
+    missed |= required_[feature] & ~hits[feature];
+    found |= required_[feature] & hits[feature];
+  }
+  FilterSet matched = (all_pass_ | (and_logic_ & ~missed) | (~and_logic_ & found)) & active_;
+
+  FilterSet rssi_filtered = matched & rssi_filtered_;
+  if (rssi_filtered.any()) {
+    for (uint8_t filter_index = 0; filter_index < kMaxFilters; filter_index++) {
+      if (rssi_filtered.test(filter_index) && rssi < rssi_threshold_[filter_index]) {
+        matched.reset(filter_index);
+      }
+    }
+  }
+  return matched.any();
+}
+
+}  // namespace hci
+}  // namespace bluetooth
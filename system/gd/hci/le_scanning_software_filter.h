@@ -0,0 +1,163 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "hci/address.h"
+#include "hci/hci_packets.h"
+#include "hci/le_scanning_callback.h"
+#include "hci/uuid.h"
+
+namespace bluetooth {
+namespace hci {
+
+// Host side implementation of the Advertising Packet Content Filter (APCF), used when the controller cannot filter
+// the advertising reports itself.
+//
+// It is programmed with the same filtering parameters and AdvertisingPacketContentFilterCommand the controller would
+// be, and compiles them into a matcher evaluated once per advertising report: broadcaster addresses are looked up in a
+// hash set, service and solicitation UUIDs in byte tries, and the remaining conditions are compared under their
+// masks. Each AD structure of a report is visited once, whatever the number of filters.
+//
+// The lists of conditions of a feature are always evaluated with the OR logic, so that a report is never dropped when
+// it could match a filter of the upper layers, which still evaluate their own filters on the reports delivered.
+//
+// This class is not thread safe.
+class LeScanningSoftwareFilter {
+ public:
+  // Number of filter indexes available
+  static constexpr uint8_t kMaxFilters = 32;
+
+  LeScanningSoftwareFilter() = default;
+  LeScanningSoftwareFilter(const LeScanningSoftwareFilter&) = delete;
+  LeScanningSoftwareFilter& operator=(const LeScanningSoftwareFilter&) = delete;
+
+  // Reports are only filtered once enabled
+  void SetEnabled(bool enable) {
+    enabled_ = enable;
+  }
+  bool IsEnabled() const {
+    return enabled_;
+  }
+
+  // Adds, deletes or clears the filtering parameters of |filter_index|, returns false if they could not be applied.
+  // Deleting the parameters of a filter index also deletes its conditions.
+  bool SetFilterParameters(ApcfAction action, uint8_t filter_index, const AdvertisingFilterParameter& parameter);
+
+  // Adds conditions to |filter_index|, returns false if any of them was invalid and ignored.
+  bool AddFilters(uint8_t filter_index, const std::vector<AdvertisingPacketContentFilterCommand>& filters);
+
+  // Number of filter indexes that are not used
+  uint8_t GetAvailableSpaces() const;
+
+  // Returns true if the report of |address| with |advertising_data| matches at least one filter, or if filtering is
+  // not enabled.
+  bool Match(const Address& address, int8_t rssi, const std::vector<uint8_t>& advertising_data) const;
+
+ private:
+  using FilterSet = std::bitset<kMaxFilters>;
+
+  // Features of the filtering parameters, as bits of the feature selection
+  enum Feature : uint8_t {
+    kBroadcasterAddress = 0,
+    kServiceDataChange = 1,
+    kServiceUuid = 2,
+    kServiceSolicitationUuid = 3,
+    kLocalName = 4,
+    kManufacturerData = 5,
+    kServiceData = 6,
+    kFeatureCount = 7,
+  };
+
+  // Byte trie of the 128-bit UUIDs, in little endian order so that the UUIDs derived from the Base UUID share the
+  // nodes of their common prefix. The UUIDs of a trie are all masked with the same mask.
+  class UuidTrie {
+   public:
+    explicit UuidTrie(const Uuid::UUID128Bit& mask);
+    const Uuid::UUID128Bit& GetMask() const {
+      return mask_;
+    }
+    void Insert(const Uuid::UUID128Bit& uuid, uint8_t filter_index);
+    FilterSet Find(const Uuid::UUID128Bit& uuid) const;
+
+   private:
+    struct Node {
+      uint8_t value;
+      uint32_t first_child;
+      uint32_t next_sibling;
+      FilterSet filters;
+    };
+    static constexpr uint32_t kNone = 0;
+
+    uint32_t FindChild(uint32_t node, uint8_t value) const;
+
+    Uuid::UUID128Bit mask_;
+    // The root is the first node, so no node links to index 0
+    std::vector<Node> nodes_;
+  };
+
+  struct DataCondition {
+    uint8_t filter_index;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> mask;
+  };
+  struct ManufacturerCondition {
+    uint8_t filter_index;
+    uint16_t company;
+    uint16_t company_mask;
+    DataCondition data;
+  };
+  struct FilterEntry {
+    bool has_parameters = false;
+    AdvertisingFilterParameter parameter{};
+    std::vector<AdvertisingPacketContentFilterCommand> conditions;
+  };
+
+  static bool MatchData(const DataCondition& condition, const uint8_t* data, size_t length);
+  static FilterSet FindUuid(const std::vector<UuidTrie>& tries, const Uuid& uuid);
+  static void InsertUuid(std::vector<UuidTrie>& tries, const Uuid& uuid, const Uuid& uuid_mask, uint8_t filter_index);
+  void MatchUuids(const uint8_t* data, size_t length, size_t uuid_size, Feature feature, FilterSet* hits) const;
+  void MatchAdStructure(uint8_t type, const uint8_t* data, size_t length, FilterSet* hits) const;
+
+  // Rebuilds the matcher from |filters_|
+  void Compile();
+
+  bool enabled_ = false;
+  std::array<FilterEntry, kMaxFilters> filters_;
+
+  // Compiled matcher
+  FilterSet active_;
+  FilterSet all_pass_;
+  FilterSet and_logic_;
+  FilterSet rssi_filtered_;
+  std::array<int8_t, kMaxFilters> rssi_threshold_{};
+  std::array<FilterSet, kFeatureCount> required_;
+  std::unordered_map<Address, FilterSet> addresses_;
+  std::vector<UuidTrie> service_uuids_;
+  std::vector<UuidTrie> solicitation_uuids_;
+  std::vector<DataCondition> local_names_;
+  std::unordered_map<uint16_t, std::vector<ManufacturerCondition>> manufacturer_data_;
+  std::vector<ManufacturerCondition> masked_manufacturer_data_;
+  std::vector<DataCondition> service_data_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
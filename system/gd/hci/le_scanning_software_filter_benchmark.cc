@@ -0,0 +1,99 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/le_scanning_software_filter.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+
+constexpr size_t kNumReports = 256;
+
+// Each filter index holds a service UUID and a manufacturer data condition, as the filters of the scanning apps do
+static void ConfigureFilters(LeScanningSoftwareFilter& filter, uint8_t num_filters) {
+  filter.SetEnabled(true);
+  for (uint8_t filter_index = 0; filter_index < num_filters; filter_index++) {
+    AdvertisingFilterParameter parameter{};
+    parameter.feature_selection = (1 << static_cast<uint8_t>(ApcfFilterType::SERVICE_UUID)) |
+                                  (1 << static_cast<uint8_t>(ApcfFilterType::MANUFACTURER_DATA));
+    parameter.filter_logic_type = 0;
+    parameter.rssi_high_thresh = static_cast<uint8_t>(-128);
+    filter.SetFilterParameters(ApcfAction::ADD, filter_index, parameter);
+
+    AdvertisingPacketContentFilterCommand uuid{};
+    uuid.filter_type = ApcfFilterType::SERVICE_UUID;
+    uuid.uuid = Uuid::From16Bit(0x1800 + filter_index);
+    AdvertisingPacketContentFilterCommand manufacturer{};
+    manufacturer.filter_type = ApcfFilterType::MANUFACTURER_DATA;
+    manufacturer.company = 0x0100 + filter_index;
+    manufacturer.data = {0x02, 0x15};
+    manufacturer.data_mask = {0xff, 0xff};
+    filter.AddFilters(filter_index, {uuid, manufacturer});
+  }
+}
+
+// Reports of advertisers with a few service UUIDs and manufacturer data, of which a few match the filters
+static std::vector<std::pair<Address, std::vector<uint8_t>>> MakeReports() {
+  std::vector<std::pair<Address, std::vector<uint8_t>>> reports;
+  for (size_t i = 0; i < kNumReports; i++) {
+    Address address({0x00, 0x11, 0x22, 0x33, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)});
+    uint16_t uuid = 0x1800 + (i * 7) % 128;
+    uint16_t company = 0x0100 + (i * 13) % 256;
+    std::vector<uint8_t> data = {
+        0x02,
+        0x01,
+        0x06,
+        0x07,
+        0x03,
+        static_cast<uint8_t>(uuid),
+        static_cast<uint8_t>(uuid >> 8),
+        0x0f,
+        0x18,
+        0x0a,
+        0x18,
+        0x1a,
+        0xff,
+        static_cast<uint8_t>(company),
+        static_cast<uint8_t>(company >> 8),
+        0x02,
+        0x15};
+    data.resize(data.size() + 21, static_cast<uint8_t>(i));
+    reports.emplace_back(address, std::move(data));
+  }
+  return reports;
+}
+
+static void BM_SoftwareFilterMatch(State& state) {
+  LeScanningSoftwareFilter filter;
+  ConfigureFilters(filter, static_cast<uint8_t>(state.range(0)));
+  auto reports = MakeReports();
+  size_t matched = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& report = reports[i++ % kNumReports];
+    matched += filter.Match(report.first, -60, report.second);
+  }
+  benchmark::DoNotOptimize(matched);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SoftwareFilterMatch)->Arg(1)->Arg(8)->Arg(LeScanningSoftwareFilter::kMaxFilters);
+
+}  // namespace hci
+}  // namespace bluetooth
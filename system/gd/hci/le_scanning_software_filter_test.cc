@@ -0,0 +1,224 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_scanning_software_filter.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+const Address kAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const Address kOtherAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+
+// Flags, 16-bit service UUID 0x180d, manufacturer data of company 0x00e0, service data of UUID 0xfe2c, local name
+const std::vector<uint8_t> kAdvertisingData = {
+    0x02, 0x01, 0x06, 0x03, 0x03, 0x0d, 0x18, 0x06, 0xff, 0xe0, 0x00, 0x01, 0x02, 0x03,
+    0x05, 0x16, 0x2c, 0xfe, 0xaa, 0xbb, 0x05, 0x09, 'a',  'b',  'c',  'd'};
+
+AdvertisingFilterParameter MakeParameter(uint16_t feature_selection, int8_t rssi_threshold = -128) {
+  AdvertisingFilterParameter parameter{};
+  parameter.feature_selection = feature_selection;
+  parameter.list_logic_type = 0;
+  parameter.filter_logic_type = 1;
+  parameter.rssi_high_thresh = static_cast<uint8_t>(rssi_threshold);
+  parameter.delivery_mode = DeliveryMode::IMMEDIATE;
+  return parameter;
+}
+
+AdvertisingPacketContentFilterCommand MakeCommand(ApcfFilterType filter_type) {
+  AdvertisingPacketContentFilterCommand command{};
+  command.filter_type = filter_type;
+  return command;
+}
+
+uint16_t FeatureBit(ApcfFilterType filter_type) {
+  return 1 << static_cast<uint8_t>(filter_type);
+}
+
+class LeScanningSoftwareFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    filter_.SetEnabled(true);
+  }
+
+  void AddFilter(uint8_t filter_index, AdvertisingPacketContentFilterCommand command) {
+    ASSERT_TRUE(filter_.SetFilterParameters(
+        ApcfAction::ADD, filter_index, MakeParameter(FeatureBit(command.filter_type))));
+    ASSERT_TRUE(filter_.AddFilters(filter_index, {command}));
+  }
+
+  LeScanningSoftwareFilter filter_;
+};
+
+TEST_F(LeScanningSoftwareFilterTest, disabled_filter_matches_everything) {
+  filter_.SetEnabled(false);
+  auto command = MakeCommand(ApcfFilterType::BROADCASTER_ADDRESS);
+  command.address = kAddress;
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kOtherAddress, -60, kAdvertisingData));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, no_filter_matches_nothing) {
+  ASSERT_FALSE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::ADD, 0, MakeParameter(0)));
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_EQ(LeScanningSoftwareFilter::kMaxFilters - 1, filter_.GetAvailableSpaces());
+}
+
+TEST_F(LeScanningSoftwareFilterTest, broadcaster_address) {
+  auto command = MakeCommand(ApcfFilterType::BROADCASTER_ADDRESS);
+  command.address = kAddress;
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {}));
+  ASSERT_FALSE(filter_.Match(kOtherAddress, -60, kAdvertisingData));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, service_uuid) {
+  auto command = MakeCommand(ApcfFilterType::SERVICE_UUID);
+  command.uuid = Uuid::From16Bit(0x180d);
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x03, 0x03, 0x0f, 0x18}));
+
+  // The same UUID advertised in its 128-bit representation
+  auto uuid = Uuid::From16Bit(0x180d).To128BitLE();
+  std::vector<uint8_t> data = {0x11, 0x07};
+  data.insert(data.end(), uuid.begin(), uuid.end());
+  ASSERT_TRUE(filter_.Match(kAddress, -60, data));
+
+  // Solicitation UUIDs are a different feature
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x03, 0x14, 0x0d, 0x18}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, masked_service_uuid) {
+  auto command = MakeCommand(ApcfFilterType::SERVICE_SOLICITATION_UUID);
+  command.uuid = Uuid::From16Bit(0x1800);
+  command.uuid_mask = Uuid::From16Bit(0xff00);
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {0x03, 0x14, 0x0d, 0x18}));
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {0x05, 0x14, 0x00, 0xfe, 0x42, 0x18}));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x03, 0x14, 0x0d, 0x19}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, local_name) {
+  auto command = MakeCommand(ApcfFilterType::LOCAL_NAME);
+  command.name = {'a', 'b', 'c'};
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x03, 0x09, 'a', 'b'}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, manufacturer_data) {
+  auto command = MakeCommand(ApcfFilterType::MANUFACTURER_DATA);
+  command.company = 0x00e0;
+  command.data = {0x01, 0x00};
+  command.data_mask = {0xff, 0x00};
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x05, 0xff, 0xe0, 0x00, 0x02, 0x02}));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x05, 0xff, 0xe1, 0x00, 0x01, 0x02}));
+  // Shorter than the data of the filter
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x04, 0xff, 0xe0, 0x00, 0x01}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, masked_company) {
+  auto command = MakeCommand(ApcfFilterType::MANUFACTURER_DATA);
+  command.company = 0x00e0;
+  command.company_mask = 0x00f0;
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {0x03, 0xff, 0xe5, 0x12}));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x03, 0xff, 0xd0, 0x00}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, service_data) {
+  auto command = MakeCommand(ApcfFilterType::SERVICE_DATA);
+  command.data = {0x2c, 0xfe, 0xaa};
+  AddFilter(1, command);
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x05, 0x16, 0x2c, 0xfe, 0xab, 0xbb}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, features_combined) {
+  auto address = MakeCommand(ApcfFilterType::BROADCASTER_ADDRESS);
+  address.address = kAddress;
+  auto uuid = MakeCommand(ApcfFilterType::SERVICE_UUID);
+  uuid.uuid = Uuid::From16Bit(0x180d);
+  uint16_t features = FeatureBit(ApcfFilterType::BROADCASTER_ADDRESS) | FeatureBit(ApcfFilterType::SERVICE_UUID);
+
+  // AND logic
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::ADD, 1, MakeParameter(features)));
+  ASSERT_TRUE(filter_.AddFilters(1, {address, uuid}));
+  ASSERT_TRUE(filter_.Match(kAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kOtherAddress, -60, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {}));
+
+  // OR logic
+  auto parameter = MakeParameter(features);
+  parameter.filter_logic_type = 0;
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::ADD, 1, parameter));
+  ASSERT_TRUE(filter_.Match(kOtherAddress, -60, kAdvertisingData));
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {}));
+  ASSERT_FALSE(filter_.Match(kOtherAddress, -60, {}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, rssi_threshold) {
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::ADD, 1, MakeParameter(0, -70)));
+  ASSERT_TRUE(filter_.Match(kAddress, -70, kAdvertisingData));
+  ASSERT_FALSE(filter_.Match(kAddress, -71, kAdvertisingData));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, delete_and_clear) {
+  auto command = MakeCommand(ApcfFilterType::BROADCASTER_ADDRESS);
+  command.address = kAddress;
+  AddFilter(1, command);
+  command.address = kOtherAddress;
+  AddFilter(2, command);
+  ASSERT_TRUE(filter_.Match(kOtherAddress, -60, {}));
+
+  AdvertisingFilterParameter parameter{};
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::DELETE, 2, parameter));
+  ASSERT_FALSE(filter_.Match(kOtherAddress, -60, {}));
+  ASSERT_TRUE(filter_.Match(kAddress, -60, {}));
+
+  ASSERT_TRUE(filter_.SetFilterParameters(ApcfAction::CLEAR, 0, parameter));
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {}));
+  ASSERT_EQ(LeScanningSoftwareFilter::kMaxFilters, filter_.GetAvailableSpaces());
+}
+
+TEST_F(LeScanningSoftwareFilterTest, invalid_filters) {
+  AdvertisingFilterParameter parameter{};
+  ASSERT_FALSE(filter_.SetFilterParameters(ApcfAction::ADD, LeScanningSoftwareFilter::kMaxFilters, parameter));
+  auto command = MakeCommand(ApcfFilterType::MANUFACTURER_DATA);
+  command.data = {0x01, 0x02};
+  command.data_mask = {0xff};
+  ASSERT_FALSE(filter_.AddFilters(1, {command}));
+}
+
+TEST_F(LeScanningSoftwareFilterTest, malformed_advertising_data) {
+  auto command = MakeCommand(ApcfFilterType::LOCAL_NAME);
+  command.name = {'a'};
+  AddFilter(1, command);
+  // The length of the AD structure exceeds the data
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x05, 0x09, 'a'}));
+  // Data following a zero length AD structure is not significant
+  ASSERT_FALSE(filter_.Match(kAddress, -60, {0x00, 0x02, 0x09, 'a'}));
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
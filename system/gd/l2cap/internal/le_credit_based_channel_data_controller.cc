@@ -16,10 +16,10 @@
 
 #include "l2cap/internal/le_credit_based_channel_data_controller.h"
 
+#include <algorithm>
+
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/le/internal/link.h"
-#include "packet/fragmenting_inserter.h"
-#include "packet/raw_builder.h"
 
 namespace bluetooth {
 namespace l2cap {
@@ -40,27 +40,31 @@ void LeCreditBasedDataController::OnSdu(std::unique_ptr<packet::BasePacketBuilde
   if (sdu_size > mtu_) {
     LOG_WARN("Received sdu_size %d > mtu %d", static_cast<int>(sdu_size), mtu_);
   }
-  std::vector<std::unique_ptr<packet::RawBuilder>> segments;
-  // TODO: We don't need to waste 2 bytes for continuation segment.
-  packet::FragmentingInserter fragmenting_inserter(mps_ - 2, std::back_insert_iterator(segments));
-  sdu->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
-  std::unique_ptr<BasicFrameBuilder> builder;
-  builder = FirstLeInformationFrameBuilder::Create(remote_cid_, sdu_size, std::move(segments[0]));
-  pdu_queue_.emplace(std::move(builder));
-  for (size_t i = 1; i < segments.size(); i++) {
-    builder = BasicFrameBuilder::Create(remote_cid_, std::move(segments[i]));
-    pdu_queue_.emplace(std::move(builder));
+  // The SDU is serialized once, and each K-frame refers to its part of the SDU
+  auto sdu_bytes = std::make_shared<std::vector<uint8_t>>();
+  sdu_bytes->reserve(sdu_size);
+  BitInserter inserter(*sdu_bytes);
+  sdu->Serialize(inserter);
+  // Only the first K-frame carries the SDU length
+  size_t segment_size = std::min<size_t>(sdu_size, mps_ - 2);
+  pdu_queue_.emplace(FirstLeInformationFrameBuilder::Create(
+      remote_cid_, sdu_size, std::make_unique<SduSegmentBuilder>(sdu_bytes, 0, segment_size)));
+  uint16_t num_frames = 1;
+  for (size_t begin = segment_size; begin < sdu_size; begin += segment_size) {
+    segment_size = std::min<size_t>(sdu_size - begin, mps_);
+    pdu_queue_.emplace(
+        BasicFrameBuilder::Create(remote_cid_, std::make_unique<SduSegmentBuilder>(sdu_bytes, begin, segment_size)));
+    num_frames++;
   }
-  if (credits_ >= segments.size()) {
-    scheduler_->OnPacketsReady(cid_, segments.size());
-    credits_ -= segments.size();
+  if (credits_ >= num_frames) {
+    scheduler_->OnPacketsReady(cid_, num_frames);
+    credits_ -= num_frames;
   } else if (credits_ > 0) {
     scheduler_->OnPacketsReady(cid_, credits_);
-    pending_frames_count_ += (segments.size() - credits_);
+    pending_frames_count_ += (num_frames - credits_);
     credits_ = 0;
   } else {
-    pending_frames_count_ += segments.size();
+    pending_frames_count_ += num_frames;
   }
 }
 
@@ -133,6 +137,18 @@ void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   }
 }
 
+LeCreditBasedDataController::SduSegmentBuilder::SduSegmentBuilder(std::shared_ptr<const std::vector<uint8_t>> sdu,
+                                                                  size_t begin, size_t size)
+    : sdu_(std::move(sdu)), begin_(begin), size_(size) {}
+
+size_t LeCreditBasedDataController::SduSegmentBuilder::size() const {
+  return size_;
+}
+
+void LeCreditBasedDataController::SduSegmentBuilder::Serialize(BitInserter& it) const {
+  it.insert_bytes(sdu_->data() + begin_, size_);
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
@@ -19,6 +19,7 @@
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "common/bidi_queue.h"
 #include "l2cap/cid.h"
@@ -71,6 +72,21 @@ class LeCreditBasedDataController : public DataController {
   uint16_t credits_ = 0;
   uint16_t pending_frames_count_ = 0;
 
+  // Payload of a K-frame, referring to its part of the serialized SDU shared by all the K-frames of the SDU
+  class SduSegmentBuilder : public packet::BasePacketBuilder {
+   public:
+    SduSegmentBuilder(std::shared_ptr<const std::vector<uint8_t>> sdu, size_t begin, size_t size);
+
+    void Serialize(BitInserter& it) const override;
+
+    size_t size() const override;
+
+   private:
+    std::shared_ptr<const std::vector<uint8_t>> sdu_;
+    size_t begin_;
+    size_t size_;
+  };
+
   class PacketViewForReassembly : public packet::PacketView<kLittleEndian> {
    public:
     PacketViewForReassembly(const PacketView& packetView) : PacketView(packetView) {}
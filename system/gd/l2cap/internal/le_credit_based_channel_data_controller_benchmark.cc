@@ -0,0 +1,125 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "l2cap/internal/le_credit_based_channel_data_controller.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+constexpr size_t kSdusPerIteration = 16;
+constexpr Cid kCid = 0x41;
+constexpr uint16_t kInitialCredits = 1000;
+
+// Link on which the credits sent by the receiving controller are granted to the sending one
+class LoopbackLink : public ILink {
+ public:
+  void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) override {}
+  hci::AddressWithType GetDevice() const override {
+    return hci::AddressWithType();
+  }
+  void SendLeCredit(Cid local_cid, uint16_t credit) override {
+    if (peer_ != nullptr) {
+      peer_->OnCredit(credit);
+    }
+  }
+
+  LeCreditBasedDataController* peer_ = nullptr;
+};
+
+// Counts the K-frames the sending controller has ready, as the scheduler does
+class CountingScheduler : public Scheduler {
+ public:
+  void OnPacketsReady(Cid cid, int number_packets) override {
+    ready_packets_ += number_packets;
+  }
+
+  int ready_packets_ = 0;
+};
+
+// Sends SDUs of state.range(0) bytes from a controller to another one with a MPS of state.range(1), passing each
+// K-frame through its serialized bytes as the link does, until the receiving channel dequeued all the SDUs
+static void BM_LeCreditBasedLoopback(State& state) {
+  size_t sdu_size = state.range(0);
+  uint16_t mps = state.range(1);
+  os::Thread thread("benchmark_thread", os::Thread::Priority::NORMAL);
+  os::Handler handler(&thread);
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> tx_queue{10};
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> rx_queue{kSdusPerIteration};
+  CountingScheduler tx_scheduler;
+  Scheduler rx_scheduler;
+  LoopbackLink tx_link;
+  LoopbackLink rx_link;
+  LeCreditBasedDataController tx{&tx_link, kCid, kCid, tx_queue.GetDownEnd(), &handler, &tx_scheduler};
+  LeCreditBasedDataController rx{&rx_link, kCid, kCid, rx_queue.GetDownEnd(), &handler, &rx_scheduler};
+  rx_link.peer_ = &tx;
+  for (auto controller : {&tx, &rx}) {
+    controller->SetMtu(sdu_size);
+    controller->SetMps(mps);
+  }
+  tx.OnCredit(kInitialCredits);
+
+  std::vector<uint8_t> sdu(sdu_size);
+  for (size_t i = 0; i < sdu_size; i++) {
+    sdu[i] = static_cast<uint8_t>(i);
+  }
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < kSdusPerIteration; i++) {
+      tx.OnSdu(std::make_unique<packet::RawBuilder>(sdu));
+      for (; tx_scheduler.ready_packets_ > 0; tx_scheduler.ready_packets_--) {
+        auto pdu = tx.GetNextPacket();
+        auto bytes = std::make_shared<std::vector<uint8_t>>();
+        bytes->reserve(pdu->size());
+        BitInserter inserter(*bytes);
+        pdu->Serialize(inserter);
+        rx.OnPdu(packet::PacketView<kLittleEndian>(bytes));
+      }
+    }
+    size_t received = 0;
+    while (received < kSdusPerIteration) {
+      auto received_sdu = rx_queue.GetUpEnd()->TryDequeue();
+      if (received_sdu == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+      benchmark::DoNotOptimize(received_sdu->size());
+      received++;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kSdusPerIteration * sdu_size);
+  handler.Clear();
+}
+BENCHMARK(BM_LeCreditBasedLoopback)
+    ->Args({64, 251})
+    ->Args({512, 251})
+    ->Args({4096, 251})
+    ->Args({4096, 1004})
+    ->UseRealTime();
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -121,6 +121,32 @@ TEST_F(LeCreditBasedDataControllerTest, transmit_segmented) {
   EXPECT_EQ(data, "cd");
 }
 
+TEST_F(LeCreditBasedDataControllerTest, transmit_segmented_continuation_uses_whole_mps) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnCredit(10);
+  controller.SetMps(4);
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 3));
+  // Should be divided into 'ab', 'cdef' and 'g'
+  controller.OnSdu(CreateSdu({'a', 'b', 'c', 'd', 'e', 'f', 'g'}));
+  auto view = GetPacketView(controller.GetNextPacket());
+  auto first_le_info_view = FirstLeInformationFrameView::Create(BasicFrameView::Create(view));
+  EXPECT_TRUE(first_le_info_view.IsValid());
+  EXPECT_EQ(first_le_info_view.GetL2capSduLength(), 7);
+  auto payload = first_le_info_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "ab");
+
+  for (std::string expected : {"cdef", "g"}) {
+    view = GetPacketView(controller.GetNextPacket());
+    auto pdu_view = BasicFrameView::Create(view);
+    EXPECT_TRUE(pdu_view.IsValid());
+    payload = pdu_view.GetPayload();
+    EXPECT_EQ(std::string(payload.begin(), payload.end()), expected);
+  }
+}
+
 TEST_F(LeCreditBasedDataControllerTest, receive_unsegmented) {
   common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
   testing::MockScheduler scheduler;
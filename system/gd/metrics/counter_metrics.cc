@@ -17,6 +17,8 @@
 
 #include "metrics/counter_metrics.h"
 
+#include <atomic>
+
 #include "common/bind.h"
 #include "os/log.h"
 #include "os/metrics.h"
@@ -28,6 +30,37 @@ const int COUNTER_METRICS_PERDIOD_MINUTES = 360; // Drain counters every 6 hours
 
 const ModuleFactory CounterMetrics::Factory = ModuleFactory([]() { return new CounterMetrics(); });
 
+namespace {
+
+// Shards are handed out round robin to threads on their first count, so that threads only share a shard once there
+// are more than kNumShards of them
+size_t GetShardIndex() {
+  static std::atomic<size_t> next_shard_index{0};
+  thread_local size_t shard_index =
+      next_shard_index.fetch_add(1, std::memory_order_relaxed) % CounterMetrics::kNumShards;
+  return shard_index;
+}
+
+// Saturates at LLONG_MAX, returns false if it did
+bool AddCount(std::atomic<int64_t>* counter, int64_t count) {
+  int64_t total = counter->load(std::memory_order_relaxed);
+  do {
+    if (LLONG_MAX - total < count) {
+      counter->store(LLONG_MAX, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!counter->compare_exchange_weak(total, total + count, std::memory_order_relaxed));
+  return true;
+}
+
+}  // namespace
+
+CounterMetrics::CounterMetrics() {
+  for (auto& key : keys_) {
+    key.store(kEmptyKey, std::memory_order_relaxed);
+  }
+}
+
 void CounterMetrics::ListDependencies(ModuleList* list) const {
 }
 
@@ -58,6 +91,37 @@ bool CounterMetrics::Count(int32_t key, int64_t count) {
     LOG_WARN("count is not larger than 0. count: %s, key: %d", std::to_string(count).c_str(), key);
     return false;
   }
+  size_t index = GetKeyIndex(key);
+  if (index == kMaxCounterKeys) {
+    return CountOverflowKey(key, count);
+  }
+  if (!AddCount(&shards_[GetShardIndex()].counts[index], count)) {
+    LOG_WARN("Counter metric overflows. count %s key: %d", std::to_string(count).c_str(), key);
+    return false;
+  }
+  return true;
+}
+
+size_t CounterMetrics::GetKeyIndex(int32_t key) {
+  if (key == kEmptyKey) {
+    return kMaxCounterKeys;
+  }
+  size_t start = static_cast<uint32_t>(key) % kMaxCounterKeys;
+  for (size_t i = 0; i < kMaxCounterKeys; i++) {
+    size_t index = (start + i) % kMaxCounterKeys;
+    int32_t slot_key = keys_[index].load(std::memory_order_acquire);
+    if (slot_key == kEmptyKey &&
+        keys_[index].compare_exchange_strong(slot_key, key, std::memory_order_acq_rel)) {
+      return index;
+    }
+    if (slot_key == key) {
+      return index;
+    }
+  }
+  return kMaxCounterKeys;
+}
+
+bool CounterMetrics::CountOverflowKey(int32_t key, int64_t count) {
   int64_t total = 0;
   std::lock_guard<std::mutex> lock(mutex_);
   if (counters_.find(key) != counters_.end()) {
@@ -84,6 +148,20 @@ void CounterMetrics::DrainBufferedCounters() {
   }
   std::lock_guard<std::mutex> lock(mutex_);
   LOG_INFO("Draining buffered counters");
+  for (size_t index = 0; index < kMaxCounterKeys; index++) {
+    int32_t key = keys_[index].load(std::memory_order_acquire);
+    if (key == kEmptyKey) {
+      continue;
+    }
+    int64_t total = 0;
+    for (auto& shard : shards_) {
+      int64_t count = shard.counts[index].exchange(0, std::memory_order_relaxed);
+      total = (LLONG_MAX - total < count) ? LLONG_MAX : total + count;
+    }
+    if (total > 0) {
+      WriteCounter(key, total);
+    }
+  }
   for (auto const& pair : counters_) {
     WriteCounter(pair.first, pair.second);
   }
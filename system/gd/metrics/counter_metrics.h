@@ -15,6 +15,8 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <unordered_map>
 
 #include "module.h"
@@ -23,8 +25,16 @@
 namespace bluetooth {
 namespace metrics {
 
+// Counters are bumped from any thread on hot paths, so Count() does not take a lock. Each key
+// is given a dense index the first time it is counted. Each thread is given one of kNumShards
+// shards of relaxed atomics, round robin, the first time it counts and always adds to that one.
+// Shards are only summed up when the counters are drained.
 class CounterMetrics : public bluetooth::Module {
  public:
+  static constexpr size_t kMaxCounterKeys = 256;
+  static constexpr size_t kNumShards = 16;
+
+  CounterMetrics();
   bool Count(int32_t key, int64_t value);
   void Stop() override;
   static const ModuleFactory Factory;
@@ -42,6 +52,20 @@ class CounterMetrics : public bluetooth::Module {
   }
 
  private:
+  // Keys are never removed, a slot keeps its key for the lifetime of the module
+  static constexpr int32_t kEmptyKey = INT32_MIN;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<int64_t>, kMaxCounterKeys> counts{};
+  };
+
+  // Returns the dense index of |key|, or kMaxCounterKeys if all slots are taken
+  size_t GetKeyIndex(int32_t key);
+  bool CountOverflowKey(int32_t key, int64_t count);
+
+  std::array<std::atomic<int32_t>, kMaxCounterKeys> keys_;
+  std::array<Shard, kNumShards> shards_;
+  // Keys which did not get a slot
   std::unordered_map<int32_t, int64_t> counters_;
   mutable std::mutex mutex_;
   std::unique_ptr<os::RepeatingAlarm> alarm_;
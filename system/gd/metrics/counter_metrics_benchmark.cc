@@ -0,0 +1,84 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <unordered_map>
+
+#include "benchmark/benchmark.h"
+#include "metrics/counter_metrics.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace metrics {
+
+class BenchmarkCounterMetrics : public CounterMetrics {
+ public:
+  void DrainBuffer() {
+    DrainBufferedCounters();
+  }
+
+ private:
+  void WriteCounter(int32_t key, int64_t count) override {}
+  bool IsInitialized() override {
+    return true;
+  }
+};
+
+constexpr int32_t kNumKeys = 32;
+
+BenchmarkCounterMetrics* counter_metrics = nullptr;
+
+// Each thread bumps a few keys shared with all other threads, as per packet counters would
+static void BM_CounterMetricsCount(State& state) {
+  if (state.thread_index() == 0) {
+    counter_metrics = new BenchmarkCounterMetrics();
+  }
+  int32_t key = state.thread_index();
+  for (auto _ : state) {
+    counter_metrics->Count(key % kNumKeys, 1);
+    key++;
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    counter_metrics->DrainBuffer();
+    delete counter_metrics;
+    counter_metrics = nullptr;
+  }
+}
+BENCHMARK(BM_CounterMetricsCount)->ThreadRange(1, 16)->UseRealTime();
+
+// The single lock and map CounterMetrics used to have, for comparison
+std::mutex locked_counters_mutex;
+std::unordered_map<int32_t, int64_t> locked_counters;
+
+static void BM_LockedMapCount(State& state) {
+  int32_t key = state.thread_index();
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(locked_counters_mutex);
+    locked_counters[key % kNumKeys] += 1;
+    key++;
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    std::lock_guard<std::mutex> lock(locked_counters_mutex);
+    locked_counters.clear();
+  }
+}
+BENCHMARK(BM_LockedMapCount)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace metrics
+}  // namespace bluetooth
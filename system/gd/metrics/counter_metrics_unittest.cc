@@ -16,7 +16,9 @@
 
 #include "metrics/counter_metrics.h"
 
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -86,6 +88,42 @@ TEST_F(CounterMetricsTest, non_positive) {
   ASSERT_EQ(testable_counter_metrics_.test_counters_[1], 5);
 }
 
+TEST_F(CounterMetricsTest, multiple_threads) {
+  constexpr int kNumThreads = 8;
+  constexpr int kCountsPerThread = 10000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([this, i]() {
+      for (int j = 0; j < kCountsPerThread; j++) {
+        ASSERT_TRUE(testable_counter_metrics_.Count(1, 1));
+        ASSERT_TRUE(testable_counter_metrics_.Count(2 + i, 2));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  testable_counter_metrics_.DrainBuffer();
+  ASSERT_EQ(testable_counter_metrics_.test_counters_[1], kNumThreads * kCountsPerThread);
+  for (int i = 0; i < kNumThreads; i++) {
+    ASSERT_EQ(testable_counter_metrics_.test_counters_[2 + i], 2 * kCountsPerThread);
+  }
+}
+
+TEST_F(CounterMetricsTest, more_keys_than_slots) {
+  constexpr int32_t kNumKeys = CounterMetrics::kMaxCounterKeys + 10;
+  for (int32_t key = 0; key < kNumKeys; key++) {
+    ASSERT_TRUE(testable_counter_metrics_.Count(key, key + 1));
+  }
+  ASSERT_TRUE(testable_counter_metrics_.Count(INT32_MIN, 7));
+  testable_counter_metrics_.DrainBuffer();
+  ASSERT_EQ(testable_counter_metrics_.test_counters_.size(), static_cast<size_t>(kNumKeys + 1));
+  for (int32_t key = 0; key < kNumKeys; key++) {
+    ASSERT_EQ(testable_counter_metrics_.test_counters_[key], key + 1);
+  }
+  ASSERT_EQ(testable_counter_metrics_.test_counters_[INT32_MIN], 7);
+}
+
 }  // namespace
 }  // namespace metrics
 }  // namespace bluetooth
@@ -16,6 +16,14 @@
 #define LOG_TAG "BtGdModule"
 
 #include "module.h"
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <functional>
+#include <set>
+#include <thread>
+
 #include "common/init_flags.h"
 #include "dumpsys/init_flags.h"
 #include "os/wakelock_manager.h"
@@ -56,12 +64,14 @@ Module* Module::GetDependency(const ModuleFactory* module) const {
 }
 
 Module* ModuleRegistry::Get(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(started_modules_mutex_);
   auto instance = started_modules_.find(module);
   ASSERT_LOG(instance != started_modules_.end(), "Request for module not started up, maybe not in Start(ModuleList)?");
   return instance->second;
 }
 
 bool ModuleRegistry::IsStarted(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(started_modules_mutex_);
   return started_modules_.find(module) != started_modules_.end();
 }
 
@@ -76,10 +86,36 @@ void ModuleRegistry::set_registry_and_handler(Module* instance, Thread* thread)
   instance->handler_ = new Handler(thread);
 }
 
+void ModuleRegistry::start_module(const ModuleFactory* module, Module* instance) {
+  auto begin = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(started_modules_mutex_);
+    last_instance_ = "starting " + instance->ToString();
+    if (start_time_ == std::chrono::steady_clock::time_point()) {
+      start_time_ = begin;
+    }
+  }
+
+  instance->Start();
+  auto end = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(started_modules_mutex_);
+  start_order_.push_back(module);
+  started_modules_[module] = instance;
+  start_trace_.push_back(
+      {instance->ToString(),
+       std::chrono::duration_cast<std::chrono::microseconds>(begin - start_time_),
+       std::chrono::duration_cast<std::chrono::microseconds>(end - begin)});
+  LOG_DEBUG("Started %s", instance->ToString().c_str());
+}
+
 Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
-  auto started_instance = started_modules_.find(module);
-  if (started_instance != started_modules_.end()) {
-    return started_instance->second;
+  {
+    std::lock_guard<std::mutex> lock(started_modules_mutex_);
+    auto started_instance = started_modules_.find(module);
+    if (started_instance != started_modules_.end()) {
+      return started_instance->second;
+    }
   }
 
   LOG_DEBUG("Constructing next module");
@@ -93,13 +129,105 @@ Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
 
   LOG_DEBUG("Finished starting dependencies and calling Start() of %s", instance->ToString().c_str());
 
-  instance->Start();
-  start_order_.push_back(module);
-  started_modules_[module] = instance;
-  LOG_DEBUG("Started %s", instance->ToString().c_str());
+  start_module(module, instance);
   return instance;
 }
 
+void ModuleRegistry::StartInParallel(ModuleList* modules, Thread* thread, size_t num_workers) {
+  // Construct every module that is not started yet, they all get their handler here. Modules are constructed and
+  // ranked in the order Start(ModuleList) would construct and start them
+  std::map<const ModuleFactory*, Module*> to_start;
+  std::vector<const ModuleFactory*> start_order;
+  std::function<void(const ModuleFactory*)> construct = [&](const ModuleFactory* module) {
+    if (IsStarted(module) || to_start.count(module) != 0) {
+      return;
+    }
+    Module* instance = module->ctor_();
+    set_registry_and_handler(instance, thread);
+    instance->ListDependencies(&instance->dependencies_);
+    to_start[module] = instance;
+    for (auto dependency : instance->dependencies_.list_) {
+      construct(dependency);
+    }
+    start_order.push_back(module);
+  };
+  for (auto module : modules->list_) {
+    construct(module);
+  }
+
+  std::map<const ModuleFactory*, size_t> rank;
+  for (size_t i = 0; i < start_order.size(); i++) {
+    rank[start_order[i]] = i;
+  }
+  std::vector<std::vector<size_t>> dependents(start_order.size());
+  std::vector<size_t> pending_dependencies(start_order.size());
+  // Ranks of the modules whose dependencies are started, to start on the calling thread or on any thread. The lowest
+  // rank is started first, so that the calling thread alone starts modules in the order Start(ModuleList) would
+  std::set<size_t> ready;
+  std::set<size_t> ready_concurrent;
+  size_t num_concurrent = 0;
+  for (size_t i = 0; i < start_order.size(); i++) {
+    Module* instance = to_start.at(start_order[i]);
+    for (auto dependency : instance->dependencies_.list_) {
+      auto dependency_rank = rank.find(dependency);
+      if (dependency_rank != rank.end()) {
+        dependents[dependency_rank->second].push_back(i);
+        pending_dependencies[i]++;
+      }
+    }
+    if (instance->CanStartConcurrently()) {
+      num_concurrent++;
+    }
+    if (pending_dependencies[i] == 0) {
+      (instance->CanStartConcurrently() ? ready_concurrent : ready).insert(i);
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready_changed;
+  size_t remaining = start_order.size();
+  auto start_ready_modules = [&](bool calling_thread) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+      std::set<size_t>* queue = nullptr;
+      if (calling_thread && !ready.empty() &&
+          (ready_concurrent.empty() || *ready.begin() < *ready_concurrent.begin())) {
+        queue = &ready;
+      } else if (!ready_concurrent.empty()) {
+        queue = &ready_concurrent;
+      } else {
+        ready_changed.wait(lock);
+        continue;
+      }
+      size_t module_rank = *queue->begin();
+      queue->erase(queue->begin());
+      const ModuleFactory* module = start_order[module_rank];
+
+      lock.unlock();
+      start_module(module, to_start.at(module));
+      lock.lock();
+
+      remaining--;
+      for (auto dependent : dependents[module_rank]) {
+        if (--pending_dependencies[dependent] == 0) {
+          (to_start.at(start_order[dependent])->CanStartConcurrently() ? ready_concurrent : ready).insert(dependent);
+        }
+      }
+      ready_changed.notify_all();
+    }
+  };
+
+  // The calling thread is one of the workers, and the only one for the modules that did not opt in
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers && i <= num_concurrent; i++) {
+    workers.emplace_back(start_ready_modules, false);
+  }
+  start_ready_modules(true);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
 void ModuleRegistry::StopAll() {
   // Since modules were brought up in dependency order, it is safe to tear down by going in reverse order.
   for (auto it = start_order_.rbegin(); it != start_order_.rend(); it++) {
@@ -124,9 +252,25 @@ void ModuleRegistry::StopAll() {
 
   ASSERT(started_modules_.empty());
   start_order_.clear();
+  start_trace_.clear();
+  start_time_ = std::chrono::steady_clock::time_point();
+}
+
+void ModuleRegistry::DumpStartTrace(int fd) const {
+  std::lock_guard<std::mutex> lock(started_modules_mutex_);
+  dprintf(fd, "Module start trace:\n");
+  for (const auto& trace : start_trace_) {
+    dprintf(
+        fd,
+        "  %-40s started at %8lld us, took %8lld us\n",
+        trace.name.c_str(),
+        static_cast<long long>(trace.begin.count()),
+        static_cast<long long>(trace.duration.count()));
+  }
 }
 
 os::Handler* ModuleRegistry::GetModuleHandler(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(started_modules_mutex_);
   auto started_instance = started_modules_.find(module);
   if (started_instance != started_modules_.end()) {
     return started_instance->second->GetHandler();
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <flatbuffers/flatbuffers.h>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -89,6 +91,12 @@ class Module {
   // Release all resources, you're about to be deleted
   virtual void Stop() = 0;
 
+  // Return true to let ModuleRegistry::StartInParallel() call Start() on a worker thread, concurrently with the Start()
+  // of other modules. Only for modules whose Start() touches nothing but their own state and their dependencies.
+  virtual bool CanStartConcurrently() const {
+    return false;
+  }
+
   // Get relevant state data from the module
   virtual DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const;
 
@@ -144,19 +152,41 @@ class ModuleRegistry {
 
   Module* Start(const ModuleFactory* id, ::bluetooth::os::Thread* thread);
 
+  // Start all the modules on this list and their dependencies. A module is started
+  // once all its dependencies are, in the order Start(ModuleList*) would start them
+  // among the ones that are ready. Modules that CanStartConcurrently() are started on
+  // up to |num_workers| - 1 worker threads, the other ones on the calling thread one
+  // at a time
+  void StartInParallel(ModuleList* modules, ::bluetooth::os::Thread* thread, size_t num_workers);
+
   // Stop all running modules in reverse order of start
   void StopAll();
 
+  // Print when each module started and how long its Start() took
+  void DumpStartTrace(int fd) const;
+
  protected:
+  struct ModuleStartTrace {
+    std::string name;
+    std::chrono::microseconds begin;  // since the first module started
+    std::chrono::microseconds duration;
+  };
+
   Module* Get(const ModuleFactory* module) const;
 
   void set_registry_and_handler(Module* instance, ::bluetooth::os::Thread* thread) const;
 
   os::Handler* GetModuleHandler(const ModuleFactory* module) const;
 
+  void start_module(const ModuleFactory* module, Module* instance);
+
+  // Guards the started modules and start trace while modules start in parallel
+  mutable std::mutex started_modules_mutex_;
   std::map<const ModuleFactory*, Module*> started_modules_;
   std::vector<const ModuleFactory*> start_order_;
   std::string last_instance_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::vector<ModuleStartTrace> start_trace_;
 };
 
 class ModuleDumper {
@@ -21,9 +21,12 @@
 
 #include "gtest/gtest.h"
 
+#include <unistd.h>
+
 #include <functional>
 #include <future>
 #include <string>
+#include <thread>
 
 using ::bluetooth::os::Thread;
 
@@ -217,6 +220,85 @@ class TestModuleDumpState : public Module {
 
 const ModuleFactory TestModuleDumpState::Factory = ModuleFactory([]() { return new TestModuleDumpState(); });
 
+// Each rendezvous module only finishes starting once the other one is starting too, which can
+// only happen if they are started concurrently
+std::promise<void> rendezvous_one_started;
+std::promise<void> rendezvous_two_started;
+
+class TestModuleRendezvousOne : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) const {
+    list->add<TestModuleNoDependency>();
+  }
+
+  bool CanStartConcurrently() const override {
+    return true;
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    rendezvous_one_started.set_value();
+    EXPECT_EQ(
+        rendezvous_two_started.get_future().wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  }
+
+  std::string ToString() const override {
+    return std::string("TestModuleRendezvousOne");
+  }
+};
+
+const ModuleFactory TestModuleRendezvousOne::Factory = ModuleFactory([]() { return new TestModuleRendezvousOne(); });
+
+class TestModuleRendezvousTwo : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) const {
+    list->add<TestModuleNoDependency>();
+  }
+
+  bool CanStartConcurrently() const override {
+    return true;
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    rendezvous_two_started.set_value();
+    EXPECT_EQ(
+        rendezvous_one_started.get_future().wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  }
+
+  std::string ToString() const override {
+    return std::string("TestModuleRendezvousTwo");
+  }
+};
+
+const ModuleFactory TestModuleRendezvousTwo::Factory = ModuleFactory([]() { return new TestModuleRendezvousTwo(); });
+
+std::thread::id calling_thread_module_start_thread;
+
+class TestModuleCallingThread : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) const {}
+
+  void Start() override {
+    calling_thread_module_start_thread = std::this_thread::get_id();
+  }
+
+  std::string ToString() const override {
+    return std::string("TestModuleCallingThread");
+  }
+};
+
+const ModuleFactory TestModuleCallingThread::Factory = ModuleFactory([]() { return new TestModuleCallingThread(); });
+
 TEST_F(ModuleTest, no_dependency) {
   ModuleList list;
   list.add<TestModuleNoDependency>();
@@ -314,5 +396,102 @@ TEST_F(ModuleTest, dump_state) {
   registry_->StopAll();
 }
 
+TEST_F(ModuleTest, start_in_parallel_two_dependencies) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 4);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleTwoDependencies>());
+
+  registry_->StopAll();
+
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
+}
+
+TEST_F(ModuleTest, start_in_parallel_runs_independent_modules_concurrently) {
+  rendezvous_one_started = std::promise<void>();
+  rendezvous_two_started = std::promise<void>();
+  ModuleList list;
+  list.add<TestModuleRendezvousOne>();
+  list.add<TestModuleRendezvousTwo>();
+  registry_->StartInParallel(&list, thread_, 2);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleRendezvousOne>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleRendezvousTwo>());
+
+  registry_->StopAll();
+}
+
+TEST_F(ModuleTest, start_in_parallel_starts_other_modules_on_calling_thread) {
+  rendezvous_one_started = std::promise<void>();
+  rendezvous_two_started = std::promise<void>();
+  ModuleList list;
+  list.add<TestModuleRendezvousOne>();
+  list.add<TestModuleRendezvousTwo>();
+  list.add<TestModuleCallingThread>();
+  registry_->StartInParallel(&list, thread_, 4);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleCallingThread>());
+  EXPECT_EQ(calling_thread_module_start_thread, std::this_thread::get_id());
+
+  registry_->StopAll();
+}
+
+std::string DumpStartTrace(const ModuleRegistry& registry) {
+  int fds[2];
+  EXPECT_EQ(pipe(fds), 0);
+  registry.DumpStartTrace(fds[1]);
+  close(fds[1]);
+  std::string output;
+  char buf[256];
+  ssize_t count;
+  while ((count = read(fds[0], buf, sizeof(buf))) > 0) {
+    output.append(buf, count);
+  }
+  close(fds[0]);
+  return output;
+}
+
+TEST_F(ModuleTest, dump_start_trace) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 4);
+
+  std::string output = DumpStartTrace(*registry_);
+
+  EXPECT_NE(output.find("TestModuleNoDependency"), std::string::npos);
+  EXPECT_NE(output.find("TestModuleOneDependency"), std::string::npos);
+  EXPECT_NE(output.find("TestModuleNoDependencyTwo"), std::string::npos);
+  EXPECT_NE(output.find("TestModuleTwoDependencies"), std::string::npos);
+
+  registry_->StopAll();
+}
+
+TEST_F(ModuleTest, start_in_parallel_keeps_start_order) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 4);
+
+  // None of these modules opt in, so they start on the calling thread in the order Start(ModuleList*) would
+  std::string output = DumpStartTrace(*registry_);
+  size_t no_dependency = output.find("TestModuleNoDependency ");
+  size_t one_dependency = output.find("TestModuleOneDependency");
+  size_t no_dependency_two = output.find("TestModuleNoDependencyTwo");
+  size_t two_dependencies = output.find("TestModuleTwoDependencies");
+  ASSERT_NE(two_dependencies, std::string::npos);
+  EXPECT_LT(no_dependency, one_dependency);
+  EXPECT_LT(one_dependency, no_dependency_two);
+  EXPECT_LT(no_dependency_two, two_dependencies);
+
+  registry_->StopAll();
+}
+
 }  // namespace
 }  // namespace bluetooth
@@ -41,6 +41,12 @@ std::optional<std::string> ReadSmallFile(const std::string& path);
 // Return true on success, false on failure
 bool WriteToFile(const std::string& path, const std::string& data);
 
+// Append |data| to the end of file at |path|, creating the file if it does not exist, and sync the file to storage
+// media before returning. Unlike WriteToFile(), the file is not replaced atomically, hence caller must be able to
+// detect and discard a partially written tail after a crash
+// Return true on success, false on failure
+bool AppendToFile(const std::string& path, const std::string& data);
+
 // Remove file and print error message if failed
 // Print error log when file is failed to be removed, hence user should make sure file exists before calling this
 // Return true on success, false on failure (e.g. file not exist, failed to remove, etc)
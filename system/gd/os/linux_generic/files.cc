@@ -187,6 +187,40 @@ bool WriteToFile(const std::string& path, const std::string& data) {
   return true;
 }
 
+bool AppendToFile(const std::string& path, const std::string& data) {
+  ASSERT(!path.empty());
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0) {
+    LOG_ERROR("unable to open file '%s' for append, error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  const char* ptr = data.data();
+  size_t remaining = data.size();
+  while (remaining > 0) {
+    ssize_t written = write(fd, ptr, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR("unable to append to file '%s', error: %s", path.c_str(), strerror(errno));
+      close(fd);
+      return false;
+    }
+    ptr += written;
+    remaining -= written;
+  }
+  // Only file content needs to reach storage media, directory entry is synced once when the file is created
+  if (fdatasync(fd) != 0) {
+    LOG_WARN("unable to fdatasync file '%s', error: %s", path.c_str(), strerror(errno));
+    // Allow fdatasync to fail and continue
+  }
+  if (close(fd) != 0) {
+    LOG_ERROR("unable to close file '%s', error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
 bool RemoveFile(const std::string& path) {
   if (remove(path.c_str()) != 0) {
     LOG_ERROR("unable to remove file '%s', error: %s", path.c_str(), strerror(errno));
@@ -35,6 +35,8 @@ class BitInserter : public ByteInserter {
 
   void insert_byte(uint8_t byte) override;
 
+  void insert_bytes(const uint8_t* data, size_t size) override;
+
  protected:
   size_t num_saved_bits_{0};
   uint8_t saved_bits_{0};
@@ -78,5 +78,25 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+
+TEST(BitInserterTest, insertBytesTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  it.RegisterObserver(ByteObserver([&copy](uint8_t byte) { copy.push_back(byte); }, []() { return 0; }));
+
+  std::vector<uint8_t> data = {0x01, 0x02, 0x03};
+  it.insert_bytes(data.data(), data.size());
+  it.insert_bits(0b1010, 4);
+  // Not aligned on a byte any more
+  it.insert_bytes(data.data(), data.size());
+  it.insert_bits(0b0101, 4);
+  std::vector<uint8_t> result = {0x01, 0x02, 0x03, 0x1a, 0x20, 0x30, 0x50};
+
+  ASSERT_EQ(result, bytes);
+  ASSERT_EQ(result, copy);
+  it.UnregisterObserver();
+}
+
 }  // namespace packet
 }  // namespace bluetooth
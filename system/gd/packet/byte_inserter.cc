@@ -48,5 +48,14 @@ void ByteInserter::insert_byte(uint8_t byte) {
   std::back_insert_iterator<std::vector<uint8_t>>::operator=(byte);
 }
 
+void ByteInserter::insert_bytes(const uint8_t* data, size_t size) {
+  for (auto& observer : registered_observers_) {
+    for (size_t i = 0; i < size; i++) {
+      observer.OnByte(data[i]);
+    }
+  }
+  container->insert(container->end(), data, data + size);
+}
+
 }  // namespace packet
 }  // namespace bluetooth
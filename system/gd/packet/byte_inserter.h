@@ -33,6 +33,9 @@ class ByteInserter : public std::back_insert_iterator<std::vector<uint8_t>> {
 
   virtual void insert_byte(uint8_t byte);
 
+  // Inserts |size| bytes at once, as many calls to insert_byte would
+  virtual void insert_bytes(const uint8_t* data, size_t size);
+
   void RegisterObserver(const ByteObserver& observer);
 
   ByteObserver UnregisterObserver();
@@ -80,7 +80,8 @@ init_flags!(
         gatt_robust_caching,
         btaa_hci,
         gd_rust,
-        gd_link_policy
+        gd_link_policy,
+        gd_parallel_start
     },
     dependencies: {
         gd_core => gd_security
@@ -115,7 +115,7 @@ void BleScannerIntf::OnScanResult(
     int8_t tx_power,
     int8_t rssi,
     uint16_t periodic_adv_int,
-    std::vector<uint8_t> adv_data) {
+    const std::vector<uint8_t>& adv_data) {
   RustRawAddress raw_address = rusty::CopyToRustAddress(bda);
   rusty::gdscan_on_scan_result(
       event_type,
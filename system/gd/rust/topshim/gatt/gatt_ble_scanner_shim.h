@@ -51,7 +51,7 @@ class BleScannerIntf : public ScanningCallbacks {
       int8_t tx_power,
       int8_t rssi,
       uint16_t periodic_adv_int,
-      std::vector<uint8_t> adv_data) override;
+      const std::vector<uint8_t>& adv_data) override;
 
   void OnTrackAdvFoundLost(AdvertisingTrackInfo advertising_track_info) override;
 
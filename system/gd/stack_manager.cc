@@ -34,7 +34,7 @@ using ::bluetooth::os::WakelockManager;
 
 namespace bluetooth {
 
-void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
+void StackManager::StartUp(ModuleList* modules, Thread* stack_thread, size_t num_start_workers) {
   management_thread_ = new Thread("management_thread", Thread::Priority::NORMAL);
   handler_ = new Handler(management_thread_);
 
@@ -43,7 +43,7 @@ void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
   std::promise<void> promise;
   auto future = promise.get_future();
   handler_->Post(common::BindOnce(&StackManager::handle_start_up, common::Unretained(this), modules, stack_thread,
-                                  std::move(promise)));
+                                  num_start_workers, std::move(promise)));
 
   auto init_status = future.wait_for(std::chrono::seconds(3));
 
@@ -57,8 +57,13 @@ void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
   LOG_INFO("init complete");
 }
 
-void StackManager::handle_start_up(ModuleList* modules, Thread* stack_thread, std::promise<void> promise) {
-  registry_.Start(modules, stack_thread);
+void StackManager::handle_start_up(
+    ModuleList* modules, Thread* stack_thread, size_t num_start_workers, std::promise<void> promise) {
+  if (num_start_workers > 1) {
+    registry_.StartInParallel(modules, stack_thread, num_start_workers);
+  } else {
+    registry_.Start(modules, stack_thread);
+  }
   promise.set_value();
 }
 
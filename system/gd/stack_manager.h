@@ -24,7 +24,8 @@ namespace bluetooth {
 
 class StackManager {
  public:
-  void StartUp(ModuleList *modules, os::Thread* stack_thread);
+  // Modules that do not depend on each other are started concurrently when |num_start_workers| > 1
+  void StartUp(ModuleList* modules, os::Thread* stack_thread, size_t num_start_workers = 1);
   void ShutDown();
 
   template <class T>
@@ -37,12 +38,18 @@ class StackManager {
     return registry_.IsStarted(&T::Factory);
   }
 
+  // Print when each module started and how long its Start() took
+  void DumpStartTrace(int fd) const {
+    registry_.DumpStartTrace(fd);
+  }
+
  private:
   os::Thread* management_thread_ = nullptr;
   os::Handler* handler_ = nullptr;
   ModuleRegistry registry_;
 
-  void handle_start_up(ModuleList* modules, os::Thread* stack_thread, std::promise<void> promise);
+  void handle_start_up(
+      ModuleList* modules, os::Thread* stack_thread, size_t num_start_workers, std::promise<void> promise);
   void handle_shut_down(std::promise<void> promise);
 };
 
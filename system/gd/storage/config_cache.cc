@@ -16,7 +16,9 @@
 
 #include "storage/config_cache.h"
 
+#include <algorithm>
 #include <ios>
+#include <iterator>
 #include <sstream>
 #include <utility>
 
@@ -69,14 +71,25 @@ void ConfigCache::SetPersistentConfigChangedCallback(std::function<void()> persi
   persistent_config_changed_callback_ = std::move(persistent_config_changed_callback);
 }
 
+void ConfigCache::SetPersistentMutationCallback(
+    std::function<void(const MutationEntry&)> persistent_mutation_callback) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  persistent_mutation_callback_ = std::move(persistent_mutation_callback);
+}
+
 ConfigCache::ConfigCache(ConfigCache&& other) noexcept
     : persistent_config_changed_callback_(std::move(other.persistent_config_changed_callback_)),
+      persistent_mutation_callback_(std::move(other.persistent_mutation_callback_)),
       persistent_property_names_(std::move(other.persistent_property_names_)),
       information_sections_(std::move(other.information_sections_)),
       persistent_devices_(std::move(other.persistent_devices_)),
-      temporary_devices_(std::move(other.temporary_devices_)) {
+      temporary_devices_(std::move(other.temporary_devices_)),
+      property_index_(std::move(other.property_index_)),
+      section_ordinals_(std::move(other.section_ordinals_)),
+      next_section_ordinal_(other.next_section_ordinal_) {
   // std::function will be in a valid but unspecified state after std::move(), hence resetting it
   other.persistent_config_changed_callback_ = {};
+  other.persistent_mutation_callback_ = {};
 }
 
 ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
@@ -87,10 +100,15 @@ ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
   std::lock_guard<std::recursive_mutex> others_lock(other.mutex_);
   persistent_config_changed_callback_.swap(other.persistent_config_changed_callback_);
   other.persistent_config_changed_callback_ = {};
+  persistent_mutation_callback_.swap(other.persistent_mutation_callback_);
+  other.persistent_mutation_callback_ = {};
   persistent_property_names_ = std::move(other.persistent_property_names_);
   information_sections_ = std::move(other.information_sections_);
   persistent_devices_ = std::move(other.persistent_devices_);
   temporary_devices_ = std::move(other.temporary_devices_);
+  property_index_ = std::move(other.property_index_);
+  section_ordinals_ = std::move(other.section_ordinals_);
+  next_section_ordinal_ = other.next_section_ordinal_;
   return *this;
 }
 
@@ -108,6 +126,13 @@ bool ConfigCache::operator!=(const ConfigCache& rhs) const {
 
 void ConfigCache::Clear() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (persistent_mutation_callback_) {
+    for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
+      for (const auto& section : *config_section) {
+        PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section.first));
+      }
+    }
+  }
   if (information_sections_.size() > 0) {
     information_sections_.clear();
     PersistentConfigChangedCallback();
@@ -119,12 +144,74 @@ void ConfigCache::Clear() {
   if (temporary_devices_.size() > 0) {
     temporary_devices_.clear();
   }
+  property_index_.clear();
+  section_ordinals_.clear();
+}
+
+void ConfigCache::IndexProperty(const Section& section, const std::string& property) {
+  if (!property_index_[property].insert(&section).second) {
+    return;
+  }
+  auto ordinal_iter = section_ordinals_.try_emplace(&section, SectionOrdinal{next_section_ordinal_, 0}).first;
+  if (ordinal_iter->second.indexed_properties == 0) {
+    next_section_ordinal_++;
+  }
+  ordinal_iter->second.indexed_properties++;
+}
+
+void ConfigCache::UnindexProperty(const Section& section, const std::string& property) {
+  auto index_iter = property_index_.find(property);
+  if (index_iter == property_index_.end() || index_iter->second.erase(&section) == 0) {
+    return;
+  }
+  if (index_iter->second.empty()) {
+    property_index_.erase(index_iter);
+  }
+  auto ordinal_iter = section_ordinals_.find(&section);
+  if (--ordinal_iter->second.indexed_properties == 0) {
+    section_ordinals_.erase(ordinal_iter);
+  }
+}
+
+void ConfigCache::UnindexSection(const Section& section) {
+  for (const auto& property : section.second) {
+    UnindexProperty(section, property.first);
+  }
+}
+
+void ConfigCache::IndexSection(const Section& section) {
+  for (const auto& property : section.second) {
+    IndexProperty(section, property.first);
+  }
+}
+
+void ConfigCache::TemporaryDeviceUsed(const Section& section) const {
+  auto ordinal_iter = section_ordinals_.find(&section);
+  if (ordinal_iter != section_ordinals_.end()) {
+    ordinal_iter->second.ordinal = next_section_ordinal_++;
+  }
+}
+
+void ConfigCache::EvictTemporaryDeviceIfFull() {
+  if (temporary_devices_.size() < temporary_devices_.capacity()) {
+    return;
+  }
+  auto coldest = std::prev(temporary_devices_.end());
+  UnindexSection(*coldest);
+  temporary_devices_.erase(coldest);
 }
 
 bool ConfigCache::HasSection(const std::string& section) const {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return information_sections_.contains(section) || persistent_devices_.contains(section) ||
-         temporary_devices_.contains(section);
+  if (information_sections_.contains(section) || persistent_devices_.contains(section)) {
+    return true;
+  }
+  auto section_iter = temporary_devices_.find(section);
+  if (section_iter == temporary_devices_.end()) {
+    return false;
+  }
+  TemporaryDeviceUsed(*section_iter);
+  return true;
 }
 
 bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
@@ -139,6 +226,7 @@ bool ConfigCache::HasProperty(const std::string& section, const std::string& pro
   }
   section_iter = temporary_devices_.find(section);
   if (section_iter != temporary_devices_.end()) {
+    TemporaryDeviceUsed(*section_iter);
     return section_iter->second.find(property) != section_iter->second.end();
   }
   return false;
@@ -166,6 +254,7 @@ std::optional<std::string> ConfigCache::GetProperty(const std::string& section,
   }
   section_iter = temporary_devices_.find(section);
   if (section_iter != temporary_devices_.end()) {
+    TemporaryDeviceUsed(*section_iter);
     auto property_iter = section_iter->second.find(property);
     if (property_iter != section_iter->second.end()) {
       return property_iter->second;
@@ -186,6 +275,10 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
     if (section_iter == information_sections_.end()) {
       section_iter = information_sections_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
     }
+    if (persistent_mutation_callback_) {
+      PersistentMutationCallback(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, section, property, value));
+    }
+    IndexProperty(*section_iter, property);
     section_iter->second.insert_or_assign(property, std::move(value));
     PersistentConfigChangedCallback();
     return;
@@ -193,9 +286,19 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
   auto section_iter = persistent_devices_.find(section);
   if (section_iter == persistent_devices_.end() && IsPersistentProperty(property)) {
     // move paired devices or create new paired device when a link key is set
-    auto section_properties = temporary_devices_.extract(section);
-    if (section_properties) {
-      section_iter = persistent_devices_.try_emplace_back(section, std::move(section_properties->second)).first;
+    auto temporary_section_iter = temporary_devices_.find(section);
+    if (temporary_section_iter != temporary_devices_.end()) {
+      UnindexSection(*temporary_section_iter);
+      section_iter = persistent_devices_.try_emplace_back(section, std::move(temporary_section_iter->second)).first;
+      temporary_devices_.erase(temporary_section_iter);
+      IndexSection(*section_iter);
+      // Properties of a temporary section are not on disk until the section becomes persistent
+      if (persistent_mutation_callback_) {
+        for (const auto& temp_property : section_iter->second) {
+          PersistentMutationCallback(MutationEntry::Set(
+              MutationEntry::PropertyType::NORMAL, section, temp_property.first, temp_property.second));
+        }
+      }
     } else {
       section_iter = persistent_devices_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
     }
@@ -209,27 +312,45 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
         value = kEncryptedStr;
       }
     }
+    if (persistent_mutation_callback_) {
+      PersistentMutationCallback(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, section, property, value));
+    }
+    IndexProperty(*section_iter, property);
     section_iter->second.insert_or_assign(property, std::move(value));
     PersistentConfigChangedCallback();
     return;
   }
   section_iter = temporary_devices_.find(section);
   if (section_iter == temporary_devices_.end()) {
-    auto triple = temporary_devices_.try_emplace(section, common::ListMap<std::string, std::string>{});
-    section_iter = std::get<0>(triple);
+    EvictTemporaryDeviceIfFull();
+    section_iter = std::get<0>(temporary_devices_.try_emplace(section, common::ListMap<std::string, std::string>{}));
+  } else {
+    TemporaryDeviceUsed(*section_iter);
   }
+  IndexProperty(*section_iter, property);
   section_iter->second.insert_or_assign(property, std::move(value));
 }
 
 bool ConfigCache::RemoveSection(const std::string& section) {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
   // sections are unique among all three maps, hence removing from one of them is enough
-  if (information_sections_.extract(section) || persistent_devices_.extract(section)) {
-    PersistentConfigChangedCallback();
+  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
+    auto section_iter = config_section->find(section);
+    if (section_iter != config_section->end()) {
+      PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section));
+      UnindexSection(*section_iter);
+      config_section->erase(section_iter);
+      PersistentConfigChangedCallback();
+      return true;
+    }
+  }
+  auto section_iter = temporary_devices_.find(section);
+  if (section_iter != temporary_devices_.end()) {
+    UnindexSection(*section_iter);
+    temporary_devices_.erase(section_iter);
     return true;
-  } else {
-    return temporary_devices_.extract(section).has_value();
   }
+  return false;
 }
 
 bool ConfigCache::RemoveProperty(const std::string& section, const std::string& property) {
@@ -237,11 +358,15 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
     auto value = section_iter->second.extract(property);
+    if (value) {
+      UnindexProperty(*section_iter, property);
+    }
     // if section is empty after removal, remove the whole section as empty section is not allowed
     if (section_iter->second.size() == 0) {
       information_sections_.erase(section_iter);
     }
     if (value.has_value()) {
+      PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section, property));
       PersistentConfigChangedCallback();
       return true;
     } else {
@@ -251,15 +376,29 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
   section_iter = persistent_devices_.find(section);
   if (section_iter != persistent_devices_.end()) {
     auto value = section_iter->second.extract(property);
+    if (value) {
+      UnindexProperty(*section_iter, property);
+    }
+    bool section_became_temporary = false;
     // if section is empty after removal, remove the whole section as empty section is not allowed
     if (section_iter->second.size() == 0) {
       persistent_devices_.erase(section_iter);
     } else if (value && IsPersistentProperty(property)) {
       // move unpaired device
-      auto section_properties = persistent_devices_.extract(section);
-      temporary_devices_.insert_or_assign(section, std::move(section_properties->second));
+      UnindexSection(*section_iter);
+      EvictTemporaryDeviceIfFull();
+      auto temporary_section_iter =
+          std::get<0>(temporary_devices_.try_emplace(section, std::move(section_iter->second)));
+      persistent_devices_.erase(section_iter);
+      IndexSection(*temporary_section_iter);
+      section_became_temporary = true;
     }
     if (value.has_value()) {
+      // A section that became temporary is no longer on disk at all
+      PersistentMutationCallback(
+          section_became_temporary
+              ? MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section)
+              : MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section, property));
       PersistentConfigChangedCallback();
       if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && os::ParameterProvider::IsCommonCriteriaMode() &&
           InEncryptKeyNameList(property)) {
@@ -272,7 +411,11 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
   }
   section_iter = temporary_devices_.find(section);
   if (section_iter != temporary_devices_.end()) {
+    TemporaryDeviceUsed(*section_iter);
     auto value = section_iter->second.extract(property);
+    if (value) {
+      UnindexProperty(*section_iter, property);
+    }
     if (section_iter->second.size() == 0) {
       temporary_devices_.erase(section_iter);
     }
@@ -325,6 +468,8 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
     for (auto it = config_section->begin(); it != config_section->end();) {
       if (it->second.contains(property)) {
         LOG_INFO("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
+        PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, it->first));
+        UnindexSection(*it);
         it = config_section->erase(it);
         num_persistent_removed++;
         continue;
@@ -335,6 +480,7 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
   for (auto it = temporary_devices_.begin(); it != temporary_devices_.end();) {
     if (it->second.contains(property)) {
       LOG_INFO("Removing temporary section %s with property %s", it->first.c_str(), property.c_str());
+      UnindexSection(*it);
       it = temporary_devices_.erase(it);
       continue;
     }
@@ -394,21 +540,31 @@ std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWi
     const std::string& property) const {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
   std::vector<SectionAndPropertyValue> result;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (const auto& elem : *config_section) {
-      auto it = elem.second.find(property);
-      if (it != elem.second.end()) {
-        result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-        continue;
-      }
+  auto index_iter = property_index_.find(property);
+  if (index_iter == property_index_.end()) {
+    return result;
+  }
+  // order the indexed sections by map and then by ordinal instead of walking the maps, which would also warm up
+  // temporary devices
+  std::vector<std::pair<std::pair<int, uint64_t>, const Section*>> ordered_sections;
+  ordered_sections.reserve(index_iter->second.size());
+  for (const auto* section : index_iter->second) {
+    uint64_t ordinal = section_ordinals_.at(section).ordinal;
+    if (information_sections_.contains(section->first)) {
+      ordered_sections.emplace_back(std::make_pair(0, ordinal), section);
+    } else if (persistent_devices_.contains(section->first)) {
+      ordered_sections.emplace_back(std::make_pair(1, ordinal), section);
+    } else {
+      ordered_sections.emplace_back(std::make_pair(2, UINT64_MAX - ordinal), section);
     }
   }
-  for (const auto& elem : temporary_devices_) {
-    auto it = elem.second.find(property);
-    if (it != elem.second.end()) {
-      result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-      continue;
-    }
+  std::sort(ordered_sections.begin(), ordered_sections.end());
+  result.reserve(ordered_sections.size());
+  for (const auto& ordered_section : ordered_sections) {
+    const Section& section = *ordered_section.second;
+    auto property_iter = section.second.find(property);
+    ASSERT_LOG(property_iter != section.second.end(), "Indexed property %s does not exist", property.c_str());
+    result.emplace_back(SectionAndPropertyValue{.section = section.first, .property = property_iter->second});
   }
   return result;
 }
@@ -461,13 +617,17 @@ bool ConfigCache::FixDeviceTypeInconsistencies() {
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto& elem : *config_section) {
       if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+        IndexProperty(elem, "DevType");
         persistent_device_changed = true;
+        PersistentMutationCallback(MutationEntry::Set(
+            MutationEntry::PropertyType::NORMAL, elem.first, "DevType", elem.second.find("DevType")->second));
       }
     }
   }
   bool temp_device_changed = false;
   for (auto& elem : temporary_devices_) {
     if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+      IndexProperty(elem, "DevType");
       temp_device_changed = true;
     }
   }
@@ -494,6 +654,7 @@ bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
       if (section_iter == temporary_devices_.end()) {
         return false;
       }
+      TemporaryDeviceUsed(*section_iter);
     }
     section_ptr = &section_iter->second;
   }
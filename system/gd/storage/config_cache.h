@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <mutex>
@@ -22,6 +23,7 @@
 #include <queue>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -95,6 +97,9 @@ class ConfigCache {
       return !(*this == rhs);
     }
   };
+  // Sections are returned in groups of information sections, persistent sections and then temporary sections, each
+  // group in config order. Only the sections with |property| are visited, through property_index_, and are put in
+  // config order by their ordinal
   virtual std::vector<SectionAndPropertyValue> GetSectionNamesWithProperty(const std::string& property) const;
 
   // modifiers
@@ -111,6 +116,11 @@ class ConfigCache {
   virtual void Clear();
   // Set a callback to notify interested party that a persistent config change has just happened
   virtual void SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback);
+  // Set a callback to receive every change made to the persistent part of this config, i.e. what would be written to
+  // disk by SerializeToLegacyFormat(), expressed as a mutation entry. Replaying these entries in order through Commit()
+  // onto the config as it was last serialized reproduces the current persistent config. Empty by default
+  virtual void SetPersistentMutationCallback(
+      std::function<void(const MutationEntry&)> persistent_mutation_callback);
 
   // Device config specific methods
   // TODO: methods here should be moved to a device specific config cache if this config cache is supposed to be generic
@@ -128,6 +138,8 @@ class ConfigCache {
   mutable std::recursive_mutex mutex_;
   // A callback to notify interested party that a persistent config change has just happened, empty by default
   std::function<void()> persistent_config_changed_callback_;
+  // A callback to receive each persistent change as a mutation entry, empty by default
+  std::function<void(const MutationEntry&)> persistent_mutation_callback_;
   // A set of property names that if set would make a section persistent and if non of these properties are set, a
   // section would become temporary again
   std::unordered_set<std::string_view> persistent_property_names_;
@@ -138,6 +150,34 @@ class ConfigCache {
   // Information about temporary devices, normally unpaired, will not be written to disk, will be evicted automatically
   // if capacity exceeds given value during initialization
   common::LruCache<std::string, common::ListMap<std::string, std::string>> temporary_devices_;
+  using Section = std::pair<const std::string, common::ListMap<std::string, std::string>>;
+  // Sections, in any of the three maps above, that have a given property. Sections are identified by their address in
+  // these maps, which does not change until the section is removed or moved to another map
+  std::unordered_map<std::string, std::unordered_set<const Section*>> property_index_;
+  struct SectionOrdinal {
+    // Increases with each section added to a map, and with each use of a temporary device, so that sections of a map
+    // are in config order by ascending ordinal, or by descending ordinal for temporary devices which are kept most
+    // recently used first
+    uint64_t ordinal;
+    // Number of properties of the section in property_index_
+    size_t indexed_properties;
+  };
+  // Ordinal of each section in property_index_, mutable as using a temporary device reorders temporary_devices_
+  mutable std::unordered_map<const Section*, SectionOrdinal> section_ordinals_;
+  mutable uint64_t next_section_ordinal_ = 0;
+
+  // Maintain property_index_ and section_ordinals_, must be called whenever a property is added to or removed from any
+  // section and whenever a section is removed or moved to another map. |section| must be stored in one of the three
+  // maps above
+  void IndexProperty(const Section& section, const std::string& property);
+  void UnindexProperty(const Section& section, const std::string& property);
+  void IndexSection(const Section& section);
+  void UnindexSection(const Section& section);
+  // Must be called whenever a temporary device is found in temporary_devices_, which makes it the most recently used
+  void TemporaryDeviceUsed(const Section& section) const;
+  // Remove the coldest temporary device if temporary_devices_ is full, so that adding a temporary device never evicts
+  // a section that is still indexed
+  void EvictTemporaryDeviceIfFull();
 
   // Convenience method to check if the callback is valid before calling it
   inline void PersistentConfigChangedCallback() const {
@@ -145,6 +185,13 @@ class ConfigCache {
       persistent_config_changed_callback_();
     }
   }
+
+  // Convenience method to check if the callback is valid before calling it
+  inline void PersistentMutationCallback(const MutationEntry& entry) const {
+    if (persistent_mutation_callback_) {
+      persistent_mutation_callback_(entry);
+    }
+  }
 };
 
 }  // namespace storage
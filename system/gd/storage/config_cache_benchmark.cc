@@ -0,0 +1,95 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filesystem>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "hci/address.h"
+#include "os/files.h"
+#include "storage/config_cache.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+
+// Loads and queries a legacy config file with state.range(0) bonded devices
+class BM_ConfigCache : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    config_path_ = (std::filesystem::temp_directory_path() / "bm_config_cache.conf").string();
+    std::string content = "[Info]\nFileSource = Empty\n\n[Adapter]\nAddress = 01:02:03:ab:cd:ef\n\n";
+    for (int64_t i = 0; i < st.range(0); i++) {
+      content += "[" + DeviceSection(i) + "]\n";
+      content += "Name = Device " + std::to_string(i) + "\n";
+      content += "DevClass = 2360344\nDevType = 3\nAddrType = 0\nManufacturer = 15\nLmpVer = 10\n";
+      content += "LinkKeyType = 8\nLinkKey = fedcba0987654321fedcba0987654321\n";
+      content += "LeIdentityAddr = " + IdentityAddress(i) + "\n\n";
+    }
+    benchmark::DoNotOptimize(os::WriteToFile(config_path_, content));
+  }
+
+  void TearDown(State& st) override {
+    std::filesystem::remove(config_path_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  static std::string DeviceSection(int64_t index) {
+    hci::Address address{0x11, 0x22, 0x33, 0x44, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index)};
+    return address.ToString();
+  }
+
+  static std::string IdentityAddress(int64_t index) {
+    hci::Address address{0xc0, 0x22, 0x33, 0x44, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index)};
+    return address.ToString();
+  }
+
+  std::string config_path_;
+};
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, load)(State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacyConfigFile::FromPath(config_path_).Read(100));
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, load)->Arg(100)->Arg(500)->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, get_property)(State& state) {
+  auto config = LegacyConfigFile::FromPath(config_path_).Read(100);
+  int64_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(config->GetProperty(DeviceSection(index++ % state.range(0)), "LinkKey"));
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, get_property)->Arg(100)->Arg(500);
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, get_section_names_with_property)(State& state) {
+  auto config = LegacyConfigFile::FromPath(config_path_).Read(100);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(config->GetSectionNamesWithProperty("LeIdentityAddr"));
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, get_section_names_with_property)->Arg(100)->Arg(500);
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <vector>
 
 #include "hci/enum_helper.h"
 #include "storage/device.h"
@@ -315,6 +316,70 @@ TEST(ConfigCacheTest, test_get_section_with_property) {
           SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:FF", .property = "C"}));
 }
 
+TEST(ConfigCacheTest, test_get_section_with_property_after_removal) {
+  ConfigCache config(2, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  config.SetProperty("CC:DD:EE:FF:00:11", "B", "D");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "E");
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("B"),
+      ElementsAre(
+          SectionAndPropertyValue{.section = "A", .property = "C"},
+          SectionAndPropertyValue{.section = "CC:DD:EE:FF:00:11", .property = "D"},
+          SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:FF", .property = "E"}));
+  // Unpairing keeps the property but moves the section to the head of temporary devices
+  config.RemoveProperty("CC:DD:EE:FF:00:11", "LinkKey");
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("B"),
+      ElementsAre(
+          SectionAndPropertyValue{.section = "A", .property = "C"},
+          SectionAndPropertyValue{.section = "CC:DD:EE:FF:00:11", .property = "D"},
+          SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:FF", .property = "E"}));
+  // Evicted temporary device is no longer found
+  config.SetProperty("AA:BB:CC:DD:EE:EF", "C", "D");
+  ASSERT_EQ(config.GetSectionNamesWithProperty("B").size(), 2u);
+  config.RemoveProperty("A", "B");
+  config.RemoveSection("CC:DD:EE:FF:00:11");
+  config.RemoveSection("AA:BB:CC:DD:EE:FF");
+  ASSERT_THAT(config.GetSectionNamesWithProperty("B"), ElementsAre());
+  ASSERT_THAT(
+      config.GetSectionNamesWithProperty("C"),
+      ElementsAre(SectionAndPropertyValue{.section = "AA:BB:CC:DD:EE:EF", .property = "D"}));
+}
+
+TEST(ConfigCacheTest, test_get_section_with_property_in_config_order) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  std::vector<SectionAndPropertyValue> expected;
+  for (int i = 0; i < 20; i++) {
+    std::string section = GetTestAddress(i);
+    config.SetProperty(section, "LinkKey", "AABBAABBCCDDEE");
+    if (i % 3 == 0) {
+      expected.push_back(SectionAndPropertyValue{.section = section, .property = std::to_string(i)});
+    }
+  }
+  // Properties are set in reverse order but sections are returned in config order
+  for (auto it = expected.rbegin(); it != expected.rend(); it++) {
+    config.SetProperty(it->section, "LeIdentityAddr", it->property);
+  }
+  ASSERT_THAT(config.GetSectionNamesWithProperty("LeIdentityAddr"), ElementsAreArray(expected));
+  // Pairing a temporary device appends it to persistent devices
+  config.SetProperty("CC:DD:EE:FF:00:11", "LeIdentityAddr", "temporary");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  expected.push_back(SectionAndPropertyValue{.section = "CC:DD:EE:FF:00:11", .property = "temporary"});
+  ASSERT_THAT(config.GetSectionNamesWithProperty("LeIdentityAddr"), ElementsAreArray(expected));
+  // Temporary devices come last, most recently used first
+  config.SetProperty("CC:DD:EE:FF:00:22", "LeIdentityAddr", "temporary2");
+  config.SetProperty("CC:DD:EE:FF:00:33", "LeIdentityAddr", "temporary3");
+  auto with_temporary = expected;
+  with_temporary.push_back(SectionAndPropertyValue{.section = "CC:DD:EE:FF:00:33", .property = "temporary3"});
+  with_temporary.push_back(SectionAndPropertyValue{.section = "CC:DD:EE:FF:00:22", .property = "temporary2"});
+  ASSERT_THAT(config.GetSectionNamesWithProperty("LeIdentityAddr"), ElementsAreArray(with_temporary));
+  ASSERT_TRUE(config.HasSection("CC:DD:EE:FF:00:22"));
+  std::swap(with_temporary[with_temporary.size() - 2], with_temporary.back());
+  ASSERT_THAT(config.GetSectionNamesWithProperty("LeIdentityAddr"), ElementsAreArray(with_temporary));
+}
+
 TEST(ConfigCacheTest, test_get_sections_matching_at_least_one_property) {
   ConfigCache config(100, Device::kLinkKeyProperties);
   config.SetProperty("A", "B", "C");
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <string_view>
+
+#include "os/files.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+constexpr char kSetRecord = 'S';
+constexpr char kRemovePropertyRecord = 'P';
+constexpr char kRemoveSectionRecord = 'R';
+constexpr char kBaseRecord = 'B';
+
+// 64-bit FNV-1a, which unlike std::hash is stable across builds and hence across updates
+std::string HashConfigContent(const std::string& config_content) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (unsigned char c : config_content) {
+    hash ^= c;
+    hash *= 0x100000001b3;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016" PRIx64, hash);
+  return std::string(hex);
+}
+
+void AppendField(std::string& record, const std::string& field) {
+  record.push_back(' ');
+  record.append(std::to_string(field.size()));
+  record.push_back(':');
+  record.append(field);
+}
+
+// Parse a " <length>:<bytes>" field from the beginning of |input| and advance |input| past it
+std::optional<std::string> ParseField(std::string_view& input) {
+  if (input.empty() || input.front() != ' ') {
+    return std::nullopt;
+  }
+  input.remove_prefix(1);
+  size_t colon = input.find(':');
+  if (colon == std::string_view::npos || colon == 0) {
+    return std::nullopt;
+  }
+  size_t length = 0;
+  for (size_t i = 0; i < colon; i++) {
+    if (input[i] < '0' || input[i] > '9') {
+      return std::nullopt;
+    }
+    length = length * 10 + (input[i] - '0');
+  }
+  input.remove_prefix(colon + 1);
+  if (input.size() < length) {
+    return std::nullopt;
+  }
+  std::string field(input.substr(0, length));
+  input.remove_prefix(length);
+  return field;
+}
+
+// Parse a base record from the beginning of |input| and advance |input| past it, return std::nullopt and leave |input|
+// untouched if |input| does not start with a base record
+std::optional<std::string> ParseBaseRecord(std::string_view& input) {
+  if (input.empty() || input.front() != kBaseRecord) {
+    return std::nullopt;
+  }
+  std::string_view record = input.substr(1);
+  auto hash = ParseField(record);
+  if (!hash || record.empty() || record.front() != '\n') {
+    return std::nullopt;
+  }
+  input = record.substr(1);
+  return hash;
+}
+
+// Parse one mutation record from the beginning of |input| and advance |input| past its terminating newline, return
+// std::nullopt if the record is truncated or malformed
+std::optional<MutationEntry> ParseRecord(std::string_view& input) {
+  if (input.empty()) {
+    return std::nullopt;
+  }
+  char type = input.front();
+  input.remove_prefix(1);
+  std::optional<MutationEntry> entry;
+  switch (type) {
+    case kSetRecord: {
+      auto section = ParseField(input);
+      auto property = ParseField(input);
+      auto value = ParseField(input);
+      if (section && property && value && !section->empty() && !property->empty()) {
+        entry = MutationEntry::Set(
+            MutationEntry::PropertyType::NORMAL, std::move(*section), std::move(*property), std::move(*value));
+      }
+      break;
+    }
+    case kRemovePropertyRecord: {
+      auto section = ParseField(input);
+      auto property = ParseField(input);
+      if (section && property && !section->empty() && !property->empty()) {
+        entry = MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, std::move(*section), std::move(*property));
+      }
+      break;
+    }
+    case kRemoveSectionRecord: {
+      auto section = ParseField(input);
+      if (section && !section->empty()) {
+        entry = MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, std::move(*section));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  if (!entry || input.empty() || input.front() != '\n') {
+    return std::nullopt;
+  }
+  input.remove_prefix(1);
+  return entry;
+}
+
+}  // namespace
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+std::string ConfigJournal::SerializeEntry(const MutationEntry& entry) {
+  std::string record;
+  switch (entry.entry_type) {
+    case MutationEntry::EntryType::SET:
+      record.push_back(kSetRecord);
+      AppendField(record, entry.section);
+      AppendField(record, entry.property);
+      AppendField(record, entry.value);
+      break;
+    case MutationEntry::EntryType::REMOVE_PROPERTY:
+      record.push_back(kRemovePropertyRecord);
+      AppendField(record, entry.section);
+      AppendField(record, entry.property);
+      break;
+    case MutationEntry::EntryType::REMOVE_SECTION:
+      record.push_back(kRemoveSectionRecord);
+      AppendField(record, entry.section);
+      break;
+      // do not write a default case so that when a new enum is defined, compilation would fail automatically
+  }
+  record.push_back('\n');
+  return record;
+}
+
+std::string ConfigJournal::SerializeBase(const std::string& config_content) {
+  std::string record(1, kBaseRecord);
+  AppendField(record, HashConfigContent(config_content));
+  record.push_back('\n');
+  return record;
+}
+
+void ConfigJournal::Append(const MutationEntry& entry) {
+  ASSERT_LOG(
+      entry.property_type == MutationEntry::PropertyType::NORMAL, "memory only entries must not be journaled");
+  std::string record = SerializeEntry(entry);
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_size_ += record.size();
+  pending_records_.push_back(std::move(record));
+}
+
+bool ConfigJournal::Flush() {
+  std::string records;
+  size_t record_count;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_records_.empty()) {
+      return true;
+    }
+    records.reserve(pending_size_);
+    for (const auto& record : pending_records_) {
+      records.append(record);
+    }
+    record_count = pending_records_.size();
+  }
+  // Flush() and Truncate() are serialized by the owner, hence only Append() may have run meanwhile and records flushed
+  // here are still at the front of the pending queue
+  bool success = os::AppendToFile(path_, records);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!success) {
+    return false;
+  }
+  pending_records_.erase(pending_records_.begin(), pending_records_.begin() + record_count);
+  pending_size_ -= records.size();
+  file_size_ += records.size();
+  file_record_count_ += record_count;
+  bytes_written_ += records.size();
+  return true;
+}
+
+size_t ConfigJournal::Mark() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_records_.size();
+}
+
+bool ConfigJournal::Truncate(size_t mark, const std::string& config_content) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(mark <= pending_records_.size());
+  for (size_t i = 0; i < mark; i++) {
+    pending_size_ -= pending_records_.front().size();
+    pending_records_.pop_front();
+  }
+  // Written atomically, the journal file either still has its previous base and records, or only the new base
+  if (!os::WriteToFile(path_, SerializeBase(config_content))) {
+    LOG_ERROR("unable to truncate config journal at %s", path_.c_str());
+    return false;
+  }
+  file_size_ = 0;
+  file_record_count_ = 0;
+  return true;
+}
+
+std::optional<size_t> ConfigJournal::Replay(ConfigCache* cache, const std::string& config_content) const {
+  ASSERT(cache != nullptr);
+  if (!os::FileExists(path_)) {
+    return std::nullopt;
+  }
+  auto content = os::ReadSmallFile(path_);
+  if (!content) {
+    LOG_ERROR("unable to read config journal at %s, error: %s", path_.c_str(), strerror(errno));
+    return std::nullopt;
+  }
+  std::string_view input(*content);
+  auto base = ParseBaseRecord(input);
+  if (base && *base != HashConfigContent(config_content)) {
+    LOG_INFO("config journal %s was written on top of another config, its records are already saved", path_.c_str());
+    return 0;
+  }
+  std::queue<MutationEntry> entries;
+  while (!input.empty()) {
+    auto entry = ParseRecord(input);
+    if (!entry) {
+      // Only the last record can be torn, anything after it is garbage as well
+      LOG_WARN(
+          "discarding %zu bytes of incomplete record at the end of config journal %s", input.size(), path_.c_str());
+      break;
+    }
+    entries.push(std::move(*entry));
+  }
+  size_t num_records = entries.size();
+  cache->Commit(entries);
+  return num_records;
+}
+
+bool ConfigJournal::Delete() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_records_.clear();
+  pending_size_ = 0;
+  file_size_ = 0;
+  file_record_count_ = 0;
+  if (!os::FileExists(path_)) {
+    return false;
+  }
+  return os::RemoveFile(path_);
+}
+
+size_t ConfigJournal::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_size_ + pending_size_;
+}
+
+size_t ConfigJournal::RecordCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_record_count_ + pending_records_.size();
+}
+
+size_t ConfigJournal::BytesWritten() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_written_;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
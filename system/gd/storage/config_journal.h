@@ -0,0 +1,103 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "storage/config_cache.h"
+#include "storage/mutation_entry.h"
+
+namespace bluetooth {
+namespace storage {
+
+// An append-only log of persistent config mutations that sits next to a legacy config file
+//
+// Instead of rewriting the whole legacy config file on every change, persistent mutations are appended to this
+// journal and the legacy file is only rewritten (compacted) once in a while. Replaying the journal in order on top of
+// the legacy config file, or its backup, reproduces the latest config.
+//
+// Each record is a single line: a type character followed by length prefixed fields, e.g.
+//   S 17:AA:BB:CC:DD:EE:FF 4:Name 5:Hello
+//   P 17:AA:BB:CC:DD:EE:FF 4:Name
+//   R 17:AA:BB:CC:DD:EE:FF
+// A record that is not terminated by a newline is a torn write from a crash and is discarded on replay.
+//
+// Each compaction restarts the journal with a base record holding a hash of the config file content it was written on
+// top of, e.g.
+//   B 16:0123456789abcdef
+// Records of a journal whose base is not the config file being loaded are already part of that config file, e.g. when
+// the device crashed after the config file was rewritten but before the journal was emptied, and are not replayed.
+//
+// This class is thread safe. Append() can be called from any thread while holding other locks as it only buffers
+// records in memory; all file operations happen in Flush(), Truncate() and Replay()
+class ConfigJournal {
+ public:
+  static ConfigJournal FromPath(std::string path) {
+    return ConfigJournal(std::move(path));
+  }
+  explicit ConfigJournal(std::string path);
+
+  ConfigJournal(const ConfigJournal&) = delete;
+  ConfigJournal& operator=(const ConfigJournal&) = delete;
+
+  // Buffer |entry| in memory, it will be written to disk on the next Flush()
+  void Append(const MutationEntry& entry);
+  // Append all buffered records to the journal file and sync it to storage media
+  // Return true on success or if there is nothing to flush
+  bool Flush();
+  // Return a marker for the records buffered so far, to be given to Truncate() once a snapshot of the config that
+  // includes these records has been safely written somewhere else
+  size_t Mark() const;
+  // Restart the journal file on top of |config_content| and drop buffered records up to |mark|. Records buffered after
+  // |mark| are kept, they may or may not be part of the snapshot and replaying them again is harmless
+  bool Truncate(size_t mark, const std::string& config_content);
+  // Apply every complete record in the journal file onto |cache| in order, if the journal was started on top of a
+  // config file with |config_content| or has no base record
+  // Return the number of records replayed, or std::nullopt if the journal file does not exist
+  std::optional<size_t> Replay(ConfigCache* cache, const std::string& config_content) const;
+  // Remove journal file and drop all buffered records
+  bool Delete();
+
+  // Size in bytes of records flushed since construction or last Truncate(), including buffered records that are not
+  // yet flushed. Records that were already in the journal file before construction are not counted
+  size_t Size() const;
+  // Number of records counted in Size()
+  size_t RecordCount() const;
+  // Total number of bytes written to the journal file since construction
+  size_t BytesWritten() const;
+
+  static std::string SerializeEntry(const MutationEntry& entry);
+  static std::string SerializeBase(const std::string& config_content);
+
+ private:
+  std::string path_;
+  mutable std::mutex mutex_;
+  // records that are appended but not yet flushed to disk
+  std::deque<std::string> pending_records_;
+  size_t pending_size_ = 0;
+  // size of records flushed to the journal file since construction or last Truncate()
+  size_t file_size_ = 0;
+  size_t file_record_count_ = 0;
+  size_t bytes_written_ = 0;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "hci/address.h"
+#include "storage/config_cache.h"
+#include "storage/config_journal.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+
+// Compares the cost of persisting a single bond change with the legacy full rewrite against appending it to the
+// config journal, with a config of state.range(0) bonded devices
+class BM_ConfigSave : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    auto temp_dir = std::filesystem::temp_directory_path();
+    config_path_ = (temp_dir / "bm_config.conf").string();
+    journal_path_ = (temp_dir / "bm_config.journal").string();
+    config_ = std::make_unique<ConfigCache>(100, Device::kLinkKeyProperties);
+    for (int64_t i = 0; i < st.range(0); i++) {
+      auto section = DeviceSection(i);
+      config_->SetProperty(section, "Name", "Device " + std::to_string(i));
+      config_->SetProperty(section, "DevClass", "2360344");
+      config_->SetProperty(section, "DevType", "3");
+      config_->SetProperty(section, "AddrType", "0");
+      config_->SetProperty(section, "Manufacturer", "15");
+      config_->SetProperty(section, "LmpVer", "10");
+      config_->SetProperty(
+          section, "Service", "0000110a-0000-1000-8000-00805f9b34fb 0000110b-0000-1000-8000-00805f9b34fb");
+      config_->SetProperty(section, "LinkKeyType", "8");
+      config_->SetProperty(section, "LinkKey", "fedcba0987654321fedcba0987654321");
+      config_->SetProperty(
+          section, "LE_KEY_PENC", "a5ba5cf8e2b1f7a0fa1a4a24ff9bd15c000000000000000000000000000000003b9f0ca4");
+      config_->SetProperty(section, "LE_KEY_PID", "fedcba0987654321fedcba098765432100000000000000");
+    }
+  }
+
+  void TearDown(State& st) override {
+    config_.reset();
+    std::filesystem::remove(config_path_);
+    std::filesystem::remove(journal_path_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  static std::string DeviceSection(int64_t index) {
+    hci::Address address{0x11, 0x22, 0x33, 0x44, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index)};
+    return address.ToString();
+  }
+
+  std::string config_path_;
+  std::string journal_path_;
+  std::unique_ptr<ConfigCache> config_;
+};
+
+BENCHMARK_DEFINE_F(BM_ConfigSave, legacy_rewrite_per_change)(State& state) {
+  size_t bytes_written = 0;
+  int64_t change = 0;
+  for (auto _ : state) {
+    config_->SetProperty(DeviceSection(change % state.range(0)), "MetricsId", std::to_string(change));
+    change++;
+    auto serialized = config_->SerializeToLegacyFormat();
+    bytes_written += serialized.size();
+    benchmark::DoNotOptimize(LegacyConfigFile::FromPath(config_path_).Write(*config_));
+  }
+  state.counters["bytes_per_change"] =
+      benchmark::Counter(static_cast<double>(bytes_written), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigSave, legacy_rewrite_per_change)->Arg(10)->Arg(100)->Arg(500)->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConfigSave, journal_append_per_change)(State& state) {
+  ConfigJournal journal(journal_path_);
+  config_->SetPersistentMutationCallback([&journal](const MutationEntry& entry) { journal.Append(entry); });
+  int64_t change = 0;
+  for (auto _ : state) {
+    config_->SetProperty(DeviceSection(change % state.range(0)), "MetricsId", std::to_string(change));
+    change++;
+    benchmark::DoNotOptimize(journal.Flush());
+  }
+  state.counters["bytes_per_change"] =
+      benchmark::Counter(static_cast<double>(journal.BytesWritten()), benchmark::Counter::kAvgIterations);
+  config_->SetPersistentMutationCallback({});
+  journal.Delete();
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigSave, journal_append_per_change)->Arg(10)->Arg(100)->Arg(500)->UseRealTime();
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "os/files.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+namespace testing {
+
+using bluetooth::os::AppendToFile;
+using bluetooth::os::ReadSmallFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
+using bluetooth::storage::Device;
+using bluetooth::storage::LegacyConfigFile;
+using bluetooth::storage::MutationEntry;
+
+class ConfigJournalTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_journal_ = std::filesystem::temp_directory_path() / "temp_config.journal";
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
+  }
+
+  void TearDown() override {
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
+  }
+
+  std::filesystem::path temp_journal_;
+};
+
+TEST_F(ConfigJournalTest, serialize_entry_test) {
+  EXPECT_EQ(
+      ConfigJournal::SerializeEntry(
+          MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF", "Name", "Hello world")),
+      "S 17:AA:BB:CC:DD:EE:FF 4:Name 11:Hello world\n");
+  EXPECT_EQ(
+      ConfigJournal::SerializeEntry(
+          MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF", "Name")),
+      "P 17:AA:BB:CC:DD:EE:FF 4:Name\n");
+  EXPECT_EQ(
+      ConfigJournal::SerializeEntry(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF")),
+      "R 17:AA:BB:CC:DD:EE:FF\n");
+}
+
+TEST_F(ConfigJournalTest, replay_non_existing_journal_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_FALSE(ConfigJournal::FromPath(temp_journal_.string()).Replay(&config, ""));
+}
+
+TEST_F(ConfigJournalTest, persistent_mutations_replay_to_same_config_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  // snapshot of the config as if it was written to disk
+  ConfigCache snapshot(100, Device::kLinkKeyProperties);
+  snapshot.SetProperty("A", "B", "C");
+  snapshot.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+
+  ConfigJournal journal(temp_journal_.string());
+  config.SetPersistentMutationCallback([&journal](const MutationEntry& entry) { journal.Append(entry); });
+  // temporary device is not journaled until it becomes persistent
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "Name", "Hello");
+  EXPECT_EQ(journal.RecordCount(), 0u);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "CCDDEEFF");
+  EXPECT_EQ(journal.RecordCount(), 2u);
+  config.SetProperty("A", "B", "D");
+  config.SetProperty("A", "Empty", "");
+  config.RemoveProperty("CC:DD:EE:FF:00:11", "LinkKey");
+  config.SetProperty("B", "C", "D");
+  config.RemoveSection("B");
+  ASSERT_TRUE(journal.Flush());
+
+  ASSERT_THAT(
+      ConfigJournal::FromPath(temp_journal_.string()).Replay(&snapshot, ""), Optional(Eq(journal.RecordCount())));
+  EXPECT_EQ(config.SerializeToLegacyFormat(), snapshot.SerializeToLegacyFormat());
+  EXPECT_THAT(snapshot.GetPersistentSections(), ElementsAre("AA:BB:CC:DD:EE:FF"));
+  EXPECT_THAT(snapshot.GetProperty("AA:BB:CC:DD:EE:FF", "Name"), Optional(StrEq("Hello")));
+  EXPECT_THAT(snapshot.GetProperty("A", "Empty"), Optional(StrEq("")));
+  EXPECT_FALSE(snapshot.HasSection("B"));
+}
+
+TEST_F(ConfigJournalTest, torn_record_is_discarded_test) {
+  ConfigJournal journal(temp_journal_.string());
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "C"));
+  ASSERT_TRUE(journal.Flush());
+  // simulate a crash in the middle of writing a record
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "S 1:A 1:B 5:CD"));
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_THAT(journal.Replay(&config, ""), Optional(Eq(1u)));
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C")));
+}
+
+TEST_F(ConfigJournalTest, truncate_keeps_records_after_mark_test) {
+  ConfigJournal journal(temp_journal_.string());
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "C"));
+  ASSERT_TRUE(journal.Flush());
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "C", "D"));
+  auto mark = journal.Mark();
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "D", "E"));
+  EXPECT_EQ(journal.RecordCount(), 3u);
+
+  ASSERT_TRUE(journal.Truncate(mark, "[A]\nB = C\nC = D\n"));
+  EXPECT_THAT(
+      ReadSmallFile(temp_journal_.string()), Optional(StrEq(ConfigJournal::SerializeBase("[A]\nB = C\nC = D\n"))));
+  EXPECT_EQ(journal.RecordCount(), 1u);
+  ASSERT_TRUE(journal.Flush());
+  EXPECT_THAT(
+      ReadSmallFile(temp_journal_.string()),
+      Optional(StrEq(ConfigJournal::SerializeBase("[A]\nB = C\nC = D\n") + "S 1:A 1:D 1:E\n")));
+}
+
+TEST_F(ConfigJournalTest, replay_only_on_top_of_base_config_test) {
+  ConfigJournal journal(temp_journal_.string());
+  ASSERT_TRUE(journal.Truncate(journal.Mark(), "[A]\nB = C\n"));
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "D"));
+  ASSERT_TRUE(journal.Flush());
+  EXPECT_THAT(ConfigJournal::SerializeBase("[A]\nB = C\n"), StartsWith("B 16:"));
+  EXPECT_NE(ConfigJournal::SerializeBase("[A]\nB = C\n"), ConfigJournal::SerializeBase("[A]\nB = D\n"));
+
+  // the journal was started on top of this config
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  EXPECT_THAT(journal.Replay(&config, "[A]\nB = C\n"), Optional(Eq(1u)));
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("D")));
+
+  // a later config already has the records of the journal, e.g. after a crash before the journal was truncated
+  ConfigCache newer_config(100, Device::kLinkKeyProperties);
+  newer_config.SetProperty("A", "E", "F");
+  EXPECT_THAT(journal.Replay(&newer_config, "[A]\nE = F\n"), Optional(Eq(0u)));
+  EXPECT_FALSE(newer_config.HasProperty("A", "B"));
+}
+
+TEST_F(ConfigJournalTest, delete_test) {
+  ConfigJournal journal(temp_journal_.string());
+  EXPECT_FALSE(journal.Delete());
+  journal.Append(MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "C"));
+  ASSERT_TRUE(journal.Flush());
+  EXPECT_TRUE(journal.Delete());
+  EXPECT_FALSE(std::filesystem::exists(temp_journal_));
+  EXPECT_EQ(journal.Size(), 0u);
+}
+
+}  // namespace testing
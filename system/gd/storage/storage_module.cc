@@ -20,6 +20,7 @@
 #include <ctime>
 #include <iomanip>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "common/bind.h"
@@ -30,6 +31,7 @@
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/legacy_config_file.h"
 #include "storage/mutation.h"
 
@@ -42,6 +44,7 @@ using os::Alarm;
 using os::Handler;
 
 static const std::string kFactoryResetProperty = "persist.bluetooth.factoryreset";
+static const std::string kConfigJournalProperty = "persist.bluetooth.config_journal.enabled";
 
 static const size_t kDefaultTempDeviceCapacity = 10000;
 // Save config whenever there is a change, but delay it by this value so that burst config change won't overwhelm disk
@@ -49,6 +52,9 @@ static const std::chrono::milliseconds kDefaultConfigSaveDelay = std::chrono::mi
 // Writing a config to disk takes a minimum 10 ms on a decent x86_64 machine, and 20 ms if including backup file
 // The config saving delay must be bigger than this value to avoid overwhelming the disk
 static const std::chrono::milliseconds kMinConfigSaveDelay = std::chrono::milliseconds(20);
+// Once the config journal grows beyond this size, the next save rewrites the config file and empties the journal.
+// A bonded device is roughly 1 KB in the config file, hence this is in the same order as a typical config file
+static const size_t kConfigJournalCompactionThreshold = 64 * 1024;
 
 const int kConfigFileComparePass = 1;
 const int kConfigBackupComparePass = 2;
@@ -67,14 +73,18 @@ StorageModule::StorageModule(
     std::chrono::milliseconds config_save_delay,
     size_t temp_devices_capacity,
     bool is_restricted_mode,
-    bool is_single_user_mode)
+    bool is_single_user_mode,
+    bool use_config_journal)
     : config_file_path_(std::move(config_file_path)),
       config_save_delay_(config_save_delay),
       temp_devices_capacity_(temp_devices_capacity),
       is_restricted_mode_(is_restricted_mode),
-      is_single_user_mode_(is_single_user_mode) {
+      is_single_user_mode_(is_single_user_mode),
+      use_config_journal_(use_config_journal) {
   // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.bak"
   config_backup_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".bak";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.journal"
+  config_journal_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".journal";
   ASSERT_LOG(
       config_save_delay > kMinConfigSaveDelay,
       "Config save delay of %lld ms is not enough, must be at least %lld ms to avoid overwhelming the disk",
@@ -89,16 +99,28 @@ StorageModule::~StorageModule() {
 
 const ModuleFactory StorageModule::Factory = ModuleFactory([]() {
   return new StorageModule(
-      os::ParameterProvider::ConfigFilePath(), kDefaultConfigSaveDelay, kDefaultTempDeviceCapacity, false, false);
+      os::ParameterProvider::ConfigFilePath(),
+      kDefaultConfigSaveDelay,
+      kDefaultTempDeviceCapacity,
+      false,
+      false,
+      os::GetSystemProperty(kConfigJournalProperty) == "true");
 });
 
 struct StorageModule::impl {
-  explicit impl(Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit)
-      : config_save_alarm_(handler), cache_(std::move(cache)), memory_only_cache_(in_memory_cache_size_limit, {}) {}
+  explicit impl(
+      Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit, const std::string& journal_path)
+      : config_save_alarm_(handler),
+        cache_(std::move(cache)),
+        memory_only_cache_(in_memory_cache_size_limit, {}),
+        journal_(journal_path) {}
   Alarm config_save_alarm_;
   ConfigCache cache_;
   ConfigCache memory_only_cache_;
+  ConfigJournal journal_;
   bool has_pending_config_save_ = false;
+  // Changes made before the journal is hooked up, e.g. when loading, can only be saved by rewriting the config file
+  bool needs_compaction_ = true;
 };
 
 Mutation StorageModule::Modify() {
@@ -122,25 +144,55 @@ void StorageModule::SaveDelayed() {
     return;
   }
   pimpl_->config_save_alarm_.Schedule(
-      common::BindOnce(&StorageModule::SaveImmediately, common::Unretained(this)), config_save_delay_);
+      common::BindOnce(&StorageModule::SaveIncrementally, common::Unretained(this)), config_save_delay_);
   pimpl_->has_pending_config_save_ = true;
 }
 
+void StorageModule::SaveIncrementally() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (!use_config_journal_ || pimpl_->needs_compaction_ ||
+      pimpl_->journal_.Size() >= kConfigJournalCompactionThreshold) {
+    SaveImmediately();
+    return;
+  }
+  pimpl_->has_pending_config_save_ = false;
+  if (!pimpl_->journal_.Flush()) {
+    LOG_WARN("unable to append to config journal at %s, rewriting config instead", config_journal_path_.c_str());
+    SaveImmediately();
+  }
+}
+
 void StorageModule::SaveImmediately() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
   if (pimpl_->has_pending_config_save_) {
     pimpl_->config_save_alarm_.Cancel();
     pimpl_->has_pending_config_save_ = false;
   }
+  // 0. remember which journal entries are covered by the config about to be written, entries journaled concurrently
+  //    after this point may or may not be included and are kept
+  auto journal_mark = pimpl_->journal_.Mark();
   // 1. rename old config to backup name
   if (os::FileExists(config_file_path_)) {
     ASSERT(os::RenameFile(config_file_path_, config_backup_path_));
   }
   // 2. write in-memory config to disk, if failed, backup can still be used
-  ASSERT(LegacyConfigFile::FromPath(config_file_path_).Write(pimpl_->cache_));
+  auto config_content = pimpl_->cache_.SerializeToLegacyFormat();
+  ASSERT(os::WriteToFile(config_file_path_, config_content));
   // 3. now write back up to disk as well
-  ASSERT(LegacyConfigFile::FromPath(config_backup_path_).Write(pimpl_->cache_));
-  // 4. save checksum if it is running in common criteria mode
+  ASSERT(os::WriteToFile(config_backup_path_, config_content));
+  // 4. both files are now up to date, journal entries written before can be dropped. Until then, they are based on the
+  //    previous config and are not replayed on top of the new one
+  if (use_config_journal_) {
+    // Appending to a journal based on the previous config would lose the records, rewrite the config again instead
+    pimpl_->needs_compaction_ = !pimpl_->journal_.Truncate(journal_mark, config_content);
+    if (pimpl_->needs_compaction_) {
+      LOG_WARN("unable to truncate config journal at %s", config_journal_path_.c_str());
+    }
+  } else {
+    pimpl_->journal_.Delete();
+    pimpl_->needs_compaction_ = false;
+  }
+  // 5. save checksum if it is running in common criteria mode
   if (bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
       bluetooth::os::ParameterProvider::IsCommonCriteriaMode()) {
     bluetooth::os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
@@ -159,6 +211,7 @@ void StorageModule::Start() {
     LOG_INFO("%s is true, delete config files", kFactoryResetProperty.c_str());
     LegacyConfigFile::FromPath(config_file_path_).Delete();
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
+    ConfigJournal::FromPath(config_journal_path_).Delete();
     os::SetSystemProperty(kFactoryResetProperty, "false");
   }
   if (!is_config_checksum_pass(kConfigFileComparePass)) {
@@ -168,16 +221,29 @@ void StorageModule::Start() {
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
   }
   auto config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
+  const std::string* loaded_path = &config_file_path_;
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load config at %s, using backup at %s.", config_file_path_.c_str(), config_backup_path_.c_str());
     config = LegacyConfigFile::FromPath(config_backup_path_).Read(temp_devices_capacity_);
+    loaded_path = &config_backup_path_;
     file_source = "Backup";
   }
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load backup config at %s; creating new empty ones", config_backup_path_.c_str());
     config.emplace(temp_devices_capacity_, Device::kLinkKeyProperties);
+    loaded_path = nullptr;
     file_source = "Empty";
   }
+  // Changes made after the config file was last written are in the journal, whether or not journal is still in use
+  std::optional<std::string> config_content;
+  if (loaded_path != nullptr) {
+    config_content = os::ReadSmallFile(*loaded_path);
+  }
+  auto num_journal_records =
+      ConfigJournal::FromPath(config_journal_path_).Replay(&config.value(), config_content.value_or(""));
+  if (num_journal_records) {
+    LOG_INFO("replayed %zu records from config journal at %s", *num_journal_records, config_journal_path_.c_str());
+  }
   if (!file_source.empty()) {
     config->SetProperty(kInfoSection, kFileSourceProperty, std::move(file_source));
   }
@@ -197,7 +263,17 @@ void StorageModule::Start() {
   config->FixDeviceTypeInconsistencies();
   config->SetPersistentConfigChangedCallback([this] { this->CallOn(this, &StorageModule::SaveDelayed); });
   // TODO (b/158035889) Migrate metrics module to GD
-  pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_);
+  pimpl_ = std::make_unique<impl>(
+      GetHandler(), std::move(config.value()), temp_devices_capacity_, config_journal_path_);
+  // Config file checksum in common criteria mode does not cover the journal, hence always rewrite the config file
+  if (use_config_journal_ && bluetooth::os::ParameterProvider::IsCommonCriteriaMode()) {
+    LOG_INFO("config journal disabled in common criteria mode");
+    use_config_journal_ = false;
+  }
+  if (use_config_journal_) {
+    pimpl_->cache_.SetPersistentMutationCallback(
+        [journal = &pimpl_->journal_](const MutationEntry& entry) { journal->Append(entry); });
+  }
   SaveDelayed();
   if (bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr) {
     bluetooth::os::ParameterProvider::GetBtKeystoreInterface()->ConvertEncryptOrDecryptKeyIfNeeded();
@@ -123,7 +123,7 @@ class StorageModule : public bluetooth::Module {
   // This method triggers the delayed saving automatically, the delay is equal to |config_save_delay_|
   void SaveDelayed();
   // In some cases, one may want to save the config immediately to disk. Call this method with caution as it runs
-  // immediately on the calling thread
+  // immediately on the calling thread. This always rewrites the whole config file and compacts the config journal
   void SaveImmediately();
 
   // Create the storage module where:
@@ -131,12 +131,15 @@ class StorageModule : public bluetooth::Module {
   // - config_save_delay is the duration after which to dump config to disk after SaveDelayed() is called
   // - temp_devices_capacity is the number of temporary, typically unpaired devices to hold in a memory based LRU
   // - is_restricted_mode and is_single_user_mode are flags from upper layer
+  // - use_config_journal makes delayed saves append changed entries to a journal next to the config file instead of
+  //   rewriting the whole config file, which is then only rewritten when the journal grows too big or on shutdown
   StorageModule(
       std::string config_file_path,
       std::chrono::milliseconds config_save_delay,
       size_t temp_devices_capacity,
       bool is_restricted_mode,
-      bool is_single_user_mode);
+      bool is_single_user_mode,
+      bool use_config_journal = false);
 
  private:
   struct impl;
@@ -144,10 +147,14 @@ class StorageModule : public bluetooth::Module {
   std::unique_ptr<impl> pimpl_;
   std::string config_file_path_;
   std::string config_backup_path_;
+  std::string config_journal_path_;
   std::chrono::milliseconds config_save_delay_;
   size_t temp_devices_capacity_;
   bool is_restricted_mode_;
   bool is_single_user_mode_;
+  bool use_config_journal_;
+  // Called when the delayed save alarm fires, append to journal or compact as needed
+  void SaveIncrementally();
   static bool is_config_checksum_pass(int check_bit);
 };
 
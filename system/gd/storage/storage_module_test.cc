@@ -30,6 +30,7 @@
 #include "module.h"
 #include "os/files.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/device.h"
 #include "storage/legacy_config_file.h"
 
@@ -38,6 +39,7 @@ namespace testing {
 using bluetooth::TestModuleRegistry;
 using bluetooth::hci::Address;
 using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
 using bluetooth::storage::Device;
 using bluetooth::storage::LegacyConfigFile;
 using bluetooth::storage::StorageModule;
@@ -81,13 +83,15 @@ class TestStorageModule : public StorageModule {
       std::chrono::milliseconds config_save_delay,
       size_t temp_devices_capacity,
       bool is_restricted_mode,
-      bool is_single_user_mode)
+      bool is_single_user_mode,
+      bool use_config_journal = false)
       : StorageModule(
             std::move(config_file_path),
             config_save_delay,
             temp_devices_capacity,
             is_restricted_mode,
-            is_single_user_mode) {}
+            is_single_user_mode,
+            use_config_journal) {}
 
   ConfigCache* GetConfigCachePublic() {
     return StorageModule::GetConfigCache();
@@ -108,6 +112,7 @@ class StorageModuleTest : public Test {
     temp_dir_ = std::filesystem::temp_directory_path();
     temp_config_ = temp_dir_ / "temp_config.txt";
     temp_backup_config_ = temp_dir_ / "temp_config.bak";
+    temp_journal_ = temp_dir_ / "temp_config.journal";
     DeleteConfigFiles();
     ASSERT_FALSE(std::filesystem::exists(temp_config_));
     ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
@@ -124,11 +129,15 @@ class StorageModuleTest : public Test {
     if (std::filesystem::exists(temp_backup_config_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_backup_config_));
     }
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
   }
 
   std::filesystem::path temp_dir_;
   std::filesystem::path temp_config_;
   std::filesystem::path temp_backup_config_;
+  std::filesystem::path temp_journal_;
 };
 
 TEST_F(StorageModuleTest, empty_config_no_op_test) {
@@ -283,6 +292,107 @@ TEST_F(StorageModuleTest, save_config_test) {
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
 }
 
+TEST_F(StorageModuleTest, config_journal_test) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false, true);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  // Changes made while loading are saved by rewriting the config file
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  auto config_content = bluetooth::os::ReadSmallFile(temp_config_.string());
+  ASSERT_TRUE(config_content);
+
+  // Later changes only go to the journal
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  ASSERT_THAT(bluetooth::os::ReadSmallFile(temp_config_.string()), Optional(StrEq(*config_content)));
+  ASSERT_THAT(
+      bluetooth::os::ReadSmallFile(temp_journal_.string()),
+      Optional(StrEq(ConfigJournal::SerializeBase(*config_content) + "S 17:01:02:03:ab:cd:ea 4:name 3:foo\n")));
+
+  // Config file plus journal gives the latest config
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(
+      ConfigJournal::FromPath(temp_journal_.string()).Replay(&config.value(), *config_content), Optional(Eq(1u)));
+  ASSERT_EQ(config->SerializeToLegacyFormat(), storage->GetConfigCachePublic()->SerializeToLegacyFormat());
+
+  // Tear down, config file is rewritten and journal is emptied
+  test_registry.StopAll();
+  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  config_content = bluetooth::os::ReadSmallFile(temp_config_.string());
+  ASSERT_TRUE(config_content);
+  ASSERT_THAT(
+      bluetooth::os::ReadSmallFile(temp_journal_.string()),
+      Optional(StrEq(ConfigJournal::SerializeBase(*config_content))));
+}
+
+TEST_F(StorageModuleTest, config_journal_crash_before_truncate_test) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up, a device is bonded and its bond is journaled
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false, true);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  auto old_config_content = bluetooth::os::ReadSmallFile(temp_config_.string());
+  ASSERT_TRUE(old_config_content);
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:eb", "LinkKey", "123456");
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  auto journal_content = bluetooth::os::ReadSmallFile(temp_journal_.string());
+  ASSERT_TRUE(journal_content);
+  ASSERT_THAT(*journal_content, HasSubstr("LinkKey"));
+
+  // The bond is removed, then the config and its backup are rewritten but the device crashes before the journal is
+  // truncated
+  storage->GetConfigCachePublic()->RemoveSection("01:02:03:ab:cd:eb");
+  test_registry.StopAll();
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_journal_.string(), *journal_content));
+
+  // The journal is older than the config and must not bring the bond back
+  storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false, true);
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_FALSE(storage->GetConfigCachePublic()->HasSection("01:02:03:ab:cd:eb"));
+  test_registry.StopAll();
+
+  // A crash while the config is rewritten leaves only the backup, which the journal was written on top of
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_backup_config_.string(), *old_config_content));
+  ASSERT_TRUE(std::filesystem::remove(temp_config_));
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_journal_.string(), *journal_content));
+  storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false, true);
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_THAT(
+      storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:eb", "LinkKey"), Optional(StrEq("123456")));
+  test_registry.StopAll();
+}
+
+TEST_F(StorageModuleTest, replay_config_journal_on_start_test) {
+  // Prepare config file and a journal left by a previous run
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  ASSERT_TRUE(bluetooth::os::WriteToFile(
+      temp_journal_.string(),
+      ConfigJournal::SerializeBase(kReadTestConfig) + "S 17:01:02:03:ab:cd:ea 4:name 3:foo\n"));
+
+  // Set up without journal, journal must still be replayed and then removed
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+
+  // Tear down
+  test_registry.StopAll();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+}
+
 TEST_F(StorageModuleTest, get_bonded_devices_test) {
   // Prepare config file
   ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
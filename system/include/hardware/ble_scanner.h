@@ -89,7 +89,7 @@ class ScanningCallbacks {
                             uint8_t secondary_phy, uint8_t advertising_sid,
                             int8_t tx_power, int8_t rssi,
                             uint16_t periodic_adv_int,
-                            std::vector<uint8_t> adv_data) = 0;
+                            const std::vector<uint8_t>& adv_data) = 0;
   virtual void OnTrackAdvFoundLost(
       AdvertisingTrackInfo advertising_track_info) = 0;
   virtual void OnBatchScanReports(int client_if, int status, int report_format,
@@ -26,6 +26,7 @@
 #include <future>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
@@ -808,6 +809,7 @@ struct shim::legacy::Acl::impl {
 
   ShadowAcceptlist shadow_acceptlist_;
   ShadowAddressResolutionList shadow_address_resolution_list_;
+  std::optional<hci::LeAddressManager::ListUpdate> address_resolution_batch_;
 
   bool IsClassicAcl(HciHandle handle) {
     return handle_to_classic_connection_map_.find(handle) !=
@@ -987,6 +989,12 @@ struct shim::legacy::Acl::impl {
     LOG_DEBUG("Cleared entire Le address acceptlist count:%zu", count);
   }
 
+  void begin_acceptlist_batch() {
+    GetAclManager()->BeginFilterAcceptListBatch();
+  }
+
+  void end_acceptlist_batch() { GetAclManager()->EndFilterAcceptListBatch(); }
+
   void AddToAddressResolution(const hci::AddressWithType& address_with_type,
                               const std::array<uint8_t, 16>& peer_irk,
                               const std::array<uint8_t, 16>& local_irk) {
@@ -997,6 +1005,12 @@ struct shim::legacy::Acl::impl {
     }
     // TODO This should really be added upon successful completion
     shadow_address_resolution_list_.Add(address_with_type);
+    if (address_resolution_batch_.has_value()) {
+      address_resolution_batch_->AddDeviceToResolvingList(
+          address_with_type.ToPeerAddressType(), address_with_type.GetAddress(),
+          peer_irk, local_irk);
+      return;
+    }
     GetAclManager()->AddDeviceToResolvingList(address_with_type, peer_irk,
                                               local_irk);
   }
@@ -1008,15 +1022,45 @@ struct shim::legacy::Acl::impl {
       LOG_WARN("Unable to remove from Le Address Resolution list device:%s",
                PRIVATE_ADDRESS(address_with_type));
     }
+    if (address_resolution_batch_.has_value()) {
+      address_resolution_batch_->RemoveDeviceFromResolvingList(
+          address_with_type.ToPeerAddressType(),
+          address_with_type.GetAddress());
+      return;
+    }
     GetAclManager()->RemoveDeviceFromResolvingList(address_with_type);
   }
 
   void ClearResolvingList() {
-    GetAclManager()->ClearResolvingList();
+    if (address_resolution_batch_.has_value()) {
+      address_resolution_batch_->ClearResolvingList();
+    } else {
+      GetAclManager()->ClearResolvingList();
+    }
     // TODO This should really be cleared after successful clear status
     shadow_address_resolution_list_.Clear();
   }
 
+  // Changes to the Le address resolution list until the end of the batch are
+  // sent to the controller together, with the clients of the controller lists
+  // paused once
+  void BeginAddressResolutionBatch() {
+    if (address_resolution_batch_.has_value()) {
+      LOG_WARN("Le Address Resolution list batch already in progress");
+      return;
+    }
+    address_resolution_batch_.emplace();
+  }
+
+  void EndAddressResolutionBatch() {
+    if (!address_resolution_batch_.has_value()) {
+      LOG_WARN("No Le Address Resolution list batch in progress");
+      return;
+    }
+    GetAclManager()->CommitListUpdate(std::move(*address_resolution_batch_));
+    address_resolution_batch_.reset();
+  }
+
   void DumpConnectionHistory() const {
     std::vector<std::string> history =
         connection_history_.ReadElementsAsString();
@@ -1679,6 +1723,14 @@ void shim::legacy::Acl::ClearAcceptList() {
   handler_->CallOn(pimpl_.get(), &Acl::impl::clear_acceptlist);
 }
 
+void shim::legacy::Acl::BeginAcceptListBatch() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::begin_acceptlist_batch);
+}
+
+void shim::legacy::Acl::EndAcceptListBatch() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::end_acceptlist_batch);
+}
+
 void shim::legacy::Acl::AddToAddressResolution(
     const hci::AddressWithType& address_with_type,
     const std::array<uint8_t, 16>& peer_irk,
@@ -1696,3 +1748,11 @@ void shim::legacy::Acl::RemoveFromAddressResolution(
 void shim::legacy::Acl::ClearAddressResolution() {
   handler_->CallOn(pimpl_.get(), &Acl::impl::ClearResolvingList);
 }
+
+void shim::legacy::Acl::BeginAddressResolutionBatch() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::BeginAddressResolutionBatch);
+}
+
+void shim::legacy::Acl::EndAddressResolutionBatch() {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::EndAddressResolutionBatch);
+}
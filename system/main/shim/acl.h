@@ -88,6 +88,8 @@ class Acl : public hci::acl_manager::ConnectionCallbacks,
   void RemoveFromAddressResolution(
       const hci::AddressWithType& address_with_type);
   void ClearAddressResolution();
+  void BeginAddressResolutionBatch();
+  void EndAddressResolutionBatch();
 
   // LinkPolicyInterface
   bool HoldMode(uint16_t hci_handle, uint16_t max_interval,
@@ -110,6 +112,8 @@ class Acl : public hci::acl_manager::ConnectionCallbacks,
   void FinalShutdown();
 
   void ClearAcceptList();
+  void BeginAcceptListBatch();
+  void EndAcceptListBatch();
 
  protected:
   void on_incoming_acl_credits(uint16_t handle, uint16_t credits);
@@ -128,6 +128,22 @@ void bluetooth::shim::ACL_ClearAddressResolution() {
   Stack::GetInstance()->GetAcl()->ClearAddressResolution();
 }
 
+void bluetooth::shim::ACL_BeginAddressResolutionBatch() {
+  Stack::GetInstance()->GetAcl()->BeginAddressResolutionBatch();
+}
+
+void bluetooth::shim::ACL_EndAddressResolutionBatch() {
+  Stack::GetInstance()->GetAcl()->EndAddressResolutionBatch();
+}
+
 void bluetooth::shim::ACL_ClearAcceptList() {
   Stack::GetInstance()->GetAcl()->ClearAcceptList();
 }
+
+void bluetooth::shim::ACL_BeginAcceptListBatch() {
+  Stack::GetInstance()->GetAcl()->BeginAcceptListBatch();
+}
+
+void bluetooth::shim::ACL_EndAcceptListBatch() {
+  Stack::GetInstance()->GetAcl()->EndAcceptListBatch();
+}
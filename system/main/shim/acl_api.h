@@ -48,7 +48,15 @@ void ACL_AddToAddressResolution(const tBLE_BD_ADDR& legacy_address_with_type,
 void ACL_RemoveFromAddressResolution(
     const tBLE_BD_ADDR& legacy_address_with_type);
 void ACL_ClearAddressResolution();
+// Sends the address resolution list changes made between the two calls to the
+// controller together
+void ACL_BeginAddressResolutionBatch();
+void ACL_EndAddressResolutionBatch();
 void ACL_ClearAcceptList();
+// Sends the acceptlist changes made between the two calls to the controller
+// together. Batches may overlap, the changes being sent at the end of the last.
+void ACL_BeginAcceptListBatch();
+void ACL_EndAcceptListBatch();
 
 }  // namespace shim
 }  // namespace bluetooth
@@ -19,11 +19,16 @@
  */
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
+#include <vector>
 
 #include "hci/le_scanning_callback.h"
 #include "include/hardware/ble_scanner.h"
+#include "main/shim/le_scan_result_aggregator.h"
+#include "osi/include/alarm.h"
 #include "types/ble_address_with_type.h"
 #include "types/bluetooth/uuid.h"
 #include "types/raw_address.h"
@@ -36,7 +41,7 @@ extern ::ScanningCallbacks* default_scanning_callback;
 class BleScannerInterfaceImpl : public ::BleScannerInterface,
                                 public bluetooth::hci::ScanningCallback {
  public:
-  ~BleScannerInterfaceImpl() override{};
+  ~BleScannerInterfaceImpl() override;
 
   void Init();
 
@@ -85,7 +90,8 @@ class BleScannerInterfaceImpl : public ::BleScannerInterface,
                     uint8_t secondary_phy, uint8_t advertising_sid,
                     int8_t tx_power, int8_t rssi,
                     uint16_t periodic_advertising_interval,
-                    std::vector<uint8_t> advertising_data) override;
+                    bluetooth::hci::SharedAdvertisingData advertising_data)
+      override;
   void OnTrackAdvFoundLost(bluetooth::hci::AdvertisingFilterOnFoundOnLostInfo
                                on_found_on_lost_info) override;
   void OnBatchScanReports(int client_if, int status, int report_format,
@@ -116,8 +122,19 @@ class BleScannerInterfaceImpl : public ::BleScannerInterface,
       bluetooth::hci::AdvertisingPacketContentFilterCommand&
           advertising_packet_content_filter_command,
       ApcfCommand apcf_command);
-  void handle_remote_properties(RawAddress bd_addr, tBLE_ADDR_TYPE addr_type,
-                                std::vector<uint8_t> advertising_data);
+  void handle_remote_properties(
+      RawAddress bd_addr, tBLE_ADDR_TYPE addr_type,
+      bluetooth::hci::SharedAdvertisingData advertising_data);
+  static void flush_scan_results(void* data);
+  void deliver_scan_results(std::vector<LeScanResult> results);
+  void dump_scan_results(int fd);
+  void clear_scan_results();
+
+  // Coalesces the scan results delivered to the jni thread, when enabled
+  std::mutex scan_result_mutex_;
+  std::unique_ptr<LeScanResultAggregator> scan_result_aggregator_;
+  alarm_t* scan_result_alarm_ = nullptr;
+  uint64_t scan_result_window_ms_ = 0;
 
   class AddressCache {
    public:
@@ -119,7 +119,7 @@ void Btm::ScanningCallbacks::OnScanResult(
     uint16_t event_type, uint8_t address_type, bluetooth::hci::Address address,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_advertising_interval,
-    std::vector<uint8_t> advertising_data) {
+    bluetooth::hci::SharedAdvertisingData advertising_data) {
   tBLE_ADDR_TYPE ble_address_type = to_ble_addr_type(address_type);
   uint16_t extended_event_type = 0;
 
@@ -136,8 +136,8 @@ void Btm::ScanningCallbacks::OnScanResult(
   btm_ble_process_adv_pkt_cont(
       extended_event_type, ble_address_type, raw_address, primary_phy,
       secondary_phy, advertising_sid, tx_power, rssi,
-      periodic_advertising_interval, advertising_data.size(),
-      &advertising_data[0], original_bda);
+      periodic_advertising_interval, advertising_data->size(),
+      advertising_data->data(), original_bda);
 }
 
 void Btm::ScanningCallbacks::OnTrackAdvFoundLost(
@@ -218,7 +218,8 @@ class Btm {
                       uint8_t secondary_phy, uint8_t advertising_sid,
                       int8_t tx_power, int8_t rssi,
                       uint16_t periodic_advertising_interval,
-                      std::vector<uint8_t> advertising_data) override;
+                      bluetooth::hci::SharedAdvertisingData advertising_data)
+        override;
     void OnTrackAdvFoundLost(bluetooth::hci::AdvertisingFilterOnFoundOnLostInfo
                                  on_found_on_lost_info) override;
     void OnBatchScanReports(int client_if, int status, int report_format,
@@ -281,13 +281,8 @@ static bluetooth::os::EnqueueBuffer<bluetooth::hci::ScoBuilder>*
 
 static std::unique_ptr<bluetooth::packet::RawBuilder> MakeUniquePacket(
     const uint8_t* data, size_t len) {
-  bluetooth::packet::RawBuilder builder;
-  std::vector<uint8_t> bytes(data, data + len);
-
-  auto payload = std::make_unique<bluetooth::packet::RawBuilder>();
-  payload->AddOctets(bytes);
-
-  return payload;
+  return std::make_unique<bluetooth::packet::RawBuilder>(
+      std::vector<uint8_t>(data, data + len));
 }
 
 static BT_HDR* WrapPacketAndCopy(
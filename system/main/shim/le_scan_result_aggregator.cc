@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "main/shim/le_scan_result_aggregator.h"
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+namespace bluetooth {
+namespace shim {
+
+bool LeScanResultAggregator::Key::operator==(const Key& other) const {
+  return raw_address == other.raw_address &&
+         address_type == other.address_type &&
+         *advertising_data == *other.advertising_data;
+}
+
+size_t LeScanResultAggregator::KeyHash::operator()(const Key& key) const {
+  std::string_view address(
+      reinterpret_cast<const char*>(key.raw_address.address),
+      sizeof(key.raw_address.address));
+  std::string_view data(
+      reinterpret_cast<const char*>(key.advertising_data->data()),
+      key.advertising_data->size());
+  size_t hash = std::hash<std::string_view>{}(data);
+  hash ^= std::hash<std::string_view>{}(address) + 0x9e3779b9 + (hash << 6) +
+          (hash >> 2);
+  return hash ^ key.address_type;
+}
+
+LeScanResultAggregator::LeScanResultAggregator(size_t max_batch_size,
+                                               size_t max_pending)
+    : max_batch_size_(std::max<size_t>(max_batch_size, 1)),
+      max_pending_(std::max<size_t>(max_pending, 1)) {}
+
+LeScanResultAggregator::Key LeScanResultAggregator::KeyOf(
+    const LeScanResult& result) {
+  return Key{result.raw_address, result.address_type, result.advertising_data};
+}
+
+void LeScanResultAggregator::Erase(std::list<LeScanResult>::iterator it) {
+  index_.erase(KeyOf(*it));
+  pending_.erase(it);
+}
+
+bool LeScanResultAggregator::Add(LeScanResult result) {
+  stats_.reports++;
+  if (result.advertising_data == nullptr) {
+    result.advertising_data = std::make_shared<const std::vector<uint8_t>>();
+  }
+
+  auto it = index_.find(KeyOf(result));
+  if (it != index_.end()) {
+    LeScanResult& pending = *it->second;
+    pending.rssi = result.rssi;
+    pending.rssi_min = std::min(pending.rssi_min, result.rssi);
+    pending.rssi_max = std::max(pending.rssi_max, result.rssi);
+    pending.report_count++;
+    stats_.coalesced++;
+    return true;
+  }
+
+  if (pending_.size() >= max_pending_) {
+    Erase(pending_.begin());
+    stats_.dropped++;
+  }
+
+  result.rssi_min = result.rssi;
+  result.rssi_max = result.rssi;
+  result.report_count = 1;
+  pending_.push_back(std::move(result));
+  auto last = std::prev(pending_.end());
+  index_.emplace(KeyOf(*last), last);
+  stats_.max_pending = std::max(stats_.max_pending, pending_.size());
+  return false;
+}
+
+std::vector<LeScanResult> LeScanResultAggregator::TakeBatch() {
+  std::vector<LeScanResult> batch;
+  if (pending_.empty()) return batch;
+
+  batch.reserve(std::min(pending_.size(), max_batch_size_));
+  while (!pending_.empty() && batch.size() < max_batch_size_) {
+    auto it = pending_.begin();
+    index_.erase(KeyOf(*it));
+    stats_.max_report_count =
+        std::max(stats_.max_report_count, it->report_count);
+    stats_.max_rssi_spread = std::max<uint8_t>(
+        stats_.max_rssi_spread, it->rssi_max - it->rssi_min);
+    batch.push_back(std::move(*it));
+    pending_.erase(it);
+  }
+
+  stats_.delivered += batch.size();
+  stats_.batches++;
+  return batch;
+}
+
+void LeScanResultAggregator::Clear() {
+  index_.clear();
+  pending_.clear();
+}
+
+}  // namespace shim
+}  // namespace bluetooth
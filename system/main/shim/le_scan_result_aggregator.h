@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "hci/le_scanning_callback.h"
+#include "types/ble_address_with_type.h"
+#include "types/raw_address.h"
+
+namespace bluetooth {
+namespace shim {
+
+// A scan result on its way to the upper layers
+struct LeScanResult {
+  uint16_t event_type;
+  // Address type as reported by the controller
+  uint8_t address_type;
+  // Identity address of the advertiser when it could be resolved
+  RawAddress raw_address;
+  tBLE_ADDR_TYPE ble_addr_type;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  uint8_t advertising_sid;
+  int8_t tx_power;
+  int8_t rssi;
+  uint16_t periodic_advertising_interval;
+  bluetooth::hci::SharedAdvertisingData advertising_data;
+  // Set by the aggregator: RSSI range and number of the reports coalesced into
+  // this result, |rssi| being the one of the last report
+  int8_t rssi_min;
+  int8_t rssi_max;
+  uint32_t report_count;
+};
+
+// Coalesces the scan results reported by the controller before they are
+// delivered to the upper layers.
+//
+// The reports of an advertiser with the same advertising data are merged into
+// a single result until it is delivered, which carries the RSSI of the last
+// report along with the RSSI range and number of the merged reports. Results
+// are taken in batches of a bounded size, oldest first, so that a dense
+// environment costs a bounded number of deliveries instead of one per
+// advertising report.
+//
+// This class is not thread safe.
+class LeScanResultAggregator {
+ public:
+  struct Stats {
+    uint64_t reports;
+    uint64_t coalesced;
+    uint64_t delivered;
+    uint64_t dropped;
+    uint64_t batches;
+    size_t max_pending;
+    // Over the delivered results
+    uint32_t max_report_count;
+    uint8_t max_rssi_spread;
+  };
+
+  // At most |max_batch_size| results are taken per batch, and at most
+  // |max_pending| results wait for a batch, beyond which the oldest ones are
+  // dropped.
+  LeScanResultAggregator(size_t max_batch_size, size_t max_pending);
+  LeScanResultAggregator(const LeScanResultAggregator&) = delete;
+  LeScanResultAggregator& operator=(const LeScanResultAggregator&) = delete;
+
+  // Adds the scan result of an advertising report.
+  // Returns true if it was coalesced with a result waiting for delivery.
+  bool Add(LeScanResult result);
+
+  // Takes the next batch of results to deliver.
+  std::vector<LeScanResult> TakeBatch();
+
+  size_t PendingCount() const { return pending_.size(); }
+  // The results waiting for delivery, oldest first
+  const std::list<LeScanResult>& Pending() const { return pending_; }
+  const Stats& GetStats() const { return stats_; }
+
+  // Drops the results waiting for delivery.
+  void Clear();
+
+ private:
+  struct Key {
+    RawAddress raw_address;
+    uint8_t address_type;
+    // Shared with the pending result, compared by content
+    bluetooth::hci::SharedAdvertisingData advertising_data;
+
+    bool operator==(const Key& other) const;
+  };
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  static Key KeyOf(const LeScanResult& result);
+  void Erase(std::list<LeScanResult>::iterator it);
+
+  const size_t max_batch_size_;
+  const size_t max_pending_;
+  std::list<LeScanResult> pending_;
+  std::unordered_map<Key, std::list<LeScanResult>::iterator, KeyHash> index_;
+  Stats stats_{};
+};
+
+}  // namespace shim
+}  // namespace bluetooth
@@ -24,6 +24,7 @@
 #include <hardware/bluetooth.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "advertise_data_parser.h"
@@ -37,6 +38,7 @@
 #include "main/shim/helpers.h"
 #include "main/shim/le_scanning_manager.h"
 #include "main/shim/shim.h"
+#include "osi/include/properties.h"
 #include "stack/btm/btm_int_types.h"
 #include "stack/include/btm_log_history.h"
 #include "storage/device.h"
@@ -56,6 +58,16 @@ constexpr uint16_t kListLogicOr = 0x01;
 constexpr uint8_t kFilterLogicOr = 0x00;
 constexpr uint8_t kLowestRssiValue = 129;
 
+// Scan results are coalesced and delivered in batches every window, when the
+// window is not 0.
+constexpr char kScanResultWindowProperty[] =
+    "bluetooth.le.scan_result_coalescing_window_ms";
+constexpr char kScanResultBatchSizeProperty[] =
+    "bluetooth.le.scan_result_coalescing_batch_size";
+constexpr int32_t kDefaultScanResultBatchSize = 64;
+constexpr size_t kMaxPendingScanResults = 1024;
+constexpr size_t kMaxDumpedScanResults = 16;
+
 class DefaultScanningCallback : public ::ScanningCallbacks {
   void OnScannerRegistered(const bluetooth::Uuid app_uuid, uint8_t scanner_id,
                            uint8_t status) override {
@@ -69,7 +81,7 @@ class DefaultScanningCallback : public ::ScanningCallbacks {
                     uint8_t primary_phy, uint8_t secondary_phy,
                     uint8_t advertising_sid, int8_t tx_power, int8_t rssi,
                     uint16_t periodic_advertising_interval,
-                    std::vector<uint8_t> advertising_data) override {
+                    const std::vector<uint8_t>& advertising_data) override {
     LogUnused();
   }
   void OnTrackAdvFoundLost(
@@ -116,7 +128,7 @@ extern void btm_ble_process_adv_pkt_cont_for_inquiry(
     uint16_t event_type, tBLE_ADDR_TYPE address_type,
     const RawAddress& raw_address, uint8_t primary_phy, uint8_t secondary_phy,
     uint8_t advertising_sid, int8_t tx_power, int8_t rssi,
-    uint16_t periodic_adv_int, std::vector<uint8_t> advertising_data);
+    uint16_t periodic_adv_int, std::vector<uint8_t> const& advertising_data);
 
 extern void btif_dm_update_ble_remote_properties(const RawAddress& bd_addr,
                                                  BD_NAME bd_name,
@@ -130,6 +142,29 @@ using bluetooth::shim::BleScannerInterfaceImpl;
 void BleScannerInterfaceImpl::Init() {
   LOG_INFO("init BleScannerInterfaceImpl");
   bluetooth::shim::GetScanning()->RegisterScanningCallback(this);
+
+  int32_t window_ms = osi_property_get_int32(kScanResultWindowProperty, 0);
+  if (window_ms > 0 && scan_result_aggregator_ == nullptr) {
+    int32_t batch_size = osi_property_get_int32(kScanResultBatchSizeProperty,
+                                                kDefaultScanResultBatchSize);
+    LOG_INFO("Coalescing scan results every %d ms, up to %d per batch",
+             window_ms, batch_size);
+    scan_result_window_ms_ = window_ms;
+    scan_result_aggregator_ = std::make_unique<LeScanResultAggregator>(
+        std::max(batch_size, 1), kMaxPendingScanResults);
+    scan_result_alarm_ = alarm_new("shim.scan_result_alarm");
+    RegisterDumpsysFunction(static_cast<void*>(this),
+                            [this](int fd) { dump_scan_results(fd); });
+  }
+}
+
+BleScannerInterfaceImpl::~BleScannerInterfaceImpl() {
+  if (scan_result_alarm_ != nullptr) {
+    UnregisterDumpsysFunction(static_cast<void*>(this));
+    // Waits for a flush in progress, which uses this instance
+    alarm_free(scan_result_alarm_);
+    scan_result_alarm_ = nullptr;
+  }
 }
 
 /** Registers a scanner with the stack */
@@ -150,6 +185,7 @@ void BleScannerInterfaceImpl::Unregister(int scanner_id) {
 void BleScannerInterfaceImpl::Scan(bool start) {
   LOG(INFO) << __func__ << " in shim layer " <<  ((start) ? "started" : "stopped");
   bluetooth::shim::GetScanning()->Scan(start);
+  if (!start) clear_scan_results();
   BTM_LogHistory(
       kBtmLogTag, RawAddress::kEmpty,
       base::StringPrintf("Le scan %s", (start) ? "started" : "stopped"));
@@ -407,7 +443,7 @@ void BleScannerInterfaceImpl::OnScanResult(
     uint16_t event_type, uint8_t address_type, bluetooth::hci::Address address,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_advertising_interval,
-    std::vector<uint8_t> advertising_data) {
+    bluetooth::hci::SharedAdvertisingData advertising_data) {
   RawAddress raw_address = ToRawAddress(address);
   tBLE_ADDR_TYPE ble_addr_type = to_ble_addr_type(address_type);
 
@@ -415,27 +451,130 @@ void BleScannerInterfaceImpl::OnScanResult(
     btm_ble_process_adv_addr(raw_address, &ble_addr_type);
   }
 
+  // TODO: Remove when StartInquiry in GD part implemented
+  btm_ble_process_adv_pkt_cont_for_inquiry(
+      event_type, ble_addr_type, raw_address, primary_phy, secondary_phy,
+      advertising_sid, tx_power, rssi, periodic_advertising_interval,
+      *advertising_data);
+
+  if (scan_result_aggregator_ != nullptr) {
+    std::lock_guard<std::mutex> lock(scan_result_mutex_);
+    scan_result_aggregator_->Add({
+        .event_type = event_type,
+        .address_type = address_type,
+        .raw_address = raw_address,
+        .ble_addr_type = ble_addr_type,
+        .primary_phy = primary_phy,
+        .secondary_phy = secondary_phy,
+        .advertising_sid = advertising_sid,
+        .tx_power = tx_power,
+        .rssi = rssi,
+        .periodic_advertising_interval = periodic_advertising_interval,
+        .advertising_data = std::move(advertising_data),
+    });
+    if (!alarm_is_scheduled(scan_result_alarm_)) {
+      alarm_set(scan_result_alarm_, scan_result_window_ms_,
+                &BleScannerInterfaceImpl::flush_scan_results, this);
+    }
+    return;
+  }
+
   do_in_jni_thread(
       FROM_HERE,
       base::BindOnce(&BleScannerInterfaceImpl::handle_remote_properties,
                      base::Unretained(this), raw_address, ble_addr_type,
                      advertising_data));
 
+  // The advertising data is shared with the JNI thread, not copied
   do_in_jni_thread(
       FROM_HERE,
-      base::BindOnce(&ScanningCallbacks::OnScanResult,
-                     base::Unretained(scanning_callbacks_), event_type,
-                     static_cast<uint8_t>(address_type), raw_address,
-                     primary_phy, secondary_phy, advertising_sid, tx_power,
-                     rssi, periodic_advertising_interval, advertising_data));
+      base::BindOnce(
+          [](::ScanningCallbacks* callbacks, uint16_t event_type,
+             uint8_t address_type, RawAddress raw_address, uint8_t primary_phy,
+             uint8_t secondary_phy, uint8_t advertising_sid, int8_t tx_power,
+             int8_t rssi, uint16_t periodic_advertising_interval,
+             bluetooth::hci::SharedAdvertisingData advertising_data) {
+            callbacks->OnScanResult(event_type, address_type, raw_address,
+                                    primary_phy, secondary_phy,
+                                    advertising_sid, tx_power, rssi,
+                                    periodic_advertising_interval,
+                                    *advertising_data);
+          },
+          base::Unretained(scanning_callbacks_), event_type,
+          static_cast<uint8_t>(address_type), raw_address, primary_phy,
+          secondary_phy, advertising_sid, tx_power, rssi,
+          periodic_advertising_interval, advertising_data));
+}
+
+void BleScannerInterfaceImpl::flush_scan_results(void* data) {
+  auto* impl = static_cast<BleScannerInterfaceImpl*>(data);
+  std::vector<LeScanResult> results;
+  {
+    std::lock_guard<std::mutex> lock(impl->scan_result_mutex_);
+    results = impl->scan_result_aggregator_->TakeBatch();
+    // Deliver the rest in the next window
+    if (impl->scan_result_aggregator_->PendingCount() > 0) {
+      alarm_set(impl->scan_result_alarm_, impl->scan_result_window_ms_,
+                &BleScannerInterfaceImpl::flush_scan_results, impl);
+    }
+  }
+  if (results.empty()) return;
 
-  // TODO: Remove when StartInquiry in GD part implemented
-  btm_ble_process_adv_pkt_cont_for_inquiry(
-      event_type, ble_addr_type, raw_address, primary_phy, secondary_phy,
-      advertising_sid, tx_power, rssi, periodic_advertising_interval,
-      advertising_data);
+  do_in_jni_thread(
+      FROM_HERE, base::BindOnce(&BleScannerInterfaceImpl::deliver_scan_results,
+                                base::Unretained(impl), std::move(results)));
+}
+
+void BleScannerInterfaceImpl::deliver_scan_results(
+    std::vector<LeScanResult> results) {
+  for (const auto& result : results) {
+    handle_remote_properties(result.raw_address, result.ble_addr_type,
+                             result.advertising_data);
+    scanning_callbacks_->OnScanResult(
+        result.event_type, result.address_type, result.raw_address,
+        result.primary_phy, result.secondary_phy, result.advertising_sid,
+        result.tx_power, result.rssi, result.periodic_advertising_interval,
+        *result.advertising_data);
+  }
 }
 
+void BleScannerInterfaceImpl::clear_scan_results() {
+  if (scan_result_aggregator_ == nullptr) return;
+
+  // Not under the lock, which the alarm callback takes while it is waited for
+  alarm_cancel(scan_result_alarm_);
+  std::lock_guard<std::mutex> lock(scan_result_mutex_);
+  scan_result_aggregator_->Clear();
+}
+
+#define DUMPSYS_TAG "shim::scanner"
+void BleScannerInterfaceImpl::dump_scan_results(int fd) {
+  std::lock_guard<std::mutex> lock(scan_result_mutex_);
+  const auto& stats = scan_result_aggregator_->GetStats();
+  LOG_DUMPSYS_TITLE(fd, DUMPSYS_TAG);
+  LOG_DUMPSYS(fd, "Scan result window:%llu ms",
+              (unsigned long long)scan_result_window_ms_);
+  LOG_DUMPSYS(fd, "Advertising reports:%llu coalesced:%llu dropped:%llu",
+              (unsigned long long)stats.reports,
+              (unsigned long long)stats.coalesced,
+              (unsigned long long)stats.dropped);
+  LOG_DUMPSYS(fd, "Scan results delivered:%llu in batches:%llu",
+              (unsigned long long)stats.delivered,
+              (unsigned long long)stats.batches);
+  LOG_DUMPSYS(fd, "Scan results pending:%zu max:%zu",
+              scan_result_aggregator_->PendingCount(), stats.max_pending);
+  LOG_DUMPSYS(fd, "Reports per scan result max:%u rssi spread max:%u dB",
+              stats.max_report_count, stats.max_rssi_spread);
+  size_t dumped = 0;
+  for (const auto& result : scan_result_aggregator_->Pending()) {
+    if (dumped++ == kMaxDumpedScanResults) break;
+    LOG_DUMPSYS(fd, "  %s reports:%u rssi last:%d min:%d max:%d",
+                PRIVATE_ADDRESS(result.raw_address), result.report_count,
+                result.rssi, result.rssi_min, result.rssi_max);
+  }
+}
+#undef DUMPSYS_TAG
+
 void BleScannerInterfaceImpl::OnTrackAdvFoundLost(
     bluetooth::hci::AdvertisingFilterOnFoundOnLostInfo on_found_on_lost_info) {
   AdvertisingTrackInfo track_info = {};
@@ -620,7 +759,7 @@ bool BleScannerInterfaceImpl::parse_filter_command(
 
 void BleScannerInterfaceImpl::handle_remote_properties(
     RawAddress bd_addr, tBLE_ADDR_TYPE addr_type,
-    std::vector<uint8_t> advertising_data) {
+    bluetooth::hci::SharedAdvertisingData advertising_data) {
   if (!bluetooth::shim::is_gd_stack_started_up()) {
     LOG_WARN("Gd stack is stopped, return");
     return;
@@ -634,7 +773,7 @@ void BleScannerInterfaceImpl::handle_remote_properties(
   auto device_type = bluetooth::hci::DeviceType::LE;
   uint8_t flag_len;
   const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
-      advertising_data, BTM_BLE_AD_TYPE_FLAG, &flag_len);
+      *advertising_data, BTM_BLE_AD_TYPE_FLAG, &flag_len);
   if (p_flag != NULL && flag_len != 0) {
     if ((BTM_BLE_BREDR_NOT_SPT & *p_flag) == 0) {
       device_type = bluetooth::hci::DeviceType::DUAL;
@@ -643,11 +782,11 @@ void BleScannerInterfaceImpl::handle_remote_properties(
 
   uint8_t remote_name_len;
   const uint8_t* p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-      advertising_data, HCI_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
+      *advertising_data, HCI_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
 
   if (p_eir_remote_name == NULL) {
     p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-        advertising_data, HCI_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
+        *advertising_data, HCI_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
   }
 
   // update device name
@@ -742,3 +881,10 @@ void bluetooth::shim::set_empty_filter(bool enable) {
         bluetooth::hci::ApcfAction::ADD, 0x00, advertising_filter_parameter);
   }
 }
+
+uint8_t bluetooth::shim::get_number_of_software_scan_filters() {
+  if (!bluetooth::shim::is_gd_stack_started_up()) {
+    return 0;
+  }
+  return bluetooth::shim::GetScanning()->GetNumberOfSoftwareFilters();
+}
@@ -27,6 +27,9 @@ namespace shim {
 ::BleScannerInterface* get_ble_scanner_instance();
 void init_scanning_manager();
 void set_empty_filter(bool enable);
+// Number of scan filters applied in the host when the controller does not
+// support them, 0 otherwise
+uint8_t get_number_of_software_scan_filters();
 
 }  // namespace shim
 }  // namespace bluetooth
@@ -51,6 +51,7 @@
 
 #include "main/shim/acl_legacy_interface.h"
 #include "main/shim/activity_attribution.h"
+#include "main/shim/dumpsys.h"
 #include "main/shim/hci_layer.h"
 #include "main/shim/helpers.h"
 #include "main/shim/l2c_api.h"
@@ -69,6 +70,10 @@ namespace {
 // PID file format
 constexpr char pid_file_format[] = "/var/run/bluetooth/bluetooth%d.pid";
 
+// Threads, the starting one included, used to start the Gd modules that can
+// start concurrently
+constexpr size_t kNumModuleStartWorkers = 4;
+
 void CreatePidFile() {
   std::string pid_file =
       StringFormat(pid_file_format, InitFlags::GetAdapterIndex());
@@ -215,7 +220,13 @@ void Stack::Start(ModuleList* modules) {
 
   stack_thread_ =
       new os::Thread("gd_stack_thread", os::Thread::Priority::REAL_TIME);
-  stack_manager_.StartUp(modules, stack_thread_);
+  stack_manager_.StartUp(modules, stack_thread_,
+                         common::init_flags::gd_parallel_start_is_enabled()
+                             ? kNumModuleStartWorkers
+                             : 1);
+  RegisterDumpsysFunction(static_cast<void*>(this), [this](int fd) {
+    stack_manager_.DumpStartTrace(fd);
+  });
 
   stack_handler_ = new os::Handler(stack_thread_);
 
@@ -253,6 +264,7 @@ void Stack::Stop() {
 
   stack_handler_->Clear();
 
+  UnregisterDumpsysFunction(static_cast<void*>(this));
   stack_manager_.ShutDown();
 
   delete stack_handler_;
@@ -0,0 +1,134 @@
+/*
+ *  Copyright 2022 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "main/shim/le_scan_result_aggregator.h"
+
+using bluetooth::shim::LeScanResult;
+using bluetooth::shim::LeScanResultAggregator;
+
+namespace {
+
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+
+LeScanResult MakeResult(const RawAddress& address, std::vector<uint8_t> data,
+                        int8_t rssi) {
+  LeScanResult result{};
+  result.address_type = BLE_ADDR_PUBLIC;
+  result.raw_address = address;
+  result.ble_addr_type = BLE_ADDR_PUBLIC;
+  result.rssi = rssi;
+  result.advertising_data =
+      std::make_shared<const std::vector<uint8_t>>(std::move(data));
+  return result;
+}
+
+}  // namespace
+
+TEST(LeScanResultAggregatorTest, coalesce_same_advertising_data) {
+  LeScanResultAggregator aggregator(16, 16);
+
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -60)));
+  ASSERT_TRUE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -40)));
+  ASSERT_TRUE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -50)));
+  ASSERT_EQ(1UL, aggregator.PendingCount());
+
+  auto batch = aggregator.TakeBatch();
+  ASSERT_EQ(1UL, batch.size());
+  ASSERT_EQ(kAddress1, batch[0].raw_address);
+  ASSERT_EQ(-50, batch[0].rssi);
+  ASSERT_EQ(-60, batch[0].rssi_min);
+  ASSERT_EQ(-40, batch[0].rssi_max);
+  ASSERT_EQ(3U, batch[0].report_count);
+  ASSERT_EQ(3U, aggregator.GetStats().reports);
+  ASSERT_EQ(2U, aggregator.GetStats().coalesced);
+  ASSERT_EQ(3U, aggregator.GetStats().max_report_count);
+  ASSERT_EQ(20U, aggregator.GetStats().max_rssi_spread);
+  ASSERT_EQ(0UL, aggregator.PendingCount());
+
+  // Once delivered, the same result is reported again
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -60)));
+}
+
+TEST(LeScanResultAggregatorTest, keep_different_advertisers_and_data) {
+  LeScanResultAggregator aggregator(16, 16);
+
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -60)));
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress2, {0x02, 0x01, 0x06}, -60)));
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x1a}, -60)));
+
+  auto batch = aggregator.TakeBatch();
+  ASSERT_EQ(3UL, batch.size());
+  ASSERT_EQ(kAddress1, batch[0].raw_address);
+  ASSERT_EQ(kAddress2, batch[1].raw_address);
+  ASSERT_EQ(std::vector<uint8_t>({0x02, 0x01, 0x1a}),
+            *batch[2].advertising_data);
+}
+
+TEST(LeScanResultAggregatorTest, bounded_batches) {
+  LeScanResultAggregator aggregator(2, 16);
+
+  for (uint8_t i = 0; i < 5; i++) {
+    aggregator.Add(MakeResult(kAddress1, {0x02, 0xff, i}, -60));
+  }
+
+  ASSERT_EQ(2UL, aggregator.TakeBatch().size());
+  ASSERT_EQ(2UL, aggregator.TakeBatch().size());
+  auto batch = aggregator.TakeBatch();
+  ASSERT_EQ(1UL, batch.size());
+  ASSERT_EQ(4, (*batch[0].advertising_data)[2]);
+  ASSERT_TRUE(aggregator.TakeBatch().empty());
+
+  ASSERT_EQ(5U, aggregator.GetStats().delivered);
+  ASSERT_EQ(3U, aggregator.GetStats().batches);
+}
+
+TEST(LeScanResultAggregatorTest, drop_oldest_when_full) {
+  LeScanResultAggregator aggregator(16, 2);
+
+  aggregator.Add(MakeResult(kAddress1, {0x02, 0xff, 0x00}, -60));
+  aggregator.Add(MakeResult(kAddress1, {0x02, 0xff, 0x01}, -60));
+  aggregator.Add(MakeResult(kAddress1, {0x02, 0xff, 0x02}, -60));
+  ASSERT_EQ(2UL, aggregator.PendingCount());
+  ASSERT_EQ(1U, aggregator.GetStats().dropped);
+
+  // The dropped result is no longer coalesced with
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0xff, 0x00}, -60)));
+
+  auto batch = aggregator.TakeBatch();
+  ASSERT_EQ(2UL, batch.size());
+  ASSERT_EQ(0x02, (*batch[0].advertising_data)[2]);
+  ASSERT_EQ(0x00, (*batch[1].advertising_data)[2]);
+}
+
+TEST(LeScanResultAggregatorTest, clear_pending_results) {
+  LeScanResultAggregator aggregator(16, 16);
+
+  aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -60));
+  aggregator.Add(MakeResult(kAddress2, {0x02, 0x01, 0x06}, -60));
+  aggregator.Clear();
+  ASSERT_EQ(0UL, aggregator.PendingCount());
+  ASSERT_TRUE(aggregator.TakeBatch().empty());
+
+  // The cleared results are no longer coalesced with
+  ASSERT_FALSE(aggregator.Add(MakeResult(kAddress1, {0x02, 0x01, 0x06}, -60)));
+  ASSERT_EQ(1UL, aggregator.TakeBatch().size());
+}
@@ -577,7 +577,7 @@ class TestScanningCallbacks : public ::ScanningCallbacks {
                     uint8_t primary_phy, uint8_t secondary_phy,
                     uint8_t advertising_sid, int8_t tx_power, int8_t rssi,
                     uint16_t periodic_adv_int,
-                    std::vector<uint8_t> adv_data) override {}
+                    const std::vector<uint8_t>& adv_data) override {}
   void OnTrackAdvFoundLost(
       AdvertisingTrackInfo advertising_track_info) override {}
   void OnBatchScanReports(int client_if, int status, int report_format,
@@ -620,7 +620,7 @@ TEST_F(MainShimTest, DISABLED_BleScannerInterfaceImpl_OnScanResult) {
     int8_t tx_power = 0;
     int8_t rssi = 0;
     uint16_t periodic_advertising_interval = 0;
-    std::vector<uint8_t> advertising_data;
+    auto advertising_data = std::make_shared<const std::vector<uint8_t>>();
 
     ble->OnScanResult(event_type, address_type, address, primary_phy,
                       secondary_phy, advertising_sid, tx_power, rssi,
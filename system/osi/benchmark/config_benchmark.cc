@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+#include <filesystem>
+#include <string>
+
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+namespace {
+
+const std::filesystem::path kConfigFile =
+    std::filesystem::temp_directory_path() / "config_benchmark.conf";
+
+std::string device_section(int64_t index) {
+  char address[18];
+  snprintf(address, sizeof(address), "11:22:33:44:%02x:%02x",
+           static_cast<unsigned>((index >> 8) & 0xff),
+           static_cast<unsigned>(index & 0xff));
+  return address;
+}
+
+// Writes a config file similar to bt_config.conf with |num_devices| bonded
+// devices
+void write_config_file(int64_t num_devices) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config_set_string(config.get(), "Adapter", "Address", "01:02:03:ab:cd:ef");
+  for (int64_t i = 0; i < num_devices; i++) {
+    std::string section = device_section(i);
+    config_set_string(config.get(), section, "Name",
+                      "Device " + std::to_string(i));
+    config_set_string(config.get(), section, "DevClass", "2360344");
+    config_set_string(config.get(), section, "DevType", "3");
+    config_set_string(config.get(), section, "AddrType", "0");
+    config_set_string(config.get(), section, "Manufacturer", "15");
+    config_set_string(config.get(), section, "LmpVer", "10");
+    config_set_string(config.get(), section, "LinkKeyType", "8");
+    config_set_string(config.get(), section, "LinkKey",
+                      "fedcba0987654321fedcba0987654321");
+  }
+  config_save(*config, kConfigFile.string());
+}
+
+}  // namespace
+
+static void BM_config_new(State& state) {
+  write_config_file(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(config_new(kConfigFile.c_str()));
+  }
+  std::filesystem::remove(kConfigFile);
+}
+BENCHMARK(BM_config_new)->Arg(100)->Arg(500)->UseRealTime();
+
+static void BM_config_get_string(State& state) {
+  write_config_file(state.range(0));
+  std::unique_ptr<config_t> config = config_new(kConfigFile.c_str());
+  int64_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(config_get_string(
+        *config, device_section(index++ % state.range(0)), "LinkKey", nullptr));
+  }
+  std::filesystem::remove(kConfigFile);
+}
+BENCHMARK(BM_config_get_string)->Arg(100)->Arg(500);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
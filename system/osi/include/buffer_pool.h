@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A pool of preallocated buffers of the same size.
+//
+// Buffers taken from a pool are released with |osi_free|, like any other
+// buffer, so they can be handed to code which does not know about the pool.
+// All the functions below are thread safe.
+typedef struct buffer_pool_t buffer_pool_t;
+
+typedef struct {
+  size_t buffer_size;
+  size_t buffer_count;
+  size_t buffers_in_use;
+  size_t max_buffers_in_use;
+  // Number of buffers handed out, and of requests which found no free buffer
+  size_t total_taken;
+  size_t total_exhausted;
+  // Time between taking a buffer and releasing it, over all released buffers
+  size_t total_released;
+  uint64_t total_lifetime_us;
+  uint64_t max_lifetime_us;
+} buffer_pool_stats_t;
+
+// Creates a pool of |buffer_count| buffers of at least |buffer_size| bytes.
+// Returns NULL if |buffer_size| or |buffer_count| is zero. The pool must be
+// freed using |buffer_pool_free|.
+buffer_pool_t* buffer_pool_new(size_t buffer_size, size_t buffer_count);
+
+// Frees |pool|. Buffers still in use stay valid: the memory of the pool is
+// released when the last of them is released. Safe to call with NULL.
+void buffer_pool_free(buffer_pool_t* pool);
+
+// Takes a buffer of |pool|. Returns NULL if all the buffers are in use.
+void* buffer_pool_get(buffer_pool_t* pool);
+
+// Returns |ptr| to its pool if it was taken from one. Returns false if |ptr|
+// does not belong to any pool, without taking any lock unless |ptr| is within
+// the address range spanned by the pools. Called by |osi_free|.
+bool buffer_pool_release(void* ptr);
+
+// Fills |stats| with the statistics of |pool|.
+void buffer_pool_get_stats(const buffer_pool_t* pool,
+                           buffer_pool_stats_t* stats);
@@ -17,14 +17,97 @@
 // - All strings are case sensitive.
 
 #include <stdbool.h>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 // The default section name to use if a key/value pair is not defined within
 // a section.
 #define CONFIG_DEFAULT_SECTION "Global"
 
+// A list that keeps its elements in insertion order, which is the order they
+// are written to disk, while indexing them by |Name| for constant time lookup.
+// Only the list operations needed by config users are provided. Names must be
+// unique and must not be modified while an element is in the list, except for
+// moving an element out right before erasing it.
+template <typename T, std::string T::*Name>
+class indexed_list {
+ public:
+  using value_type = T;
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  indexed_list() = default;
+  indexed_list(const indexed_list& other) : list_(other.list_) { reindex(); }
+  indexed_list& operator=(const indexed_list& other) {
+    if (&other != this) {
+      list_ = other.list_;
+      reindex();
+    }
+    return *this;
+  }
+  // std::list keeps its nodes when moved, hence iterators in index_ stay valid
+  indexed_list(indexed_list&& other) noexcept = default;
+  indexed_list& operator=(indexed_list&& other) noexcept = default;
+
+  iterator begin() { return list_.begin(); }
+  iterator end() { return list_.end(); }
+  const_iterator begin() const { return list_.begin(); }
+  const_iterator end() const { return list_.end(); }
+  size_t size() const { return list_.size(); }
+  bool empty() const { return list_.empty(); }
+
+  void clear() {
+    index_.clear();
+    list_.clear();
+  }
+
+  template <class... Args>
+  T& emplace_back(Args&&... args) {
+    list_.emplace_back(std::forward<Args>(args)...);
+    auto last = std::prev(list_.end());
+    index_.emplace((*last).*Name, last);
+    return *last;
+  }
+
+  iterator erase(const_iterator pos) {
+    auto index_iter = index_.find((*pos).*Name);
+    if (index_iter == index_.end() || index_iter->second != pos) {
+      // the element was moved out before being erased and lost its name
+      for (index_iter = index_.begin(); index_iter != index_.end();
+           ++index_iter) {
+        if (index_iter->second == pos) break;
+      }
+    }
+    if (index_iter != index_.end()) index_.erase(index_iter);
+    return list_.erase(pos);
+  }
+
+  iterator find(const std::string& name) {
+    auto index_iter = index_.find(name);
+    return index_iter == index_.end() ? list_.end() : index_iter->second;
+  }
+
+  const_iterator find(const std::string& name) const {
+    auto index_iter = index_.find(name);
+    return index_iter == index_.end() ? list_.end() : index_iter->second;
+  }
+
+ private:
+  void reindex() {
+    index_.clear();
+    for (auto it = list_.begin(); it != list_.end(); ++it) {
+      index_.emplace((*it).*Name, it);
+    }
+  }
+
+  std::list<T> list_;
+  std::unordered_map<std::string, iterator> index_;
+};
+
 struct entry_t {
   std::string key;
   std::string value;
@@ -32,14 +115,14 @@ struct entry_t {
 
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  indexed_list<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
   std::list<entry_t>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 };
 
 struct config_t {
-  std::list<section_t> sections;
+  indexed_list<section_t, &section_t::name> sections;
   std::list<section_t>::iterator Find(const std::string& section);
   bool Has(const std::string& section);
 };
@@ -22,6 +22,7 @@
 #include "check.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
@@ -73,6 +74,7 @@ void* osi_calloc(size_t size) {
 }
 
 void osi_free(void* ptr) {
+  if (buffer_pool_release(ptr)) return;
   free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
 }
 
@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "check.h"
+#include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
+
+struct buffer_pool_t {
+  uint8_t* base;
+  uint8_t* end;
+  size_t stride;
+  std::vector<size_t> free_buffers;
+  // Time each buffer in use was taken at
+  std::vector<uint64_t> taken_us;
+  bool retired;
+  buffer_pool_stats_t stats;
+};
+
+// Pools which still own buffers, and the address range they span so that
+// |osi_free| does not take the lock for buffers which are not theirs. Only
+// the pools lock writes the range: it is widened before a new pool hands out
+// buffers and only narrowed when a pool is destroyed, hence it covers the
+// buffers in use whichever of its values a reader sees.
+static std::mutex pools_mutex;
+static std::vector<buffer_pool_t*> pools;
+static std::atomic<uintptr_t> pools_begin(UINTPTR_MAX);
+static std::atomic<uintptr_t> pools_end(0);
+
+static uint64_t now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Must be called with |pools_mutex| held.
+static void buffer_pool_update_range_locked() {
+  uintptr_t begin = UINTPTR_MAX;
+  uintptr_t end = 0;
+  for (const buffer_pool_t* pool : pools) {
+    begin = std::min(begin, reinterpret_cast<uintptr_t>(pool->base));
+    end = std::max(end, reinterpret_cast<uintptr_t>(pool->end));
+  }
+  pools_begin.store(begin, std::memory_order_relaxed);
+  pools_end.store(end, std::memory_order_relaxed);
+}
+
+// Must be called with |pools_mutex| held.
+static void buffer_pool_destroy_locked(buffer_pool_t* pool) {
+  pools.erase(std::find(pools.begin(), pools.end(), pool));
+  buffer_pool_update_range_locked();
+  free(pool->base);
+  delete pool;
+}
+
+buffer_pool_t* buffer_pool_new(size_t buffer_size, size_t buffer_count) {
+  if (buffer_size == 0 || buffer_count == 0) return NULL;
+
+  // Keep every buffer aligned as malloc would
+  const size_t alignment = alignof(max_align_t);
+  size_t stride = (buffer_size + alignment - 1) & ~(alignment - 1);
+  uint8_t* base = static_cast<uint8_t*>(malloc(stride * buffer_count));
+  CHECK(base);
+
+  buffer_pool_t* pool = new buffer_pool_t();
+  pool->base = base;
+  pool->end = base + stride * buffer_count;
+  pool->stride = stride;
+  pool->free_buffers.reserve(buffer_count);
+  // Hand out the lowest buffers first, they are the ones most likely cached
+  for (size_t i = buffer_count; i > 0; i--) pool->free_buffers.push_back(i - 1);
+  pool->taken_us.resize(buffer_count, 0);
+  pool->retired = false;
+  pool->stats.buffer_size = stride;
+  pool->stats.buffer_count = buffer_count;
+
+  std::lock_guard<std::mutex> lock(pools_mutex);
+  pools.push_back(pool);
+  buffer_pool_update_range_locked();
+  return pool;
+}
+
+void buffer_pool_free(buffer_pool_t* pool) {
+  if (pool == NULL) return;
+
+  std::lock_guard<std::mutex> lock(pools_mutex);
+  CHECK(!pool->retired);
+  pool->retired = true;
+  if (pool->stats.buffers_in_use == 0) buffer_pool_destroy_locked(pool);
+}
+
+void* buffer_pool_get(buffer_pool_t* pool) {
+  CHECK(pool != NULL);
+
+  std::lock_guard<std::mutex> lock(pools_mutex);
+  CHECK(!pool->retired);
+  if (pool->free_buffers.empty()) {
+    pool->stats.total_exhausted++;
+    return NULL;
+  }
+
+  size_t index = pool->free_buffers.back();
+  pool->free_buffers.pop_back();
+  pool->taken_us[index] = now_us();
+  pool->stats.total_taken++;
+  pool->stats.buffers_in_use++;
+  pool->stats.max_buffers_in_use =
+      std::max(pool->stats.max_buffers_in_use, pool->stats.buffers_in_use);
+  return pool->base + index * pool->stride;
+}
+
+bool buffer_pool_release(void* ptr) {
+  // Most buffers freed while a pool is alive are not from a pool
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  if (address < pools_begin.load(std::memory_order_relaxed) ||
+      address >= pools_end.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  uint8_t* p = static_cast<uint8_t*>(ptr);
+  std::lock_guard<std::mutex> lock(pools_mutex);
+  for (buffer_pool_t* pool : pools) {
+    if (p < pool->base || p >= pool->end) continue;
+
+    size_t index = (p - pool->base) / pool->stride;
+    CHECK(pool->base + index * pool->stride == p);
+    uint64_t lifetime_us = now_us() - pool->taken_us[index];
+    pool->stats.total_released++;
+    pool->stats.total_lifetime_us += lifetime_us;
+    pool->stats.max_lifetime_us =
+        std::max(pool->stats.max_lifetime_us, lifetime_us);
+    pool->stats.buffers_in_use--;
+    pool->free_buffers.push_back(index);
+    if (pool->retired && pool->stats.buffers_in_use == 0) {
+      buffer_pool_destroy_locked(pool);
+    }
+    return true;
+  }
+  return false;
+}
+
+void buffer_pool_get_stats(const buffer_pool_t* pool,
+                           buffer_pool_stats_t* stats) {
+  CHECK(pool != NULL);
+  CHECK(stats != NULL);
+
+  std::lock_guard<std::mutex> lock(pools_mutex);
+  *stats = pool->stats;
+}
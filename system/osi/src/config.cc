@@ -37,11 +37,10 @@
 #include "check.h"
 
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
@@ -49,9 +48,7 @@ void section_t::Set(std::string key, std::string value) {
 }
 
 std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.find(key);
 }
 
 bool section_t::Has(const std::string& key) {
@@ -59,9 +56,7 @@ bool section_t::Has(const std::string& key) {
 }
 
 std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.find(section);
 }
 
 bool config_t::Has(const std::string& key) {
@@ -74,9 +69,7 @@ template <typename T,
           class = typename std::enable_if<std::is_same<
               config_t, typename std::remove_const<T>::type>::value>>
 static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return config.sections.find(section);
 }
 
 static const entry_t* entry_find(const config_t& config,
@@ -85,11 +78,10 @@ static const entry_t* entry_find(const config_t& config,
   auto sec = section_find(config, section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -225,11 +217,10 @@ void config_set_string(config_t* config, const std::string& section,
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
+  auto entry = sec->entries.find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = value_no_newline;
+    return;
   }
 
   sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
@@ -251,15 +242,11 @@ bool config_remove_key(config_t* config, const std::string& section,
   auto sec = section_find(*config, section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool config_save(const config_t& config, const std::string& filename) {
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <set>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/allocator.h"
+#include "osi/include/buffer_pool.h"
+
+class BufferPoolTest : public AllocationTestHarness {};
+
+TEST_F(BufferPoolTest, test_new_invalid) {
+  EXPECT_EQ(NULL, buffer_pool_new(0, 4));
+  EXPECT_EQ(NULL, buffer_pool_new(64, 0));
+  buffer_pool_free(NULL);
+}
+
+TEST_F(BufferPoolTest, test_get_until_exhausted) {
+  buffer_pool_t* pool = buffer_pool_new(100, 3);
+  ASSERT_TRUE(pool != NULL);
+
+  std::set<void*> buffers;
+  for (int i = 0; i < 3; i++) {
+    void* p = buffer_pool_get(pool);
+    ASSERT_TRUE(p != NULL);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignof(max_align_t));
+    memset(p, i, 100);
+    buffers.insert(p);
+  }
+  EXPECT_EQ(3u, buffers.size());
+  EXPECT_EQ(NULL, buffer_pool_get(pool));
+
+  buffer_pool_stats_t stats;
+  buffer_pool_get_stats(pool, &stats);
+  EXPECT_GE(stats.buffer_size, 100u);
+  EXPECT_EQ(3u, stats.buffer_count);
+  EXPECT_EQ(3u, stats.buffers_in_use);
+  EXPECT_EQ(3u, stats.total_taken);
+  EXPECT_EQ(1u, stats.total_exhausted);
+
+  for (void* p : buffers) osi_free(p);
+  buffer_pool_get_stats(pool, &stats);
+  EXPECT_EQ(0u, stats.buffers_in_use);
+  EXPECT_EQ(3u, stats.max_buffers_in_use);
+  EXPECT_EQ(3u, stats.total_released);
+
+  // Released buffers are handed out again
+  void* p = buffer_pool_get(pool);
+  EXPECT_EQ(1u, buffers.count(p));
+  osi_free(p);
+
+  buffer_pool_free(pool);
+}
+
+TEST_F(BufferPoolTest, test_release_other_buffer) {
+  buffer_pool_t* pool = buffer_pool_new(32, 2);
+  void* p = osi_malloc(32);
+  EXPECT_FALSE(buffer_pool_release(p));
+  EXPECT_FALSE(buffer_pool_release(NULL));
+  osi_free(p);
+
+  buffer_pool_stats_t stats;
+  buffer_pool_get_stats(pool, &stats);
+  EXPECT_EQ(0u, stats.total_released);
+  buffer_pool_free(pool);
+}
+
+TEST_F(BufferPoolTest, test_free_with_buffers_in_use) {
+  buffer_pool_t* pool = buffer_pool_new(64, 2);
+  uint8_t* p = static_cast<uint8_t*>(buffer_pool_get(pool));
+  ASSERT_TRUE(p != NULL);
+  buffer_pool_free(pool);
+
+  // The buffer outlives the pool until it is released
+  memset(p, 0xaa, 64);
+  EXPECT_TRUE(buffer_pool_release(p));
+  EXPECT_FALSE(buffer_pool_release(p));
+}
+
+TEST_F(BufferPoolTest, test_release_with_several_pools) {
+  buffer_pool_t* first = buffer_pool_new(64, 2);
+  buffer_pool_t* second = buffer_pool_new(64, 2);
+  void* p_first = buffer_pool_get(first);
+  void* p_second = buffer_pool_get(second);
+  ASSERT_TRUE(p_first != NULL);
+  ASSERT_TRUE(p_second != NULL);
+
+  // Buffers of a pool still release once another pool is destroyed
+  osi_free(p_first);
+  buffer_pool_free(first);
+  void* p_other = osi_malloc(64);
+  EXPECT_FALSE(buffer_pool_release(p_other));
+  osi_free(p_other);
+  EXPECT_TRUE(buffer_pool_release(p_second));
+
+  buffer_pool_stats_t stats;
+  buffer_pool_get_stats(second, &stats);
+  EXPECT_EQ(0u, stats.buffers_in_use);
+  buffer_pool_free(second);
+}
@@ -20,6 +20,8 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <string>
+#include <vector>
 
 #include "AllocationTestHarness.h"
 
@@ -134,6 +136,35 @@ TEST_F(ConfigTest, section_set) {
   EXPECT_EQ(entry_iter->value, "bar");
 }
 
+TEST_F(ConfigTest, sections_keep_insertion_order_and_index) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config_set_string(config.get(), "B", "b", "1");
+  config_set_string(config.get(), "A", "a", "2");
+  config_set_string(config.get(), "C", "c", "3");
+  EXPECT_TRUE(config_remove_section(config.get(), "A"));
+  config_set_string(config.get(), "A", "a", "4");
+  std::vector<std::string> names;
+  for (const section_t& section : config->sections) names.push_back(section.name);
+  EXPECT_EQ(names, std::vector<std::string>({"B", "C", "A"}));
+  EXPECT_EQ(config_get_string(*config, "A", "a", nullptr)->compare("4"), 0);
+
+  // Moving a section out before erasing it must not leave a stale index
+  auto section_iter = config->Find("B");
+  ASSERT_NE(section_iter, config->sections.end());
+  section_t moved_section = std::move(*section_iter);
+  config->sections.erase(section_iter);
+  EXPECT_FALSE(config->Has("B"));
+  EXPECT_TRUE(moved_section.Has("b"));
+
+  // Copies have their own index
+  std::unique_ptr<config_t> clone = config_new_clone(*config);
+  config_t copy = *config;
+  EXPECT_TRUE(config_remove_section(config.get(), "C"));
+  EXPECT_TRUE(clone->Has("C"));
+  EXPECT_TRUE(copy.Has("C"));
+  EXPECT_TRUE(config_has_key(copy, "C", "c"));
+}
+
 TEST_F(ConfigTest, config_new_empty) {
   std::unique_ptr<config_t> config = config_new_empty();
   EXPECT_TRUE(config.get() != NULL);
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "hardware/avrcp/avrcp_common.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+// A helper class that keeps the items of the last few listings sent to a
+// connected device, so that the following pages of a Get Folder Items
+// request can be built without fetching the whole list again from the AVRCP
+// Media Interface layer.
+//
+// The items are stored ready to be added to a response, with their UID's
+// assigned and all of their attributes. They are only valid as long as the
+// UID's they were given, so a listing must be invalidated whenever the
+// matching Media ID map is rebuilt or the UID's change.
+class BrowseCache {
+ public:
+  static constexpr size_t kMaxListings = 4;
+
+  // Returns the items of a listing, or nullptr if it is not cached.
+  const std::vector<MediaListItem>* Find(Scope scope, int player_id,
+                                         const std::string& folder) {
+    for (auto it = listings_.begin(); it != listings_.end(); it++) {
+      if (it->scope == scope && it->player_id == player_id &&
+          it->folder == folder) {
+        // Keep the most recently used listing first
+        listings_.splice(listings_.begin(), listings_, it);
+        return &listings_.front().items;
+      }
+    }
+    return nullptr;
+  }
+
+  void Insert(Scope scope, int player_id, const std::string& folder,
+              std::vector<MediaListItem> items) {
+    Invalidate(scope, player_id, folder);
+    listings_.push_front(Listing{scope, player_id, folder, std::move(items)});
+    if (listings_.size() > kMaxListings) listings_.pop_back();
+  }
+
+  void Invalidate(Scope scope) {
+    listings_.remove_if(
+        [scope](const Listing& listing) { return listing.scope == scope; });
+  }
+
+  void Clear() { listings_.clear(); }
+
+  size_t size() const { return listings_.size(); }
+
+ private:
+  void Invalidate(Scope scope, int player_id, const std::string& folder) {
+    listings_.remove_if([&](const Listing& listing) {
+      return listing.scope == scope && listing.player_id == player_id &&
+             listing.folder == folder;
+    });
+  }
+
+  struct Listing {
+    Scope scope;
+    int player_id;
+    std::string folder;
+    std::vector<MediaListItem> items;
+  };
+
+  std::list<Listing> listings_;
+};
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -73,6 +73,9 @@ void Device::SetBrowseMtu(uint16_t browse_mtu) {
 void Device::SetBipClientStatus(bool connected) {
   DEVICE_LOG(INFO) << __PRETTY_FUNCTION__ << ": connected = " << connected;
   has_bip_client_ = connected;
+
+  // Cached items carry the cover art handles only when a client can use them
+  browse_cache_.Clear();
 }
 
 bool Device::HasBipClient() const {
@@ -473,6 +476,7 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
   // Anytime we use the now playing list, update our map so that its always
   // current
   now_playing_ids_.clear();
+  browse_cache_.Invalidate(Scope::NOW_PLAYING);
   uint64_t uid = 0;
   for (const SongInfo& song : song_list) {
     now_playing_ids_.insert(song.media_id);
@@ -851,12 +855,15 @@ void Device::HandleGetFolderItems(uint8_t label,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
       break;
     case Scope::VFS:
+      if (SendCachedFolderItems(label, pkt)) break;
       media_interface_->GetFolderItems(
           curr_browsed_player_id_, CurrentFolder(),
           base::Bind(&Device::GetVFSListResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label, pkt));
+                     weak_ptr_factory_.GetWeakPtr(), label, pkt,
+                     CurrentFolder()));
       break;
     case Scope::NOW_PLAYING:
+      if (SendCachedFolderItems(label, pkt)) break;
       media_interface_->GetNowPlayingList(
           base::Bind(&Device::GetNowPlayingListResponse,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
@@ -1184,117 +1191,139 @@ void Device::GetMediaPlayerListResponse(
 }
 
 std::set<AttributeEntry> filter_attributes_requested(
-    const SongInfo& song, const std::vector<Attribute>& attrs) {
+    const std::set<AttributeEntry>& attributes,
+    const std::vector<Attribute>& attrs) {
   std::set<AttributeEntry> result;
   for (const auto& attr : attrs) {
-    if (song.attributes.find(attr) != song.attributes.end()) {
-      result.insert(*song.attributes.find(attr));
+    if (attributes.find(attr) != attributes.end()) {
+      result.insert(*attributes.find(attr));
     }
   }
 
   return result;
 }
 
+// Builds the list item of a song with all of its attributes, the requested
+// ones are picked when a page is sent.
+MediaListItem make_song_item(uint64_t uid, SongInfo song) {
+  auto title = song.attributes.find(Attribute::TITLE) != song.attributes.end()
+                   ? song.attributes.find(Attribute::TITLE)->value()
+                   : "No Song Info";
+  MediaElementItem song_item(uid, title, std::set<AttributeEntry>());
+  song_item.attributes_ = std::move(song.attributes);
+  return MediaListItem(song_item);
+}
+
 void Device::GetVFSListResponse(uint8_t label,
                                 std::shared_ptr<GetFolderItemsRequest> pkt,
+                                std::string folder,
                                 std::vector<ListItem> items) {
   DEVICE_VLOG(2) << __func__ << ": start_item=" << pkt->GetStartItem()
                  << " end_item=" << pkt->GetEndItem();
 
-  // The builder will automatically correct the status if there are zero items
-  auto builder = GetFolderItemsResponseBuilder::MakeVFSBuilder(
-      Status::NO_ERROR, 0x0000, browse_mtu_);
-
-  // TODO (apanicke): Add test that checks if vfs_ids_ is the correct size after
-  // an operation.
-  for (const auto& item : items) {
-    if (item.type == ListItem::FOLDER) {
-      vfs_ids_.insert(item.folder.media_id);
-    } else if (item.type == ListItem::SONG) {
-      vfs_ids_.insert(item.song.media_id);
-    }
-  }
-
   // Add the elements retrieved in the last get folder items request and map
   // them to UIDs The maps will be cleared every time a directory change
   // happens. These items do not need to correspond with the now playing list as
   // the UID's only need to be unique in the context of the current scope and
   // the current folder
-  for (auto i = pkt->GetStartItem(); i <= pkt->GetEndItem() && i < items.size();
-       i++) {
-    if (items[i].type == ListItem::FOLDER) {
-      auto folder = items[i].folder;
+  // TODO (apanicke): Add test that checks if vfs_ids_ is the correct size after
+  // an operation.
+  std::vector<MediaListItem> list_items;
+  list_items.reserve(items.size());
+  for (auto& item : items) {
+    if (item.type == ListItem::FOLDER) {
       // right now we always use folders of mixed type
-      FolderItem folder_item(vfs_ids_.get_uid(folder.media_id), 0x00,
-                             folder.is_playable, folder.name);
-      if (!builder->AddFolder(folder_item)) break;
-    } else if (items[i].type == ListItem::SONG) {
-      auto song = items[i].song;
-
+      list_items.push_back(FolderItem(vfs_ids_.insert(item.folder.media_id),
+                                      0x00, item.folder.is_playable,
+                                      item.folder.name));
+    } else if (item.type == ListItem::SONG) {
       // Filter out DEFAULT_COVER_ART handle if this device has no client
       if (!HasBipClient()) {
-        filter_cover_art(song);
-      }
-
-      auto title =
-          song.attributes.find(Attribute::TITLE) != song.attributes.end()
-              ? song.attributes.find(Attribute::TITLE)->value()
-              : "No Song Info";
-      MediaElementItem song_item(vfs_ids_.get_uid(song.media_id), title,
-                                 std::set<AttributeEntry>());
-
-      if (pkt->GetNumAttributes() == 0x00) {  // All attributes requested
-        song_item.attributes_ = std::move(song.attributes);
-      } else {
-        song_item.attributes_ =
-            filter_attributes_requested(song, pkt->GetAttributesRequested());
+        filter_cover_art(item.song);
       }
 
-      // If we fail to add a song, don't accidentally add one later that might
-      // fit.
-      if (!builder->AddSong(song_item)) break;
+      uint64_t uid = vfs_ids_.insert(item.song.media_id);
+      list_items.push_back(make_song_item(uid, std::move(item.song)));
     }
   }
 
-  send_message(label, true, std::move(builder));
+  SendFolderItems(label, pkt, list_items);
+
+  // Don't keep the listing if the path changed while it was fetched
+  if (folder != CurrentFolder()) return;
+  browse_cache_.Insert(Scope::VFS, curr_browsed_player_id_, folder,
+                       std::move(list_items));
 }
 
 void Device::GetNowPlayingListResponse(
     uint8_t label, std::shared_ptr<GetFolderItemsRequest> pkt,
     std::string /* unused curr_song_id */, std::vector<SongInfo> song_list) {
   DEVICE_VLOG(2) << __func__;
-  auto builder = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
-      Status::NO_ERROR, 0x0000, browse_mtu_);
 
   now_playing_ids_.clear();
-  for (const SongInfo& song : song_list) {
+  std::vector<MediaListItem> list_items;
+  list_items.reserve(song_list.size());
+  for (auto& song : song_list) {
     now_playing_ids_.insert(song.media_id);
-  }
-
-  for (size_t i = pkt->GetStartItem();
-       i <= pkt->GetEndItem() && i < song_list.size(); i++) {
-    auto song = song_list[i];
 
     // Filter out DEFAULT_COVER_ART handle if this device has no client
     if (!HasBipClient()) {
       filter_cover_art(song);
     }
 
-    auto title = song.attributes.find(Attribute::TITLE) != song.attributes.end()
-                     ? song.attributes.find(Attribute::TITLE)->value()
-                     : "No Song Info";
+    list_items.push_back(
+        make_song_item(list_items.size() + 1, std::move(song)));
+  }
 
-    MediaElementItem item(i + 1, title, std::set<AttributeEntry>());
-    if (pkt->GetNumAttributes() == 0x00) {
-      item.attributes_ = std::move(song.attributes);
-    } else {
-      item.attributes_ =
-          filter_attributes_requested(song, pkt->GetAttributesRequested());
-    }
+  SendFolderItems(label, pkt, list_items);
+  browse_cache_.Insert(Scope::NOW_PLAYING, curr_browsed_player_id_, "",
+                       std::move(list_items));
+}
+
+bool Device::SendCachedFolderItems(uint8_t label,
+                                   std::shared_ptr<GetFolderItemsRequest> pkt) {
+  // A listing from the start is always fetched again, so that a device
+  // browsing from the top never sees a list older than its first page.
+  if (pkt->GetStartItem() == 0) return false;
+
+  auto folder = pkt->GetScope() == Scope::VFS ? CurrentFolder() : "";
+  auto items =
+      browse_cache_.Find(pkt->GetScope(), curr_browsed_player_id_, folder);
+  if (items == nullptr) return false;
+
+  DEVICE_VLOG(2) << __func__ << ": scope=" << pkt->GetScope()
+                 << " start_item=" << pkt->GetStartItem()
+                 << " end_item=" << pkt->GetEndItem();
+  SendFolderItems(label, pkt, *items);
+  return true;
+}
+
+void Device::SendFolderItems(uint8_t label,
+                             std::shared_ptr<GetFolderItemsRequest> pkt,
+                             const std::vector<MediaListItem>& items) {
+  // The builder will automatically correct the status if there are zero items
+  auto builder =
+      pkt->GetScope() == Scope::VFS
+          ? GetFolderItemsResponseBuilder::MakeVFSBuilder(Status::NO_ERROR,
+                                                          0x0000, browse_mtu_)
+          : GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+                Status::NO_ERROR, 0x0000, browse_mtu_);
+
+  for (size_t i = pkt->GetStartItem();
+       i <= pkt->GetEndItem() && i < items.size(); i++) {
+    if (items[i].type_ == MediaListItem::FOLDER) {
+      if (!builder->AddFolder(items[i].folder_)) break;
+    } else if (items[i].type_ == MediaListItem::SONG) {
+      MediaElementItem song_item = items[i].song_;
+      if (pkt->GetNumAttributes() != 0x00) {  // Not all attributes requested
+        song_item.attributes_ = filter_attributes_requested(
+            song_item.attributes_, pkt->GetAttributesRequested());
+      }
 
-    // If we fail to add a song, don't accidentally add one later that might
-    // fit.
-    if (!builder->AddSong(item)) break;
+      // If we fail to add a song, don't accidentally add one later that might
+      // fit.
+      if (!builder->AddSong(song_item)) break;
+    }
   }
 
   send_message(label, true, std::move(builder));
@@ -1342,6 +1371,7 @@ void Device::SetBrowsedPlayerResponse(
   // Clear the path and push the new root.
   current_path_ = std::stack<std::string>();
   current_path_.push(root_id);
+  browse_cache_.Invalidate(Scope::VFS);
 
   auto response = SetBrowsedPlayerResponseBuilder::MakeBuilder(
       Status::NO_ERROR, 0x0000, num_items, 0, "");
@@ -1357,6 +1387,7 @@ void Device::SendMediaUpdate(bool metadata, bool play_status, bool queue) {
                  << " ; is_silence=" << is_silence;
 
   if (queue) {
+    browse_cache_.Invalidate(Scope::NOW_PLAYING);
     HandleNowPlayingUpdate();
   }
 
@@ -1375,6 +1406,11 @@ void Device::SendFolderUpdate(bool available_players, bool addressed_player,
   CHECK(media_interface_);
   DEVICE_VLOG(4) << __func__;
 
+  // The items of any listing may have been renumbered
+  if (uids) {
+    browse_cache_.Clear();
+  }
+
   if (available_players) {
     HandleAvailablePlayerUpdate();
   }
@@ -1432,6 +1468,7 @@ void Device::HandleNowPlayingNotificationResponse(
   }
 
   now_playing_ids_.clear();
+  browse_cache_.Invalidate(Scope::NOW_PLAYING);
   for (const SongInfo& song : song_list) {
     now_playing_ids_.insert(song.media_id);
   }
@@ -1531,6 +1568,7 @@ std::ostream& operator<<(std::ostream& out, const Device& d) {
   out << "Current Folder: \"" << d.CurrentFolder() << "\"\n";
   out << "MTU Sizes: CTRL=" << d.ctrl_mtu_ << " BROWSE=" << d.browse_mtu_
       << std::endl;
+  out << "Cached Listings: " << d.browse_cache_.size() << std::endl;
   // TODO (apanicke): Add supported features as well as media keys
   return out;
 }
@@ -38,6 +38,7 @@
 #include "packet/avrcp/set_addressed_player.h"
 #include "packet/avrcp/set_browsed_player.h"
 #include "packet/avrcp/vendor_packet.h"
+#include "profile/avrcp/browse_cache.h"
 #include "profile/avrcp/media_id_map.h"
 #include "raw_address.h"
 
@@ -210,10 +211,18 @@ class Device {
       uint16_t curr_player, std::vector<MediaPlayerInfo> players);
   virtual void GetVFSListResponse(uint8_t label,
                                   std::shared_ptr<GetFolderItemsRequest> pkt,
+                                  std::string folder,
                                   std::vector<ListItem> items);
   virtual void GetNowPlayingListResponse(
       uint8_t label, std::shared_ptr<GetFolderItemsRequest> pkt,
       std::string curr_song_id, std::vector<SongInfo> song_list);
+  // Sends a page of a VFS or Now Playing listing already in the browse cache.
+  // Returns false if the listing has to be fetched.
+  virtual bool SendCachedFolderItems(
+      uint8_t label, std::shared_ptr<GetFolderItemsRequest> pkt);
+  virtual void SendFolderItems(uint8_t label,
+                               std::shared_ptr<GetFolderItemsRequest> pkt,
+                               const std::vector<MediaListItem>& items);
 
   // GET TOTAL NUMBER OF ITEMS
   virtual void HandleGetTotalNumberOfItems(
@@ -327,6 +336,7 @@ class Device {
 
   MediaIdMap vfs_ids_;
   MediaIdMap now_playing_ids_;
+  BrowseCache browse_cache_;
 
   uint32_t play_pos_interval_ = 0;
 
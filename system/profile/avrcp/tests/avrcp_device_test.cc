@@ -1052,6 +1052,111 @@ TEST_F(AvrcpDeviceTest, changePathTest) {
   SendBrowseMessage(5, request);
 }
 
+TEST_F(AvrcpDeviceTest, getVFSFolderPagesTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  FolderInfo info0 = {"test_id0", true, "Test Folder0"};
+  FolderInfo info1 = {"test_id1", true, "Test Folder1"};
+  FolderInfo info2 = {"test_id2", true, "Test Folder2"};
+  ListItem item0 = {ListItem::FOLDER, info0, SongInfo()};
+  ListItem item1 = {ListItem::FOLDER, info1, SongInfo()};
+  ListItem item2 = {ListItem::FOLDER, info2, SongInfo()};
+  std::vector<ListItem> list = {item0, item1, item2};
+
+  // The following pages of a listing are served without fetching it again
+  // until the UIDs change
+  EXPECT_CALL(interface, GetFolderItems(_, "", _))
+      .Times(2)
+      .WillRepeatedly(InvokeCb<2>(list));
+
+  auto first_page = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  first_page->AddFolder(FolderItem(1, 0, true, "Test Folder0"));
+  EXPECT_CALL(response_cb, Call(1, true, matchPacket(std::move(first_page))))
+      .Times(1);
+  auto folder_request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, 0, 0, {});
+  auto request = TestBrowsePacket::Make();
+  folder_request_builder->Serialize(request);
+  SendBrowseMessage(1, request);
+
+  auto second_page = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  second_page->AddFolder(FolderItem(2, 0, true, "Test Folder1"));
+  second_page->AddFolder(FolderItem(3, 0, true, "Test Folder2"));
+  EXPECT_CALL(response_cb, Call(2, true, matchPacket(std::move(second_page))))
+      .Times(1);
+  folder_request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, 1, 2, {});
+  request = TestBrowsePacket::Make();
+  folder_request_builder->Serialize(request);
+  SendBrowseMessage(2, request);
+
+  test_device->SendFolderUpdate(false, false, true);
+
+  auto last_page = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  last_page->AddFolder(FolderItem(3, 0, true, "Test Folder2"));
+  EXPECT_CALL(response_cb, Call(3, true, matchPacket(std::move(last_page))))
+      .Times(1);
+  folder_request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, 2, 2, {});
+  request = TestBrowsePacket::Make();
+  folder_request_builder->Serialize(request);
+  SendBrowseMessage(3, request);
+}
+
+TEST_F(AvrcpDeviceTest, getNowPlayingListPagesTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+  SetBipClientStatus(false);
+
+  SongInfo info0 = {"test_id0",
+                    {AttributeEntry(Attribute::TITLE, "Test Song0"),
+                     AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  SongInfo info1 = {"test_id1",
+                    {AttributeEntry(Attribute::TITLE, "Test Song1"),
+                     AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  std::vector<SongInfo> list = {info0, info1};
+
+  // A change of the queue drops the cached listing
+  EXPECT_CALL(interface, GetNowPlayingList(_))
+      .Times(2)
+      .WillRepeatedly(InvokeCb<0>("test_id0", list));
+
+  auto first_page = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  first_page->AddSong(MediaElementItem(1, "Test Song0", info0.attributes));
+  EXPECT_CALL(response_cb, Call(1, true, matchPacket(std::move(first_page))))
+      .Times(1);
+  auto folder_request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::NOW_PLAYING, 0, 0, {});
+  auto request = TestBrowsePacket::Make();
+  folder_request_builder->Serialize(request);
+  SendBrowseMessage(1, request);
+
+  // Only the requested attributes are sent for a cached song
+  auto second_page = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  second_page->AddSong(MediaElementItem(
+      2, "Test Song1", {AttributeEntry(Attribute::TITLE, "Test Song1")}));
+  EXPECT_CALL(response_cb, Call(2, true, matchPacket(std::move(second_page))))
+      .Times(2);
+  folder_request_builder = GetFolderItemsRequestBuilder::MakeBuilder(
+      Scope::NOW_PLAYING, 1, 1, {Attribute::TITLE});
+  request = TestBrowsePacket::Make();
+  folder_request_builder->Serialize(request);
+  SendBrowseMessage(2, request);
+
+  test_device->SendMediaUpdate(false, false, true);
+  SendBrowseMessage(2, request);
+}
+
 TEST_F(AvrcpDeviceTest, getItemAttributesNowPlayingTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -117,6 +117,7 @@ static const tA2DP_ENCODER_INTERFACE a2dp_encoder_interface_aac = {
     a2dp_aac_feeding_flush,
     a2dp_aac_get_encoder_interval_ms,
     a2dp_aac_get_effective_frame_size,
+    a2dp_aac_get_media_buffer_size,
     a2dp_aac_send_frames,
     nullptr  // set_transmit_queue_length
 };
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "a2dp_aac.h"
+#include "a2dp_media_buffer.h"
 #include "common/time_util.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
@@ -482,6 +483,12 @@ int a2dp_aac_get_effective_frame_size() {
   return a2dp_aac_encoder_cb.TxAaMtuSize;
 }
 
+size_t a2dp_aac_get_media_buffer_size() {
+  // Each packet holds a single encoded frame, which may exceed the MTU
+  return sizeof(BT_HDR) + A2DP_AAC_OFFSET +
+         a2dp_aac_encoder_cb.aac_encoder_params.max_encoded_buffer_bytes;
+}
+
 void a2dp_aac_send_frames(uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
@@ -586,7 +593,7 @@ static void a2dp_aac_encode_frames(uint8_t nb_frame) {
   int written = 0;
 
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    BT_HDR* p_buf = a2dp_media_buffer_alloc(a2dp_aac_get_media_buffer_size());
     p_buf->offset = A2DP_AAC_OFFSET;
     p_buf->len = 0;
     p_buf->layer_specific = 0;
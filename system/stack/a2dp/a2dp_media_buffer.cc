@@ -0,0 +1,64 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "a2dp_media_buffer"
+
+#include "a2dp_media_buffer.h"
+
+#include <mutex>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+
+// The pool is used from the A2DP source thread, and its statistics are read
+// from the thread dumping the state.
+static std::mutex media_buffer_mutex;
+static buffer_pool_t* media_buffer_pool = nullptr;
+static size_t media_buffer_size = 0;
+
+void a2dp_media_buffer_pool_init(size_t buffer_size, size_t buffer_count) {
+  std::lock_guard<std::mutex> lock(media_buffer_mutex);
+  buffer_pool_free(media_buffer_pool);
+  media_buffer_pool = buffer_pool_new(buffer_size, buffer_count);
+  media_buffer_size = buffer_size;
+  LOG_INFO("%s: %zu buffers of %zu bytes", __func__, buffer_count,
+           buffer_size);
+}
+
+void a2dp_media_buffer_pool_cleanup(void) {
+  std::lock_guard<std::mutex> lock(media_buffer_mutex);
+  buffer_pool_free(media_buffer_pool);
+  media_buffer_pool = nullptr;
+  media_buffer_size = 0;
+}
+
+BT_HDR* a2dp_media_buffer_alloc(size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(media_buffer_mutex);
+    if (media_buffer_pool != nullptr && size <= media_buffer_size) {
+      void* p_buf = buffer_pool_get(media_buffer_pool);
+      if (p_buf != nullptr) return static_cast<BT_HDR*>(p_buf);
+    }
+  }
+  return static_cast<BT_HDR*>(osi_malloc(size));
+}
+
+bool a2dp_media_buffer_pool_get_stats(buffer_pool_stats_t* stats) {
+  std::lock_guard<std::mutex> lock(media_buffer_mutex);
+  if (media_buffer_pool == nullptr) return false;
+  buffer_pool_get_stats(media_buffer_pool, stats);
+  return true;
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "a2dp_pcm_resampler"
+
+#include "a2dp_pcm_resampler.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "osi/include/log.h"
+
+namespace {
+
+// Filter length in source samples when up-sampling, a multiple of 4. It grows
+// with the decimation ratio when down-sampling, to keep the same transition
+// band.
+constexpr size_t kTapsPerPhase = 16;
+// Bounds the coefficient table, 44.1 kHz <-> 48 kHz needs 160 phases
+constexpr uint32_t kMaxPhases = 1024;
+// Passband edge, relative to the Nyquist frequency of the lower of the rates
+constexpr double kCutoff = 0.9;
+
+bool is_supported_format(uint8_t bits_per_sample, uint8_t channel_count) {
+  return (bits_per_sample == 16 || bits_per_sample == 24 ||
+          bits_per_sample == 32) &&
+         (channel_count == 1 || channel_count == 2);
+}
+
+// Rounds to nearest, |value| is already clamped to the integer range
+int32_t round_sample(float value) {
+  return static_cast<int32_t>(value + (value < 0 ? -0.5f : 0.5f));
+}
+
+float read_sample(const uint8_t* p, uint8_t bits_per_sample) {
+  switch (bits_per_sample) {
+    case 16: {
+      int16_t sample;
+      memcpy(&sample, p, sizeof(sample));
+      return sample * (1.0f / 32768.0f);
+    }
+    case 24: {
+      int32_t sample = static_cast<int32_t>(
+          (uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24);
+      return (sample >> 8) * (1.0f / 8388608.0f);
+    }
+    default: {
+      int32_t sample;
+      memcpy(&sample, p, sizeof(sample));
+      return sample * (1.0f / 2147483648.0f);
+    }
+  }
+}
+
+void write_sample(float value, uint8_t bits_per_sample, uint8_t* p) {
+  switch (bits_per_sample) {
+    case 16: {
+      float scaled = std::min(std::max(value * 32768.0f, -32768.0f), 32767.0f);
+      int16_t sample = static_cast<int16_t>(round_sample(scaled));
+      memcpy(p, &sample, sizeof(sample));
+      break;
+    }
+    case 24: {
+      float scaled =
+          std::min(std::max(value * 8388608.0f, -8388608.0f), 8388607.0f);
+      int32_t sample = round_sample(scaled);
+      p[0] = sample & 0xff;
+      p[1] = (sample >> 8) & 0xff;
+      p[2] = (sample >> 16) & 0xff;
+      break;
+    }
+    default: {
+      double scaled = std::min(std::max(value * 2147483648.0, -2147483648.0),
+                               2147483647.0);
+      int32_t sample = static_cast<int32_t>(std::lrint(scaled));
+      memcpy(p, &sample, sizeof(sample));
+      break;
+    }
+  }
+}
+
+// The taps count is always a multiple of 4, the separate accumulators let the
+// compiler turn this loop into SIMD multiply-adds. It is fully unrolled when
+// the taps count is a constant.
+inline float dot_product(const float* coefficients, const float* samples,
+                         size_t taps) {
+  float sum[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < taps; i += 4) {
+    sum[0] += coefficients[i] * samples[i];
+    sum[1] += coefficients[i + 1] * samples[i + 1];
+    sum[2] += coefficients[i + 2] * samples[i + 2];
+    sum[3] += coefficients[i + 3] * samples[i + 3];
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+double sinc(double x) {
+  if (x == 0) return 1;
+  return std::sin(M_PI * x) / (M_PI * x);
+}
+
+// Blackman window over [-1, 1]
+double window(double x) {
+  if (x <= -1 || x >= 1) return 0;
+  return 0.42 + 0.5 * std::cos(M_PI * x) + 0.08 * std::cos(2 * M_PI * x);
+}
+
+}  // namespace
+
+bool A2dpPcmResampler::Configure(uint32_t src_sample_rate,
+                                 uint8_t src_bits_per_sample,
+                                 uint8_t src_channel_count,
+                                 uint32_t dst_sample_rate,
+                                 uint8_t dst_bits_per_sample,
+                                 uint8_t dst_channel_count) {
+  if (configured_ && src_sample_rate == src_sample_rate_ &&
+      src_bits_per_sample == src_bits_per_sample_ &&
+      src_channel_count == src_channel_count_ &&
+      dst_sample_rate == dst_sample_rate_ &&
+      dst_bits_per_sample == dst_bits_per_sample_ &&
+      dst_channel_count == dst_channel_count_) {
+    return true;
+  }
+
+  configured_ = false;
+  if (src_sample_rate == 0 || dst_sample_rate == 0 ||
+      !is_supported_format(src_bits_per_sample, src_channel_count) ||
+      !is_supported_format(dst_bits_per_sample, dst_channel_count)) {
+    LOG_ERROR("%s: unsupported conversion %u Hz %u bits %u ch -> %u Hz %u "
+              "bits %u ch",
+              __func__, src_sample_rate, src_bits_per_sample,
+              src_channel_count, dst_sample_rate, dst_bits_per_sample,
+              dst_channel_count);
+    return false;
+  }
+
+  uint32_t gcd = std::gcd(src_sample_rate, dst_sample_rate);
+  if (dst_sample_rate / gcd > kMaxPhases) {
+    LOG_ERROR("%s: unsupported rate ratio %u Hz -> %u Hz", __func__,
+              src_sample_rate, dst_sample_rate);
+    return false;
+  }
+
+  src_sample_rate_ = src_sample_rate;
+  src_bits_per_sample_ = src_bits_per_sample;
+  src_channel_count_ = src_channel_count;
+  dst_sample_rate_ = dst_sample_rate;
+  dst_bits_per_sample_ = dst_bits_per_sample;
+  dst_channel_count_ = dst_channel_count;
+  interpolation_ = dst_sample_rate / gcd;
+  decimation_ = src_sample_rate / gcd;
+  position_step_ = decimation_ / interpolation_;
+  phase_step_ = decimation_ % interpolation_;
+
+  coefficients_.clear();
+  taps_ = 0;
+  if (interpolation_ != decimation_) {
+    // Source samples per destination sample, rounded up
+    size_t ratio = (decimation_ + interpolation_ - 1) / interpolation_;
+    taps_ = kTapsPerPhase * ratio;
+    double cutoff =
+        kCutoff * std::min(1.0, (double)interpolation_ / decimation_) / 2;
+    double center = taps_ / 2 - 1;
+
+    coefficients_.resize(interpolation_ * taps_);
+    for (uint32_t phase = 0; phase < interpolation_; phase++) {
+      float* coefficients = &coefficients_[phase * taps_];
+      double fraction = (double)phase / interpolation_;
+      double sum = 0;
+      for (size_t tap = 0; tap < taps_; tap++) {
+        double distance = center + fraction - tap;
+        double value = 2 * cutoff * sinc(2 * cutoff * distance) *
+                       window(distance / (taps_ / 2));
+        coefficients[tap] = value;
+        sum += value;
+      }
+      // Unity gain for every phase
+      for (size_t tap = 0; tap < taps_; tap++) {
+        coefficients[tap] /= sum;
+      }
+    }
+  }
+
+  LOG_INFO("%s: %u Hz %u bits %u ch -> %u Hz %u bits %u ch, %u/%u %zu taps",
+           __func__, src_sample_rate_, src_bits_per_sample_,
+           src_channel_count_, dst_sample_rate_, dst_bits_per_sample_,
+           dst_channel_count_, interpolation_, decimation_, taps_);
+  configured_ = true;
+  Reset();
+  return true;
+}
+
+void A2dpPcmResampler::Reset() {
+  for (size_t channel = 0; channel < kMaxChannels; channel++) {
+    history_[channel].clear();
+    // Centers the filter on the first source sample
+    if (taps_ > 0) history_[channel].resize(taps_ / 2 - 1, 0);
+  }
+  position_ = 0;
+  phase_ = 0;
+  src_frames_remainder_ = 0;
+}
+
+bool A2dpPcmResampler::IsPassthrough() const {
+  return src_sample_rate_ == dst_sample_rate_ &&
+         src_bits_per_sample_ == dst_bits_per_sample_ &&
+         src_channel_count_ == dst_channel_count_;
+}
+
+size_t A2dpPcmResampler::GetSourceFrames(size_t dst_frames) {
+  if (!configured_) return dst_frames;
+  uint64_t total =
+      (uint64_t)dst_frames * decimation_ + src_frames_remainder_;
+  src_frames_remainder_ = total % interpolation_;
+  return total / interpolation_;
+}
+
+size_t A2dpPcmResampler::Convert(const uint8_t* src, size_t src_len,
+                                 uint8_t* dst, size_t dst_len) {
+  if (!configured_) {
+    LOG_ERROR("%s: not configured", __func__);
+    return 0;
+  }
+
+  if (IsPassthrough() && history_[0].empty() && src_len <= dst_len) {
+    memcpy(dst, src, src_len);
+    return src_len;
+  }
+
+  size_t src_frame_size = src_bits_per_sample_ / 8 * src_channel_count_;
+  size_t dst_frame_size = dst_bits_per_sample_ / 8 * dst_channel_count_;
+  DecodeFrames(src, src_len / src_frame_size);
+  size_t num_frames = FilterFrames(dst_len / dst_frame_size);
+
+  // Only keep the source samples that are still needed
+  for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+    history_[channel].erase(history_[channel].begin(),
+                            history_[channel].begin() + position_);
+  }
+  position_ = 0;
+
+  return EncodeFrames(num_frames, dst);
+}
+
+void A2dpPcmResampler::DecodeFrames(const uint8_t* src, size_t num_frames) {
+  size_t sample_size = src_bits_per_sample_ / 8;
+  size_t history_size = history_[0].size();
+  for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+    history_[channel].resize(history_size + num_frames);
+  }
+
+  float* left = &history_[0][history_size];
+  if (dst_channel_count_ == 1) {
+    for (size_t i = 0; i < num_frames; i++) {
+      float sample = read_sample(src, src_bits_per_sample_);
+      src += sample_size;
+      if (src_channel_count_ == 2) {
+        sample = (sample + read_sample(src, src_bits_per_sample_)) / 2;
+        src += sample_size;
+      }
+      left[i] = sample;
+    }
+    return;
+  }
+
+  float* right = &history_[1][history_size];
+  for (size_t i = 0; i < num_frames; i++) {
+    left[i] = read_sample(src, src_bits_per_sample_);
+    src += sample_size;
+    if (src_channel_count_ == 2) {
+      right[i] = read_sample(src, src_bits_per_sample_);
+      src += sample_size;
+    } else {
+      right[i] = left[i];
+    }
+  }
+}
+
+size_t A2dpPcmResampler::FilterFrames(size_t max_frames) {
+  for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+    output_[channel].resize(max_frames);
+  }
+
+  size_t history_size = history_[0].size();
+  size_t num_frames = 0;
+  if (taps_ == 0) {
+    num_frames = std::min(max_frames, history_size - position_);
+    for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+      std::copy_n(history_[channel].begin() + position_, num_frames,
+                  output_[channel].begin());
+    }
+    position_ += num_frames;
+    return num_frames;
+  }
+
+  for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+    const float* samples = history_[channel].data();
+    float* output = output_[channel].data();
+    size_t position = position_;
+    uint32_t phase = phase_;
+    num_frames = 0;
+    while (num_frames < max_frames && position + taps_ <= history_size) {
+      const float* coefficients = &coefficients_[phase * taps_];
+      if (taps_ == kTapsPerPhase) {
+        output[num_frames] =
+            dot_product(coefficients, &samples[position], kTapsPerPhase);
+      } else {
+        output[num_frames] =
+            dot_product(coefficients, &samples[position], taps_);
+      }
+      num_frames++;
+      position += position_step_;
+      phase += phase_step_;
+      if (phase >= interpolation_) {
+        phase -= interpolation_;
+        position++;
+      }
+    }
+    // All channels advance the same way
+    if (channel + 1 == dst_channel_count_) {
+      position_ = position;
+      phase_ = phase;
+    }
+  }
+  return num_frames;
+}
+
+size_t A2dpPcmResampler::EncodeFrames(size_t num_frames, uint8_t* dst) {
+  size_t sample_size = dst_bits_per_sample_ / 8;
+  uint8_t* p = dst;
+  for (size_t i = 0; i < num_frames; i++) {
+    for (size_t channel = 0; channel < dst_channel_count_; channel++) {
+      write_sample(output_[channel][i], dst_bits_per_sample_, p);
+      p += sample_size;
+    }
+  }
+  return p - dst;
+}
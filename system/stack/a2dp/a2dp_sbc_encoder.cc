@@ -25,8 +25,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_media_buffer.h"
+#include "a2dp_pcm_resampler.h"
 #include "a2dp_sbc.h"
-#include "a2dp_sbc_up_sample.h"
 #include "common/time_util.h"
 #include "embdrv/sbc/encoder/include/sbc_encoder.h"
 #include "osi/include/allocator.h"
@@ -69,7 +70,6 @@
 
 typedef struct {
   uint32_t aa_frame_counter;
-  int32_t aa_feed_counter;
   int32_t aa_feed_residue;
   float counter;
   uint32_t bytes_per_tick; /* pcm bytes read each media task tick */
@@ -108,6 +108,9 @@ typedef struct {
 
 static tA2DP_SBC_ENCODER_CB a2dp_sbc_encoder_cb;
 
+// Used when the feeding rate differs from the SBC sampling rate
+static A2dpPcmResampler a2dp_sbc_resampler;
+
 static void a2dp_sbc_encoder_update(A2dpCodecConfig* a2dp_codec_config,
                                     bool* p_restart_input,
                                     bool* p_restart_output,
@@ -357,11 +360,13 @@ void a2dp_sbc_feeding_reset(void) {
 
   LOG_INFO("%s: PCM bytes per tick %u", __func__,
            a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
+  a2dp_sbc_resampler.Reset();
 }
 
 void a2dp_sbc_feeding_flush(void) {
   a2dp_sbc_encoder_cb.feeding_state.counter = 0.0f;
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
+  a2dp_sbc_resampler.Reset();
 }
 
 uint64_t a2dp_sbc_get_encoder_interval_ms(void) {
@@ -372,6 +377,11 @@ int a2dp_sbc_get_effective_frame_size() {
   return a2dp_sbc_encoder_cb.TxAaMtuSize;
 }
 
+size_t a2dp_sbc_get_media_buffer_size() {
+  // The packets are filled up to the MTU
+  return sizeof(BT_HDR) + A2DP_SBC_OFFSET + a2dp_sbc_encoder_cb.TxAaMtuSize;
+}
+
 void a2dp_sbc_send_frames(uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
@@ -497,7 +507,7 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
   uint8_t last_frame_len = 0;
 
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(A2DP_SBC_BUFFER_SIZE);
+    BT_HDR* p_buf = a2dp_media_buffer_alloc(a2dp_sbc_get_media_buffer_size());
     uint32_t bytes_read = 0;
 
     p_buf->offset = A2DP_SBC_OFFSET;
@@ -574,14 +584,11 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   static uint16_t up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
                                     SBC_MAX_NUM_OF_CHANNELS *
                                     SBC_MAX_NUM_OF_SUBBANDS * 2];
+  /* Large enough to down-sample from up to 4 times the SBC sampling rate */
   static uint16_t read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
                               SBC_MAX_NUM_OF_CHANNELS *
-                              SBC_MAX_NUM_OF_SUBBANDS];
-  uint32_t src_size_used;
+                              SBC_MAX_NUM_OF_SUBBANDS * 4];
   uint32_t dst_size_used;
-  bool fract_needed;
-  int32_t fract_max;
-  int32_t fract_threshold;
   uint32_t nb_byte_read;
 
   /* Get the SBC sampling rate */
@@ -622,48 +629,31 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
     return true;
   }
 
-  /*
-   * Some Feeding PCM frequencies require to split the number of sample
-   * to read.
-   * E.g 128 / 6 = 21.3333 => read 22 and 21 and 21 => max = 2; threshold = 0
-   */
-  fract_needed = false; /* Default */
-  switch (a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
-    case 32000:
-    case 8000:
-      fract_needed = true;
-      fract_max = 2;       /* 0, 1 and 2 */
-      fract_threshold = 0; /* Add one for the first */
-      break;
-    case 16000:
-      fract_needed = true;
-      fract_max = 2;       /* 0, 1 and 2 */
-      fract_threshold = 1; /* Add one for the first two frames*/
-      break;
+  /* The resampler keeps its filter state across reads */
+  if (!a2dp_sbc_resampler.Configure(
+          a2dp_sbc_encoder_cb.feeding_params.sample_rate,
+          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
+          a2dp_sbc_encoder_cb.feeding_params.channel_count, sbc_sampling,
+          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
+          p_encoder_params->s16NumOfChannels)) {
+    return false;
   }
 
-  /* Compute number of sample to read from source */
-  src_samples = blocm_x_subband;
-  src_samples *= a2dp_sbc_encoder_cb.feeding_params.sample_rate;
-  src_samples /= sbc_sampling;
-
-  /* The previous division may have a remainder not null */
-  if (fract_needed) {
-    if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter <= fract_threshold) {
-      src_samples++; /* for every read before threshold add one sample */
-    }
-
-    /* do nothing if counter >= threshold */
-    a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter++; /* one more read */
-    if (a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter > fract_max) {
-      a2dp_sbc_encoder_cb.feeding_state.aa_feed_counter = 0;
-    }
-  }
+  /*
+   * Compute number of sample to read from source, the resampler carries the
+   * remainder of the division over to the next reads.
+   */
+  src_samples = a2dp_sbc_resampler.GetSourceFrames(blocm_x_subband);
 
   /* Compute number of bytes to read from source */
   read_size = src_samples;
   read_size *= a2dp_sbc_encoder_cb.feeding_params.channel_count;
   read_size *= (a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8);
+  if (read_size > sizeof(read_buffer)) {
+    LOG_ERROR("%s: cannot resample %u Hz to %u Hz", __func__,
+              a2dp_sbc_encoder_cb.feeding_params.sample_rate, sbc_sampling);
+    return false;
+  }
   a2dp_sbc_encoder_cb.stats.media_read_total_expected_read_bytes += read_size;
 
   /* Read Data from UIPC channel */
@@ -680,23 +670,16 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   }
   a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
 
-  /* Initialize PCM up-sampling engine */
-  a2dp_sbc_init_up_sample(a2dp_sbc_encoder_cb.feeding_params.sample_rate,
-                          sbc_sampling,
-                          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
-                          a2dp_sbc_encoder_cb.feeding_params.channel_count);
-
   /*
    * Re-sample the read buffer.
-   * The output PCM buffer will be stereo, 16 bit per sample.
+   * The output PCM buffer has the SBC channel count.
    */
-  dst_size_used = a2dp_sbc_up_sample(
-      (uint8_t*)read_buffer,
+  dst_size_used = a2dp_sbc_resampler.Convert(
+      (uint8_t*)read_buffer, nb_byte_read,
       (uint8_t*)up_sampled_buffer +
           a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      nb_byte_read, sizeof(up_sampled_buffer) -
-                        a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      &src_size_used);
+      sizeof(up_sampled_buffer) -
+          a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
 
   /* update the residue */
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue += dst_size_used;
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_media_buffer.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx_hd.h"
 #include "common/time_util.h"
@@ -61,6 +62,8 @@ static tAPTX_HD_API aptx_hd_api;
                     A2DP_VendorUnloadEncoderAptxHd, symbol_name, api_type)
 
 #define A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ 4096
+// Largest aptx_hd_bytes set by aptx_hd_update_framing_params()
+#define A2DP_APTX_HD_MAX_BYTES_PER_PACKET 648
 
 typedef struct {
   uint64_t sleep_time_ns;
@@ -322,12 +325,18 @@ int a2dp_vendor_aptx_hd_get_effective_frame_size() {
   return a2dp_aptx_hd_encoder_cb.peer_params.peer_mtu;
 }
 
+size_t a2dp_vendor_aptx_hd_get_media_buffer_size() {
+  return sizeof(BT_HDR) + A2DP_APTX_HD_OFFSET +
+         A2DP_APTX_HD_MAX_BYTES_PER_PACKET;
+}
+
 void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   tAPTX_HD_FRAMING_PARAMS* framing_params =
       &a2dp_aptx_hd_encoder_cb.framing_params;
 
   // Prepare the packet to send
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+  BT_HDR* p_buf =
+      a2dp_media_buffer_alloc(a2dp_vendor_aptx_hd_get_media_buffer_size());
   p_buf->offset = A2DP_APTX_HD_OFFSET;
   p_buf->len = 0;
   p_buf->layer_specific = 0;
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_media_buffer.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_ldac.h"
 #include "common/time_util.h"
@@ -364,6 +365,11 @@ int a2dp_vendor_ldac_get_effective_frame_size() {
   return a2dp_ldac_encoder_cb.TxAaMtuSize;
 }
 
+size_t a2dp_vendor_ldac_get_media_buffer_size() {
+  // The encoder library is configured to fill the packets up to the MTU
+  return sizeof(BT_HDR) + A2DP_LDAC_OFFSET + a2dp_ldac_encoder_cb.TxAaMtuSize;
+}
+
 void a2dp_vendor_ldac_send_frames(uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
@@ -462,7 +468,8 @@ static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
 
   uint32_t bytes_read = 0;
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    BT_HDR* p_buf =
+        a2dp_media_buffer_alloc(a2dp_vendor_ldac_get_media_buffer_size());
     p_buf->offset = A2DP_LDAC_OFFSET;
     p_buf->len = 0;
     p_buf->layer_specific = 0;
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "a2dp_pcm_resampler.h"
+#include "a2dp_sbc_up_sample.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// One SBC frame of 16 blocks and 8 subbands
+constexpr size_t kBlockFrames = 128;
+constexpr size_t kNumBlocks = 400;
+constexpr double kToneHz = 1000;
+
+std::vector<int16_t> make_tone(uint32_t sample_rate, size_t num_frames) {
+  std::vector<int16_t> pcm;
+  for (size_t i = 0; i < num_frames; i++) {
+    int16_t sample = static_cast<int16_t>(
+        std::lrint(16384 * std::sin(2 * M_PI * kToneHz * i / sample_rate)));
+    pcm.push_back(sample);
+    pcm.push_back(sample);
+  }
+  return pcm;
+}
+
+// Ratio in dB of the tone power to the error power, skipping the first block
+double signal_to_noise_db(const std::vector<int16_t>& stereo,
+                          uint32_t sample_rate) {
+  double signal = 0;
+  double noise = 0;
+  for (size_t i = kBlockFrames; i < stereo.size() / 2; i++) {
+    double expected = 16384 * std::sin(2 * M_PI * kToneHz * i / sample_rate);
+    double error = stereo[i * 2] - expected;
+    signal += expected * expected;
+    noise += error * error;
+  }
+  return 10 * std::log10(signal / noise);
+}
+
+// Converts kNumBlocks blocks of 16 bits stereo PCM with the SBC up-sampler,
+// initialized before each block as a2dp_sbc_read_feeding used to.
+static void BM_SbcUpSample(State& state) {
+  uint32_t src_rate = state.range(0);
+  uint32_t dst_rate = state.range(1);
+  size_t src_frames = kBlockFrames * src_rate / dst_rate;
+  std::vector<int16_t> src = make_tone(src_rate, src_frames * kNumBlocks);
+  std::vector<int16_t> dst;
+  for (auto _ : state) {
+    dst.clear();
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      uint16_t out[kBlockFrames * 2 * 2];
+      uint32_t src_used;
+      a2dp_sbc_init_up_sample(src_rate, dst_rate, 16, 2);
+      int len = a2dp_sbc_up_sample(&src[block * src_frames * 2], out,
+                                   src_frames * 4, sizeof(out), &src_used);
+      dst.insert(dst.end(), out, out + len / 2);
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumBlocks * kBlockFrames);
+  state.counters["snr_db"] = signal_to_noise_db(dst, dst_rate);
+}
+BENCHMARK(BM_SbcUpSample)->Args({16000, 48000})->Args({32000, 48000});
+
+// Same conversion with the polyphase resampler
+static void BM_PcmResampler(State& state) {
+  uint32_t src_rate = state.range(0);
+  uint32_t dst_rate = state.range(1);
+  std::vector<int16_t> src =
+      make_tone(src_rate, kBlockFrames * kNumBlocks * 4);
+  std::vector<int16_t> dst;
+  A2dpPcmResampler resampler;
+  resampler.Configure(src_rate, 16, 2, dst_rate, 16, 2);
+  for (auto _ : state) {
+    resampler.Reset();
+    dst.clear();
+    size_t src_frame = 0;
+    for (size_t block = 0; block < kNumBlocks; block++) {
+      int16_t out[kBlockFrames * 2];
+      size_t src_frames = resampler.GetSourceFrames(kBlockFrames);
+      size_t len = resampler.Convert(
+          reinterpret_cast<const uint8_t*>(&src[src_frame * 2]),
+          src_frames * 4, reinterpret_cast<uint8_t*>(out), sizeof(out));
+      dst.insert(dst.end(), out, out + len / 2);
+      src_frame += src_frames;
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumBlocks * kBlockFrames);
+  state.counters["snr_db"] = signal_to_noise_db(dst, dst_rate);
+}
+BENCHMARK(BM_PcmResampler)
+    ->Args({16000, 48000})
+    ->Args({32000, 48000})
+    ->Args({44100, 48000})
+    ->Args({48000, 44100});
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "internal_include/bt_trace.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
+#include "stack/btm/btm_int_types.h"
+#include "stack/l2cap/l2c_int.h"
+
+using ::benchmark::State;
+
+tBTM_CB btm_cb;
+extern tL2C_CB l2cb;
+
+// Global trace level referred in the code under test
+uint8_t appl_trace_level = BT_TRACE_LEVEL_NONE;
+
+extern "C" void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr size_t kSdusPerIteration = 16;
+
+size_t received_bytes = 0;
+
+void on_data_ind(uint16_t local_cid, BT_HDR* p_buf) {
+  received_bytes += p_buf->len;
+  osi_free(p_buf);
+}
+
+// Sends SDUs of state.range(0) bytes from a channel to another one with a MPS
+// of state.range(1), passing each K-frame from the transmit path to the
+// receive path as the link does
+void BM_LeCocLoopback(State& state) {
+  size_t sdu_size = state.range(0);
+  uint16_t mps = state.range(1);
+
+  l2cb = {};
+  l2cb.rcb_pool[0].api.pL2CA_DataInd_Cb = on_data_ind;
+
+  tL2C_CCB* tx_ccb = &l2cb.ccb_pool[0];
+  tx_ccb->in_use = true;
+  tx_ccb->remote_cid = 0x0041;
+  tx_ccb->peer_conn_cfg.mps = mps;
+  tx_ccb->xmit_hold_q = fixed_queue_new(SIZE_MAX);
+
+  tL2C_CCB* rx_ccb = &l2cb.ccb_pool[1];
+  rx_ccb->in_use = true;
+  rx_ccb->chnl_state = CST_OPEN;
+  rx_ccb->p_rcb = &l2cb.rcb_pool[0];
+  rx_ccb->is_first_seg = true;
+  rx_ccb->local_conn_cfg.mtu = sdu_size;
+  rx_ccb->local_conn_cfg.mps = mps;
+
+  std::vector<uint8_t> data(sdu_size);
+  for (size_t i = 0; i < sdu_size; i++) data[i] = static_cast<uint8_t>(i);
+
+  received_bytes = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kSdusPerIteration; i++) {
+      BT_HDR* p_sdu =
+          (BT_HDR*)osi_malloc(BT_HDR_SIZE + L2CAP_MIN_OFFSET + sdu_size);
+      p_sdu->offset = L2CAP_MIN_OFFSET;
+      p_sdu->len = sdu_size;
+      p_sdu->event = 0;
+      memcpy((uint8_t*)(p_sdu + 1) + p_sdu->offset, data.data(), sdu_size);
+      fixed_queue_enqueue(tx_ccb->xmit_hold_q, p_sdu);
+
+      bool last_piece_of_sdu = false;
+      while (!last_piece_of_sdu) {
+        BT_HDR* p_xmit =
+            l2c_lcc_get_next_xmit_sdu_seg(tx_ccb, &last_piece_of_sdu);
+        p_xmit->offset += L2CAP_PKT_OVERHEAD;
+        p_xmit->len -= L2CAP_PKT_OVERHEAD;
+        l2c_lcc_proc_pdu(rx_ccb, p_xmit);
+      }
+    }
+  }
+  benchmark::DoNotOptimize(received_bytes);
+  state.SetBytesProcessed(state.iterations() * kSdusPerIteration * sdu_size);
+
+  fixed_queue_free(tx_ccb->xmit_hold_q, osi_free);
+  l2cb = {};
+}
+BENCHMARK(BM_LeCocLoopback)
+    ->Args({64, 251})
+    ->Args({512, 251})
+    ->Args({4096, 251})
+    ->Args({4096, 1004});
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mock_btm_layer.h"
+#include "mock_l2cap_layer.h"
+#include "osi/include/allocator.h"
+#include "stack/include/bt_hdr.h"
+#include "stack/include/l2c_api.h"
+#include "stack/include/port_api.h"
+#include "stack/rfcomm/rfc_int.h"
+#include "stack_rfcomm_test_utils.h"
+#include "stack_test_packet_utils.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+using bluetooth::AllocateWrappedIncomingL2capAclPacket;
+using bluetooth::rfcomm::CreateQuickDataPacket;
+using bluetooth::rfcomm::CreateQuickMscPacket;
+using bluetooth::rfcomm::CreateQuickPnPacket;
+using bluetooth::rfcomm::CreateQuickSabmPacket;
+using bluetooth::rfcomm::GetDlci;
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+extern "C" void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+namespace {
+
+constexpr uint16_t kAclHandle = 0x0009;
+constexpr uint16_t kLcid = 0x0054;
+constexpr uint16_t kSppUuid = 0x1101;
+constexpr uint8_t kScn = 8;
+constexpr uint16_t kMtu = 1600;
+constexpr uint8_t kCmdId = 0x07;
+
+uint64_t bytes_from_peer = 0;
+uint64_t bytes_to_peer = 0;
+int app_pending = 0;
+std::vector<uint8_t> app_data;
+
+// Stands in for btif_sock_rfc: incoming buffers are taken over as they are and
+// outgoing data is read straight into the RFCOMM buffer
+int loopback_data_co_cback(uint16_t /* port_handle */, uint8_t* p_buf,
+                           uint16_t len, int type) {
+  switch (type) {
+    case DATA_CO_CALLBACK_TYPE_INCOMING: {
+      BT_HDR* p_hdr = reinterpret_cast<BT_HDR*>(p_buf);
+      bytes_from_peer += p_hdr->len;
+      osi_free(p_hdr);
+      return true;
+    }
+    case DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE:
+      *reinterpret_cast<int*>(p_buf) = app_pending;
+      return true;
+    case DATA_CO_CALLBACK_TYPE_OUTGOING:
+      memcpy(p_buf, app_data.data(), len);
+      app_pending -= len;
+      bytes_to_peer += len;
+      return true;
+  }
+  return false;
+}
+
+void port_cback(uint32_t /* code */, uint16_t /* port_handle */) {}
+
+// Fake L2CAP and security layers: everything is accepted and every frame
+// sent to the peer is dropped
+class SppLoopback {
+ public:
+  SppLoopback() {
+    bluetooth::manager::SetMockSecurityInternalInterface(&btm_security_);
+    bluetooth::l2cap::SetMockInterface(&l2cap_);
+    ON_CALL(l2cap_, Register(BT_PSM_RFCOMM, _, _, _))
+        .WillByDefault(
+            DoAll(SaveArg<1>(&l2cap_appl_info_), Return(BT_PSM_RFCOMM)));
+    ON_CALL(l2cap_, ConnectResponse(_, _, _, _, _)).WillByDefault(Return(true));
+    ON_CALL(l2cap_, ConfigRequest(_, _)).WillByDefault(Return(true));
+    ON_CALL(l2cap_, ConfigResponse(_, _)).WillByDefault(Return(true));
+    ON_CALL(l2cap_, DataWrite(_, _))
+        .WillByDefault(Invoke([](uint16_t /* cid */, BT_HDR* p_buf) {
+          osi_free(p_buf);
+          return static_cast<uint8_t>(L2CAP_DW_SUCCESS);
+        }));
+    ON_CALL(btm_security_,
+            MultiplexingProtocolAccessRequest(_, _, _, _, _, _, _))
+        .WillByDefault(DoAll(SaveArg<5>(&security_callback_),
+                             SaveArg<6>(&security_ref_data_),
+                             Return(BTM_SUCCESS)));
+    RFCOMM_Init();
+  }
+
+  ~SppLoopback() {
+    bluetooth::l2cap::SetMockInterface(nullptr);
+    bluetooth::manager::SetMockSecurityInternalInterface(nullptr);
+  }
+
+  // Runs the server side of an SPP connection from a peer, as
+  // StackRfcommTest does, and returns the port handle or 0 on failure
+  uint16_t Connect(const RawAddress& peer_addr) {
+    uint16_t handle = 0;
+    if (RFCOMM_CreateConnection(kSppUuid, kScn, true, kMtu, RawAddress::kAny,
+                                &handle, port_cback) != PORT_SUCCESS ||
+        PORT_SetDataCOCallback(handle, loopback_data_co_cback) !=
+            PORT_SUCCESS) {
+      return 0;
+    }
+
+    // L2CAP channel and multiplexer
+    l2cap_appl_info_.pL2CA_ConnectInd_Cb(peer_addr, kLcid, BT_PSM_RFCOMM,
+                                         kCmdId);
+    l2cap_appl_info_.pL2CA_ConfigCfm_Cb(kLcid, L2CAP_CFG_OK, {});
+    tL2CAP_CFG_INFO cfg = {.mtu_present = true, .mtu = L2CAP_MTU_SIZE};
+    l2cap_appl_info_.pL2CA_ConfigInd_Cb(kLcid, &cfg);
+    ReceiveFromPeer(CreateQuickSabmPacket(RFCOMM_MX_DLCI, kLcid, kAclHandle));
+
+    // Server channel, with credit based flow control
+    uint8_t dlci = GetDlci(false, kScn);
+    ReceiveFromPeer(CreateQuickPnPacket(true, dlci, true, kMtu,
+                                        RFCOMM_PN_CONV_LAYER_CBFC_I >> 4, 0,
+                                        RFCOMM_K_MAX, kLcid, kAclHandle));
+    ReceiveFromPeer(CreateQuickSabmPacket(dlci, kLcid, kAclHandle));
+    if (security_callback_ == nullptr) {
+      return 0;
+    }
+    security_callback_(&peer_addr, BT_TRANSPORT_BR_EDR, security_ref_data_,
+                       BTM_SUCCESS);
+    ReceiveFromPeer(CreateQuickMscPacket(true, dlci, kLcid, kAclHandle, true,
+                                         false, true, true, false, true));
+    ReceiveFromPeer(CreateQuickMscPacket(true, dlci, kLcid, kAclHandle, false,
+                                         false, true, true, false, true));
+    return handle;
+  }
+
+  void ReceiveFromPeer(const std::vector<uint8_t>& packet) {
+    l2cap_appl_info_.pL2CA_DataInd_Cb(
+        kLcid, AllocateWrappedIncomingL2capAclPacket(packet));
+  }
+
+ private:
+  NiceMock<bluetooth::manager::MockBtmSecurityInternalInterface> btm_security_;
+  NiceMock<bluetooth::l2cap::MockL2capInterface> l2cap_;
+  tL2CAP_APPL_INFO l2cap_appl_info_ = {};
+  tBTM_SEC_CALLBACK* security_callback_ = nullptr;
+  void* security_ref_data_ = nullptr;
+};
+
+SppLoopback* loopback = nullptr;
+uint16_t port_handle = 0;
+
+// Echoes SDUs of state.range(0) bytes: each packet from the peer goes up
+// through the incoming data callout, and the same amount goes back down
+// through PORT_WriteDataCO and the outgoing data callouts
+void BM_SppLoopback(State& state) {
+  size_t payload_size = state.range(0);
+  app_data.assign(payload_size, 'x');
+  // Every packet from the peer returns the credit used by the previous echo
+  const std::vector<uint8_t> data_from_peer =
+      CreateQuickDataPacket(GetDlci(false, kScn), true, kLcid, kAclHandle, 1,
+                            std::string(payload_size, 'y'));
+  bytes_from_peer = 0;
+  bytes_to_peer = 0;
+  for (auto _ : state) {
+    loopback->ReceiveFromPeer(data_from_peer);
+    app_pending = payload_size;
+    int written = 0;
+    if (PORT_WriteDataCO(port_handle, &written) != PORT_SUCCESS ||
+        written != static_cast<int>(payload_size)) {
+      state.SkipWithError("Echo was not sent");
+      break;
+    }
+  }
+  if (bytes_from_peer != state.iterations() * payload_size ||
+      bytes_to_peer != state.iterations() * payload_size) {
+    state.SkipWithError("Data was lost");
+  }
+  state.SetBytesProcessed(2 * state.iterations() * payload_size);
+}
+BENCHMARK(BM_SppLoopback)->Arg(127)->Arg(1000);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  SppLoopback spp_loopback;
+  loopback = &spp_loopback;
+  port_handle =
+      spp_loopback.Connect(RawAddress({0xAA, 0x00, 0x11, 0x22, 0x33, 0x00}));
+  if (port_handle == 0) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
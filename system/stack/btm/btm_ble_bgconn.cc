@@ -241,3 +241,21 @@ void BTM_AcceptlistClear() {
   }
   bluetooth::shim::ACL_IgnoreAllLeConnections();
 }
+
+/** Starts collecting the acceptlist changes, to send them together */
+void BTM_AcceptlistBeginBatch() {
+  if (!controller_get_interface()->supports_ble()) {
+    LOG_WARN("Controller does not support Le");
+    return;
+  }
+  bluetooth::shim::ACL_BeginAcceptListBatch();
+}
+
+/** Sends the acceptlist changes collected since BTM_AcceptlistBeginBatch() */
+void BTM_AcceptlistEndBatch() {
+  if (!controller_get_interface()->supports_ble()) {
+    LOG_WARN("Controller does not support Le");
+    return;
+  }
+  bluetooth::shim::ACL_EndAcceptListBatch();
+}
@@ -28,6 +28,12 @@ extern void BTM_AcceptlistRemove(const RawAddress& address);
 /** Clear the acceptlist, end any pending acceptlist connections */
 extern void BTM_AcceptlistClear();
 
+/** The acceptlist changes made until BTM_AcceptlistEndBatch() are sent to the
+ * controller together. Batches may overlap, the changes being sent when the
+ * last one ends. */
+extern void BTM_AcceptlistBeginBatch();
+extern void BTM_AcceptlistEndBatch();
+
 /* Use fast scan window/interval for LE connection establishment.
  * This does not send any requests to controller, instead it changes the
  * parameters that will be used after next add/remove request.
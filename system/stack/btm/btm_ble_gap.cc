@@ -2781,7 +2781,7 @@ void btm_ble_process_adv_pkt_cont_for_inquiry(
     uint16_t evt_type, tBLE_ADDR_TYPE addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int,
-    std::vector<uint8_t> advertising_data) {
+    std::vector<uint8_t> const& advertising_data) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
 
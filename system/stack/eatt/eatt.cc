@@ -179,6 +179,12 @@ EattChannel* EattExtension::GetChannelAvailableForClientRequest(
   return pimpl_->eatt_impl_->get_channel_available_for_client_request(bd_addr);
 }
 
+EattChannel* EattExtension::GetChannelAvailableForNotification(
+    const RawAddress& bd_addr, uint16_t len) {
+  return pimpl_->eatt_impl_->get_channel_available_for_notification(bd_addr,
+                                                                    len);
+}
+
 /* Start stop GATT indication timer per CID */
 void EattExtension::StartIndicationConfirmationTimer(const RawAddress& bd_addr,
                                                      uint16_t cid) {
@@ -201,6 +207,11 @@ void EattExtension::StopAppIndicationTimer(const RawAddress& bd_addr,
   pimpl_->eatt_impl_->stop_app_indication_timer(bd_addr, cid);
 }
 
+void EattExtension::Dump(int fd) {
+  eatt_impl* p_eatt_impl = EattExtension::impl::GetImplInstance();
+  if (p_eatt_impl) p_eatt_impl->dump(fd);
+}
+
 void EattExtension::Start() { pimpl_->Start(); }
 
 void EattExtension::Stop() { pimpl_->Stop(); }
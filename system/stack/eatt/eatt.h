@@ -54,6 +54,11 @@ class EattChannel {
   alarm_t* ind_confirmation_timer_;
   /* GATT client command queue */
   std::queue<tGATT_CMD_Q> cl_cmd_q_;
+  /* Operations sent on the channel, used to balance the load of the channels
+   * and dumped in dumpsys */
+  uint32_t num_client_requests_;
+  uint32_t num_notifications_;
+  uint32_t num_indications_;
 
   EattChannel(RawAddress& bda, uint16_t cid, uint16_t tx_mtu, uint16_t rx_mtu)
       : bda_(bda),
@@ -63,7 +68,10 @@ class EattChannel {
         state_(EattChannelState::EATT_CHANNEL_PENDING),
         indicate_handle_(0),
         ind_ack_timer_(NULL),
-        ind_confirmation_timer_(NULL) {}
+        ind_confirmation_timer_(NULL),
+        num_client_requests_(0),
+        num_notifications_(0),
+        num_indications_(0) {}
 
   ~EattChannel() {
     if (ind_ack_timer_ != NULL) {
@@ -93,6 +101,9 @@ class EattChannel {
     state_ = state;
   }
   void EattChannelSetTxMTU(uint16_t tx_mtu) { this->tx_mtu_ = tx_mtu; }
+  uint32_t EattChannelGetNumOperations() const {
+    return num_client_requests_ + num_notifications_ + num_indications_;
+  }
 };
 
 /* Interface class */
@@ -187,7 +198,8 @@ class EattExtension {
                                    uint16_t indication_handle);
 
   /**
-   * Get EATT channel available for indication.
+   * Get the least loaded EATT channel not waiting for an indication
+   * confirmation.
    *
    * @param bd_addr peer device address
    *
@@ -224,7 +236,9 @@ class EattExtension {
   virtual EattChannel* GetChannelWithQueuedData(const RawAddress& bd_addr);
 
   /**
-   * Get EATT channel available to send GATT request.
+   * Get EATT channel available to send GATT request, which is the connected
+   * channel with the fewest queued requests. Channels with the same number of
+   * queued requests share the requests in proportion of their MTU.
    *
    * @param bd_addr peer device address
    *
@@ -233,6 +247,18 @@ class EattExtension {
   virtual EattChannel* GetChannelAvailableForClientRequest(
       const RawAddress& bd_addr);
 
+  /**
+   * Get EATT channel to send a notification, which is the least loaded
+   * connected channel whose MTU fits the notified value.
+   *
+   * @param bd_addr peer device address
+   * @param len length of the notified value
+   *
+   * @return pointer to EATT channel, nullptr if no channel fits the value.
+   */
+  virtual EattChannel* GetChannelAvailableForNotification(
+      const RawAddress& bd_addr, uint16_t len);
+
   /**
    * Start GATT indication timer per CID.
    *
@@ -267,6 +293,13 @@ class EattExtension {
    */
   virtual void StopAppIndicationTimer(const RawAddress& bd_addr, uint16_t cid);
 
+  /**
+   * Dumps the EATT channels and their statistics.
+   *
+   * @param fd file descriptor to dump into
+   */
+  static void Dump(int fd);
+
   /**
    * Starts the EattExtension module
    */
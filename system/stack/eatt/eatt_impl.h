@@ -17,6 +17,7 @@
 
 #include <base/logging.h>
 
+#include <functional>
 #include <map>
 #include <queue>
 
@@ -385,31 +386,56 @@ struct eatt_impl {
     return (iter != eatt_dev->eatt_channels.end());
   };
 
-  EattChannel* get_channel_available_for_indication(const RawAddress& bd_addr) {
+  /* Channels are ordered by the number of client requests queued on them,
+   * then by the number of operations sent on them relative to their MTU, so
+   * that the channels are used in turn, each in proportion of its MTU.
+   */
+  static bool is_less_loaded(const EattChannel& a, const EattChannel& b) {
+    if (a.cl_cmd_q_.size() != b.cl_cmd_q_.size())
+      return a.cl_cmd_q_.size() < b.cl_cmd_q_.size();
+
+    return static_cast<uint64_t>(a.EattChannelGetNumOperations()) * b.tx_mtu_ <
+           static_cast<uint64_t>(b.EattChannelGetNumOperations()) * a.tx_mtu_;
+  }
+
+  EattChannel* find_least_loaded_channel(
+      const RawAddress& bd_addr,
+      const std::function<bool(const EattChannel&)>& is_available) {
     eatt_device* eatt_dev = find_device_by_address(bd_addr);
-    auto iter = find_if(
-        eatt_dev->eatt_channels.begin(), eatt_dev->eatt_channels.end(),
-        [](const std::pair<uint16_t, std::shared_ptr<EattChannel>>& el) {
-          return !GATT_HANDLE_IS_VALID(el.second->indicate_handle_);
-        });
+    if (!eatt_dev) return nullptr;
 
-    return (iter == eatt_dev->eatt_channels.end()) ? nullptr
-                                                   : iter->second.get();
+    EattChannel* least_loaded = nullptr;
+    for (const auto& el : eatt_dev->eatt_channels) {
+      EattChannel* channel = el.second.get();
+      if (channel->state_ == EattChannelState::EATT_CHANNEL_PENDING ||
+          !is_available(*channel))
+        continue;
+
+      if (!least_loaded || is_less_loaded(*channel, *least_loaded))
+        least_loaded = channel;
+    }
+
+    return least_loaded;
+  }
+
+  EattChannel* get_channel_available_for_indication(const RawAddress& bd_addr) {
+    return find_least_loaded_channel(bd_addr, [](const EattChannel& channel) {
+      return !GATT_HANDLE_IS_VALID(channel.indicate_handle_);
+    });
   };
 
   EattChannel* get_channel_available_for_client_request(
       const RawAddress& bd_addr) {
-    eatt_device* eatt_dev = find_device_by_address(bd_addr);
-    if (!eatt_dev) return nullptr;
+    return find_least_loaded_channel(
+        bd_addr, [](const EattChannel& channel) { return true; });
+  }
 
-    auto iter = find_if(
-        eatt_dev->eatt_channels.begin(), eatt_dev->eatt_channels.end(),
-        [](const std::pair<uint16_t, std::shared_ptr<EattChannel>>& el) {
-          return el.second->cl_cmd_q_.empty();
+  EattChannel* get_channel_available_for_notification(const RawAddress& bd_addr,
+                                                      uint16_t len) {
+    return find_least_loaded_channel(
+        bd_addr, [len](const EattChannel& channel) {
+          return channel.tx_mtu_ >= len + GATT_HDR_SIZE;
         });
-
-    return (iter == eatt_dev->eatt_channels.end()) ? nullptr
-                                                   : iter->second.get();
   }
 
   void free_gatt_resources(const RawAddress& bd_addr) {
@@ -663,6 +689,31 @@ struct eatt_impl {
     }
   }
 
+  void dump(int fd) {
+    dprintf(fd, "\nEATT state:\n");
+    if (devices_.empty()) {
+      dprintf(fd, "\tno EATT devices\n");
+      return;
+    }
+
+    for (const eatt_device& eatt_dev : devices_) {
+      dprintf(fd, "\t * %s: channels: %d\n", eatt_dev.bda_.ToString().c_str(),
+              (int)eatt_dev.eatt_channels.size());
+
+      for (const auto& el : eatt_dev.eatt_channels) {
+        const EattChannel* channel = el.second.get();
+        dprintf(fd,
+                "\t\tcid: 0x%04x, state: %d, tx mtu: %d, rx mtu: %d, "
+                "queued requests: %d, requests: %u, notifications: %u, "
+                "indications: %u\n",
+                channel->cid_, static_cast<int>(channel->state_),
+                channel->tx_mtu_, channel->rx_mtu_,
+                (int)channel->cl_cmd_q_.size(), channel->num_client_requests_,
+                channel->num_notifications_, channel->num_indications_);
+      }
+    }
+  }
+
   void add_from_storage(const RawAddress& bd_addr) {
     eatt_device* eatt_dev = find_device_by_address(bd_addr);
 
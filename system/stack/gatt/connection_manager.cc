@@ -18,14 +18,14 @@
 
 #include "connection_manager.h"
 
-#include <base/bind.h>
-#include <base/callback.h>
-#include <base/location.h>
 #include <base/logging.h>
 
+#include <array>
 #include <map>
-#include <memory>
 #include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "internal_include/bt_trace.h"
 #include "main/shim/shim.h"
@@ -36,30 +36,7 @@
 #include "types/raw_address.h"
 
 #define DIRECT_CONNECT_TIMEOUT (30 * 1000) /* 30 seconds */
-
-struct closure_data {
-  base::OnceClosure user_task;
-  base::Location posted_from;
-};
-
-static void alarm_closure_cb(void* p) {
-  closure_data* data = (closure_data*)p;
-  VLOG(1) << "executing timer scheduled at %s" << data->posted_from.ToString();
-  std::move(data->user_task).Run();
-  delete data;
-}
-
-// Periodic alarms are not supported, because we clean up data in callback
-void alarm_set_closure(const base::Location& posted_from, alarm_t* alarm,
-                       uint64_t interval_ms, base::OnceClosure user_task) {
-  closure_data* data = new closure_data;
-  data->posted_from = posted_from;
-  data->user_task = std::move(user_task);
-  VLOG(1) << "scheduling timer %s" << data->posted_from.ToString();
-  alarm_set_on_mloop(alarm, interval_ms, alarm_closure_cb, data);
-}
-
-using unique_alarm_ptr = std::unique_ptr<alarm_t, decltype(&alarm_free)>;
+#define DIRECT_CONNECT_TIMEOUT_TICK (1000) /* 1 second */
 
 namespace connection_manager {
 
@@ -67,20 +44,132 @@ struct tAPPS_CONNECTING {
   // ids of clients doing background connection to given device
   std::set<tAPP_ID> doing_bg_conn;
 
-  // Apps trying to do direct connection.
-  std::map<tAPP_ID, unique_alarm_ptr> doing_direct_conn;
+  // Apps trying to do direct connection, with the slot of the timeout wheel
+  // their attempt expires in.
+  std::map<tAPP_ID, size_t> doing_direct_conn;
 };
 
 namespace {
-// Maps address to apps trying to connect to it
-std::map<RawAddress, tAPPS_CONNECTING> bgconn_dev;
+using bgconn_dev_iterator =
+    std::unordered_map<RawAddress, tAPPS_CONNECTING>::iterator;
 
-bool anyone_connecting(
-    const std::map<RawAddress, tAPPS_CONNECTING>::iterator it) {
+// Maps address to apps trying to connect to it
+std::unordered_map<RawAddress, tAPPS_CONNECTING> bgconn_dev;
+
+// Maps app to the devices it is doing background or direct connection to
+std::unordered_map<tAPP_ID, std::set<RawAddress>> app_devices;
+
+// Number of direct connection attempts, to all devices
+size_t num_direct_connections = 0;
+
+/* Direct connection attempts all time out on a single alarm. The attempts are
+ * kept in a wheel of slots, the alarm moving the wheel by one slot every
+ * DIRECT_CONNECT_TIMEOUT_TICK. An attempt is put in the current slot, and
+ * times out when the wheel comes back to it, DIRECT_CONNECT_TIMEOUT later. The
+ * alarm only runs while there are attempts. */
+constexpr size_t kTimeoutWheelSize =
+    DIRECT_CONNECT_TIMEOUT / DIRECT_CONNECT_TIMEOUT_TICK;
+std::array<std::set<std::pair<tAPP_ID, RawAddress>>, kTimeoutWheelSize>
+    timeout_wheel;
+size_t timeout_wheel_slot = 0;
+alarm_t* timeout_alarm = nullptr;
+bool timeout_alarm_running = false;
+
+bool anyone_connecting(const bgconn_dev_iterator it) {
   return (!it->second.doing_bg_conn.empty() ||
           !it->second.doing_direct_conn.empty());
 }
 
+void direct_connect_timeout_tick(void* data);
+
+void start_timeout_alarm() {
+  if (timeout_alarm == nullptr) {
+    timeout_alarm = alarm_new("wl_conn_params_30s");
+  }
+  alarm_set_on_mloop(timeout_alarm, DIRECT_CONNECT_TIMEOUT_TICK,
+                     direct_connect_timeout_tick, nullptr);
+  timeout_alarm_running = true;
+}
+
+/* Removes |app_id| from the apps connecting to the device of |it|. Returns
+ * true if the app is not connecting to the device anymore. */
+bool forget_app_if_not_connecting(tAPP_ID app_id,
+                                  const bgconn_dev_iterator it) {
+  if (it->second.doing_bg_conn.count(app_id) ||
+      it->second.doing_direct_conn.count(app_id)) {
+    return false;
+  }
+  auto app_it = app_devices.find(app_id);
+  if (app_it != app_devices.end()) {
+    app_it->second.erase(it->first);
+    if (app_it->second.empty()) app_devices.erase(app_it);
+  }
+  return true;
+}
+
+/* Removes the direct connection attempt of |app_id| to the device of |it|,
+ * without updating the acceptlist or the scan parameters. */
+void erase_direct_connection(tAPP_ID app_id, const bgconn_dev_iterator it) {
+  auto app_it = it->second.doing_direct_conn.find(app_id);
+  timeout_wheel[app_it->second].erase(std::make_pair(app_id, it->first));
+  it->second.doing_direct_conn.erase(app_it);
+  num_direct_connections--;
+  forget_app_if_not_connecting(app_id, it);
+}
+
+/* Removes the devices of |removed| from the acceptlist, in a single batch when
+ * there are several of them. */
+void acceptlist_remove_batch(const std::vector<RawAddress>& removed) {
+  if (removed.size() > 1) BTM_AcceptlistBeginBatch();
+  for (const RawAddress& address : removed) {
+    BTM_AcceptlistRemove(address);
+  }
+  if (removed.size() > 1) BTM_AcceptlistEndBatch();
+}
+
+/* Called when the last direct connection attempt ended, to stop the timeout
+ * alarm and lower the scan parameters used for connecting. */
+void on_direct_connections_done() {
+  if (timeout_alarm_running) {
+    alarm_cancel(timeout_alarm);
+    timeout_alarm_running = false;
+  }
+  BTM_SetLeConnectionModeToSlow();
+}
+
+/* Moves the timeout wheel by one slot, and removes the attempts of the slot
+ * before notifying their apps, so that the apps can connect again. */
+void direct_connect_timeout_tick(void* data) {
+  timeout_alarm_running = false;
+  timeout_wheel_slot = (timeout_wheel_slot + 1) % kTimeoutWheelSize;
+  std::set<std::pair<tAPP_ID, RawAddress>> expired =
+      std::move(timeout_wheel[timeout_wheel_slot]);
+  timeout_wheel[timeout_wheel_slot].clear();
+
+  std::vector<RawAddress> removed;
+  for (const auto& attempt : expired) {
+    LOG_DEBUG("app_id=%d, address=%s", static_cast<int>(attempt.first),
+              attempt.second.ToString().c_str());
+    auto it = bgconn_dev.find(attempt.second);
+    erase_direct_connection(attempt.first, it);
+    if (!anyone_connecting(it)) {
+      removed.push_back(it->first);
+      bgconn_dev.erase(it);
+    }
+  }
+  acceptlist_remove_batch(removed);
+
+  if (num_direct_connections == 0) {
+    if (!expired.empty()) BTM_SetLeConnectionModeToSlow();
+  } else {
+    start_timeout_alarm();
+  }
+
+  for (const auto& attempt : expired) {
+    on_connection_timed_out(attempt.first, attempt.second);
+  }
+}
+
 }  // namespace
 
 /** background connection device from the list. Returns pointer to the device
@@ -131,6 +220,7 @@ bool background_connect_add(uint8_t app_id, const RawAddress& address) {
   // create entry for address, and insert app_id.
   // new tAPPS_CONNECTING will be default constructed if not exist
   bgconn_dev[address].doing_bg_conn.insert(app_id);
+  app_devices[app_id].insert(address);
   return true;
 }
 
@@ -144,6 +234,19 @@ bool remove_unconditional(const RawAddress& address) {
     return false;
   }
 
+  std::set<tAPP_ID> apps = it->second.doing_bg_conn;
+  it->second.doing_bg_conn.clear();
+  for (tAPP_ID app_id : apps) {
+    forget_app_if_not_connecting(app_id, it);
+  }
+  bool had_direct_connections = !it->second.doing_direct_conn.empty();
+  while (!it->second.doing_direct_conn.empty()) {
+    erase_direct_connection(it->second.doing_direct_conn.begin()->first, it);
+  }
+  if (had_direct_connections && num_direct_connections == 0) {
+    on_direct_connections_done();
+  }
+
   BTM_AcceptlistRemove(address);
   bgconn_dev.erase(it);
   return true;
@@ -166,6 +269,7 @@ bool background_connect_remove(uint8_t app_id, const RawAddress& address) {
              static_cast<int>(app_id), address.ToString().c_str());
     return false;
   }
+  forget_app_if_not_connecting(app_id, it);
 
   if (anyone_connecting(it)) {
     LOG_DEBUG("some device is still connecting, app_id=%d, address=%s",
@@ -182,21 +286,32 @@ bool background_connect_remove(uint8_t app_id, const RawAddress& address) {
 /** deregister all related background connetion device. */
 void on_app_deregistered(uint8_t app_id) {
   LOG_DEBUG("app_id=%d", static_cast<int>(app_id));
-  auto it = bgconn_dev.begin();
-  auto end = bgconn_dev.end();
-  /* update the BG conn device list */
-  while (it != end) {
-    it->second.doing_bg_conn.erase(app_id);
+  auto app_it = app_devices.find(app_id);
+  if (app_it == app_devices.end()) return;
 
-    it->second.doing_direct_conn.erase(app_id);
+  // only the devices of the app are visited
+  std::set<RawAddress> devices = std::move(app_it->second);
+  app_devices.erase(app_it);
 
-    if (anyone_connecting(it)) {
-      it++;
-      continue;
+  bool had_direct_connections = false;
+  std::vector<RawAddress> removed;
+  for (const RawAddress& address : devices) {
+    auto it = bgconn_dev.find(address);
+    it->second.doing_bg_conn.erase(app_id);
+    if (it->second.doing_direct_conn.count(app_id)) {
+      erase_direct_connection(app_id, it);
+      had_direct_connections = true;
     }
 
-    BTM_AcceptlistRemove(it->first);
-    it = bgconn_dev.erase(it);
+    if (anyone_connecting(it)) continue;
+
+    removed.push_back(address);
+    bgconn_dev.erase(it);
+  }
+  acceptlist_remove_batch(removed);
+
+  if (had_direct_connections && num_direct_connections == 0) {
+    on_direct_connections_done();
   }
 }
 
@@ -225,19 +340,17 @@ void on_connection_timed_out_from_shim(const RawAddress& address) {
  * true, as there is no need to wipe controller acceptlist in this case. */
 void reset(bool after_reset) {
   bgconn_dev.clear();
+  app_devices.clear();
+  for (auto& slot : timeout_wheel) slot.clear();
+  num_direct_connections = 0;
+  if (timeout_alarm != nullptr) {
+    alarm_free(timeout_alarm);
+    timeout_alarm = nullptr;
+    timeout_alarm_running = false;
+  }
   if (!after_reset) BTM_AcceptlistClear();
 }
 
-void wl_direct_connect_timeout_cb(uint8_t app_id, const RawAddress& address) {
-  LOG_DEBUG("app_id=%d, address=%s", static_cast<int>(app_id),
-            address.ToString().c_str());
-  on_connection_timed_out(app_id, address);
-
-  // TODO: this would free the timer, from within the timer callback, which is
-  // bad.
-  direct_connect_remove(app_id, address);
-}
-
 /** Add a device to the direcgt connection list.  Returns true if device
  * added to the list, false otherwise */
 bool direct_connect_add(uint8_t app_id, const RawAddress& address) {
@@ -276,24 +389,16 @@ bool direct_connect_add(uint8_t app_id, const RawAddress& address) {
     }
   }
 
-  // Setup a timer
-  alarm_t* timeout = alarm_new("wl_conn_params_30s");
-  alarm_set_closure(
-      FROM_HERE, timeout, DIRECT_CONNECT_TIMEOUT,
-      base::BindOnce(&wl_direct_connect_timeout_cb, app_id, address));
+  // Time the attempt out with the others
+  timeout_wheel[timeout_wheel_slot].emplace(app_id, address);
+  if (!timeout_alarm_running) start_timeout_alarm();
+  num_direct_connections++;
 
-  bgconn_dev[address].doing_direct_conn.emplace(
-      app_id, unique_alarm_ptr(timeout, &alarm_free));
+  bgconn_dev[address].doing_direct_conn.emplace(app_id, timeout_wheel_slot);
+  app_devices[app_id].insert(address);
   return true;
 }
 
-static bool any_direct_connect_left() {
-  for (const auto& tmp : bgconn_dev) {
-    if (!tmp.second.doing_direct_conn.empty()) return true;
-  }
-  return false;
-}
-
 bool direct_connect_remove(uint8_t app_id, const RawAddress& address) {
   LOG_DEBUG("app_id=%d, address=%s", static_cast<int>(app_id),
             address.ToString().c_str());
@@ -303,19 +408,17 @@ bool direct_connect_remove(uint8_t app_id, const RawAddress& address) {
     return false;
   }
 
-  auto app_it = it->second.doing_direct_conn.find(app_id);
-  if (app_it == it->second.doing_direct_conn.end()) {
+  if (!it->second.doing_direct_conn.count(app_id)) {
     LOG_WARN("Unable to find direct connection to remove");
     return false;
   }
 
-  // this will free the alarm
-  it->second.doing_direct_conn.erase(app_it);
+  erase_direct_connection(app_id, it);
 
   // if we removed last direct connection, lower the scan parameters used for
   // connecting
-  if (!any_direct_connect_left()) {
-    BTM_SetLeConnectionModeToSlow();
+  if (num_direct_connections == 0) {
+    on_direct_connections_done();
   }
 
   if (anyone_connecting(it)) {
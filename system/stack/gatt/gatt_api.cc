@@ -132,7 +132,8 @@ static void gatt_update_last_srv_info() {
 
 /** Update database hash and client status */
 static void gatt_update_for_database_change() {
-  gatt_cb.database_hash = gatts_calculate_database_hash(gatt_cb.srv_list_info);
+  // Computed on the next read, so adding many services hashes only once
+  gatt_cb.database_hash_dirty = true;
 
   uint8_t i = 0;
   for (i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
@@ -525,7 +526,8 @@ tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
   tGATT_SR_MSG gatt_sr_msg;
   gatt_sr_msg.attr_value = notif;
 
-  uint16_t cid = gatt_tcb_get_att_cid(*p_tcb, p_reg->eatt_support);
+  uint16_t cid =
+      gatt_tcb_get_cid_for_notification(*p_tcb, p_reg->eatt_support, val_len);
 
   BT_HDR* p_buf =
       attp_build_sr_msg(*p_tcb, GATT_HANDLE_VALUE_NOTIF, &gatt_sr_msg);
@@ -873,7 +873,8 @@ void gatt_sr_init_cl_status(tGATT_TCB& tcb) {
 
   if (gatt_sr_is_cl_robust_caching_supported(tcb)) {
     Octet16 stored_hash = btif_storage_get_gatt_cl_db_hash(tcb.peer_bda);
-    tcb.is_robust_cache_change_aware = (stored_hash == gatt_cb.database_hash);
+    tcb.is_robust_cache_change_aware =
+        (stored_hash == gatts_get_database_hash());
   } else {
     // set default value for untrusted device
     tcb.is_robust_cache_change_aware = true;
@@ -900,7 +901,7 @@ void gatt_sr_update_cl_status(tGATT_TCB& tcb, bool chg_aware) {
   // only when client status is changed from change-unaware to change-aware, we
   // can then store database hash into btif_storage
   if (!tcb.is_robust_cache_change_aware && chg_aware) {
-    btif_storage_set_gatt_cl_db_hash(tcb.peer_bda, gatt_cb.database_hash);
+    btif_storage_set_gatt_cl_db_hash(tcb.peer_bda, gatts_get_database_hash());
   }
 
   // only when the status is changed, print the log
@@ -918,7 +919,7 @@ static tGATT_STATUS gatt_sr_read_db_hash(uint16_t conn_id,
   LOG(INFO) << __func__ << ": conn_id=" << loghex(conn_id);
 
   uint8_t* p = p_value->value;
-  Octet16& db_hash = gatt_cb.database_hash;
+  const Octet16& db_hash = gatts_get_database_hash();
   ARRAY_TO_STREAM(p, db_hash.data(), (uint16_t)db_hash.size());
   p_value->len = (uint16_t)db_hash.size();
 
@@ -196,8 +196,9 @@ void gatt_act_read(tGATT_CLCB* p_clcb, uint16_t offset) {
       break;
 
     case GATT_READ_MULTIPLE:
-      op_code = GATT_REQ_READ_MULTI;
       memcpy(&msg.read_multi, p_clcb->p_attr_buf, sizeof(tGATT_READ_MULTI));
+      op_code = msg.read_multi.variable_len ? GATT_REQ_READ_MULTI_VAR
+                                            : GATT_REQ_READ_MULTI;
       break;
 
     case GATT_READ_INC_SRV_UUID128:
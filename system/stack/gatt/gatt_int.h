@@ -300,6 +300,10 @@ typedef struct {
   uint16_t e_hdl;      /* service ending handle */
   tGATT_IF gatt_if;    /* this service is belong to which application */
   bool is_primary;
+
+  /* byte reversed database hash input of this service, empty until the hash
+   * is first computed; services do not change once started */
+  std::vector<uint8_t> hash_data;
 } tGATT_SRV_LIST_ELEM;
 
 typedef struct {
@@ -440,7 +444,8 @@ typedef struct {
   uint8_t gatt_cl_supported_feat_mask;
 
   uint16_t handle_of_database_hash;
-  Octet16 database_hash;
+  Octet16 database_hash; /* use gatts_get_database_hash() to read */
+  bool database_hash_dirty; /* database changed since hash was computed */
 
   tGATT_APPL_INFO cb_info;
 
@@ -583,6 +588,9 @@ extern bool gatt_tcb_get_cid_available_for_indication(
 extern bool gatt_tcb_find_indicate_handle(tGATT_TCB& tcb, uint16_t cid,
                                           uint16_t* indicated_handle_p);
 extern uint16_t gatt_tcb_get_att_cid(tGATT_TCB& tcb, bool eatt_support);
+extern uint16_t gatt_tcb_get_cid_for_notification(tGATT_TCB& tcb,
+                                                  bool eatt_support,
+                                                  uint16_t len);
 extern uint16_t gatt_tcb_get_payload_size_tx(tGATT_TCB& tcb, uint16_t cid);
 extern uint16_t gatt_tcb_get_payload_size_rx(tGATT_TCB& tcb, uint16_t cid);
 extern void gatt_clcb_dealloc(tGATT_CLCB* p_clcb);
@@ -679,5 +687,6 @@ extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
 /* gatt_sr_hash.cc */
 extern Octet16 gatts_calculate_database_hash(
     std::list<tGATT_SRV_LIST_ELEM>* lst_ptr);
+extern const Octet16& gatts_get_database_hash();
 
 #endif
@@ -1045,6 +1045,7 @@ bool gatt_tcb_get_cid_available_for_indication(tGATT_TCB* p_tcb,
     if (channel) {
       *indicated_handle_p = &channel->indicate_handle_;
       *cid_p = channel->cid_;
+      channel->num_indications_++;
       return true;
     }
   }
@@ -1102,7 +1103,30 @@ uint16_t gatt_tcb_get_att_cid(tGATT_TCB& tcb, bool eatt_support) {
   if (eatt_support && tcb.eatt) {
     EattChannel* channel =
         EattExtension::GetInstance()->GetChannelAvailableForClientRequest(tcb.peer_bda);
+    /* The unenhanced bearer takes the request when it is less loaded */
+    if (channel && channel->cl_cmd_q_.size() <= tcb.cl_cmd_q.size()) {
+      return channel->cid_;
+    }
+  }
+  return tcb.att_lcid;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tcb_get_cid_for_notification
+ *
+ * Description      This function gets cid for a notification of |len| bytes
+ *
+ * Returns          Available CID
+ *
+ ******************************************************************************/
+uint16_t gatt_tcb_get_cid_for_notification(tGATT_TCB& tcb, bool eatt_support,
+                                           uint16_t len) {
+  if (eatt_support && tcb.eatt) {
+    EattChannel* channel =
+        EattExtension::GetInstance()->GetChannelAvailableForNotification(tcb.peer_bda, len);
     if (channel) {
+      channel->num_notifications_++;
       return channel->cid_;
     }
   }
@@ -1446,6 +1470,7 @@ void gatt_cmd_enq(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, bool to_send,
         EattExtension::GetInstance()->FindEattChannelByCid(tcb.peer_bda, cmd.cid);
     CHECK(channel);
     channel->cl_cmd_q_.push(cmd);
+    channel->num_client_requests_++;
   }
 }
 
@@ -516,6 +516,10 @@ typedef struct {
   // Get the A2DP encoded maximum frame size (similar to MTU).
   int (*get_effective_frame_size)(void);
 
+  // Get the size of the buffers the encoder needs for its media packets,
+  // including the BT_HDR and the headroom for the protocol headers.
+  size_t (*get_media_buffer_size)(void);
+
   // Prepare and send A2DP encoded frames.
   // |timestamp_us| is the current timestamp (in microseconds).
   void (*send_frames)(uint64_t timestamp_us);
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Buffers for the A2DP media packets built by the encoders.
+//
+// The packets are taken from a pool preallocated for the streaming session,
+// so that the encoders do not allocate on every media tick. Each encoder
+// reserves AVDT_MEDIA_OFFSET bytes in front of the payload, which is where
+// AVDTP, L2CAP and HCI write their headers on the way down, and the buffer is
+// released with |osi_free| once its content was handed to the controller.
+//
+
+#ifndef A2DP_MEDIA_BUFFER_H
+#define A2DP_MEDIA_BUFFER_H
+
+#include <stddef.h>
+
+#include "osi/include/buffer_pool.h"
+#include "stack/include/bt_hdr.h"
+
+// Creates the pool of media packet buffers for a new streaming session, with
+// |buffer_count| buffers of |buffer_size| bytes including the BT_HDR.
+// Replaces the pool of the previous session: its buffers still in use stay
+// valid until released.
+void a2dp_media_buffer_pool_init(size_t buffer_size, size_t buffer_count);
+
+// Releases the pool of media packet buffers.
+void a2dp_media_buffer_pool_cleanup(void);
+
+// Allocates a media packet buffer of at least |size| bytes including the
+// BT_HDR. The buffer is taken from the pool if it has one of that size left,
+// otherwise it is allocated with |osi_malloc|.
+// The returned buffer must be released with |osi_free|.
+BT_HDR* a2dp_media_buffer_alloc(size_t size);
+
+// Fills |stats| with the statistics of the current pool.
+// Returns false if there is no pool.
+bool a2dp_media_buffer_pool_get_stats(buffer_pool_stats_t* stats);
+
+#endif  // A2DP_MEDIA_BUFFER_H
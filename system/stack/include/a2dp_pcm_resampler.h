@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// PCM format conversion and sample rate conversion for the A2DP encoders
+// feeding.
+//
+
+#ifndef A2DP_PCM_RESAMPLER_H
+#define A2DP_PCM_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Converts interleaved PCM between sample rates, sample formats (16, packed
+// 24 and 32 bits signed) and channel counts (mono and stereo).
+// Rate conversion uses a windowed-sinc polyphase filter, with the filter state
+// kept across calls so that the PCM is converted as one continuous stream.
+class A2dpPcmResampler {
+ public:
+  A2dpPcmResampler() = default;
+
+  // Configures the source and destination PCM formats. Nothing is done if the
+  // formats did not change, otherwise the filter state is reset.
+  // Returns true on success, or false if one of the formats is not supported.
+  bool Configure(uint32_t src_sample_rate, uint8_t src_bits_per_sample,
+                 uint8_t src_channel_count, uint32_t dst_sample_rate,
+                 uint8_t dst_bits_per_sample, uint8_t dst_channel_count);
+
+  // Drops the filter state, e.g. when the audio feeding is restarted.
+  void Reset();
+
+  // Returns true if the source and destination formats are the same.
+  bool IsPassthrough() const;
+
+  // Gets the number of source frames to convert so that, over time, exactly
+  // |dst_frames| destination frames are produced for each call.
+  size_t GetSourceFrames(size_t dst_frames);
+
+  // Converts |src_len| bytes from |src| and writes at most |dst_len| bytes to
+  // |dst|. All of |src| is consumed, source frames which could not be
+  // converted yet are kept for the next call.
+  // Returns the number of bytes written to |dst|.
+  size_t Convert(const uint8_t* src, size_t src_len, uint8_t* dst,
+                 size_t dst_len);
+
+ private:
+  static constexpr size_t kMaxChannels = 2;
+
+  void DecodeFrames(const uint8_t* src, size_t num_frames);
+  size_t FilterFrames(size_t max_frames);
+  size_t EncodeFrames(size_t num_frames, uint8_t* dst);
+
+  bool configured_ = false;
+  uint32_t src_sample_rate_ = 0;
+  uint8_t src_bits_per_sample_ = 0;
+  uint8_t src_channel_count_ = 0;
+  uint32_t dst_sample_rate_ = 0;
+  uint8_t dst_bits_per_sample_ = 0;
+  uint8_t dst_channel_count_ = 0;
+
+  // The rate ratio, dst_sample_rate_ / src_sample_rate_ reduced
+  uint32_t interpolation_ = 1;
+  uint32_t decimation_ = 1;
+  // How far the filter moves in the source for each destination frame
+  size_t position_step_ = 0;
+  uint32_t phase_step_ = 0;
+  size_t taps_ = 0;
+  // |interpolation_| phases of |taps_| coefficients each
+  std::vector<float> coefficients_;
+
+  // Source samples per channel, in [-1, 1), which have not been fully used
+  std::vector<float> history_[kMaxChannels];
+  // Converted samples per channel, in [-1, 1)
+  std::vector<float> output_[kMaxChannels];
+  size_t position_ = 0;
+  uint32_t phase_ = 0;
+  uint32_t src_frames_remainder_ = 0;
+};
+
+#endif  // A2DP_PCM_RESAMPLER_H
@@ -57,6 +57,9 @@ uint64_t a2dp_vendor_aptx_hd_get_encoder_interval_ms(void);
 // Get the A2DP aptX-HD encoded maximum frame size
 int a2dp_vendor_aptx_hd_get_effective_frame_size();
 
+// Get the size of the A2DP aptX-HD media packet buffers
+size_t a2dp_vendor_aptx_hd_get_media_buffer_size();
+
 // Prepare and send A2DP aptX-HD encoded frames.
 // |timestamp_us| is the current timestamp (in microseconds).
 void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us);
@@ -44,6 +44,10 @@
 /* this is the minimal offset required by OBX to process incoming packets */
 static const uint16_t OBX_BUF_MIN_OFFSET = 4;
 
+/* room needed in front of a K-frame payload for the HCI and L2CAP headers */
+static const uint16_t L2CAP_LCC_PDU_HEADROOM =
+    L2CAP_MIN_OFFSET - L2CAP_LCC_SDU_LENGTH - 2 /* control */;
+
 static const char* SAR_types[] = {"Unsegmented", "Start", "End",
                                   "Continuation"};
 static const char* SUP_types[] = {"RR", "REJ", "RNR", "SREJ"};
@@ -715,6 +719,12 @@ void l2c_lcc_proc_pdu(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
       return;
     }
 
+    /* An SDU received in a single PDU is passed up in the PDU buffer */
+    if (sdu_length == p_buf->len) {
+      l2c_csm_execute(p_ccb, L2CEVT_L2CAP_DATA, p_buf);
+      return;
+    }
+
     p_data = (BT_HDR*)osi_malloc(BT_HDR_SIZE + sdu_length);
     if (p_data == NULL) {
       osi_free(p_buf);
@@ -1528,34 +1538,44 @@ BT_HDR* l2c_lcc_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
       (uint16_t)(first_pdu ? (max_pdu - L2CAP_LCC_SDU_LENGTH) : max_pdu));
   bool last_pdu = (no_of_bytes_to_send == p_buf->len);
 
-  /* Get a new buffer and copy the data that can be sent in a PDU */
-  BT_HDR* p_xmit =
-      l2c_fcr_clone_buf(p_buf, first_pdu ? L2CAP_LCC_OFFSET : L2CAP_MIN_OFFSET,
-                        no_of_bytes_to_send);
+  /* The last piece of the SDU is sent from the SDU buffer itself when the
+   * headers fit in front of it, otherwise the piece is copied in a new buffer.
+   */
+  uint16_t headroom = L2CAP_LCC_PDU_HEADROOM +
+                      (first_pdu ? L2CAP_LCC_SDU_LENGTH : 0);
+  BT_HDR* p_xmit;
+  uint16_t sdu_length = p_buf->len;
+  if (last_pdu && p_buf->offset >= headroom) {
+    p_xmit = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
+  } else {
+    p_xmit = l2c_fcr_clone_buf(
+        p_buf, first_pdu ? L2CAP_LCC_OFFSET : L2CAP_MIN_OFFSET,
+        no_of_bytes_to_send);
+
+    p_buf->len -= no_of_bytes_to_send;
+    p_buf->offset += no_of_bytes_to_send;
+    p_buf->event = p_ccb->local_cid;
+
+    /* copy PBF setting */
+    p_xmit->layer_specific = p_buf->layer_specific;
+
+    if (last_pdu) {
+      p_buf = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
+      osi_free(p_buf);
+    }
+  }
 
-  p_buf->event = p_ccb->local_cid;
   p_xmit->event = p_ccb->local_cid;
 
   if (first_pdu) {
     p_xmit->offset -= L2CAP_LCC_SDU_LENGTH; /* for writing the SDU length. */
     uint8_t* p = (uint8_t*)(p_xmit + 1) + p_xmit->offset;
-    UINT16_TO_STREAM(p, p_buf->len);
+    UINT16_TO_STREAM(p, sdu_length);
     p_xmit->len += L2CAP_LCC_SDU_LENGTH;
   }
 
-  p_buf->len -= no_of_bytes_to_send;
-  p_buf->offset += no_of_bytes_to_send;
-
-  /* copy PBF setting */
-  p_xmit->layer_specific = p_buf->layer_specific;
-
   if (last_piece_of_sdu) *last_piece_of_sdu = last_pdu;
 
-  if (last_pdu) {
-    p_buf = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
-    osi_free(p_buf);
-  }
-
   /* Step back to add the L2CAP headers */
   p_xmit->offset -= L2CAP_PKT_OVERHEAD;
   p_xmit->len += L2CAP_PKT_OVERHEAD;
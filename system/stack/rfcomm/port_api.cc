@@ -973,6 +973,7 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
       error(
           "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d",
           length);
+      osi_free(p_buf);
       return (PORT_UNKNOWN_ERROR);
     }
 
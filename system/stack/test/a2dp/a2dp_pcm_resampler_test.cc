@@ -0,0 +1,183 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "a2dp_pcm_resampler.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr double kToneHz = 1000;
+constexpr size_t kBlockFrames = 128;
+
+std::vector<int16_t> make_tone(uint32_t sample_rate, size_t num_frames,
+                               uint8_t channel_count) {
+  std::vector<int16_t> pcm;
+  for (size_t i = 0; i < num_frames; i++) {
+    int16_t sample = static_cast<int16_t>(
+        std::lrint(16384 * std::sin(2 * M_PI * kToneHz * i / sample_rate)));
+    for (uint8_t channel = 0; channel < channel_count; channel++) {
+      pcm.push_back(sample);
+    }
+  }
+  return pcm;
+}
+
+// Feeds a tone through |resampler| one block at a time, as the encoders do,
+// and returns the converted 16 bits stereo PCM.
+std::vector<int16_t> resample_tone(A2dpPcmResampler& resampler,
+                                   uint32_t src_sample_rate,
+                                   size_t num_blocks) {
+  std::vector<int16_t> src =
+      make_tone(src_sample_rate, num_blocks * kBlockFrames * 4, 2);
+  std::vector<int16_t> dst;
+  size_t src_frame = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    size_t src_frames = resampler.GetSourceFrames(kBlockFrames);
+    int16_t out[kBlockFrames * 2 * 2];
+    size_t len = resampler.Convert(
+        reinterpret_cast<const uint8_t*>(&src[src_frame * 2]), src_frames * 4,
+        reinterpret_cast<uint8_t*>(out), sizeof(out));
+    dst.insert(dst.end(), out, out + len / 2);
+    src_frame += src_frames;
+  }
+  return dst;
+}
+
+// Ratio in dB of the tone power to the error power, skipping the start of the
+// stream where the filter is still filling up.
+double signal_to_noise_db(const std::vector<int16_t>& stereo,
+                          uint32_t sample_rate) {
+  double signal = 0;
+  double noise = 0;
+  for (size_t i = 256; i < stereo.size() / 2; i++) {
+    double expected = 16384 * std::sin(2 * M_PI * kToneHz * i / sample_rate);
+    for (size_t channel = 0; channel < 2; channel++) {
+      double error = stereo[i * 2 + channel] - expected;
+      signal += expected * expected;
+      noise += error * error;
+    }
+  }
+  return 10 * std::log10(signal / noise);
+}
+
+}  // namespace
+
+TEST(A2dpPcmResamplerTest, unsupported_formats) {
+  A2dpPcmResampler resampler;
+  EXPECT_FALSE(resampler.Configure(48000, 8, 2, 48000, 16, 2));
+  EXPECT_FALSE(resampler.Configure(48000, 16, 6, 48000, 16, 2));
+  EXPECT_FALSE(resampler.Configure(0, 16, 2, 48000, 16, 2));
+  // 1021 phases is fine, 1031 is not
+  EXPECT_TRUE(resampler.Configure(1000, 16, 2, 1021, 16, 2));
+  EXPECT_FALSE(resampler.Configure(1000, 16, 2, 1031, 16, 2));
+  uint8_t buffer[16] = {};
+  EXPECT_EQ(resampler.Convert(buffer, sizeof(buffer), buffer, sizeof(buffer)),
+            0u);
+}
+
+TEST(A2dpPcmResamplerTest, passthrough) {
+  A2dpPcmResampler resampler;
+  ASSERT_TRUE(resampler.Configure(44100, 16, 2, 44100, 16, 2));
+  EXPECT_TRUE(resampler.IsPassthrough());
+  EXPECT_EQ(resampler.GetSourceFrames(kBlockFrames), kBlockFrames);
+
+  std::vector<int16_t> src = make_tone(44100, kBlockFrames, 2);
+  std::vector<int16_t> dst(src.size());
+  EXPECT_EQ(resampler.Convert(reinterpret_cast<uint8_t*>(src.data()),
+                              src.size() * 2,
+                              reinterpret_cast<uint8_t*>(dst.data()),
+                              dst.size() * 2),
+            src.size() * 2);
+  EXPECT_EQ(src, dst);
+}
+
+TEST(A2dpPcmResamplerTest, passthrough_keeps_what_does_not_fit) {
+  A2dpPcmResampler resampler;
+  ASSERT_TRUE(resampler.Configure(44100, 16, 2, 44100, 16, 2));
+
+  std::vector<int16_t> src = make_tone(44100, 8, 2);
+  std::vector<int16_t> dst(src.size());
+  uint8_t* p_dst = reinterpret_cast<uint8_t*>(dst.data());
+  EXPECT_EQ(resampler.Convert(reinterpret_cast<uint8_t*>(src.data()), 32,
+                              p_dst, 16),
+            16u);
+  EXPECT_EQ(resampler.Convert(nullptr, 0, p_dst + 16, 16), 16u);
+  EXPECT_EQ(memcmp(src.data(), dst.data(), 32), 0);
+}
+
+TEST(A2dpPcmResamplerTest, format_conversion) {
+  A2dpPcmResampler resampler;
+  ASSERT_TRUE(resampler.Configure(48000, 16, 2, 48000, 24, 1));
+  EXPECT_FALSE(resampler.IsPassthrough());
+
+  const int16_t src[] = {1000, 3000, -32768, -32768, 32767, 32767};
+  uint8_t dst[9];
+  ASSERT_EQ(resampler.Convert(reinterpret_cast<const uint8_t*>(src),
+                              sizeof(src), dst, sizeof(dst)),
+            sizeof(dst));
+  const uint8_t expected[] = {0x00, 0xd0, 0x07, 0x00, 0x00,
+                              0x80, 0x00, 0xff, 0x7f};
+  EXPECT_EQ(memcmp(dst, expected, sizeof(dst)), 0);
+
+  ASSERT_TRUE(resampler.Configure(48000, 32, 1, 48000, 16, 2));
+  const int32_t src32[] = {0x12345678, INT32_MIN};
+  int16_t dst16[4];
+  ASSERT_EQ(resampler.Convert(reinterpret_cast<const uint8_t*>(src32),
+                              sizeof(src32), reinterpret_cast<uint8_t*>(dst16),
+                              sizeof(dst16)),
+            sizeof(dst16));
+  EXPECT_EQ(dst16[0], 0x1234);
+  EXPECT_EQ(dst16[1], 0x1234);
+  EXPECT_EQ(dst16[2], INT16_MIN);
+  EXPECT_EQ(dst16[3], INT16_MIN);
+}
+
+TEST(A2dpPcmResamplerTest, source_frames_follow_rate) {
+  A2dpPcmResampler resampler;
+  ASSERT_TRUE(resampler.Configure(44100, 16, 2, 48000, 16, 2));
+  size_t total = 0;
+  for (size_t i = 0; i < 375; i++) {
+    size_t frames = resampler.GetSourceFrames(kBlockFrames);
+    EXPECT_TRUE(frames == 117 || frames == 118);
+    total += frames;
+  }
+  // 375 blocks of 128 frames is one second at 48 kHz
+  EXPECT_EQ(total, 44100u);
+}
+
+TEST(A2dpPcmResamplerTest, resample_tone) {
+  const uint32_t rates[][2] = {
+      {44100, 48000}, {48000, 44100}, {16000, 48000},
+      {32000, 44100}, {96000, 48000}, {96000, 44100},
+  };
+  for (auto& rate : rates) {
+    A2dpPcmResampler resampler;
+    ASSERT_TRUE(resampler.Configure(rate[0], 16, 2, rate[1], 16, 2));
+    std::vector<int16_t> dst = resample_tone(resampler, rate[0], 200);
+
+    // Only the filter delay is missing from the output
+    EXPECT_GE(dst.size() / 2, 200 * kBlockFrames - 64);
+    EXPECT_LE(dst.size() / 2, 200 * kBlockFrames);
+    double snr = signal_to_noise_db(dst, rate[1]);
+    EXPECT_GT(snr, 60) << rate[0] << " -> " << rate[1];
+  }
+}
@@ -96,6 +96,11 @@ EattChannel* EattExtension::GetChannelAvailableForClientRequest(
   return pimpl_->GetChannelAvailableForClientRequest(bd_addr);
 }
 
+EattChannel* EattExtension::GetChannelAvailableForNotification(
+    const RawAddress& bd_addr, uint16_t len) {
+  return pimpl_->GetChannelAvailableForNotification(bd_addr, len);
+}
+
 /* Start stop GATT indication timer per CID */
 void EattExtension::StartIndicationConfirmationTimer(const RawAddress& bd_addr,
                                                      uint16_t cid) {
@@ -118,6 +123,8 @@ void EattExtension::StopAppIndicationTimer(const RawAddress& bd_addr,
   pimpl_->StopAppIndicationTimer(bd_addr, cid);
 }
 
+void EattExtension::Dump(int fd) {}
+
 void EattExtension::Start() {
   // It is needed here as IsoManager which is a singleton creates it, but in
   // this mock we want to destroy and recreate the mock on each test case.
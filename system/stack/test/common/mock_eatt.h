@@ -56,6 +56,8 @@ class MockEattExtension : public EattExtension {
               (const RawAddress& bd_addr));
   MOCK_METHOD((EattChannel*), GetChannelAvailableForClientRequest,
               (const RawAddress& bd_addr));
+  MOCK_METHOD((EattChannel*), GetChannelAvailableForNotification,
+              (const RawAddress& bd_addr, uint16_t len));
   MOCK_METHOD((void), StartIndicationConfirmationTimer,
               (const RawAddress& bd_addr, uint16_t cid));
   MOCK_METHOD((void), StopIndicationConfirmationTimer,
@@ -120,6 +120,42 @@ class EattTest : public testing::Test {
     ASSERT_TRUE(test_tcb.eatt == 0);
   }
 
+  /* Issues |num_requests| client requests at once, the way gatt_cmd_enq queues
+   * them on the channel picked for each of them. The peer answers the request
+   * at the head of each channel queue |response_time_ms| after it reaches the
+   * head, as ATT allows a single outstanding request per bearer.
+   *
+   * Returns the number of requests completed per second.
+   */
+  double RunClientRequests(int num_requests, int response_time_ms) {
+    for (int i = 0; i < num_requests; i++) {
+      EattChannel* channel =
+          eatt_instance_->GetChannelAvailableForClientRequest(test_address);
+      EXPECT_TRUE(channel != nullptr);
+      if (!channel) return 0;
+
+      tGATT_CMD_Q cmd = {.op_code = GATT_REQ_READ, .cid = channel->cid_};
+      channel->cl_cmd_q_.push(cmd);
+      channel->num_client_requests_++;
+    }
+
+    int completed = 0;
+    int time_ms = 0;
+    while (completed < num_requests) {
+      time_ms += response_time_ms;
+      for (uint16_t cid : connected_cids_) {
+        EattChannel* channel =
+            eatt_instance_->FindEattChannelByCid(test_address, cid);
+        if (channel->cl_cmd_q_.empty()) continue;
+
+        channel->cl_cmd_q_.pop();
+        completed++;
+      }
+    }
+
+    return completed * 1000.0 / time_ms;
+  }
+
   void SetUp() override {
     bluetooth::l2cap::SetMockInterface(&l2cap_interface_);
     bluetooth::manager::SetMockBtmApiInterface(&btm_api_interface_);
@@ -436,6 +472,112 @@ TEST_F(EattTest, ReconfigPeerFailed) {
   DisconnectEattDevice(connected_cids_);
 }
 
+TEST_F(EattTest, ClientRequestsThroughputScalesWithChannels) {
+  const int num_requests = 300;
+  const int response_time_ms = 30;
+  double single_channel_ops_per_sec = 0;
+
+  for (int num_of_channels = 1; num_of_channels <= 5; num_of_channels++) {
+    connected_cids_.clear();
+    ConnectDeviceEattSupported(num_of_channels);
+
+    double ops_per_sec = RunClientRequests(num_requests, response_time_ms);
+    LOG(INFO) << num_of_channels << " channels: " << ops_per_sec << " ops/sec";
+    if (num_of_channels == 1) single_channel_ops_per_sec = ops_per_sec;
+
+    /* Requests are shared evenly, so that the channels work in parallel */
+    ASSERT_DOUBLE_EQ(ops_per_sec, num_of_channels * single_channel_ops_per_sec);
+    for (uint16_t cid : connected_cids_) {
+      EattChannel* channel =
+          eatt_instance_->FindEattChannelByCid(test_address, cid);
+      ASSERT_EQ(channel->num_client_requests_,
+                (uint32_t)(num_requests / num_of_channels));
+    }
+
+    DisconnectEattDevice(connected_cids_);
+  }
+}
+
+TEST_F(EattTest, ClientRequestsOnLeastQueuedChannel) {
+  ConnectDeviceEattSupported(3);
+
+  EattChannel* busy =
+      eatt_instance_->FindEattChannelByCid(test_address, connected_cids_[0]);
+  busy->cl_cmd_q_.push({.op_code = GATT_REQ_READ, .cid = busy->cid_});
+
+  /* Channels with nothing queued are used first, even if used more before */
+  EattChannel* idle =
+      eatt_instance_->FindEattChannelByCid(test_address, connected_cids_[1]);
+  idle->num_client_requests_ = 10;
+
+  for (int i = 0; i < 2; i++) {
+    EattChannel* channel =
+        eatt_instance_->GetChannelAvailableForClientRequest(test_address);
+    ASSERT_TRUE(channel != busy);
+    channel->cl_cmd_q_.push({.op_code = GATT_REQ_READ, .cid = channel->cid_});
+  }
+
+  DisconnectEattDevice(connected_cids_);
+}
+
+TEST_F(EattTest, NotificationsSharedInProportionOfMtu) {
+  ConnectDeviceEattSupported(3);
+
+  /* The last two channels get twice the MTU of the first one */
+  tL2CAP_LE_CFG_INFO cfg = {.result = L2CAP_CFG_OK,
+                            .mtu = 2 * EATT_MIN_MTU_MPS};
+  l2cap_app_info_.pL2CA_CreditBasedReconfigCompleted_Cb(
+      test_address, connected_cids_[1], false, &cfg);
+  l2cap_app_info_.pL2CA_CreditBasedReconfigCompleted_Cb(
+      test_address, connected_cids_[2], false, &cfg);
+
+  for (int i = 0; i < 50; i++) {
+    EattChannel* channel =
+        eatt_instance_->GetChannelAvailableForNotification(test_address, 20);
+    ASSERT_TRUE(channel != nullptr);
+    channel->num_notifications_++;
+  }
+
+  std::vector<uint32_t> expected_notifications{10, 20, 20};
+  for (size_t i = 0; i < connected_cids_.size(); i++) {
+    EattChannel* channel =
+        eatt_instance_->FindEattChannelByCid(test_address, connected_cids_[i]);
+    ASSERT_EQ(channel->num_notifications_, expected_notifications[i]);
+  }
+
+  /* Values longer than the MTU of a channel are never sent on it */
+  for (int i = 0; i < 10; i++) {
+    EattChannel* channel = eatt_instance_->GetChannelAvailableForNotification(
+        test_address, EATT_MIN_MTU_MPS);
+    ASSERT_TRUE(channel != nullptr);
+    ASSERT_TRUE(channel->cid_ != connected_cids_[0]);
+    channel->num_notifications_++;
+  }
+
+  ASSERT_TRUE(eatt_instance_->GetChannelAvailableForNotification(
+                  test_address, 2 * EATT_MIN_MTU_MPS) == nullptr);
+
+  DisconnectEattDevice(connected_cids_);
+}
+
+TEST_F(EattTest, IndicationOnChannelWithoutPendingIndication) {
+  ConnectDeviceEattSupported(2);
+
+  EattChannel* pending =
+      eatt_instance_->FindEattChannelByCid(test_address, connected_cids_[0]);
+  pending->indicate_handle_ = 0x0010;
+
+  for (int i = 0; i < 3; i++) {
+    EattChannel* channel =
+        eatt_instance_->GetChannelAvailableForIndication(test_address);
+    ASSERT_TRUE(channel != nullptr);
+    ASSERT_EQ(channel->cid_, connected_cids_[1]);
+    channel->num_indications_++;
+  }
+
+  DisconnectEattDevice(connected_cids_);
+}
+
 TEST_F(EattTest, DoubleDisconnect) {
   ConnectDeviceEattSupported(1);
   DisconnectEattDevice(connected_cids_);
@@ -25,6 +25,8 @@ class AcceptlistMock {
   MOCK_METHOD1(AcceptlistAdd, bool(const RawAddress&));
   MOCK_METHOD1(AcceptlistRemove, void(const RawAddress&));
   MOCK_METHOD0(AcceptlistClear, void());
+  MOCK_METHOD0(AcceptlistBeginBatch, void());
+  MOCK_METHOD0(AcceptlistEndBatch, void());
   MOCK_METHOD0(SetLeConnectionModeToFast, bool());
   MOCK_METHOD0(SetLeConnectionModeToSlow, void());
   MOCK_METHOD2(OnConnectionTimedOut, void(uint8_t, const RawAddress&));
@@ -52,6 +54,10 @@ void BTM_AcceptlistRemove(const RawAddress& address) {
 
 void BTM_AcceptlistClear() { return localAcceptlistMock->AcceptlistClear(); }
 
+void BTM_AcceptlistBeginBatch() { localAcceptlistMock->AcceptlistBeginBatch(); }
+
+void BTM_AcceptlistEndBatch() { localAcceptlistMock->AcceptlistEndBatch(); }
+
 bool BTM_SetLeConnectionModeToFast() {
   return localAcceptlistMock->SetLeConnectionModeToFast();
 }
@@ -168,9 +174,9 @@ TEST_F(BleConnectionManager, test_direct_connection_client) {
 
   EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
   EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(_)).Times(1);
-  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+  EXPECT_CALL(*AlarmMock::Get(), AlarmCancel(_)).Times(1);
 
-  // Removal should lower the connection parameters, and free the alarm.
+  // Removal should lower the connection parameters, and stop the alarm.
   // Even though we call AcceptlistRemove, it won't be executed over HCI until
   // acceptlist is in use, i.e. next connection attempt
   EXPECT_TRUE(direct_connect_remove(CLIENT1, address1));
@@ -188,20 +194,26 @@ TEST_F(BleConnectionManager, test_direct_connect_timeout) {
   alarm_callback_t alarm_callback = nullptr;
   void* alarm_data = nullptr;
 
-  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, _, _, _))
-      .Times(1)
-      .WillOnce(DoAll(SaveArg<2>(&alarm_callback), SaveArg<3>(&alarm_data)));
+  // The alarm ticks every second until the attempt times out
+  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, 1000, _, _))
+      .Times(30)
+      .WillRepeatedly(
+          DoAll(SaveArg<2>(&alarm_callback), SaveArg<3>(&alarm_data)));
 
   // Start direct connect attempt...
   EXPECT_TRUE(direct_connect_add(CLIENT1, address1));
 
   Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
 
+  // simulate 29 seconds passed
+  EXPECT_CALL(*localAcceptlistMock, OnConnectionTimedOut(_, _)).Times(0);
+  for (int i = 0; i < 29; i++) alarm_callback(alarm_data);
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+
   EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
   EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(_)).Times(1);
   EXPECT_CALL(*localAcceptlistMock, OnConnectionTimedOut(CLIENT1, address1))
       .Times(1);
-  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
 
   // simulate timeout seconds passed, alarm executing
   alarm_callback(alarm_data);
@@ -224,7 +236,7 @@ TEST_F(BleConnectionManager, test_direct_connection_success) {
 
   EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
   EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(address1)).Times(1);
-  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+  EXPECT_CALL(*AlarmMock::Get(), AlarmCancel(_)).Times(1);
   // simulate event from lower layers - connections was established
   // successfully.
   on_connection_complete(address1);
@@ -271,7 +283,7 @@ TEST_F(BleConnectionManager, test_direct_and_background_connect) {
   Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
 
   EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
-  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+  EXPECT_CALL(*AlarmMock::Get(), AlarmCancel(_)).Times(1);
   // not removing from acceptlist yet, as the background connection is still
   // pending.
   EXPECT_TRUE(direct_connect_remove(CLIENT1, address1));
@@ -283,4 +295,82 @@ TEST_F(BleConnectionManager, test_direct_and_background_connect) {
   Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
 }
 
+/** Verify that the apps and devices are tracked with many devices: direct
+ * connection attempts time out on a single alarm, and deregistering an app
+ * only removes the devices nobody else connects to. */
+TEST_F(BleConnectionManager, test_many_devices_and_apps) {
+  constexpr int kNumDevices = 500;
+  constexpr int kNumApps = 10;
+  constexpr int kNumDirectConnections = 100;
+  auto address_of = [](int device) {
+    return RawAddress{{0x00, 0x11, 0x22, 0x33,
+                       static_cast<uint8_t>(device >> 8),
+                       static_cast<uint8_t>(device)}};
+  };
+  auto app_of = [](int device) {
+    return static_cast<tAPP_ID>(device % kNumApps + 1);
+  };
+  auto next_app_of = [](int device) {
+    return static_cast<tAPP_ID>((device + 1) % kNumApps + 1);
+  };
+
+  // Each device is connected to by two apps
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(_))
+      .Times(kNumDevices)
+      .WillRepeatedly(Return(true));
+  for (int device = 0; device < kNumDevices; device++) {
+    EXPECT_TRUE(background_connect_add(app_of(device), address_of(device)));
+    EXPECT_TRUE(
+        background_connect_add(next_app_of(device), address_of(device)));
+  }
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+
+  // Direct connection attempts all share one alarm
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(_)).Times(0);
+  EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToFast())
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmNew(_)).Times(1);
+  alarm_callback_t alarm_callback = nullptr;
+  void* alarm_data = nullptr;
+  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, _, _, _))
+      .WillRepeatedly(
+          DoAll(SaveArg<2>(&alarm_callback), SaveArg<3>(&alarm_data)));
+  for (int device = 0; device < kNumDirectConnections; device++) {
+    EXPECT_TRUE(direct_connect_add(app_of(device), address_of(device)));
+  }
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+
+  // ... and time out together, the devices staying in the acceptlist for the
+  // background connections
+  EXPECT_CALL(*localAcceptlistMock, OnConnectionTimedOut(_, _))
+      .Times(kNumDirectConnections);
+  EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(_)).Times(0);
+  for (int i = 0; i < 30; i++) alarm_callback(alarm_data);
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  Mock::VerifyAndClearExpectations(AlarmMock::Get());
+
+  // Every device is still connected to by an odd app
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(_)).Times(0);
+  for (tAPP_ID app_id = 1; app_id <= kNumApps; app_id += 2) {
+    on_app_deregistered(app_id);
+  }
+  EXPECT_EQ(get_apps_connecting_to(address_of(0)).size(), 1UL);
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+
+  // The devices of each app are removed in one batch
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(_)).Times(kNumDevices);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistBeginBatch())
+      .Times(kNumApps / 2);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistEndBatch()).Times(kNumApps / 2);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistClear()).Times(0);
+  for (tAPP_ID app_id = 2; app_id <= kNumApps; app_id += 2) {
+    on_app_deregistered(app_id);
+  }
+  for (int device = 0; device < kNumDevices; device++) {
+    EXPECT_EQ(get_apps_connecting_to(address_of(device)).size(), 0UL);
+  }
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+}
+
 }  // namespace connection_manager
@@ -62,7 +62,9 @@ void PrintTo(tL2CAP_CFG_INFO* value, ::std::ostream* os) {
 namespace {
 
 using testing::_;
+using testing::AnyNumber;
 using testing::DoAll;
+using testing::Invoke;
 using testing::Return;
 using testing::Test;
 using testing::StrictMock;
@@ -121,6 +123,34 @@ void port_event_cback_1(uint32_t code, uint16_t port_handle) {
   rfcomm_callback->PortEventCallback(code, port_handle, 1);
 }
 
+uint64_t spp_bytes_from_peer = 0;
+uint64_t spp_bytes_to_peer = 0;
+int spp_app_pending = 0;
+std::vector<uint8_t> spp_app_data;
+
+// Stands in for btif_sock_rfc: incoming buffers are taken over as they are and
+// outgoing data is read straight into the RFCOMM buffer.
+int spp_loopback_data_co_cback(uint16_t /* port_handle */, uint8_t* p_buf,
+                               uint16_t len, int type) {
+  switch (type) {
+    case DATA_CO_CALLBACK_TYPE_INCOMING: {
+      BT_HDR* p_hdr = reinterpret_cast<BT_HDR*>(p_buf);
+      spp_bytes_from_peer += p_hdr->len;
+      osi_free(p_hdr);
+      return true;
+    }
+    case DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE:
+      *reinterpret_cast<int*>(p_buf) = spp_app_pending;
+      return true;
+    case DATA_CO_CALLBACK_TYPE_OUTGOING:
+      memcpy(p_buf, spp_app_data.data(), len);
+      spp_app_pending -= len;
+      spp_bytes_to_peer += len;
+      return true;
+  }
+  return false;
+}
+
 RawAddress GetTestAddress(int index) {
   CHECK_LT(index, UINT8_MAX);
   RawAddress result = {
@@ -887,4 +917,66 @@ TEST_F(StackRfcommTest, TestConnectionCollision) {
   l2cap_appl_info_.pL2CA_DataInd_Cb(new_lcid, uih_msc_rsp_from_peer);
 }
 
+TEST_F(StackRfcommTest, SppLoopbackThroughDataCallouts) {
+  static const uint16_t acl_handle = 0x0009;
+  static const uint16_t lcid = 0x0054;
+  static const uint16_t test_uuid = 0x1101;
+  static const uint8_t test_scn = 8;
+  static const uint16_t test_mtu = 1600;
+  static const size_t payload_size = 1000;
+  static const int iterations = 4;
+  static const RawAddress test_address = GetTestAddress(0);
+  uint16_t server_handle = 0;
+  ASSERT_NO_FATAL_FAILURE(StartServerPort(test_uuid, test_scn, test_mtu,
+                                          port_mgmt_cback_0, port_event_cback_0,
+                                          &server_handle));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerL2cap(test_address, acl_handle, lcid));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerPort(
+      test_address, server_handle, test_scn, test_mtu, acl_handle, lcid, 0));
+  ASSERT_EQ(PORT_SetDataCOCallback(server_handle, spp_loopback_data_co_cback),
+            PORT_SUCCESS);
+
+  spp_bytes_from_peer = 0;
+  spp_bytes_to_peer = 0;
+  spp_app_data.assign(payload_size, 'x');
+  EXPECT_CALL(rfcomm_callback_, PortEventCallback(_, server_handle, 0))
+      .Times(AnyNumber());
+
+  // Data frames to the peer end with the payload and a 1 byte FCS, credit
+  // frames carry no payload
+  static std::vector<std::string> payloads_to_peer;
+  payloads_to_peer.clear();
+  EXPECT_CALL(l2cap_interface_, DataWrite(lcid, _))
+      .WillRepeatedly(Invoke([](uint16_t /* cid */, BT_HDR* p_buf) -> uint8_t {
+        if (p_buf->len > payload_size) {
+          const char* p_data = reinterpret_cast<const char*>(
+              p_buf->data + p_buf->offset + p_buf->len - 1 - payload_size);
+          payloads_to_peer.emplace_back(p_data, payload_size);
+        }
+        osi_free(p_buf);
+        return L2CAP_DW_SUCCESS;
+      }));
+
+  // Every packet from the peer returns the credit used by our previous echo
+  const std::vector<uint8_t> data_from_peer = CreateQuickDataPacket(
+      GetDlci(false, test_scn), true, lcid, acl_handle, 1,
+      std::string(payload_size, 'y'));
+  for (int i = 0; i < iterations; i++) {
+    // The incoming buffer is handed over to the data callout
+    l2cap_appl_info_.pL2CA_DataInd_Cb(
+        lcid, AllocateWrappedIncomingL2capAclPacket(data_from_peer));
+    ASSERT_EQ(spp_bytes_from_peer, payload_size * (i + 1));
+
+    // The data callout writes the outgoing data into the frame sent to L2CAP
+    spp_app_pending = payload_size;
+    int written = 0;
+    ASSERT_EQ(PORT_WriteDataCO(server_handle, &written), PORT_SUCCESS);
+    ASSERT_EQ(written, (int)payload_size);
+    ASSERT_EQ(spp_app_pending, 0);
+    ASSERT_EQ(spp_bytes_to_peer, payload_size * (i + 1));
+    ASSERT_EQ(payloads_to_peer.size(), (size_t)i + 1);
+    ASSERT_EQ(payloads_to_peer.back(), std::string(payload_size, 'x'));
+  }
+}
+
 }  // namespace
@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdio>
+
 #include "crypto_toolbox/crypto_toolbox.h"
 #include "stack/gatt/gatt_int.h"
 #include "stack/test/common/mock_eatt.h"
@@ -87,3 +90,57 @@ TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
 
   ASSERT_EQ(result_hash, expected_hash);
 }
+
+// Apps register services one at a time, and a robust caching client may read
+// the hash after each of them
+TEST(GattDatabaseTest, registerServicesOneByOne) {
+  constexpr int kNumServices = 50;
+  constexpr uint16_t kHandlesPerService = 10;
+  std::list<tGATT_SVC_DB> local_db;
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  gatt_cb.srv_list_info = &srv_list_info;
+
+  std::vector<Octet16> hashes;
+  std::chrono::duration<double, std::milli> incremental_time(0);
+  for (int i = 0; i < kNumServices; i++) {
+    local_db.emplace_back();
+    tGATT_SVC_DB& db = local_db.back();
+    add_item_to_list(srv_list_info, &db, true);
+    gatts_init_service_db(db, Uuid::From16Bit(0x1800 + i), true,
+                          1 + i * kHandlesPerService, kHandlesPerService);
+    for (int c = 0; c < 3; c++) {
+      gatts_add_characteristic(
+          db, GATT_PERM_READ, GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_NOTIFY,
+          Uuid::From16Bit(0x2A00 + c));
+      gatts_add_char_descr(db, GATT_PERM_READ | GATT_PERM_WRITE,
+                           Uuid::From16Bit(0x2902));
+    }
+    gatt_cb.database_hash_dirty = true;
+
+    auto start = std::chrono::steady_clock::now();
+    hashes.push_back(gatts_get_database_hash());
+    incremental_time += std::chrono::steady_clock::now() - start;
+  }
+
+  // Reference: serialize the whole database on every change
+  std::chrono::duration<double, std::milli> full_time(0);
+  std::list<tGATT_SRV_LIST_ELEM> full_list;
+  auto srv_it = srv_list_info.begin();
+  for (int i = 0; i < kNumServices; i++, srv_it++) {
+    full_list.push_back(*srv_it);
+    for (auto& srv : full_list) srv.hash_data.clear();
+
+    auto start = std::chrono::steady_clock::now();
+    Octet16 full_hash = gatts_calculate_database_hash(&full_list);
+    full_time += std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(full_hash, hashes[i]);
+  }
+
+  // Nothing changed, nothing is computed
+  EXPECT_FALSE(gatt_cb.database_hash_dirty);
+  EXPECT_EQ(gatts_get_database_hash(), hashes.back());
+
+  printf("services:%d full:%.3f ms incremental:%.3f ms\n", kNumServices,
+         full_time.count(), incremental_time.count());
+  gatt_cb.srv_list_info = nullptr;
+}
@@ -16,8 +16,13 @@
 
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <vector>
+
 #include "common/init_flags.h"
 #include "internal_include/bt_trace.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
 #include "stack/btm/btm_int_types.h"
 #include "stack/include/l2cap_hci_link_interface.h"
 #include "stack/l2cap/l2c_int.h"
@@ -65,3 +70,113 @@ TEST_F(StackL2capTest, l2cble_process_data_length_change_event) {
   l2cble_process_data_length_change_event(0x1234, 0x001b, 0x001b);
   ASSERT_EQ(0x001b, l2cb.lcb_pool[0].tx_data_len);
 }
+
+namespace {
+
+std::vector<BT_HDR*> received_sdus;
+
+void on_data_ind(uint16_t local_cid, BT_HDR* p_buf) {
+  received_sdus.push_back(p_buf);
+}
+
+}  // namespace
+
+class StackL2capLeCocTest : public StackL2capTest {
+ protected:
+  void SetUp() override {
+    StackL2capTest::SetUp();
+    received_sdus.clear();
+    l2cb.rcb_pool[0].api.pL2CA_DataInd_Cb = on_data_ind;
+
+    tx_ccb_ = &l2cb.ccb_pool[0];
+    tx_ccb_->in_use = true;
+    tx_ccb_->remote_cid = 0x0041;
+    tx_ccb_->xmit_hold_q = fixed_queue_new(SIZE_MAX);
+
+    rx_ccb_ = &l2cb.ccb_pool[1];
+    rx_ccb_->in_use = true;
+    rx_ccb_->chnl_state = CST_OPEN;
+    rx_ccb_->p_rcb = &l2cb.rcb_pool[0];
+    rx_ccb_->is_first_seg = true;
+    rx_ccb_->local_conn_cfg.mtu = 512;
+  }
+
+  void TearDown() override {
+    for (BT_HDR* p_buf : received_sdus) osi_free(p_buf);
+    fixed_queue_free(tx_ccb_->xmit_hold_q, osi_free);
+    StackL2capTest::TearDown();
+  }
+
+  void SetMps(uint16_t mps) {
+    tx_ccb_->peer_conn_cfg.mps = mps;
+    rx_ccb_->local_conn_cfg.mps = mps;
+  }
+
+  BT_HDR* MakeSdu(const std::vector<uint8_t>& data) {
+    BT_HDR* p_buf =
+        (BT_HDR*)osi_malloc(BT_HDR_SIZE + L2CAP_MIN_OFFSET + data.size());
+    p_buf->offset = L2CAP_MIN_OFFSET;
+    p_buf->len = data.size();
+    p_buf->event = 0;
+    memcpy((uint8_t*)(p_buf + 1) + p_buf->offset, data.data(), data.size());
+    return p_buf;
+  }
+
+  // Sends the K-frames of the queued SDU to the receiving channel, stripping
+  // the L2CAP header as the link does
+  std::vector<BT_HDR*> Transfer() {
+    std::vector<BT_HDR*> pdus;
+    bool last_piece_of_sdu = false;
+    while (!last_piece_of_sdu) {
+      BT_HDR* p_xmit =
+          l2c_lcc_get_next_xmit_sdu_seg(tx_ccb_, &last_piece_of_sdu);
+      pdus.push_back(p_xmit);
+      p_xmit->offset += L2CAP_PKT_OVERHEAD;
+      p_xmit->len -= L2CAP_PKT_OVERHEAD;
+      l2c_lcc_proc_pdu(rx_ccb_, p_xmit);
+    }
+    return pdus;
+  }
+
+  tL2C_CCB* tx_ccb_;
+  tL2C_CCB* rx_ccb_;
+};
+
+TEST_F(StackL2capLeCocTest, single_pdu_sdu_is_not_copied) {
+  SetMps(64);
+  std::vector<uint8_t> data = {'a', 'b', 'c', 'd'};
+  BT_HDR* p_sdu = MakeSdu(data);
+  fixed_queue_enqueue(tx_ccb_->xmit_hold_q, p_sdu);
+
+  auto pdus = Transfer();
+  ASSERT_EQ(1u, pdus.size());
+  ASSERT_EQ(p_sdu, pdus[0]);
+  ASSERT_TRUE(fixed_queue_is_empty(tx_ccb_->xmit_hold_q));
+
+  ASSERT_EQ(1u, received_sdus.size());
+  ASSERT_EQ(p_sdu, received_sdus[0]);
+  ASSERT_EQ(data.size(), received_sdus[0]->len);
+  ASSERT_EQ(0, memcmp((uint8_t*)(received_sdus[0] + 1) +
+                          received_sdus[0]->offset,
+                      data.data(), data.size()));
+  ASSERT_TRUE(rx_ccb_->is_first_seg);
+}
+
+TEST_F(StackL2capLeCocTest, segmented_sdu_is_reassembled) {
+  SetMps(8);
+  std::vector<uint8_t> data(30);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i;
+  fixed_queue_enqueue(tx_ccb_->xmit_hold_q, MakeSdu(data));
+
+  // 2 bytes in the first K-frame, then 4 bytes in each K-frame
+  auto pdus = Transfer();
+  ASSERT_EQ(8u, pdus.size());
+  ASSERT_TRUE(fixed_queue_is_empty(tx_ccb_->xmit_hold_q));
+
+  ASSERT_EQ(1u, received_sdus.size());
+  ASSERT_EQ(data.size(), received_sdus[0]->len);
+  ASSERT_EQ(0, memcmp((uint8_t*)(received_sdus[0] + 1) +
+                          received_sdus[0]->offset,
+                      data.data(), data.size()));
+  ASSERT_TRUE(rx_ccb_->is_first_seg);
+}
@@ -86,3 +86,15 @@ void bluetooth::shim::ACL_RemoveFromAddressResolution(
 void bluetooth::shim::ACL_ClearAddressResolution() {
   mock_function_count_map[__func__]++;
 }
+void bluetooth::shim::ACL_BeginAddressResolutionBatch() {
+  mock_function_count_map[__func__]++;
+}
+void bluetooth::shim::ACL_EndAddressResolutionBatch() {
+  mock_function_count_map[__func__]++;
+}
+void bluetooth::shim::ACL_BeginAcceptListBatch() {
+  mock_function_count_map[__func__]++;
+}
+void bluetooth::shim::ACL_EndAcceptListBatch() {
+  mock_function_count_map[__func__]++;
+}
@@ -90,6 +90,24 @@ struct ACL_AddToAddressResolution {
 };
 extern struct ACL_AddToAddressResolution ACL_AddToAddressResolution;
 
+// Name: ACL_BeginAcceptListBatch
+// Params:
+// Return: void
+struct ACL_BeginAcceptListBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct ACL_BeginAcceptListBatch ACL_BeginAcceptListBatch;
+
+// Name: ACL_BeginAddressResolutionBatch
+// Params:
+// Return: void
+struct ACL_BeginAddressResolutionBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct ACL_BeginAddressResolutionBatch ACL_BeginAddressResolutionBatch;
+
 // Name: ACL_CancelClassicConnection
 // Params: const RawAddress& raw_address
 // Return: void
@@ -153,6 +171,24 @@ struct ACL_Disconnect {
 };
 extern struct ACL_Disconnect ACL_Disconnect;
 
+// Name: ACL_EndAcceptListBatch
+// Params:
+// Return: void
+struct ACL_EndAcceptListBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct ACL_EndAcceptListBatch ACL_EndAcceptListBatch;
+
+// Name: ACL_EndAddressResolutionBatch
+// Params:
+// Return: void
+struct ACL_EndAddressResolutionBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct ACL_EndAddressResolutionBatch ACL_EndAddressResolutionBatch;
+
 // Name: ACL_IgnoreAllLeConnections
 // Params:
 // Return: void
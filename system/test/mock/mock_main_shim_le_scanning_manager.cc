@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:3
+ *   Functions generated:4
  */
 
 #include <map>
@@ -42,3 +42,8 @@ void bluetooth::shim::init_scanning_manager() {
 void bluetooth::shim::set_empty_filter(bool enable) {
   mock_function_count_map[__func__]++;
 }
+
+uint8_t bluetooth::shim::get_number_of_software_scan_filters() {
+  mock_function_count_map[__func__]++;
+  return 0;
+}
@@ -56,6 +56,8 @@ struct BTM_SetLeConnectionModeToSlow BTM_SetLeConnectionModeToSlow;
 struct BTM_AcceptlistAdd BTM_AcceptlistAdd;
 struct BTM_AcceptlistRemove BTM_AcceptlistRemove;
 struct BTM_AcceptlistClear BTM_AcceptlistClear;
+struct BTM_AcceptlistBeginBatch BTM_AcceptlistBeginBatch;
+struct BTM_AcceptlistEndBatch BTM_AcceptlistEndBatch;
 
 }  // namespace stack_btm_ble_bgconn
 }  // namespace mock
@@ -106,5 +108,13 @@ void BTM_AcceptlistClear() {
   mock_function_count_map[__func__]++;
   test::mock::stack_btm_ble_bgconn::BTM_AcceptlistClear();
 }
+void BTM_AcceptlistBeginBatch() {
+  mock_function_count_map[__func__]++;
+  test::mock::stack_btm_ble_bgconn::BTM_AcceptlistBeginBatch();
+}
+void BTM_AcceptlistEndBatch() {
+  mock_function_count_map[__func__]++;
+  test::mock::stack_btm_ble_bgconn::BTM_AcceptlistEndBatch();
+}
 
 // END mockcify generation
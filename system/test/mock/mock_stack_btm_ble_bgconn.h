@@ -147,6 +147,22 @@ struct BTM_AcceptlistClear {
   void operator()() { body(); };
 };
 extern struct BTM_AcceptlistClear BTM_AcceptlistClear;
+// Name: BTM_AcceptlistBeginBatch
+// Params:
+// Returns: void
+struct BTM_AcceptlistBeginBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct BTM_AcceptlistBeginBatch BTM_AcceptlistBeginBatch;
+// Name: BTM_AcceptlistEndBatch
+// Params:
+// Returns: void
+struct BTM_AcceptlistEndBatch {
+  std::function<void()> body{[]() {}};
+  void operator()() { body(); };
+};
+extern struct BTM_AcceptlistEndBatch BTM_AcceptlistEndBatch;
 
 }  // namespace stack_btm_ble_bgconn
 }  // namespace mock
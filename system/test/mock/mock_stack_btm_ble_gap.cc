@@ -177,7 +177,7 @@ void btm_ble_process_adv_pkt_cont_for_inquiry(
     uint16_t evt_type, tBLE_ADDR_TYPE addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int,
-    std::vector<uint8_t> advertising_data) {
+    std::vector<uint8_t> const& advertising_data) {
   mock_function_count_map[__func__]++;
 }
 void btm_ble_process_ext_adv_pkt(uint8_t data_len, const uint8_t* data) {
@@ -51,6 +51,7 @@ typedef enum {
 #define UIPC_REQ_RX_FLUSH 1
 #define UIPC_REG_REMOVE_ACTIVE_READSET 3
 #define UIPC_SET_READ_POLL_TMO 4
+#define UIPC_REQ_RING_ATTACH 5
 
 typedef void(tUIPC_RCV_CBACK)(
     tUIPC_CH_ID ch_id,
@@ -61,12 +62,16 @@ typedef void(tUIPC_RCV_CBACK)(
 
 const char* dump_uipc_event(tUIPC_EVENT event);
 
+class A2dpAudioRing;
+
 typedef struct {
   int srvfd;
   int fd;
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  /* shared memory ring the data is read from instead of fd, when attached */
+  std::shared_ptr<A2dpAudioRing> ring;
 } tUIPC_CHAN;
 
 struct tUIPC_STATE {
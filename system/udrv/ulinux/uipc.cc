@@ -42,6 +42,7 @@
 #include <set>
 
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
+#include "audio_a2dp_hw/include/audio_a2dp_hw_ring.h"
 #include "bt_utils.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -182,7 +183,6 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
   memset(&uipc.read_set, 0, sizeof(uipc.read_set));
   uipc.max_fd = 0;
   memset(&uipc.signal_fds, 0, sizeof(uipc.signal_fds));
-  memset(&uipc.ch, 0, sizeof(uipc.ch));
 
   /* setup interrupt socket pair */
   if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc.signal_fds) < 0) {
@@ -196,8 +196,10 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
     tUIPC_CHAN* p = &uipc.ch[i];
     p->srvfd = UIPC_DISCONNECTED;
     p->fd = UIPC_DISCONNECTED;
+    p->read_poll_tmo_ms = 0;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->ring.reset();
   }
 
   return 0;
@@ -241,6 +243,7 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
       close(uipc.ch[ch_id].fd);
       FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
       uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+      uipc.ch[ch_id].ring.reset();
     }
 
     uipc.ch[ch_id].fd = accept_server_socket(uipc.ch[ch_id].srvfd);
@@ -329,6 +332,11 @@ static void uipc_flush_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     return;
   }
 
+  if (uipc.ch[ch_id].ring != nullptr) {
+    uipc.ch[ch_id].ring->Flush();
+    return;
+  }
+
   while (1) {
     int ret;
     OSI_NO_INTR(ret = poll(&pfd, 1, 1));
@@ -368,6 +376,29 @@ static void uipc_flush_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   }
 }
 
+static void uipc_attach_ring_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
+  if (ch_id >= UIPC_CH_NUM) return;
+
+  if (uipc.ch[ch_id].fd == UIPC_DISCONNECTED) {
+    LOG_WARN("%s: channel %d is not connected", __func__, ch_id);
+    return;
+  }
+
+  /* the peer offered the ring on the control channel, and sends it right
+   * after connecting, before any data */
+  std::unique_ptr<A2dpAudioRing> ring = A2dpAudioRing::ReceiveFrom(
+      uipc.ch[ch_id].fd, A2DP_AUDIO_RING_HANDSHAKE_TMO_MS);
+  if (ring == nullptr) {
+    LOG_WARN("%s: no ring received on channel %d, reading from the socket",
+             __func__, ch_id);
+    return;
+  }
+
+  LOG_INFO("%s: channel %d reads from a %u bytes ring", __func__, ch_id,
+           ring->size());
+  uipc.ch[ch_id].ring = std::move(ring);
+}
+
 static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   int wakeup = 0;
 
@@ -388,6 +419,7 @@ static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     close(uipc.ch[ch_id].fd);
     FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
     uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+    uipc.ch[ch_id].ring.reset();
     wakeup = 1;
   }
 
@@ -593,6 +625,31 @@ bool UIPC_Send(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
   return false;
 }
 
+/* Reads from the shared memory ring of a channel. Like the socket reads, this
+ * waits at most the read poll timeout for each missing part of the data. */
+static uint32_t uipc_read_ring(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
+                               A2dpAudioRing& ring, int fd, uint8_t* p_buf,
+                               uint32_t len) {
+  uint32_t n_read = ring.Read(p_buf, len);
+
+  while (n_read < len) {
+    int ret = ring.Wait(len - n_read, fd, uipc.ch[ch_id].read_poll_tmo_ms);
+    if (ret == 0) {
+      LOG_WARN("ring wait timeout (%d ms)", uipc.ch[ch_id].read_poll_tmo_ms);
+      break;
+    }
+    if (ret < 0) {
+      LOG_WARN("UIPC_Read : ring detached remotely");
+      std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+      uipc_close_locked(uipc, ch_id);
+      return 0;
+    }
+    n_read += ring.Read(p_buf + n_read, len - n_read);
+  }
+
+  return n_read;
+}
+
 /*******************************************************************************
  **
  ** Function         UIPC_Read
@@ -619,6 +676,16 @@ uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint8_t* p_buf,
     return 0;
   }
 
+  /* keep the ring mapped while reading, even if the channel gets closed */
+  std::shared_ptr<A2dpAudioRing> ring;
+  {
+    std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+    ring = uipc.ch[ch_id].ring;
+  }
+  if (ring != nullptr) {
+    return uipc_read_ring(uipc, ch_id, *ring, fd, p_buf, len);
+  }
+
   while (n_read < (int)len) {
     pfd.fd = fd;
     pfd.events = POLLIN | POLLHUP;
@@ -703,6 +770,11 @@ extern bool UIPC_Ioctl(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t request,
                 uipc.ch[ch_id].read_poll_tmo_ms);
       break;
 
+    case UIPC_REQ_RING_ATTACH:
+      /* user will read data from the shared memory ring sent by the peer */
+      uipc_attach_ring_locked(uipc, ch_id);
+      break;
+
     default:
       LOG_DEBUG("UIPC_Ioctl : request not handled (%d)", request);
       break;